@@ -1,11 +1,275 @@
 #include "AudioDataLib/AudioSink.h"
-#include "AudioDataLib/WaveForm.h"
 #include "AudioDataLib/ErrorSystem.h"
+#include "AudioDataLib/PCMConverter.h"
+#include "AudioDataLib/SIMD.h"
 
 using namespace AudioDataLib;
 
+// Each mixing task works in memory that starts on its own cache line, so that the threads don't step on each other.
+#define ADL_ALIGN_TO_CACHE_LINE(x)		(((x) + (ADL_CACHE_LINE_SIZE - 1)) & ~uint64_t(ADL_CACHE_LINE_SIZE - 1))
+
+//---------------------------------- Mixing Kernels ----------------------------------
+
+// Mixing same-format audio is a matter of adding every input into an accumulator that is wide enough not to overflow,
+// and then saturating the sum back down to the sample type.  Unsigned samples are biased to be signed while they're
+// in the accumulator.  The generic versions here cover every sample type, and the overloads below them are the
+// vectorized versions for the types that we see the most (16-bit PCM and 32-bit float).
+
+template<typename T>
+static constexpr int64_t MixBias()
+{
+	if constexpr (std::is_unsigned<T>())
+		return (int64_t(1) << (sizeof(T) * 8 - 1)) - 1;
+	else
+		return 0;
+}
+
+template<typename A, typename T>
+static void AccumulateSamples(A* accumulator, const T* samples, uint64_t count)
+{
+	if constexpr (std::is_floating_point<T>())
+	{
+		for (uint64_t i = 0; i < count; i++)
+			accumulator[i] += A(samples[i]);
+	}
+	else
+	{
+		constexpr A bias = A(MixBias<T>());
+		for (uint64_t i = 0; i < count; i++)
+			accumulator[i] += A(samples[i]) - bias;
+	}
+}
+
+template<typename T, typename A>
+static void StoreSamples(T* samples, const A* accumulator, uint64_t count)
+{
+	if constexpr (std::is_floating_point<T>())
+	{
+		for (uint64_t i = 0; i < count; i++)
+			samples[i] = T(ADL_CLAMP(accumulator[i], A(-1.0), A(1.0)));
+	}
+	else if constexpr (std::is_signed<T>())
+	{
+		constexpr A minSample = A(std::numeric_limits<T>::min());
+		constexpr A maxSample = A(std::numeric_limits<T>::max());
+		for (uint64_t i = 0; i < count; i++)
+			samples[i] = T(ADL_CLAMP(accumulator[i], minSample, maxSample));
+	}
+	else
+	{
+		constexpr A bias = A(MixBias<T>());
+		constexpr A maxSample = A(int64_t(1) << (sizeof(T) * 8 - 1));
+		constexpr A minSample = -maxSample + 1;
+		for (uint64_t i = 0; i < count; i++)
+			samples[i] = T(ADL_CLAMP(accumulator[i], minSample, maxSample) + bias);
+	}
+}
+
+#if defined ADL_SIMD_X86
+
+static void AccumulateSamplesSSE2(int32_t* accumulator, const int16_t* samples, uint64_t count)
+{
+	uint64_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		// Sign-extend by putting each sample in the high half of a 32-bit lane and shifting it back down.
+		__m128i sampleVec = _mm_loadu_si128((const __m128i*)&samples[i]);
+		__m128i lowVec = _mm_srai_epi32(_mm_unpacklo_epi16(sampleVec, sampleVec), 16);
+		__m128i highVec = _mm_srai_epi32(_mm_unpackhi_epi16(sampleVec, sampleVec), 16);
+		_mm_storeu_si128((__m128i*)&accumulator[i], _mm_add_epi32(_mm_loadu_si128((const __m128i*)&accumulator[i]), lowVec));
+		_mm_storeu_si128((__m128i*)&accumulator[i + 4], _mm_add_epi32(_mm_loadu_si128((const __m128i*)&accumulator[i + 4]), highVec));
+	}
+
+	AccumulateSamples(&accumulator[i], &samples[i], count - i);
+}
+
+ADL_AVX2_FUNC static void AccumulateSamplesAVX2(int32_t* accumulator, const int16_t* samples, uint64_t count)
+{
+	uint64_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m256i lowVec = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)&samples[i]));
+		__m256i highVec = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)&samples[i + 8]));
+		_mm256_storeu_si256((__m256i*)&accumulator[i], _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)&accumulator[i]), lowVec));
+		_mm256_storeu_si256((__m256i*)&accumulator[i + 8], _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)&accumulator[i + 8]), highVec));
+	}
+
+	AccumulateSamples(&accumulator[i], &samples[i], count - i);
+}
+
+static void StoreSamplesSSE2(int16_t* samples, const int32_t* accumulator, uint64_t count)
+{
+	// The signed pack instruction saturates for us.
+	uint64_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i lowVec = _mm_loadu_si128((const __m128i*)&accumulator[i]);
+		__m128i highVec = _mm_loadu_si128((const __m128i*)&accumulator[i + 4]);
+		_mm_storeu_si128((__m128i*)&samples[i], _mm_packs_epi32(lowVec, highVec));
+	}
+
+	StoreSamples(&samples[i], &accumulator[i], count - i);
+}
+
+ADL_AVX2_FUNC static void StoreSamplesAVX2(int16_t* samples, const int32_t* accumulator, uint64_t count)
+{
+	uint64_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		// The pack works within each 128-bit lane, so the middle two quarters come out swapped.
+		__m256i lowVec = _mm256_loadu_si256((const __m256i*)&accumulator[i]);
+		__m256i highVec = _mm256_loadu_si256((const __m256i*)&accumulator[i + 8]);
+		__m256i packedVec = _mm256_permute4x64_epi64(_mm256_packs_epi32(lowVec, highVec), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm256_storeu_si256((__m256i*)&samples[i], packedVec);
+	}
+
+	StoreSamples(&samples[i], &accumulator[i], count - i);
+}
+
+static void AccumulateSamplesSSE2(float* accumulator, const float* samples, uint64_t count)
+{
+	uint64_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm_storeu_ps(&accumulator[i], _mm_add_ps(_mm_loadu_ps(&accumulator[i]), _mm_loadu_ps(&samples[i])));
+		_mm_storeu_ps(&accumulator[i + 4], _mm_add_ps(_mm_loadu_ps(&accumulator[i + 4]), _mm_loadu_ps(&samples[i + 4])));
+	}
+
+	AccumulateSamples(&accumulator[i], &samples[i], count - i);
+}
+
+ADL_AVX2_FUNC static void AccumulateSamplesAVX2(float* accumulator, const float* samples, uint64_t count)
+{
+	uint64_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		_mm256_storeu_ps(&accumulator[i], _mm256_add_ps(_mm256_loadu_ps(&accumulator[i]), _mm256_loadu_ps(&samples[i])));
+		_mm256_storeu_ps(&accumulator[i + 8], _mm256_add_ps(_mm256_loadu_ps(&accumulator[i + 8]), _mm256_loadu_ps(&samples[i + 8])));
+	}
+
+	AccumulateSamples(&accumulator[i], &samples[i], count - i);
+}
+
+static void StoreSamplesSSE2(float* samples, const float* accumulator, uint64_t count)
+{
+	__m128 minVec = _mm_set1_ps(-1.0f);
+	__m128 maxVec = _mm_set1_ps(1.0f);
+
+	uint64_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(&samples[i], _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&accumulator[i]), minVec), maxVec));
+
+	StoreSamples(&samples[i], &accumulator[i], count - i);
+}
+
+ADL_AVX2_FUNC static void StoreSamplesAVX2(float* samples, const float* accumulator, uint64_t count)
+{
+	__m256 minVec = _mm256_set1_ps(-1.0f);
+	__m256 maxVec = _mm256_set1_ps(1.0f);
+
+	uint64_t i = 0;
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_ps(&samples[i], _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(&accumulator[i]), minVec), maxVec));
+
+	StoreSamples(&samples[i], &accumulator[i], count - i);
+}
+
+#endif //ADL_SIMD_X86
+
+static void AccumulateSamples(int32_t* accumulator, const int16_t* samples, uint64_t count)
+{
+#if defined ADL_SIMD_X86
+	switch (PCMConverter::GetInstructionSet())
+	{
+		case PCMConverter::InstructionSet::AVX2:
+			AccumulateSamplesAVX2(accumulator, samples, count);
+			return;
+		case PCMConverter::InstructionSet::SSE2:
+			AccumulateSamplesSSE2(accumulator, samples, count);
+			return;
+		default:
+			break;
+	}
+#endif //ADL_SIMD_X86
+
+	AccumulateSamples<int32_t, int16_t>(accumulator, samples, count);
+}
+
+static void StoreSamples(int16_t* samples, const int32_t* accumulator, uint64_t count)
+{
+#if defined ADL_SIMD_X86
+	switch (PCMConverter::GetInstructionSet())
+	{
+		case PCMConverter::InstructionSet::AVX2:
+			StoreSamplesAVX2(samples, accumulator, count);
+			return;
+		case PCMConverter::InstructionSet::SSE2:
+			StoreSamplesSSE2(samples, accumulator, count);
+			return;
+		default:
+			break;
+	}
+#endif //ADL_SIMD_X86
+
+	StoreSamples<int16_t, int32_t>(samples, accumulator, count);
+}
+
+static void AccumulateSamples(float* accumulator, const float* samples, uint64_t count)
+{
+#if defined ADL_SIMD_X86
+	switch (PCMConverter::GetInstructionSet())
+	{
+		case PCMConverter::InstructionSet::AVX2:
+			AccumulateSamplesAVX2(accumulator, samples, count);
+			return;
+		case PCMConverter::InstructionSet::SSE2:
+			AccumulateSamplesSSE2(accumulator, samples, count);
+			return;
+		default:
+			break;
+	}
+#endif //ADL_SIMD_X86
+
+	AccumulateSamples<float, float>(accumulator, samples, count);
+}
+
+static void StoreSamples(float* samples, const float* accumulator, uint64_t count)
+{
+#if defined ADL_SIMD_X86
+	switch (PCMConverter::GetInstructionSet())
+	{
+		case PCMConverter::InstructionSet::AVX2:
+			StoreSamplesAVX2(samples, accumulator, count);
+			return;
+		case PCMConverter::InstructionSet::SSE2:
+			StoreSamplesSSE2(samples, accumulator, count);
+			return;
+		default:
+			break;
+	}
+#endif //ADL_SIMD_X86
+
+	StoreSamples<float, float>(samples, accumulator, count);
+}
+
+// This is for inputs with a gain, which are always mixed as amplitudes.  It's simple enough for the compiler to vectorize.
+static void AccumulateScaledSamples(double* accumulator, const double* samples, double gain, uint64_t count)
+{
+	for (uint64_t i = 0; i < count; i++)
+		accumulator[i] += samples[i] * gain;
+}
+
+//---------------------------------- AudioSink ----------------------------------
+
 AudioSink::AudioSink()
 {
+	this->resamplerQuality = Resampler::Quality::SINC_32;
+	this->formatOutKnown = false;
+	this->minInputsPerTask = 16;
+	this->maxVoices = 0;
+	this->numAudibleInputs = 0;
+	this->nextSequenceNumber = 0;
+	this->lastMixStats = MixStats{};
 }
 
 /*virtual*/ AudioSink::~AudioSink()
@@ -14,8 +278,12 @@ AudioSink::AudioSink()
 
 void AudioSink::Clear()
 {
-	this->audioStreamInArray.clear();
+	MutexScopeLock scopeLock(&this->inputMutex);
+
+	this->inputArray.clear();
 	this->audioStreamOut.reset();
+	this->formatOutKnown = false;
+	this->lastMixStats = MixStats{};
 }
 
 void AudioSink::SetAudioOutput(std::shared_ptr<AudioStream> audioStreamOut)
@@ -23,209 +291,644 @@ void AudioSink::SetAudioOutput(std::shared_ptr<AudioStream> audioStreamOut)
 	this->audioStreamOut = audioStreamOut;
 }
 
+uint32_t AudioSink::GetAudioInputCount() const
+{
+	MutexScopeLock scopeLock(&this->inputMutex);
+
+	return (uint32_t)this->inputArray.size();
+}
+
 void AudioSink::GenerateAudio(double desiredSecondsAvailable, double minSecondsAddedPerMix)
 {
 	// There's nothing for us to do if we don't have a place to put generated audio.
 	if (!this->audioStreamOut)
 		return;
 
+	const AudioData::Format& format = this->audioStreamOut->GetFormat();
+	if (this->latencyController)
+	{
+		this->latencyController->ReportFillLevel(format.BytesToSeconds(this->audioStreamOut->GetSize()));
+		desiredSecondsAvailable = this->latencyController->GetTargetSeconds();
+		minSecondsAddedPerMix = this->latencyController->GetMinSecondsAddedPerMix();
+	}
+
 	// Early out here if there is already enough data available.
-	uint64_t numDesiredBytesAvailable = this->audioStreamOut->GetFormat().BytesFromSeconds(desiredSecondsAvailable);
+	uint64_t numDesiredBytesAvailable = format.BytesFromSeconds(desiredSecondsAvailable);
 	uint64_t numActualBytesAvailable = this->audioStreamOut->GetSize();
 	if (numDesiredBytesAvailable <= numActualBytesAvailable)
 		return;
 
 	// How much data do we need to add to the output stream?
 	uint64_t numBytesNeeded = numDesiredBytesAvailable - numActualBytesAvailable;
-	uint64_t minBytesAddedPerMix = this->audioStreamOut->GetFormat().BytesFromSeconds(minSecondsAddedPerMix);
+	uint64_t minBytesAddedPerMix = format.BytesFromSeconds(minSecondsAddedPerMix);
 	if (numBytesNeeded < minBytesAddedPerMix)
 		numBytesNeeded = minBytesAddedPerMix;
-	numBytesNeeded = this->audioStreamOut->GetFormat().RoundUpToNearestFrameMultiple(numBytesNeeded);
-
-	// In the trivial case, we need only write a bunch of silence to the stream.
-	if (this->audioStreamInArray.size() == 0)
-	{
-        // Note that rather than write one byte of silence at a time, we want to
-        // write all the silence at once to avoid thrashing a potential mutex
-        // lock occurring on the stream if it is a thread-safe stream.
-        if(numBytesNeeded > 0)
-        {
-            uint8_t* silenceBuffer = new uint8_t[(uint32_t)numBytesNeeded];
-            ::memset(silenceBuffer, 0, (size_t)numBytesNeeded);
-            this->audioStreamOut->WriteBytesToStream(silenceBuffer, numBytesNeeded);
-            delete[] silenceBuffer;
-        }
+	numBytesNeeded = format.RoundUpToNearestFrameMultiple(numBytesNeeded);
+	if (numBytesNeeded == 0)
 		return;
-	}
 
-	// Are all the formats the same?
-	bool allSameFormat = true;
-	for (auto& audioStreamIn : this->audioStreamInArray)
+	// The buffer we generate into hangs around between mixes so that we're not going to the heap every time.
+	if (this->generatedAudioBuffer.size() < numBytesNeeded)
+		this->generatedAudioBuffer.resize(numBytesNeeded);
+
+	// Note that rather than write one sample at a time, we want to write the whole mix at
+	// once to avoid thrashing a potential mutex lock occurring on the stream if it is a thread-safe stream.
+	this->RenderAudio(format, this->generatedAudioBuffer.data(), numBytesNeeded);
+	this->audioStreamOut->WriteBytesToStream(this->generatedAudioBuffer.data(), numBytesNeeded);
+}
+
+void AudioSink::RenderAudio(const AudioData::Format& format, uint8_t* audioBuffer, uint64_t audioBufferSize)
+{
+	MutexScopeLock scopeLock(&this->inputMutex);
+
+	this->mixTimer.Start();
+
+	// Remember the format so that inputs added from now on can have their converters set up right away.
+	this->formatOut = format;
+	this->formatOutKnown = true;
+
+	// Whatever doesn't make up a whole frame is left silent.
+	uint64_t numBytesNeeded = (audioBufferSize / format.BytesPerFrame()) * format.BytesPerFrame();
+	if (numBytesNeeded < audioBufferSize)
+		::memset(&audioBuffer[numBytesNeeded], 0, size_t(audioBufferSize - numBytesNeeded));
+
+	this->numAudibleInputs = this->SelectAudibleInputs();
+
+	// In the trivial case, we need only produce silence.
+	if (this->numAudibleInputs == 0)
+		::memset(audioBuffer, 0, (size_t)numBytesNeeded);
+	else
 	{
-		if (audioStreamIn->GetFormat() != this->audioStreamOut->GetFormat())
+		// Are all the formats the same?  (An input with a gain to apply might as well not be, since it has to be decoded either way.)
+		bool allSameFormat = true;
+		for (uint32_t i = 0; i < this->numAudibleInputs; i++)
 		{
-			allSameFormat = false;
-			break;
+			const Input& input = this->inputArray[i];
+			if (input.audioStream->GetFormat() != format || input.gain != 1.0)
+			{
+				allSameFormat = false;
+				break;
+			}
 		}
+
+		// Handle this case specifically, because it's easy and fast.
+		if (allSameFormat && CanMixSameFormat(format))
+			this->MixSameFormatInputs(format, audioBuffer, numBytesNeeded);
+		else
+			this->MixConvertedInputs(format, audioBuffer, numBytesNeeded);
 	}
 
-	// Allocate space for the audio data we're going to geneate.
-	uint8_t* generatedAudioBuffer = new uint8_t[(uint32_t)numBytesNeeded];
-	::memset(generatedAudioBuffer, 0, (size_t)numBytesNeeded);
+	// The inputs that didn't get a voice still have to keep time with the ones that did.
+	uint64_t numFramesNeeded = numBytesNeeded / format.BytesPerFrame();
+	for (uint32_t i = this->numAudibleInputs; i < this->inputArray.size(); i++)
+	{
+		Input& input = this->inputArray[i];
+		input.converter->Skip(input.audioStream.get(), format, numFramesNeeded);
+	}
+
+	this->lastMixStats.numInputs = uint32_t(this->inputArray.size());
+	this->lastMixStats.numAudibleInputs = this->numAudibleInputs;
+	this->lastMixStats.numVirtualInputs = this->lastMixStats.numInputs - this->numAudibleInputs;
+	this->lastMixStats.numFramesMixed = numFramesNeeded;
 
-	// Handle this case specifically, because it's easy and fast.
-	if (allSameFormat)
+	// Lastly, cull any input audio streams that have been depleted.
+	uint32_t i = 0;
+	while (i < this->inputArray.size())
 	{
-		uint64_t numSamples = numBytesNeeded / this->audioStreamOut->GetFormat().BytesPerSample();
-		uint64_t bytesPerSample = this->audioStreamOut->GetFormat().BytesPerSample();
-		for (uint64_t i = 0; i < numSamples; i++)
+		uint64_t audioStreamInSize = this->inputArray[i].audioStream->GetSize();
+		if (audioStreamInSize > 0)
+			i++;
+		else
+		{
+			uint32_t j = uint32_t(this->inputArray.size()) - 1;
+			if (i != j)
+				this->inputArray[i] = this->inputArray[j];
+			this->inputArray.pop_back();
+		}
+	}
+
+	this->lastMixStats.mixTimeSeconds = this->mixTimer.GetElapsedTimeSeconds();
+}
+
+AudioSink::MixStats AudioSink::GetLastMixStats() const
+{
+	MutexScopeLock scopeLock(&this->inputMutex);
+
+	return this->lastMixStats;
+}
+
+void AudioSink::SetMaxVoices(uint32_t maxVoices)
+{
+	MutexScopeLock scopeLock(&this->inputMutex);
+
+	this->maxVoices = maxVoices;
+}
+
+/*static*/ bool AudioSink::IsMoreAudible(const Input& inputA, const Input& inputB)
+{
+	if (inputA.priority != inputB.priority)
+		return inputA.priority > inputB.priority;
+
+	double gainA = ::fabs(inputA.gain);
+	double gainB = ::fabs(inputB.gain);
+	if (gainA != gainB)
+		return gainA > gainB;
+
+	// Favoring whoever was already playing keeps two otherwise equal inputs from trading places from one mix to the next.
+	return inputA.sequenceNumber < inputB.sequenceNumber;
+}
+
+uint32_t AudioSink::SelectAudibleInputs()
+{
+	uint32_t numInputs = uint32_t(this->inputArray.size());
+	if (this->maxVoices == 0 || numInputs <= this->maxVoices)
+		return numInputs;
+
+	// We don't care what order the inputs are in, just which side of the line they fall on.
+	std::nth_element(this->inputArray.begin(), this->inputArray.begin() + this->maxVoices, this->inputArray.end(), &AudioSink::IsMoreAudible);
+	return this->maxVoices;
+}
+
+void AudioSink::MixConvertedInputs(const AudioData::Format& formatOut, uint8_t* generatedAudioBuffer, uint64_t numBytesNeeded)
+{
+	uint64_t numFramesNeeded = numBytesNeeded / formatOut.BytesPerFrame();
+	uint64_t numAmplitudes = numFramesNeeded * formatOut.numChannels;
+
+	MixJob job;
+	job.audioSink = this;
+	job.numInputs = this->numAudibleInputs;
+	job.formatOut = &formatOut;
+	job.numSamples = numFramesNeeded;
+	job.numTasks = this->CalcNumMixTasks();
+	job.accumulatorBytes = ADL_ALIGN_TO_CACHE_LINE(numAmplitudes * sizeof(double));
+	job.taskStrideBytes = job.accumulatorBytes;
+	job.taskMemory = this->PrepareTaskMemory(job.numTasks, job.taskStrideBytes);
+
+	this->RunMixTasks(job, [](void* context, uint32_t taskIndex) {
+		auto job = static_cast<MixJob*>(context);
+		const AudioData::Format& formatOut = *job->formatOut;
+		uint64_t numFramesNeeded = job->numSamples;
+		double* mixBuffer = reinterpret_cast<double*>(job->taskMemory + taskIndex * job->taskStrideBytes);
+		::memset(mixBuffer, 0, numFramesNeeded * formatOut.numChannels * sizeof(double));
+
+		uint32_t firstInput = 0, lastInput = 0;
+		job->GetInputRange(taskIndex, firstInput, lastInput);
+		for (uint32_t j = firstInput; j < lastInput; j++)
 		{
-			uint8_t* sampleBuffer = &generatedAudioBuffer[i * bytesPerSample];
+			Input& input = job->audioSink->inputArray[j];
 
-			if (this->audioStreamOut->GetFormat().sampleType == AudioData::Format::SIGNED_INTEGER)
+			// The output format can change out from under us, so make sure the converter is keeping up.
+			const AudioData::Format& formatIn = input.audioStream->GetFormat();
+			if (!input.converter->IsConfiguredFor(formatIn, formatOut))
+				input.converter->Configure(formatIn, formatOut, job->audioSink->resamplerQuality);
+
+			input.converter->Process(input.audioStream.get(), numFramesNeeded);
+
+			for (uint16_t i = 0; i < formatOut.numChannels; i++)
 			{
-				switch (this->audioStreamOut->GetFormat().bitsPerSample)
-				{
-					case 8:
-					{
-						int8_t netSample = this->CalcNetSample<int8_t>();
-						::memcpy(sampleBuffer, (const void*)&netSample, sizeof(int8_t));
-						break;
-					}
-					case 16:
-					{
-						int16_t netSample = this->CalcNetSample<int16_t>();
-						::memcpy(sampleBuffer, (const void*)&netSample, sizeof(int16_t));
-						break;
-					}
-					case 32:
-					{
-						int32_t netSample = this->CalcNetSample<int32_t>();
-						::memcpy(sampleBuffer, (const void*)&netSample, sizeof(int32_t));
-						break;
-					}
-				}
+				if (input.gain == 1.0)
+					AccumulateSamples(&mixBuffer[i * numFramesNeeded], input.converter->GetChannelAmplitudes(i), numFramesNeeded);
+				else
+					AccumulateScaledSamples(&mixBuffer[i * numFramesNeeded], input.converter->GetChannelAmplitudes(i), input.gain, numFramesNeeded);
 			}
-			else if (this->audioStreamOut->GetFormat().sampleType == AudioData::Format::UNSIGNED_INTEGER)
+		}
+	});
+
+	// Add the partial mixes together, always in the same order.
+	double* mixBuffer = reinterpret_cast<double*>(job.taskMemory);
+	for (uint32_t i = 1; i < job.numTasks; i++)
+		AccumulateSamples(mixBuffer, reinterpret_cast<const double*>(job.taskMemory + i * job.taskStrideBytes), numAmplitudes);
+
+	// Encoding clamps, so this is also where the mix saturates.
+	PCMConverter pcmConverter;
+	if (!pcmConverter.Configure(formatOut))
+	{
+		::memset(generatedAudioBuffer, 0, (size_t)numBytesNeeded);
+		return;
+	}
+
+	for (uint16_t i = 0; i < formatOut.numChannels; i++)
+		pcmConverter.EncodeChannel(&mixBuffer[i * numFramesNeeded], generatedAudioBuffer, i, numFramesNeeded);
+}
+
+void AudioSink::MixSameFormatInputs(const AudioData::Format& format, uint8_t* generatedAudioBuffer, uint64_t numBytesNeeded)
+{
+	uint64_t numSamples = numBytesNeeded / format.BytesPerSample();
+
+	if (format.sampleType == AudioData::Format::SIGNED_INTEGER)
+	{
+		switch (format.bitsPerSample)
+		{
+			case 8:
+				this->MixBlock<int8_t, int32_t>((int8_t*)generatedAudioBuffer, numSamples);
+				break;
+			case 16:
+				this->MixBlock<int16_t, int32_t>((int16_t*)generatedAudioBuffer, numSamples);
+				break;
+			case 32:
+				this->MixBlock<int32_t, int64_t>((int32_t*)generatedAudioBuffer, numSamples);
+				break;
+		}
+	}
+	else if (format.sampleType == AudioData::Format::UNSIGNED_INTEGER)
+	{
+		switch (format.bitsPerSample)
+		{
+			case 8:
+				this->MixBlock<uint8_t, int32_t>((uint8_t*)generatedAudioBuffer, numSamples);
+				break;
+			case 16:
+				this->MixBlock<uint16_t, int32_t>((uint16_t*)generatedAudioBuffer, numSamples);
+				break;
+			case 32:
+				this->MixBlock<uint32_t, int64_t>((uint32_t*)generatedAudioBuffer, numSamples);
+				break;
+		}
+	}
+	else if (format.sampleType == AudioData::Format::FLOAT)
+	{
+		switch (format.bitsPerSample)
+		{
+			case 32:
+				this->MixBlock<float, float>((float*)generatedAudioBuffer, numSamples);
+				break;
+			case 64:
+				this->MixBlock<double, double>((double*)generatedAudioBuffer, numSamples);
+				break;
+		}
+	}
+}
+
+/*static*/ bool AudioSink::CanMixSameFormat(const AudioData::Format& format)
+{
+	switch (format.sampleType)
+	{
+		case AudioData::Format::SIGNED_INTEGER:
+		case AudioData::Format::UNSIGNED_INTEGER:
+			return format.bitsPerSample == 8 || format.bitsPerSample == 16 || format.bitsPerSample == 32;
+		case AudioData::Format::FLOAT:
+			return format.bitsPerSample == 32 || format.bitsPerSample == 64;
+	}
+
+	return false;
+}
+
+template<typename T, typename A>
+void AudioSink::MixBlock(T* generatedSamples, uint64_t numSamples)
+{
+	// Each task gets an accumulator and a place to read its inputs, each starting on its own cache line.
+	MixJob job;
+	job.audioSink = this;
+	job.numInputs = this->numAudibleInputs;
+	job.formatOut = nullptr;
+	job.numSamples = numSamples;
+	job.numTasks = this->CalcNumMixTasks();
+	job.accumulatorBytes = ADL_ALIGN_TO_CACHE_LINE(numSamples * sizeof(A));
+	job.taskStrideBytes = job.accumulatorBytes + ADL_ALIGN_TO_CACHE_LINE(numSamples * sizeof(T));
+	job.taskMemory = this->PrepareTaskMemory(job.numTasks, job.taskStrideBytes);
+
+	this->RunMixTasks(job, [](void* context, uint32_t taskIndex) {
+		auto job = static_cast<MixJob*>(context);
+		uint8_t* taskMemory = job->taskMemory + taskIndex * job->taskStrideBytes;
+		A* accumulator = reinterpret_cast<A*>(taskMemory);
+		uint8_t* inputBlock = taskMemory + job->accumulatorBytes;
+		::memset(accumulator, 0, job->numSamples * sizeof(A));
+
+		// One read per input per mix keeps us from taking a thread-safe stream's lock for every sample.
+		// An input that comes up short is silent for the rest of the block, just as it would be if we had
+		// read it one sample at a time.
+		uint32_t firstInput = 0, lastInput = 0;
+		job->GetInputRange(taskIndex, firstInput, lastInput);
+		for (uint32_t i = firstInput; i < lastInput; i++)
+		{
+			AudioStream* audioStream = job->audioSink->inputArray[i].audioStream.get();
+			uint64_t numBytesWanted = job->numSamples * sizeof(T);
+			uint64_t numBytesMixed = 0;
+
+			// If the input's memory can be gotten at directly, mix straight out of it.  It may come in a few pieces.
+			if (audioStream->CanAccessInPlace())
 			{
-				switch (this->audioStreamOut->GetFormat().bitsPerSample)
+				while (numBytesMixed < numBytesWanted)
 				{
-					case 8:
-					{
-						uint8_t netSample = this->CalcNetSample<uint8_t>();
-						::memcpy(sampleBuffer, (const void*)&netSample, sizeof(uint8_t));
-						break;
-					}
-					case 16:
-					{
-						uint16_t netSample = this->CalcNetSample<uint16_t>();
-						::memcpy(sampleBuffer, (const void*)&netSample, sizeof(uint16_t));
-						break;
-					}
-					case 32:
-					{
-						uint32_t netSample = this->CalcNetSample<uint32_t>();
-						::memcpy(sampleBuffer, (const void*)&netSample, sizeof(uint32_t));
+					uint64_t numBytesAvailable = 0;
+					const uint8_t* region = audioStream->AcquireRead(numBytesWanted - numBytesMixed, numBytesAvailable);
+					numBytesAvailable -= numBytesAvailable % sizeof(T);
+					if (numBytesAvailable == 0)
 						break;
-					}
+
+					AccumulateSamples(&accumulator[numBytesMixed / sizeof(T)], reinterpret_cast<const T*>(region), numBytesAvailable / sizeof(T));
+					audioStream->CommitRead(numBytesAvailable);
+					numBytesMixed += numBytesAvailable;
 				}
 			}
-			else if (this->audioStreamOut->GetFormat().sampleType == AudioData::Format::FLOAT)
+
+			// Whatever's left (a sample split across pieces, or an input that can't be had in place) gets copied out.
+			if (numBytesMixed < numBytesWanted)
 			{
-				switch (this->audioStreamOut->GetFormat().bitsPerSample)
-				{
-					case 32:
-					{
-						float netSample = this->CalcNetSample<float>();
-						::memcpy(sampleBuffer, (const void*)&netSample, sizeof(float));
-						break;
-					}
-					case 64:
-					{
-						double netSample = this->CalcNetSample<double>();
-						::memcpy(sampleBuffer, (const void*)&netSample, sizeof(double));
-						break;
-					}
-				}
-				
+				uint64_t numBytesRead = audioStream->ReadBytesFromStream(inputBlock, numBytesWanted - numBytesMixed);
+				AccumulateSamples(&accumulator[numBytesMixed / sizeof(T)], reinterpret_cast<const T*>(inputBlock), numBytesRead / sizeof(T));
 			}
 		}
+	});
+
+	// Add the partial sums together.  Integer addition doesn't care about order, so integer
+	// formats come out exactly the same no matter how the inputs were split up.
+	A* accumulator = reinterpret_cast<A*>(job.taskMemory);
+	for (uint32_t i = 1; i < job.numTasks; i++)
+		AccumulateSamples(accumulator, reinterpret_cast<const A*>(job.taskMemory + i * job.taskStrideBytes), numSamples);
+
+	StoreSamples(generatedSamples, accumulator, numSamples);
+}
+
+void AudioSink::SetParallelMixing(uint32_t numWorkerThreads, uint32_t minInputsPerTask /*= 16*/)
+{
+	MutexScopeLock scopeLock(&this->inputMutex);
+
+	this->minInputsPerTask = ADL_MAX(minInputsPerTask, 1);
+
+	if (this->GetNumWorkerThreads() != numWorkerThreads)
+	{
+		this->threadPool.reset();
+		if (numWorkerThreads > 0)
+			this->threadPool = std::make_unique<ThreadPool>(numWorkerThreads);
 	}
+}
+
+uint32_t AudioSink::GetNumWorkerThreads() const
+{
+	return this->threadPool ? this->threadPool->GetNumThreads() : 0;
+}
+
+uint32_t AudioSink::CalcNumMixTasks() const
+{
+	if (!this->threadPool)
+		return 1;
+
+	// There's no point in making more tasks than there are threads to run them, and no
+	// point in making tasks so small that the reduction costs more than they save.
+	uint32_t numTasks = this->numAudibleInputs / this->minInputsPerTask;
+	numTasks = ADL_MIN(numTasks, this->threadPool->GetNumThreads() + 1);
+	return ADL_MAX(numTasks, 1);
+}
+
+uint8_t* AudioSink::PrepareTaskMemory(uint32_t numTasks, uint64_t taskStrideBytes)
+{
+	// This hangs around between mixes so that we're not going to the heap every time.
+	uint64_t numBytesNeeded = numTasks * taskStrideBytes + ADL_CACHE_LINE_SIZE;
+	if (this->taskMemoryBuffer.size() < numBytesNeeded)
+		this->taskMemoryBuffer.resize(numBytesNeeded);
+
+	return reinterpret_cast<uint8_t*>(ADL_ALIGN_TO_CACHE_LINE(uintptr_t(this->taskMemoryBuffer.data())));
+}
+
+void AudioSink::RunMixTasks(MixJob& job, ThreadPool::TaskFunction taskFunction)
+{
+	if (job.numTasks == 1)
+		taskFunction(&job, 0);
+	else
+		this->threadPool->Run(job.numTasks, taskFunction, &job);
+}
+
+void AudioSink::MixJob::GetInputRange(uint32_t taskIndex, uint32_t& firstInput, uint32_t& lastInput) const
+{
+	uint64_t numInputs = this->numInputs;
+	firstInput = uint32_t(numInputs * taskIndex / this->numTasks);
+	lastInput = uint32_t(numInputs * (taskIndex + 1) / this->numTasks);
+}
+
+void AudioSink::AddAudioInput(std::shared_ptr<AudioStream> audioStream, int32_t priority /*= 0*/, double gain /*= 1.0*/)
+{
+	Input input;
+	input.audioStream = audioStream;
+	input.converter = std::make_shared<InputConverter>();
+	input.priority = priority;
+	input.gain = gain;
+
+	// If we don't know the output format yet, the converter gets configured on the first mix instead.
+	// Otherwise, we get that out of the way here, rather than on what might be the audio thread.
+	if (this->audioStreamOut)
+		input.converter->Configure(audioStream->GetFormat(), this->audioStreamOut->GetFormat(), this->resamplerQuality);
 	else
 	{
-		// Grab audio buffers from all the inputs and transform them into wave form space.
-		double secondsNeeded = this->audioStreamOut->GetFormat().BytesToSeconds(numBytesNeeded);
-		auto waveFormListArray = new std::list<WaveForm*>[this->audioStreamOut->GetFormat().numChannels];
-		for (auto& audioStreamIn : this->audioStreamInArray)
-		{
-			uint64_t audioBufferSize = audioStreamIn->GetFormat().BytesFromSeconds(secondsNeeded);
-			audioBufferSize = audioStreamIn->GetFormat().RoundUpToNearestFrameMultiple(audioBufferSize);
-			uint8_t* audioBuffer = new uint8_t[(size_t)audioBufferSize];
-			uint64_t numBytesRead = audioStreamIn->ReadBytesFromStream(audioBuffer, audioBufferSize);
-			for (uint64_t i = numBytesRead; i < audioBufferSize; i++)
-				audioBuffer[i] = 0;
-
-			for (uint32_t i = 0; i < this->audioStreamOut->GetFormat().numChannels; i++)
-			{
-				WaveForm* waveForm = new WaveForm();
-				if(!waveForm->ConvertFromAudioBuffer(audioStreamIn->GetFormat(), audioBuffer, audioBufferSize, i))
-					waveForm->MakeSilence(audioStreamIn->GetFormat().framesPerSecond, secondsNeeded);
-				waveFormListArray[i].push_back(waveForm);
-			}
+		MutexScopeLock scopeLock(&this->inputMutex);
+		if (this->formatOutKnown)
+			input.converter->Configure(audioStream->GetFormat(), this->formatOut, this->resamplerQuality);
+	}
+
+	MutexScopeLock scopeLock(&this->inputMutex);
+	input.sequenceNumber = this->nextSequenceNumber++;
+	this->inputArray.push_back(input);
+}
+
+bool AudioSink::SetAudioInputParams(const AudioStream* audioStream, int32_t priority, double gain)
+{
+	MutexScopeLock scopeLock(&this->inputMutex);
 
-			delete[] audioBuffer;
+	for (Input& input : this->inputArray)
+	{
+		if (input.audioStream.get() == audioStream)
+		{
+			input.priority = priority;
+			input.gain = gain;
+			return true;
 		}
+	}
+
+	return false;
+}
 
-		// Build each channel in the audio output stream.
-		for (uint32_t i = 0; i < this->audioStreamOut->GetFormat().numChannels; i++)
+//---------------------------------- AudioSink::InputConverter ----------------------------------
+
+AudioSink::InputConverter::InputConverter()
+{
+	this->configured = false;
+	this->configureAttempted = false;
+	this->numFramesOut = 0;
+	this->skipFraction = 0.0;
+	this->resetNeeded = false;
+}
+
+/*virtual*/ AudioSink::InputConverter::~InputConverter()
+{
+}
+
+bool AudioSink::InputConverter::Configure(const AudioData::Format& formatIn, const AudioData::Format& formatOut, Resampler::Quality resamplerQuality)
+{
+	this->formatIn = formatIn;
+	this->formatOut = formatOut;
+	this->configured = false;
+	this->configureAttempted = true;
+	this->resamplerArray.clear();
+	this->skipFraction = 0.0;
+	this->resetNeeded = false;
+
+	if (formatIn.numChannels == 0 || formatOut.numChannels == 0)
+	{
+		ErrorSystem::Get()->Add("Can't convert audio without any channels.");
+		return false;
+	}
+
+	if (!this->pcmConverter.Configure(formatIn))
+		return false;
+
+	// A mono input is heard in every output channel.  Otherwise, channels map straight across, and any the input doesn't have are silent.
+	this->channelMap.resize(formatOut.numChannels);
+	for (uint16_t i = 0; i < formatOut.numChannels; i++)
+	{
+		if (formatIn.numChannels == 1)
+			this->channelMap[i] = 0;
+		else
+			this->channelMap[i] = (i < formatIn.numChannels) ? int32_t(i) : -1;
+	}
+
+	if (formatIn.framesPerSecond != formatOut.framesPerSecond)
+	{
+		this->resamplerArray.resize(formatOut.numChannels);
+		for (Resampler& resampler : this->resamplerArray)
 		{
-			// If we're not mixing audio, just convert/resample.
-			if (waveFormListArray[i].size() == 1)
-			{
-				const WaveForm* waveForm = *waveFormListArray[i].begin();
-				waveForm->ConvertToAudioBuffer(this->audioStreamOut->GetFormat(), generatedAudioBuffer, numBytesNeeded, i);
-			}
-			else
+			if (!resampler.Configure(double(formatIn.framesPerSecond), double(formatOut.framesPerSecond), resamplerQuality))
 			{
-				// Add all the wave forms up into a single wave form for the channel.
-				WaveForm mixedWave;
-				mixedWave.SumTogether(waveFormListArray[i]);
-				for (WaveForm* waveForm : waveFormListArray[i])
-					delete waveForm;
-
-				// Convert the aggregated wave form into audio data in the target format.
-				mixedWave.ConvertToAudioBuffer(this->audioStreamOut->GetFormat(), generatedAudioBuffer, numBytesNeeded, i);
+				this->resamplerArray.clear();
+				return false;
 			}
 		}
+	}
+
+	this->configured = true;
+	return true;
+}
+
+bool AudioSink::InputConverter::IsConfiguredFor(const AudioData::Format& formatIn, const AudioData::Format& formatOut) const
+{
+	return this->formatIn == formatIn && this->formatOut == formatOut && this->configureAttempted;
+}
+
+void AudioSink::InputConverter::Process(AudioStream* audioStreamIn, uint64_t numFramesOut)
+{
+	uint16_t numChannelsOut = this->formatOut.numChannels;
+	this->numFramesOut = numFramesOut;
+	if (this->channelAmplitudeBuffer.size() < numFramesOut * numChannelsOut)
+		this->channelAmplitudeBuffer.resize(numFramesOut * numChannelsOut);
+
+	// If we've skipped ahead since the resamplers were last used, what they're holding onto is stale.
+	if (this->resetNeeded)
+	{
+		for (Resampler& resampler : this->resamplerArray)
+			resampler.Reset();
 
-		delete[] waveFormListArray;
+		this->skipFraction = 0.0;
+		this->resetNeeded = false;
 	}
 
-	// Write the generated audio data to the output stream.
-	this->audioStreamOut->WriteBytesToStream(generatedAudioBuffer, numBytesNeeded);
+	// If the resamplers are in play, they tell us exactly how much input to pull.
+	uint64_t numFramesIn = (this->resamplerArray.size() > 0) ? this->resamplerArray[0].GetInputNeeded(numFramesOut) : numFramesOut;
+	uint64_t bytesPerFrameIn = this->formatIn.BytesPerFrame();
+	uint64_t numBytesIn = numFramesIn * bytesPerFrameIn;
+	if (this->audioBuffer.size() < numBytesIn)
+		this->audioBuffer.resize(numBytesIn);
 
-	// Free any remaining memory we used.
-	delete[] generatedAudioBuffer;
+	// We still pull from an input we can't convert, so that it runs its course like any other.  If the input's memory
+	// can be gotten at directly and what we need is all in one piece, we decode straight out of it instead of copying.
+	const uint8_t* audioBufferIn = nullptr;
+	uint64_t numBytesRead = 0;
+	if (numBytesIn > 0 && audioStreamIn->CanAccessInPlace())
+	{
+		const uint8_t* region = audioStreamIn->AcquireRead(numBytesIn, numBytesRead);
+		if (numBytesRead == numBytesIn || numBytesRead == audioStreamIn->GetSize())
+			audioBufferIn = region;
+	}
 
-	// Lastly, cull any input audio streams that have been depleted.
-	uint32_t i = 0;
-	while (i < this->audioStreamInArray.size())
+	if (!audioBufferIn)
 	{
-		AudioStream* audioStreamIn = this->audioStreamInArray[i].get();
-		uint64_t audioStreamInSize = audioStreamIn->GetSize();
-		if (audioStreamInSize > 0)
-			i++;
-		else
+		audioBufferIn = this->audioBuffer.data();
+		numBytesRead = (numBytesIn > 0) ? audioStreamIn->ReadBytesFromStream(this->audioBuffer.data(), numBytesIn) : 0;
+	}
+
+	this->Decode(audioBufferIn, (bytesPerFrameIn > 0) ? numBytesRead / bytesPerFrameIn : 0, numFramesIn);
+
+	if (audioBufferIn != this->audioBuffer.data())
+		audioStreamIn->CommitRead(numBytesRead);
+}
+
+void AudioSink::InputConverter::Decode(const uint8_t* audioBufferIn, uint64_t numFramesRead, uint64_t numFramesIn)
+{
+	uint16_t numChannelsOut = this->formatOut.numChannels;
+	uint64_t numFramesOut = this->numFramesOut;
+
+	if (!this->configured)
+	{
+		::memset(this->channelAmplitudeBuffer.data(), 0, numFramesOut * numChannelsOut * sizeof(double));
+		return;
+	}
+
+	if (this->resamplerArray.size() > 0 && this->decodeBuffer.size() < numFramesIn)
+		this->decodeBuffer.resize(numFramesIn);
+
+	for (uint16_t i = 0; i < numChannelsOut; i++)
+	{
+		double* channelAmplitudes = &this->channelAmplitudeBuffer[i * numFramesOut];
+
+		if (this->channelMap[i] < 0)
 		{
-			uint32_t j = uint32_t(this->audioStreamInArray.size()) - 1;
-			if (i != j)
-				this->audioStreamInArray[i] = this->audioStreamInArray[j];
-			this->audioStreamInArray.pop_back();
+			::memset(channelAmplitudes, 0, numFramesOut * sizeof(double));
+			continue;
+		}
+
+		// Decode straight into the output channel if we don't have to resample.  Whatever the input was short is silence.
+		double* amplitudes = (this->resamplerArray.size() > 0) ? this->decodeBuffer.data() : channelAmplitudes;
+		this->pcmConverter.DecodeChannel(audioBufferIn, uint16_t(this->channelMap[i]), amplitudes, numFramesRead);
+		for (uint64_t j = numFramesRead; j < numFramesIn; j++)
+			amplitudes[j] = 0.0;
+
+		if (this->resamplerArray.size() > 0)
+		{
+			uint64_t numInputSamplesConsumed = 0;
+			uint64_t numResampled = this->resamplerArray[i].Process(amplitudes, numFramesIn, channelAmplitudes, numFramesOut, numInputSamplesConsumed);
+			for (uint64_t j = numResampled; j < numFramesOut; j++)
+				channelAmplitudes[j] = 0.0;
 		}
 	}
 }
 
-void AudioSink::AddAudioInput(std::shared_ptr<AudioStream> audioStream)
+void AudioSink::InputConverter::Skip(AudioStream* audioStreamIn, const AudioData::Format& formatOut, uint64_t numFramesOut)
 {
-	this->audioStreamInArray.push_back(audioStream);
+	const AudioData::Format& formatIn = audioStreamIn->GetFormat();
+	uint64_t bytesPerFrameIn = formatIn.BytesPerFrame();
+	if (bytesPerFrameIn == 0)
+		return;
+
+	// Keep the fractional frames around so that an input skipped for a long time doesn't drift.
+	uint64_t numFramesIn = numFramesOut;
+	if (formatIn.framesPerSecond != formatOut.framesPerSecond && formatOut.framesPerSecond > 0)
+	{
+		this->skipFraction += double(numFramesOut) * double(formatIn.framesPerSecond) / double(formatOut.framesPerSecond);
+		numFramesIn = uint64_t(this->skipFraction);
+		this->skipFraction -= double(numFramesIn);
+	}
+
+	uint64_t numBytesIn = numFramesIn * bytesPerFrameIn;
+	this->resetNeeded = true;
+
+	// There's no need to copy what we're skipping if we can just step over it.
+	if (audioStreamIn->CanAccessInPlace())
+	{
+		while (numBytesIn > 0)
+		{
+			uint64_t numBytesAvailable = 0;
+			audioStreamIn->AcquireRead(numBytesIn, numBytesAvailable);
+			if (numBytesAvailable == 0)
+				break;
+
+			audioStreamIn->CommitRead(numBytesAvailable);
+			numBytesIn -= numBytesAvailable;
+		}
+
+		return;
+	}
+
+	if (this->audioBuffer.size() < numBytesIn)
+		this->audioBuffer.resize(numBytesIn);
+
+	if (numBytesIn > 0)
+		audioStreamIn->ReadBytesFromStream(this->audioBuffer.data(), numBytesIn);
 }
\ No newline at end of file
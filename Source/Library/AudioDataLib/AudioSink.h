@@ -2,6 +2,12 @@
 
 #include "AudioDataLib/Common.h"
 #include "AudioDataLib/ByteStream.h"
+#include "AudioDataLib/Resampler.h"
+#include "AudioDataLib/PCMConverter.h"
+#include "AudioDataLib/Mutex.h"
+#include "AudioDataLib/ThreadPool.h"
+#include "AudioDataLib/Timer.h"
+#include "AudioDataLib/LatencyController.h"
 
 namespace AudioDataLib
 {
@@ -11,7 +17,8 @@ namespace AudioDataLib
 	 * What this class is trying to be is a general purpose way of mixing and/or converting audio.
 	 * It can be used for synthesis or real-time purposes.  Note that to use this class in a
 	 * thread-safe manner (typically for real-time playback of audio), you should use the
-	 * ThreadSafeAudioStream class instead of just the regular AudioStream class for the audio output.
+	 * RingBufferAudioStream or ThreadSafeAudioStream class instead of just the regular AudioStream class
+	 * for the audio output.
 	 * 
 	 * The real-time case is all about feeding an audio device.  The synthesis case is about converting
 	 * audio from one format to another, or mixing audio.
@@ -30,13 +37,47 @@ namespace AudioDataLib
 		 * This will produce silence in the audio output if necessary.  Note that
 		 * too much buffered time will create latency when new audio clips are fired.
 		 * But too little buffered can cause audio drop-outs due to a starved device.
+		 * If we've been given a latency controller, it makes this call instead, and the given values are ignored.
 		 */
 		void GenerateAudio(double desiredSecondsAvailable, double minSecondsAddedPerMix);
+
+		/**
+		 * Let the given controller decide how much audio GenerateAudio keeps in the output stream.
+		 * Whoever consumes the output stream should report underruns to it.  Pass null to go back to
+		 * what's given to GenerateAudio.
+		 */
+		void SetLatencyController(std::shared_ptr<LatencyController> latencyController) { this->latencyController = latencyController; }
+
+		std::shared_ptr<LatencyController> GetLatencyController() { return this->latencyController; }
+
+		/**
+		 * This is the pull-mode alternative to GenerateAudio.  Rather than keep the output stream topped up,
+		 * mix exactly as much audio as fits in the given buffer, in the given format, straight into it.
+		 * This is meant to be called from an audio device callback, so that latency is just one device period
+		 * and nothing gets copied in between.  No output stream is needed for this.  Inputs may be added from
+		 * another thread while this is going on.
+		 *
+		 * @param[in] format This is the format of the audio to mix.
+		 * @param[out] audioBuffer This receives the mixed audio.
+		 * @param[in] audioBufferSize This is the size of the given buffer in bytes.
+		 */
+		void RenderAudio(const AudioData::Format& format, uint8_t* audioBuffer, uint64_t audioBufferSize);
 	
 		/**
 		 * Start playing/mixing the given audio stream immediately.
+		 *
+		 * @param[in] audioStream This is the audio to play.  It's dropped once it runs dry.
+		 * @param[in] priority When there are more inputs than voices (see SetMaxVoices), those of higher priority are heard first.
+		 * @param[in] gain The input's samples are scaled by this when they're mixed.  Among inputs of equal priority, the louder ones are heard first.
 		 */
-		void AddAudioInput(std::shared_ptr<AudioStream> audioStream);
+		void AddAudioInput(std::shared_ptr<AudioStream> audioStream, int32_t priority = 0, double gain = 1.0);
+
+		/**
+		 * Change the priority and gain of an input that's already playing.
+		 *
+		 * @return True is returned if the given stream was found among our inputs; false otherwise.
+		 */
+		bool SetAudioInputParams(const AudioStream* audioStream, int32_t priority, double gain);
 
 		std::shared_ptr<AudioStream> GetAudioOutput() { return this->audioStreamOut; }
 		void SetAudioOutput(std::shared_ptr<AudioStream> audioStreamOut);
@@ -44,100 +85,218 @@ namespace AudioDataLib
 		/**
 		 * Return the current number of simulatneously playing audio stream.
 		 */
-		uint32_t GetAudioInputCount() const { return (uint32_t)this->audioStreamInArray.size(); }
+		uint32_t GetAudioInputCount() const;
+
+		/**
+		 * Inputs with a sample-rate different from that of the output get streamed through a resampler
+		 * of the given quality.  Each such input keeps its own resamplers for as long as it's playing.
+		 * Changing this only affects inputs added afterward.
+		 */
+		void SetResamplerQuality(Resampler::Quality resamplerQuality) { this->resamplerQuality = resamplerQuality; }
+
+		/**
+		 * Return the quality of resampling used on inputs that don't match the output sample-rate.
+		 */
+		Resampler::Quality GetResamplerQuality() const { return this->resamplerQuality; }
+
+		/**
+		 * Spread the work of mixing across some worker threads.  The inputs are split up among them, each
+		 * adds up its share into its own accumulator, and then the partial sums are added together.
+		 * Integer formats mix to exactly the same result as they do on one thread.  Floating-point
+		 * formats can differ in the last bit or so, since the additions happen in a different order.
+		 *
+		 * @param[in] numWorkerThreads This is how many threads to make, in addition to the one mixing.  Zero (the default) mixes serially.
+		 * @param[in] minInputsPerTask This is the fewest inputs worth handing to a thread.  With fewer inputs than this in all, we mix serially.
+		 */
+		void SetParallelMixing(uint32_t numWorkerThreads, uint32_t minInputsPerTask = 16);
+
+		/**
+		 * Return how many worker threads help out with mixing, not counting the one doing the mixing.
+		 */
+		uint32_t GetNumWorkerThreads() const;
+
+		/**
+		 * Return the fewest inputs that get handed to a worker thread.
+		 */
+		uint32_t GetMinInputsPerTask() const { return this->minInputsPerTask; }
+
+		/**
+		 * Put a limit on how many inputs get mixed at once, so that the cost of a mix can't grow without bound.
+		 * When there are more inputs than this, the ones of lowest priority (and then the quietest of those, and
+		 * then the newest of those) are virtualized: they keep playing, in that we still pull from them, but they
+		 * aren't converted or mixed.  Once a voice frees up, the next most important input is heard again from
+		 * wherever it has gotten to.
+		 *
+		 * @param[in] maxVoices This is the most inputs we'll mix at once.  Zero (the default) means there is no limit.
+		 */
+		void SetMaxVoices(uint32_t maxVoices);
+
+		/**
+		 * Return the most inputs we'll mix at once, or zero if there's no limit.
+		 */
+		uint32_t GetMaxVoices() const { return this->maxVoices; }
+
+		/**
+		 * These are the numbers we keep about the most recent mix, which are handy for tuning the voice budget.
+		 */
+		struct MixStats
+		{
+			uint32_t numInputs;				///< This is how many inputs there were, audible or not.
+			uint32_t numAudibleInputs;		///< This is how many of them were mixed.
+			uint32_t numVirtualInputs;		///< This is how many of them were only pulled from.
+			uint64_t numFramesMixed;		///< This is how many frames of audio the mix produced.
+			double mixTimeSeconds;			///< This is how long the mix took, including the waiting on any worker threads.
+		};
+
+		/**
+		 * Get the statistics of the most recent call to RenderAudio (or GenerateAudio).
+		 */
+		MixStats GetLastMixStats() const;
 
 	protected:
 
-		// TODO: Byte swapping?
-		template<typename T>
-		T CalcNetSample()
+		/**
+		 * @brief This brings one input into the format of the output, a block at a time.
+		 *
+		 * Every input gets one of these when it's added, and keeps it for as long as it's playing.
+		 * It maps the input's channels onto those of the output (a mono input is heard in every channel),
+		 * decodes its samples into amplitudes, and resamples them if the rates differ.  Since the resamplers
+		 * live as long as the input does, there are no discontinuities where one mix meets the next, and since
+		 * the buffers do too, converting doesn't touch the heap once they've grown to the size of a mix.
+		 */
+		class AUDIO_DATA_LIB_API InputConverter
 		{
-			if constexpr (std::is_signed<T>())
-			{
-				int64_t netSampleWide = 0;
-
-				for (auto& audioStreamIn : this->audioStreamInArray)
-				{
-					T sampleNarrow = 0;
-					if (audioStreamIn->ReadType<T>(&sampleNarrow))
-						netSampleWide += int64_t(sampleNarrow);
-				}
-
-				constexpr int64_t minSample = std::numeric_limits<T>::min();
-				constexpr int64_t maxSample = std::numeric_limits<T>::max();
-
-				if (netSampleWide > maxSample)
-					netSampleWide = maxSample;
-				if (netSampleWide < minSample)
-					netSampleWide = minSample;
-
-				T netSampleNarrow = T(netSampleWide);
-				return netSampleNarrow;
-			}
-			else
-			{
-				// TODO: This has not yet been tested.  Test it.
-
-				int64_t netSampleSignedWide = 0;
-				constexpr int64_t delta = (1 << (sizeof(T) * 8 - 1)) - 1;
-
-				for (auto& audioStreamIn : this->audioStreamInArray)
-				{
-					T sampleUnsignedNarrow = 0;
-					if (audioStreamIn->ReadType<T>(&sampleUnsignedNarrow))
-					{
-						int64_t sampleSignedWide = int64_t(sampleUnsignedNarrow) - delta;
-						netSampleSignedWide += sampleSignedWide;
-					}
-				}
-
-				constexpr int64_t maxSample = 1 << (sizeof(T) * 8 - 1);
-				constexpr int64_t minSample = -maxSample + 1;
-
-				if (netSampleSignedWide > maxSample)
-					netSampleSignedWide = maxSample;
-				if (netSampleSignedWide < minSample)
-					netSampleSignedWide = minSample;
-
-				uint64_t netSampleUnsignedWide = uint64_t(netSampleSignedWide + delta);
-				T netSampleUnsignedNarrow = T(netSampleUnsignedWide);
-				return netSampleUnsignedNarrow;
-			}
-		}
+		public:
+			InputConverter();
+			virtual ~InputConverter();
 
-		// TODO: Byte swapping?
-		template<>
-		float CalcNetSample()
+			/**
+			 * Get ready to convert from the given input format to the given output format.  This resets all conversion state.
+			 *
+			 * @return True is returned on success; false otherwise, such as when one of the formats isn't supported.
+			 */
+			bool Configure(const AudioData::Format& formatIn, const AudioData::Format& formatOut, Resampler::Quality resamplerQuality);
+
+			/**
+			 * Tell us if we were last configured (successfully or not) for the given formats.
+			 */
+			bool IsConfiguredFor(const AudioData::Format& formatIn, const AudioData::Format& formatOut) const;
+
+			/**
+			 * Pull from the given input stream whatever is needed to produce the given number of frames in the output format.
+			 * If the input runs dry, what's missing is silence.  The results are had from GetChannelAmplitudes.
+			 */
+			void Process(AudioStream* audioStreamIn, uint64_t numFramesOut);
+
+			/**
+			 * Pull from the given input stream as much as Process would have, but don't convert any of it.  This is how
+			 * a virtualized input keeps its place.  The next call to Process picks up from there, starting its resamplers fresh.
+			 */
+			void Skip(AudioStream* audioStreamIn, const AudioData::Format& formatOut, uint64_t numFramesOut);
+
+			/**
+			 * Get the amplitudes of the given output channel from the last call to Process.
+			 */
+			const double* GetChannelAmplitudes(uint16_t channel) const { return &this->channelAmplitudeBuffer[channel * this->numFramesOut]; }
+
+		private:
+			void Decode(const uint8_t* audioBufferIn, uint64_t numFramesRead, uint64_t numFramesIn);
+
+			AudioData::Format formatIn;
+			AudioData::Format formatOut;
+			bool configured;
+			bool configureAttempted;
+			PCMConverter pcmConverter;
+			std::vector<int32_t> channelMap;				///< For each output channel, this is the input channel it comes from, or -1 if it's silent.
+			std::vector<Resampler> resamplerArray;			///< There is one of these per output channel if the rates differ; none otherwise.
+			std::vector<uint8_t> audioBuffer;				///< This is where raw input data lands.
+			std::vector<double> decodeBuffer;				///< This is where a channel is decoded before it's resampled.
+			std::vector<double> channelAmplitudeBuffer;		///< These are the converted amplitudes, one channel after another.
+			uint64_t numFramesOut;
+			double skipFraction;							///< This is the part of an input frame that skipping has yet to account for.
+			bool resetNeeded;								///< This is set if we've skipped since the resamplers were last used.
+		};
+
+		/**
+		 * This is an input stream along with what we need to mix it.
+		 */
+		struct Input
 		{
-			double netSampleWide = 0.0;
+			std::shared_ptr<AudioStream> audioStream;
+			std::shared_ptr<InputConverter> converter;
+			int32_t priority;
+			double gain;
+			uint64_t sequenceNumber;		///< This says which inputs were added first.
+		};
 
-			for (auto& audioStreamIn : this->audioStreamInArray)
-			{
-				float sampleNarrow = 0.0f;
-				if (audioStreamIn->ReadType<float>(&sampleNarrow))
-					netSampleWide += double(sampleNarrow);
-			}
+		/**
+		 * Tell us which of the given inputs gets a voice first.
+		 */
+		static bool IsMoreAudible(const Input& inputA, const Input& inputB);
 
-			netSampleWide = ADL_CLAMP(netSampleWide, -1.0, 1.0);
-			float netSampleNarrow = float(netSampleWide);
-			return netSampleNarrow;
-		}
+		/**
+		 * Move the inputs that get mixed this time to the front of the input array, and return how many there are.
+		 */
+		uint32_t SelectAudibleInputs();
+
+		/**
+		 * This is the general path, for when some inputs need to be converted.  Each is converted by its own converter,
+		 * and then the results are added up and encoded into the given buffer.
+		 */
+		void MixConvertedInputs(const AudioData::Format& formatOut, uint8_t* generatedAudioBuffer, uint64_t numBytesNeeded);
+
+		/**
+		 * This is the fast path for when every input has the same format as the output, so that no conversion is needed.
+		 * We read one block from each input, add them all up in a wider accumulator, and then saturate into the given buffer.
+		 */
+		void MixSameFormatInputs(const AudioData::Format& format, uint8_t* generatedAudioBuffer, uint64_t numBytesNeeded);
+
+		/**
+		 * Tell us whether MixSameFormatInputs knows how to add up samples of the given format.  Anything it
+		 * doesn't know (24-bit integers, say) has to go through MixConvertedInputs, even if no conversion is needed.
+		 */
+		static bool CanMixSameFormat(const AudioData::Format& format);
 
 		// TODO: Byte swapping?
-		template<>
-		double CalcNetSample()
+		template<typename T, typename A>
+		void MixBlock(T* generatedSamples, uint64_t numSamples);
+
+		/**
+		 * This describes one mix that's being split into tasks, each of which works on a contiguous range of the inputs.
+		 */
+		struct MixJob
 		{
-			double netSample = 0.0;
-			double sample = 0.0;
-			for(auto& audioStreamIn : this->audioStreamInArray)
-				if (audioStreamIn->ReadType<double>(&sample))
-					netSample += sample;
+			AudioSink* audioSink;
+			uint32_t numInputs;				///< This is how many inputs, from the front of the input array, get mixed.
+			const AudioData::Format* formatOut;
+			uint64_t numSamples;
+			uint32_t numTasks;
+			uint8_t* taskMemory;			///< Each task gets taskStrideBytes of this, starting on a cache line.
+			uint64_t taskStrideBytes;
+			uint64_t accumulatorBytes;		///< This is how much of a task's memory is its accumulator.  The rest, if any, is for reading inputs.
+
+			void GetInputRange(uint32_t taskIndex, uint32_t& firstInput, uint32_t& lastInput) const;
+		};
 
-			netSample = ADL_CLAMP(netSample, -1.0, 1.0);
-			return netSample;
-		}
+		uint32_t CalcNumMixTasks() const;
+		uint8_t* PrepareTaskMemory(uint32_t numTasks, uint64_t taskStrideBytes);
+		void RunMixTasks(MixJob& job, ThreadPool::TaskFunction taskFunction);
 
-		std::vector<std::shared_ptr<AudioStream>> audioStreamInArray;
+		std::vector<Input> inputArray;
+		mutable StandardMutex inputMutex;				///< This guards the input array, since inputs may be added while another thread is mixing.
 		std::shared_ptr<AudioStream> audioStreamOut;
+		std::shared_ptr<LatencyController> latencyController;
+		AudioData::Format formatOut;					///< This is the format we last mixed into.
+		bool formatOutKnown;
+		Resampler::Quality resamplerQuality;
+		std::vector<uint8_t> generatedAudioBuffer;		///< This is where each mix is put together before it's written to the output.
+		std::vector<uint8_t> taskMemoryBuffer;			///< This is where the mixing tasks add up their inputs.
+		std::unique_ptr<ThreadPool> threadPool;			///< This is only here if we've been asked to mix in parallel.
+		uint32_t minInputsPerTask;
+		uint32_t maxVoices;
+		uint32_t numAudibleInputs;						///< This is how many inputs, from the front of the input array, are being mixed right now.
+		uint64_t nextSequenceNumber;
+		MixStats lastMixStats;
+		HighResTimer mixTimer;
 	};
 }
\ No newline at end of file
@@ -1,5 +1,15 @@
 #include "AudioDataLib/ByteStream.h"
 #include "AudioDataLib/Mutex.h"
+#if defined _WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	define NOMINMAX
+#	include <Windows.h>
+#else
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
 
 using namespace AudioDataLib;
 
@@ -18,6 +28,42 @@ ByteStream::ByteStream()
 	return 0;
 }
 
+/*virtual*/ const uint8_t* ByteStream::AcquireRead(uint64_t numBytesWanted, uint64_t& numBytesAvailable)
+{
+	if (this->readSpanBuffer.size() < numBytesWanted)
+		this->readSpanBuffer.resize(numBytesWanted);
+
+	numBytesAvailable = this->PeekBytesFromStream(this->readSpanBuffer.data(), numBytesWanted);
+	return this->readSpanBuffer.data();
+}
+
+/*virtual*/ void ByteStream::CommitRead(uint64_t numBytes)
+{
+	// What was peeked is still in our buffer, so reading it again into the same place changes nothing but the stream.
+	if (numBytes > 0)
+		this->ReadBytesFromStream(this->readSpanBuffer.data(), numBytes);
+}
+
+/*virtual*/ uint8_t* ByteStream::AcquireWrite(uint64_t numBytesWanted, uint64_t& numBytesAvailable)
+{
+	if (this->writeSpanBuffer.size() < numBytesWanted)
+		this->writeSpanBuffer.resize(numBytesWanted);
+
+	numBytesAvailable = this->CanWrite() ? numBytesWanted : 0;
+	return this->writeSpanBuffer.data();
+}
+
+/*virtual*/ void ByteStream::CommitWrite(uint64_t numBytes)
+{
+	if (numBytes > 0)
+		this->WriteBytesToStream(this->writeSpanBuffer.data(), numBytes);
+}
+
+/*virtual*/ bool ByteStream::CanAccessInPlace() const
+{
+	return false;
+}
+
 //------------------------- FileStream -------------------------
 
 FileStream::FileStream(const char* filePath, const char* mode)
@@ -46,12 +92,173 @@ void FileStream::Close()
 
 //------------------------- FileInputStream -------------------------
 
-FileInputStream::FileInputStream(const char* filePath) : FileStream(filePath, "rb")
+FileInputStream::FileInputStream(const char* filePath, uint64_t readAheadSize /*= 64 * 1024*/, bool prefetch /*= false*/) : FileStream(filePath, "rb")
 {
+	this->fileSize = 0;
+	this->filePosition = 0;
+	this->readAheadBuffer.resize(size_t(ADL_MAX(readAheadSize, 1)));
+	this->readAheadStart = 0;
+	this->readAheadEnd = 0;
+
+	this->prefetchThread = nullptr;
+	this->prefetchMutex = nullptr;
+	this->prefetchCondition = nullptr;
+	this->prefetchStart = 0;
+	this->prefetchEnd = 0;
+	this->prefetchPending = false;
+	this->prefetchQuit = false;
+
+	if (!this->fp)
+		return;
+
+	fseek(this->fp, 0, SEEK_END);
+	this->fileSize = (uint64_t)ftell(this->fp);
+	fseek(this->fp, 0, SEEK_SET);
+
+	// There's no point in a thread for a file we'd read in one go anyway.
+	if (prefetch && this->fileSize > this->readAheadBuffer.size())
+	{
+		this->prefetchMutex = new std::mutex();
+		this->prefetchCondition = new std::condition_variable();
+		this->prefetchBuffer.resize(this->readAheadBuffer.size());
+		this->prefetchPending = true;
+		this->prefetchThread = new std::thread([this]() { this->PrefetchThreadMain(); });
+	}
 }
 
 /*virtual*/ FileInputStream::~FileInputStream()
 {
+	this->Close();
+}
+
+/*virtual*/ void FileInputStream::Close()
+{
+	this->StopPrefetching();
+
+	FileStream::Close();
+
+	this->fileSize = this->filePosition;
+	this->readAheadStart = 0;
+	this->readAheadEnd = 0;
+}
+
+void FileInputStream::StopPrefetching()
+{
+	if (!this->prefetchThread)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(*this->prefetchMutex);
+		this->prefetchQuit = true;
+	}
+
+	this->prefetchCondition->notify_all();
+	this->prefetchThread->join();
+
+	delete this->prefetchThread;
+	delete this->prefetchMutex;
+	delete this->prefetchCondition;
+	this->prefetchThread = nullptr;
+	this->prefetchMutex = nullptr;
+	this->prefetchCondition = nullptr;
+}
+
+void FileInputStream::PrefetchThreadMain()
+{
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(*this->prefetchMutex);
+			this->prefetchCondition->wait(lock, [this]() { return this->prefetchQuit || this->prefetchPending; });
+			if (this->prefetchQuit)
+				return;
+		}
+
+		// Nobody else touches the file or the prefetch buffer while a prefetch is pending, so we don't need the lock for this.
+		uint64_t numBytesRead = (uint64_t)fread(this->prefetchBuffer.data(), 1, this->prefetchBuffer.size(), this->fp);
+
+		{
+			std::lock_guard<std::mutex> lock(*this->prefetchMutex);
+			this->prefetchStart = 0;
+			this->prefetchEnd = numBytesRead;
+			this->prefetchPending = false;
+		}
+
+		this->prefetchCondition->notify_all();
+	}
+}
+
+uint64_t FileInputStream::ReadFromFile(uint8_t* buffer, uint64_t bufferSize)
+{
+	if (!this->fp)
+		return 0;
+
+	if (!this->prefetchThread)
+		return (uint64_t)fread(buffer, 1, (size_t)bufferSize, this->fp);
+
+	uint64_t numBytesRead = 0;
+	std::unique_lock<std::mutex> lock(*this->prefetchMutex);
+	while (numBytesRead < bufferSize)
+	{
+		this->prefetchCondition->wait(lock, [this]() { return !this->prefetchPending; });
+
+		// If the last prefetch came back empty, then we're at the end of the file.
+		if (this->prefetchStart == this->prefetchEnd)
+			break;
+
+		uint64_t numBytesToCopy = ADL_MIN(bufferSize - numBytesRead, this->prefetchEnd - this->prefetchStart);
+		::memcpy(&buffer[numBytesRead], &this->prefetchBuffer[this->prefetchStart], size_t(numBytesToCopy));
+		this->prefetchStart += numBytesToCopy;
+		numBytesRead += numBytesToCopy;
+
+		// Get the thread going on the next block right away, so that it's working while our caller is.
+		if (this->prefetchStart == this->prefetchEnd)
+		{
+			this->prefetchPending = true;
+			this->prefetchCondition->notify_all();
+		}
+	}
+
+	return numBytesRead;
+}
+
+uint64_t FileInputStream::FillReadAheadBuffer(uint64_t numBytesWanted)
+{
+	uint64_t numBytesBuffered = this->readAheadEnd - this->readAheadStart;
+	if (numBytesBuffered >= numBytesWanted)
+		return numBytesBuffered;
+
+	// Someone wants to peek at more than we'd normally hold, so make room for it.
+	if (numBytesWanted > this->readAheadBuffer.size())
+		this->readAheadBuffer.resize(size_t(numBytesWanted));
+
+	// In the usual case of reading straight through with the prefetch thread, we've used up the last block
+	// and the next one is waiting for us whole, so we can just trade buffers with the thread instead of copying.
+	if (numBytesBuffered == 0 && this->prefetchThread)
+	{
+		std::unique_lock<std::mutex> lock(*this->prefetchMutex);
+		this->prefetchCondition->wait(lock, [this]() { return !this->prefetchPending; });
+		if (this->prefetchStart == 0 && this->prefetchEnd > 0 && this->prefetchEnd >= ADL_MIN(numBytesWanted, this->fileSize - this->filePosition))
+		{
+			this->readAheadBuffer.swap(this->prefetchBuffer);
+			this->readAheadStart = 0;
+			this->readAheadEnd = this->prefetchEnd;
+			this->prefetchEnd = 0;
+			this->prefetchPending = true;
+			this->prefetchCondition->notify_all();
+			return this->readAheadEnd;
+		}
+	}
+
+	if (this->readAheadStart > 0)
+	{
+		::memmove(this->readAheadBuffer.data(), this->readAheadBuffer.data() + this->readAheadStart, size_t(numBytesBuffered));
+		this->readAheadStart = 0;
+		this->readAheadEnd = numBytesBuffered;
+	}
+
+	this->readAheadEnd += this->ReadFromFile(this->readAheadBuffer.data() + this->readAheadEnd, this->readAheadBuffer.size() - this->readAheadEnd);
+	return this->readAheadEnd - this->readAheadStart;
 }
 
 /*virtual*/ uint64_t FileInputStream::WriteBytesToStream(const uint8_t* buffer, uint64_t bufferSize)
@@ -61,27 +268,71 @@ FileInputStream::FileInputStream(const char* filePath) : FileStream(filePath, "r
 
 /*virtual*/ uint64_t FileInputStream::ReadBytesFromStream(uint8_t* buffer, uint64_t bufferSize)
 {
-	if (!this->fp)
-		return 0;
+	uint64_t numBytesRead = 0;
+
+	while (numBytesRead < bufferSize)
+	{
+		uint64_t numBytesBuffered = this->readAheadEnd - this->readAheadStart;
+		if (numBytesBuffered == 0)
+		{
+			// Big reads may as well go straight to the caller's buffer, rather than through ours.
+			uint64_t numBytesLeft = bufferSize - numBytesRead;
+			if (!this->prefetchThread && numBytesLeft >= this->readAheadBuffer.size())
+			{
+				numBytesRead += this->ReadFromFile(&buffer[numBytesRead], numBytesLeft);
+				break;
+			}
+
+			numBytesBuffered = this->FillReadAheadBuffer(1);
+			if (numBytesBuffered == 0)
+				break;
+		}
+
+		uint64_t numBytesToCopy = ADL_MIN(bufferSize - numBytesRead, numBytesBuffered);
+		::memcpy(&buffer[numBytesRead], this->readAheadBuffer.data() + this->readAheadStart, size_t(numBytesToCopy));
+		this->readAheadStart += numBytesToCopy;
+		numBytesRead += numBytesToCopy;
+	}
+
+	this->filePosition += numBytesRead;
+	return numBytesRead;
+}
 
-	return (uint64_t)fread(buffer, 1, (size_t)bufferSize, fp);
+/*virtual*/ uint64_t FileInputStream::PeekBytesFromStream(uint8_t* buffer, uint64_t bufferSize)
+{
+	uint64_t numBytesPeeked = ADL_MIN(bufferSize, this->FillReadAheadBuffer(ADL_MIN(bufferSize, this->GetSize())));
+	::memcpy(buffer, this->readAheadBuffer.data() + this->readAheadStart, size_t(numBytesPeeked));
+	return numBytesPeeked;
+}
+
+/*virtual*/ const uint8_t* FileInputStream::AcquireRead(uint64_t numBytesWanted, uint64_t& numBytesAvailable)
+{
+	// Unlike a peek, we don't grow our buffer for this.  The caller can always come back for the rest.
+	numBytesWanted = ADL_MIN(numBytesWanted, ADL_MIN(this->GetSize(), (uint64_t)this->readAheadBuffer.size()));
+	numBytesAvailable = ADL_MIN(numBytesWanted, this->FillReadAheadBuffer(numBytesWanted));
+	return this->readAheadBuffer.data() + this->readAheadStart;
+}
+
+/*virtual*/ void FileInputStream::CommitRead(uint64_t numBytes)
+{
+	numBytes = ADL_MIN(numBytes, this->readAheadEnd - this->readAheadStart);
+	this->readAheadStart += numBytes;
+	this->filePosition += numBytes;
+}
+
+/*virtual*/ bool FileInputStream::CanAccessInPlace() const
+{
+	return true;
 }
 
 /*virtual*/ uint64_t FileInputStream::GetSize() const
 {
-	if (!this->fp)
-		return 0;
-	uint64_t curPos = ftell(this->fp);
-	fseek(this->fp, 0, SEEK_END);
-	uint64_t endPos = ftell(this->fp);
-	uint64_t numBytesLeft = endPos - curPos;
-	fseek(this->fp, (long)curPos, SEEK_SET);
-	return numBytesLeft;
+	return this->fileSize - this->filePosition;
 }
 
 /*virtual*/ bool FileInputStream::CanRead()
 {
-	return this->GetSize() > 0;
+	return this->filePosition < this->fileSize;
 }
 
 /*virtual*/ bool FileInputStream::CanWrite()
@@ -127,6 +378,191 @@ FileOutputStream::FileOutputStream(const char* filePath) : FileStream(filePath,
 	return true;
 }
 
+//------------------------- AsyncFileOutputStream -------------------------
+
+AsyncFileOutputStream::AsyncFileOutputStream(const char* filePath, uint64_t blockSize /*= 256 * 1024*/, uint32_t numBlocks /*= 3*/, bool waitWhenFull /*= false*/) : FileOutputStream(filePath)
+{
+	this->blockArray.resize(ADL_MAX(numBlocks, 2));
+	for (Block& block : this->blockArray)
+	{
+		block.data.resize(size_t(ADL_MAX(blockSize, 1)));
+		block.size = 0;
+	}
+
+	this->fillBlockIndex = 0;
+	this->writeBlockIndex = 0;
+	this->numBlocksQueued = 0;
+	this->waitWhenFull = waitWhenFull;
+	this->quit = false;
+	this->stats = Stats{};
+
+	this->writerThread = nullptr;
+	this->mutex = new std::mutex();
+	this->queuedCondition = new std::condition_variable();
+	this->writtenCondition = new std::condition_variable();
+
+	if (this->fp)
+		this->writerThread = new std::thread([this]() { this->WriterThreadMain(); });
+}
+
+/*virtual*/ AsyncFileOutputStream::~AsyncFileOutputStream()
+{
+	this->Close();
+
+	delete this->mutex;
+	delete this->queuedCondition;
+	delete this->writtenCondition;
+}
+
+/*virtual*/ void AsyncFileOutputStream::Close()
+{
+	if (this->writerThread)
+	{
+		this->Flush();
+
+		{
+			std::lock_guard<std::mutex> lock(*this->mutex);
+			this->quit = true;
+		}
+
+		this->queuedCondition->notify_all();
+		this->writerThread->join();
+		delete this->writerThread;
+		this->writerThread = nullptr;
+	}
+
+	FileOutputStream::Close();
+}
+
+/*virtual*/ uint64_t AsyncFileOutputStream::WriteBytesToStream(const uint8_t* buffer, uint64_t bufferSize)
+{
+	if (!this->writerThread)
+		return 0;
+
+	uint64_t blockSize = this->blockArray[0].data.size();
+
+	// A block that filled up when there was nowhere to queue it is still sitting here, so try again.
+	if (this->blockArray[this->fillBlockIndex].size == blockSize && !this->QueueFillBlock(this->waitWhenFull))
+	{
+		std::lock_guard<std::mutex> lock(*this->mutex);
+		this->stats.numBytesDropped += bufferSize;
+		this->stats.numWritesDropped++;
+		return 0;
+	}
+
+	if (!this->waitWhenFull)
+	{
+		// Our thread only ever makes more room, so if it all fits now, it'll still fit once we're done copying.
+		std::lock_guard<std::mutex> lock(*this->mutex);
+		uint64_t numBlocksFree = this->blockArray.size() - 1 - this->numBlocksQueued;
+		uint64_t numBytesFree = (blockSize - this->blockArray[this->fillBlockIndex].size) + numBlocksFree * blockSize;
+		if (bufferSize > numBytesFree)
+		{
+			this->stats.numBytesDropped += bufferSize;
+			this->stats.numWritesDropped++;
+			return 0;
+		}
+	}
+
+	// The fill block is ours alone, so we don't need the lock to copy into it.
+	uint64_t numBytesWritten = 0;
+	while (numBytesWritten < bufferSize)
+	{
+		Block& block = this->blockArray[this->fillBlockIndex];
+		uint64_t numBytesToCopy = ADL_MIN(bufferSize - numBytesWritten, blockSize - block.size);
+		::memcpy(&block.data[block.size], &buffer[numBytesWritten], size_t(numBytesToCopy));
+		block.size += numBytesToCopy;
+		numBytesWritten += numBytesToCopy;
+
+		if (block.size == blockSize && !this->QueueFillBlock(this->waitWhenFull))
+			break;
+	}
+
+	return numBytesWritten;
+}
+
+bool AsyncFileOutputStream::QueueFillBlock(bool wait)
+{
+	uint32_t numBlocks = uint32_t(this->blockArray.size());
+
+	std::unique_lock<std::mutex> lock(*this->mutex);
+
+	// The next block to fill has to be one that isn't queued.
+	if (this->numBlocksQueued == numBlocks - 1)
+	{
+		if (!wait)
+			return false;
+
+		this->stats.numStalls++;
+		this->writtenCondition->wait(lock, [this, numBlocks]() { return this->numBlocksQueued < numBlocks - 1; });
+	}
+
+	this->numBlocksQueued++;
+	this->stats.maxBlocksQueued = ADL_MAX(this->stats.maxBlocksQueued, this->numBlocksQueued);
+	this->fillBlockIndex = (this->fillBlockIndex + 1) % numBlocks;
+
+	lock.unlock();
+	this->queuedCondition->notify_one();
+	return true;
+}
+
+void AsyncFileOutputStream::Flush()
+{
+	if (!this->writerThread)
+		return;
+
+	if (this->blockArray[this->fillBlockIndex].size > 0)
+		this->QueueFillBlock(true);
+
+	std::unique_lock<std::mutex> lock(*this->mutex);
+	this->writtenCondition->wait(lock, [this]() { return this->numBlocksQueued == 0; });
+
+	// Our thread is idle now, so the file is ours for the moment.
+	fflush(this->fp);
+}
+
+AsyncFileOutputStream::Stats AsyncFileOutputStream::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(*this->mutex);
+	return this->stats;
+}
+
+void AsyncFileOutputStream::WriterThreadMain()
+{
+	uint32_t numBlocks = uint32_t(this->blockArray.size());
+
+	while (true)
+	{
+		uint32_t blockIndex = 0;
+
+		{
+			std::unique_lock<std::mutex> lock(*this->mutex);
+			this->queuedCondition->wait(lock, [this]() { return this->quit || this->numBlocksQueued > 0; });
+			if (this->numBlocksQueued == 0)
+				return;
+
+			blockIndex = this->writeBlockIndex;
+		}
+
+		// This is the whole point: the disk can take as long as it likes here, and nobody is waiting on us.
+		Block& block = this->blockArray[blockIndex];
+		uint64_t numBytesWritten = (uint64_t)fwrite(block.data.data(), 1, size_t(block.size), this->fp);
+
+		{
+			std::lock_guard<std::mutex> lock(*this->mutex);
+			this->stats.numBytesWritten += numBytesWritten;
+			if (numBytesWritten != block.size)
+				this->stats.numWriteErrors++;
+
+			block.size = 0;
+			this->writeBlockIndex = (this->writeBlockIndex + 1) % numBlocks;
+			this->numBlocksQueued--;
+		}
+
+		this->writtenCondition->notify_all();
+	}
+}
+
 //------------------------- ReadOnlyBufferStream -------------------------
 
 ReadOnlyBufferStream::ReadOnlyBufferStream(const uint8_t* buffer, uint64_t bufferSize)
@@ -152,23 +588,34 @@ void ReadOnlyBufferStream::Reset()
 
 /*virtual*/ uint64_t ReadOnlyBufferStream::ReadBytesFromStream(uint8_t* buffer, uint64_t bufferSize)
 {
-	uint64_t numBytesRead = 0;
-	while (numBytesRead < bufferSize && this->readOffset < this->readOnlyBufferSize)
-		buffer[numBytesRead++] = this->readOnlyBuffer[this->readOffset++];
-
+	uint64_t numBytesRead = this->PeekBytesFromStream(buffer, bufferSize);
+	this->readOffset += numBytesRead;
 	return numBytesRead;
 }
 
 /*virtual*/ uint64_t ReadOnlyBufferStream::PeekBytesFromStream(uint8_t* buffer, uint64_t bufferSize)
 {
-	uint64_t numBytesPeeked = 0;
-	uint64_t i = this->readOffset;
-	while (numBytesPeeked < bufferSize && i < this->readOnlyBufferSize)
-		buffer[numBytesPeeked++] = this->readOnlyBuffer[i++];
-
+	uint64_t numBytesPeeked = ADL_MIN(bufferSize, this->GetSize());
+	::memcpy(buffer, &this->readOnlyBuffer[this->readOffset], size_t(numBytesPeeked));
 	return numBytesPeeked;
 }
 
+/*virtual*/ const uint8_t* ReadOnlyBufferStream::AcquireRead(uint64_t numBytesWanted, uint64_t& numBytesAvailable)
+{
+	numBytesAvailable = ADL_MIN(numBytesWanted, this->GetSize());
+	return &this->readOnlyBuffer[this->readOffset];
+}
+
+/*virtual*/ void ReadOnlyBufferStream::CommitRead(uint64_t numBytes)
+{
+	this->readOffset += ADL_MIN(numBytes, this->GetSize());
+}
+
+/*virtual*/ bool ReadOnlyBufferStream::CanAccessInPlace() const
+{
+	return true;
+}
+
 /*virtual*/ uint64_t ReadOnlyBufferStream::GetSize() const
 {
 	return this->readOnlyBufferSize - this->readOffset;
@@ -193,6 +640,135 @@ bool ReadOnlyBufferStream::SetReadOffset(uint64_t readOffset)
 	return true;
 }
 
+//------------------------- MappedFileInputStream -------------------------
+
+MappedFileInputStream::MappedFileInputStream(const char* filePath, AccessPattern accessPattern /*= SEQUENTIAL*/) : ReadOnlyBufferStream(nullptr, 0)
+{
+	// Once the view is made, it keeps the file open on its own, so there are no handles for us to hang on to.
+#if defined _WIN32
+	DWORD flags = FILE_ATTRIBUTE_NORMAL;
+	if (accessPattern == SEQUENTIAL)
+		flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+	else if (accessPattern == RANDOM)
+		flags |= FILE_FLAG_RANDOM_ACCESS;
+
+	HANDLE fileHandle = ::CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER fileSize;
+	if (::GetFileSizeEx(fileHandle, &fileSize) && fileSize.QuadPart > 0)
+	{
+		HANDLE mappingHandle = ::CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mappingHandle)
+		{
+			void* view = ::MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+			if (view)
+			{
+				this->readOnlyBuffer = (const uint8_t*)view;
+				this->readOnlyBufferSize = uint64_t(fileSize.QuadPart);
+			}
+
+			::CloseHandle(mappingHandle);
+		}
+	}
+
+	::CloseHandle(fileHandle);
+#else
+	int fileDescriptor = ::open(filePath, O_RDONLY);
+	if (fileDescriptor < 0)
+		return;
+
+	struct stat fileStat;
+	if (::fstat(fileDescriptor, &fileStat) == 0 && fileStat.st_size > 0)
+	{
+		void* view = ::mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+		if (view != MAP_FAILED)
+		{
+			this->readOnlyBuffer = (const uint8_t*)view;
+			this->readOnlyBufferSize = uint64_t(fileStat.st_size);
+			this->SetAccessPattern(accessPattern);
+		}
+	}
+
+	::close(fileDescriptor);
+#endif
+}
+
+/*virtual*/ MappedFileInputStream::~MappedFileInputStream()
+{
+	this->Close();
+}
+
+bool MappedFileInputStream::IsOpen()
+{
+	return this->readOnlyBuffer != nullptr;
+}
+
+void MappedFileInputStream::Close()
+{
+	if (!this->readOnlyBuffer)
+		return;
+
+#if defined _WIN32
+	::UnmapViewOfFile(this->readOnlyBuffer);
+#else
+	::munmap((void*)this->readOnlyBuffer, size_t(this->readOnlyBufferSize));
+#endif
+
+	this->readOnlyBuffer = nullptr;
+	this->readOnlyBufferSize = 0;
+	this->readOffset = 0;
+}
+
+void MappedFileInputStream::SetAccessPattern(AccessPattern accessPattern)
+{
+	if (!this->readOnlyBuffer)
+		return;
+
+	// Windows only takes this hint when the file is opened, which is what our constructor does with it.
+#if !defined _WIN32
+	int advice = MADV_NORMAL;
+	if (accessPattern == SEQUENTIAL)
+		advice = MADV_SEQUENTIAL;
+	else if (accessPattern == RANDOM)
+		advice = MADV_RANDOM;
+
+	::madvise((void*)this->readOnlyBuffer, size_t(this->readOnlyBufferSize), advice);
+#endif
+}
+
+void MappedFileInputStream::Prefetch(uint64_t offset, uint64_t numBytes)
+{
+	if (offset >= this->readOnlyBufferSize)
+		return;
+
+	numBytes = ADL_MIN(numBytes, this->readOnlyBufferSize - offset);
+	if (numBytes == 0)
+		return;
+
+#if defined _WIN32
+	WIN32_MEMORY_RANGE_ENTRY rangeEntry;
+	rangeEntry.VirtualAddress = (PVOID)&this->readOnlyBuffer[offset];
+	rangeEntry.NumberOfBytes = SIZE_T(numBytes);
+	::PrefetchVirtualMemory(::GetCurrentProcess(), 1, &rangeEntry, 0);
+#else
+	// The mapping starts on a page boundary, but the given offset may not, and madvise wants one.
+	uint64_t pageSize = uint64_t(::sysconf(_SC_PAGESIZE));
+	uint64_t alignedOffset = offset - offset % pageSize;
+	::madvise((void*)&this->readOnlyBuffer[alignedOffset], size_t(offset + numBytes - alignedOffset), MADV_WILLNEED);
+#endif
+}
+
+bool MappedFileInputStream::GetFileOffset(const uint8_t* buffer, uint64_t bufferSize, uint64_t& offset) const
+{
+	if (!this->readOnlyBuffer || buffer < this->readOnlyBuffer)
+		return false;
+
+	offset = uint64_t(buffer - this->readOnlyBuffer);
+	return offset <= this->readOnlyBufferSize && bufferSize <= this->readOnlyBufferSize - offset;
+}
+
 //------------------------- WriteOnlyBufferStream -------------------------
 
 WriteOnlyBufferStream::WriteOnlyBufferStream(uint8_t* buffer, uint64_t bufferSize)
@@ -213,13 +789,28 @@ void WriteOnlyBufferStream::Reset()
 
 /*virtual*/ uint64_t WriteOnlyBufferStream::WriteBytesToStream(const uint8_t* buffer, uint64_t bufferSize)
 {
-	uint64_t numBytesWritten = 0;
-	while (numBytesWritten < bufferSize && this->writeOffset < this->writeOnlyBufferSize)
-		this->writeOnlyBuffer[this->writeOffset++] = buffer[numBytesWritten++];
-
+	uint64_t numBytesWritten = ADL_MIN(bufferSize, this->writeOnlyBufferSize - this->writeOffset);
+	::memcpy(&this->writeOnlyBuffer[this->writeOffset], buffer, size_t(numBytesWritten));
+	this->writeOffset += numBytesWritten;
 	return numBytesWritten;
 }
 
+/*virtual*/ uint8_t* WriteOnlyBufferStream::AcquireWrite(uint64_t numBytesWanted, uint64_t& numBytesAvailable)
+{
+	numBytesAvailable = ADL_MIN(numBytesWanted, this->writeOnlyBufferSize - this->writeOffset);
+	return &this->writeOnlyBuffer[this->writeOffset];
+}
+
+/*virtual*/ void WriteOnlyBufferStream::CommitWrite(uint64_t numBytes)
+{
+	this->writeOffset += ADL_MIN(numBytes, this->writeOnlyBufferSize - this->writeOffset);
+}
+
+/*virtual*/ bool WriteOnlyBufferStream::CanAccessInPlace() const
+{
+	return true;
+}
+
 /*virtual*/ uint64_t WriteOnlyBufferStream::ReadBytesFromStream(uint8_t* buffer, uint64_t bufferSize)
 {
 	return 0;
@@ -240,6 +831,15 @@ void WriteOnlyBufferStream::Reset()
 	return this->GetSize() < this->writeOnlyBufferSize;
 }
 
+bool WriteOnlyBufferStream::SetWriteOffset(uint64_t writeOffset)
+{
+	if (writeOffset > this->writeOnlyBufferSize)
+		return false;
+
+	this->writeOffset = writeOffset;
+	return true;
+}
+
 //------------------------- AudioStream -------------------------
 
 AudioStream::AudioStream()
@@ -254,6 +854,12 @@ AudioStream::AudioStream(const AudioData* audioData)
 	this->byteStream = new ReadOnlyBufferStream(audioData->GetAudioBuffer(), audioData->GetAudioBufferSize());
 }
 
+AudioStream::AudioStream(ByteStream* byteStream, const AudioData::Format& format)
+{
+	this->format = format;
+	this->byteStream = byteStream;
+}
+
 /*virtual*/ AudioStream::~AudioStream()
 {
 	delete this->byteStream;
@@ -269,6 +875,11 @@ AudioStream::AudioStream(const AudioData* audioData)
 	return this->byteStream->ReadBytesFromStream(buffer, bufferSize);
 }
 
+/*virtual*/ uint64_t AudioStream::PeekBytesFromStream(uint8_t* buffer, uint64_t bufferSize)
+{
+	return this->byteStream->PeekBytesFromStream(buffer, bufferSize);
+}
+
 /*virtual*/ uint64_t AudioStream::GetSize() const
 {
 	return this->byteStream->GetSize();
@@ -284,6 +895,31 @@ AudioStream::AudioStream(const AudioData* audioData)
 	return this->byteStream->CanWrite();
 }
 
+/*virtual*/ const uint8_t* AudioStream::AcquireRead(uint64_t numBytesWanted, uint64_t& numBytesAvailable)
+{
+	return this->byteStream->AcquireRead(numBytesWanted, numBytesAvailable);
+}
+
+/*virtual*/ void AudioStream::CommitRead(uint64_t numBytes)
+{
+	this->byteStream->CommitRead(numBytes);
+}
+
+/*virtual*/ uint8_t* AudioStream::AcquireWrite(uint64_t numBytesWanted, uint64_t& numBytesAvailable)
+{
+	return this->byteStream->AcquireWrite(numBytesWanted, numBytesAvailable);
+}
+
+/*virtual*/ void AudioStream::CommitWrite(uint64_t numBytes)
+{
+	this->byteStream->CommitWrite(numBytes);
+}
+
+/*virtual*/ bool AudioStream::CanAccessInPlace() const
+{
+	return this->byteStream->CanAccessInPlace();
+}
+
 //------------------------- ThreadSafeAudioStream -------------------------
 
 ThreadSafeAudioStream::ThreadSafeAudioStream(std::shared_ptr<Mutex> mutex)
@@ -307,6 +943,12 @@ ThreadSafeAudioStream::ThreadSafeAudioStream(std::shared_ptr<Mutex> mutex)
 	return AudioStream::ReadBytesFromStream(buffer, bufferSize);
 }
 
+/*virtual*/ uint64_t ThreadSafeAudioStream::PeekBytesFromStream(uint8_t* buffer, uint64_t bufferSize)
+{
+	MutexScopeLock scopeLock(this->mutex.get());
+	return AudioStream::PeekBytesFromStream(buffer, bufferSize);
+}
+
 /*virtual*/ uint64_t ThreadSafeAudioStream::GetSize() const
 {
 	MutexScopeLock scopeLock(this->mutex.get());
@@ -325,47 +967,388 @@ ThreadSafeAudioStream::ThreadSafeAudioStream(std::shared_ptr<Mutex> mutex)
 	return AudioStream::CanWrite();
 }
 
+/*virtual*/ const uint8_t* ThreadSafeAudioStream::AcquireRead(uint64_t numBytesWanted, uint64_t& numBytesAvailable)
+{
+	MutexScopeLock scopeLock(this->mutex.get());
+
+	if (this->readSpanBuffer.size() < numBytesWanted)
+		this->readSpanBuffer.resize(numBytesWanted);
+
+	numBytesAvailable = AudioStream::PeekBytesFromStream(this->readSpanBuffer.data(), numBytesWanted);
+	return this->readSpanBuffer.data();
+}
+
+/*virtual*/ void ThreadSafeAudioStream::CommitRead(uint64_t numBytes)
+{
+	MutexScopeLock scopeLock(this->mutex.get());
+
+	if (numBytes > 0)
+		AudioStream::ReadBytesFromStream(this->readSpanBuffer.data(), numBytes);
+}
+
+/*virtual*/ uint8_t* ThreadSafeAudioStream::AcquireWrite(uint64_t numBytesWanted, uint64_t& numBytesAvailable)
+{
+	MutexScopeLock scopeLock(this->mutex.get());
+
+	if (this->writeSpanBuffer.size() < numBytesWanted)
+		this->writeSpanBuffer.resize(numBytesWanted);
+
+	numBytesAvailable = AudioStream::CanWrite() ? numBytesWanted : 0;
+	return this->writeSpanBuffer.data();
+}
+
+/*virtual*/ void ThreadSafeAudioStream::CommitWrite(uint64_t numBytes)
+{
+	MutexScopeLock scopeLock(this->mutex.get());
+
+	if (numBytes > 0)
+		AudioStream::WriteBytesToStream(this->writeSpanBuffer.data(), numBytes);
+}
+
+/*virtual*/ bool ThreadSafeAudioStream::CanAccessInPlace() const
+{
+	return false;
+}
+
+//------------------------- RingBufferAudioStream -------------------------
+
+RingBufferAudioStream::RingBufferAudioStream(uint64_t capacityBytes)
+{
+	this->capacity = 1;
+	while (this->capacity < capacityBytes)
+		this->capacity <<= 1;
+
+	this->mask = this->capacity - 1;
+	this->ringBuffer = new uint8_t[this->capacity];
+	this->writePosition = 0;
+	this->writerReadPosition = 0;
+	this->readPosition = 0;
+	this->readerWritePosition = 0;
+}
+
+/*virtual*/ RingBufferAudioStream::~RingBufferAudioStream()
+{
+	delete[] this->ringBuffer;
+}
+
+/*virtual*/ uint64_t RingBufferAudioStream::WriteBytesToStream(const uint8_t* buffer, uint64_t bufferSize)
+{
+	// If it doesn't all fit, write only whole frames, so that the reader never gets its channels crossed.
+	uint64_t bytesPerFrame = this->format.BytesPerFrame();
+	uint64_t numBytesFree = this->capacity - this->GetSize();
+	if (bufferSize > numBytesFree && bytesPerFrame > 0)
+		bufferSize = (numBytesFree / bytesPerFrame) * bytesPerFrame;
+
+	// The free space comes in at most two pieces: up to the end of the ring, and then from the start of it.
+	uint64_t numBytesWritten = 0;
+	while (numBytesWritten < bufferSize)
+	{
+		uint64_t numBytesAvailable = 0;
+		uint8_t* region = this->AcquireWrite(bufferSize - numBytesWritten, numBytesAvailable);
+		if (numBytesAvailable == 0)
+			break;
+
+		::memcpy(region, &buffer[numBytesWritten], size_t(numBytesAvailable));
+		this->CommitWrite(numBytesAvailable);
+		numBytesWritten += numBytesAvailable;
+	}
+
+	return numBytesWritten;
+}
+
+/*virtual*/ uint64_t RingBufferAudioStream::ReadBytesFromStream(uint8_t* buffer, uint64_t bufferSize)
+{
+	uint64_t numBytesRead = this->PeekBytesFromStream(buffer, bufferSize);
+	this->CommitRead(numBytesRead);
+	return numBytesRead;
+}
+
+/*virtual*/ uint64_t RingBufferAudioStream::PeekBytesFromStream(uint8_t* buffer, uint64_t bufferSize)
+{
+	uint64_t position = this->readPosition.load(std::memory_order_relaxed);
+	uint64_t numBytesToRead = ADL_MIN(bufferSize, this->GetSize());
+
+	uint64_t offset = position & this->mask;
+	uint64_t numBytesBeforeWrap = ADL_MIN(numBytesToRead, this->capacity - offset);
+	::memcpy(buffer, &this->ringBuffer[offset], size_t(numBytesBeforeWrap));
+	::memcpy(&buffer[numBytesBeforeWrap], this->ringBuffer, size_t(numBytesToRead - numBytesBeforeWrap));
+
+	return numBytesToRead;
+}
+
+/*virtual*/ uint64_t RingBufferAudioStream::GetSize() const
+{
+	uint64_t readPosition = this->readPosition.load(std::memory_order_acquire);
+	uint64_t writePosition = this->writePosition.load(std::memory_order_acquire);
+	return (writePosition > readPosition) ? (writePosition - readPosition) : 0;
+}
+
+/*virtual*/ bool RingBufferAudioStream::CanRead()
+{
+	return this->GetSize() > 0;
+}
+
+/*virtual*/ bool RingBufferAudioStream::CanWrite()
+{
+	return this->GetSize() < this->capacity;
+}
+
+/*virtual*/ const uint8_t* RingBufferAudioStream::AcquireRead(uint64_t numBytesWanted, uint64_t& numBytesAvailable)
+{
+	uint64_t position = this->readPosition.load(std::memory_order_relaxed);
+	if (position + numBytesWanted > this->readerWritePosition)
+		this->readerWritePosition = this->writePosition.load(std::memory_order_acquire);
+
+	uint64_t offset = position & this->mask;
+	numBytesAvailable = ADL_MIN(numBytesWanted, this->readerWritePosition - position);
+	numBytesAvailable = ADL_MIN(numBytesAvailable, this->capacity - offset);
+	return &this->ringBuffer[offset];
+}
+
+/*virtual*/ void RingBufferAudioStream::CommitRead(uint64_t numBytes)
+{
+	this->readPosition.store(this->readPosition.load(std::memory_order_relaxed) + numBytes, std::memory_order_release);
+}
+
+/*virtual*/ uint8_t* RingBufferAudioStream::AcquireWrite(uint64_t numBytesWanted, uint64_t& numBytesAvailable)
+{
+	uint64_t position = this->writePosition.load(std::memory_order_relaxed);
+	if (position + numBytesWanted > this->writerReadPosition + this->capacity)
+		this->writerReadPosition = this->readPosition.load(std::memory_order_acquire);
+
+	uint64_t offset = position & this->mask;
+	numBytesAvailable = ADL_MIN(numBytesWanted, this->writerReadPosition + this->capacity - position);
+	numBytesAvailable = ADL_MIN(numBytesAvailable, this->capacity - offset);
+	return &this->ringBuffer[offset];
+}
+
+/*virtual*/ void RingBufferAudioStream::CommitWrite(uint64_t numBytes)
+{
+	this->writePosition.store(this->writePosition.load(std::memory_order_relaxed) + numBytes, std::memory_order_release);
+}
+
+/*virtual*/ bool RingBufferAudioStream::CanAccessInPlace() const
+{
+	return true;
+}
+
+//------------------------- FileAudioStream -------------------------
+
+FileAudioStream::FileAudioStream(std::shared_ptr<MappedFileInputStream> mappedFile, uint64_t dataOffset, uint64_t dataSize, const AudioData::Format& format, bool byteSwapped)
+	: AudioStream(new ReadOnlyBufferStream(mappedFile->GetBuffer() + dataOffset, dataSize - dataSize % ADL_MAX(format.BytesPerFrame(), 1)), format)
+{
+	this->mappedFile = mappedFile;
+	this->dataStream = static_cast<ReadOnlyBufferStream*>(this->byteStream);
+	this->byteSwapped = byteSwapped && format.BytesPerSample() > 1;
+}
+
+/*virtual*/ FileAudioStream::~FileAudioStream()
+{
+}
+
+/*virtual*/ uint64_t FileAudioStream::ReadBytesFromStream(uint8_t* buffer, uint64_t bufferSize)
+{
+	uint64_t numBytesRead = this->PeekBytesFromStream(buffer, bufferSize);
+	this->dataStream->CommitRead(numBytesRead);
+	return numBytesRead;
+}
+
+/*virtual*/ uint64_t FileAudioStream::PeekBytesFromStream(uint8_t* buffer, uint64_t bufferSize)
+{
+	if (!this->byteSwapped)
+		return this->dataStream->PeekBytesFromStream(buffer, bufferSize);
+
+	// The read may start or end part way into a sample, but we always have the whole sample to swap from.
+	uint64_t numBytesPeeked = ADL_MIN(bufferSize, this->dataStream->GetSize());
+	const uint8_t* data = this->dataStream->GetBuffer();
+	uint64_t bytesPerSample = this->format.BytesPerSample();
+	uint64_t offset = this->dataStream->GetReadOffset();
+	uint64_t byteInSample = offset % bytesPerSample;
+	uint64_t sampleOffset = offset - byteInSample;
+
+	for (uint64_t i = 0; i < numBytesPeeked; i++)
+	{
+		buffer[i] = data[sampleOffset + bytesPerSample - 1 - byteInSample];
+		if (++byteInSample == bytesPerSample)
+		{
+			byteInSample = 0;
+			sampleOffset += bytesPerSample;
+		}
+	}
+
+	return numBytesPeeked;
+}
+
+/*virtual*/ const uint8_t* FileAudioStream::AcquireRead(uint64_t numBytesWanted, uint64_t& numBytesAvailable)
+{
+	// Swapped samples can't be handed out in place, so they go through the peeking fallback.
+	if (this->byteSwapped)
+		return ByteStream::AcquireRead(numBytesWanted, numBytesAvailable);
+
+	return this->dataStream->AcquireRead(numBytesWanted, numBytesAvailable);
+}
+
+/*virtual*/ void FileAudioStream::CommitRead(uint64_t numBytes)
+{
+	this->dataStream->CommitRead(numBytes);
+}
+
+/*virtual*/ bool FileAudioStream::CanAccessInPlace() const
+{
+	return !this->byteSwapped;
+}
+
+uint64_t FileAudioStream::GetNumFrames() const
+{
+	return (this->dataStream->GetSize() + this->dataStream->GetReadOffset()) / this->format.BytesPerFrame();
+}
+
+uint64_t FileAudioStream::GetFramePosition() const
+{
+	return this->dataStream->GetReadOffset() / this->format.BytesPerFrame();
+}
+
+bool FileAudioStream::SeekFrame(uint64_t frameNumber)
+{
+	uint64_t offset = frameNumber * this->format.BytesPerFrame();
+	if (!this->dataStream->SetReadOffset(offset))
+		return false;
+
+	// A second or so should be plenty to get ahead of whoever is reading.
+	uint64_t dataOffset = uint64_t(this->dataStream->GetBuffer() - this->mappedFile->GetBuffer());
+	this->mappedFile->Prefetch(dataOffset + offset, this->format.BytesPerSecond());
+	return true;
+}
+
 //------------------------- MemoryStream -------------------------
 
-MemoryStream::MemoryStream()
+MemoryStream::MemoryStream(uint64_t chunkSize /*= 5 * 1024*/, double chunkGrowthFactor /*= 1.0*/, uint64_t maxChunkSize /*= 4 * 1024 * 1024*/)
 {
-	this->chunkSize = 5 * 1024;
+	this->firstChunk = nullptr;
+	this->lastChunk = nullptr;
+	this->firstFreeChunk = nullptr;
+	this->numFreeChunks = 0;
+	this->maxFreeChunks = 4;
+	this->totalSize = 0;
+	this->numChunksAllocated = 0;
+	this->SetChunkSize(chunkSize, chunkGrowthFactor, maxChunkSize);
 }
 
 /*virtual*/ MemoryStream::~MemoryStream()
 {
 	this->Clear();
+
+	while (this->firstFreeChunk)
+	{
+		Chunk* chunk = this->firstFreeChunk;
+		this->firstFreeChunk = chunk->nextChunk;
+		delete chunk;
+	}
 }
 
 void MemoryStream::Clear()
 {
-	while (this->chunkList.size() > 0)
+	while (this->firstChunk)
+	{
+		Chunk* chunk = this->firstChunk;
+		this->firstChunk = chunk->nextChunk;
+		this->ReleaseChunk(chunk);
+	}
+
+	this->lastChunk = nullptr;
+	this->totalSize = 0;
+	this->chunkSize = this->initialChunkSize;
+}
+
+void MemoryStream::SetChunkSize(uint64_t chunkSize, double chunkGrowthFactor /*= 1.0*/, uint64_t maxChunkSize /*= 4 * 1024 * 1024*/)
+{
+	this->initialChunkSize = ADL_MAX(chunkSize, 1);
+	this->chunkSize = this->initialChunkSize;
+	this->chunkGrowthFactor = ADL_MAX(chunkGrowthFactor, 1.0);
+	this->maxChunkSize = ADL_MAX(maxChunkSize, this->initialChunkSize);
+}
+
+void MemoryStream::SetMaxFreeChunks(uint32_t maxFreeChunks)
+{
+	this->maxFreeChunks = maxFreeChunks;
+
+	while (this->numFreeChunks > this->maxFreeChunks)
+	{
+		Chunk* chunk = this->firstFreeChunk;
+		this->firstFreeChunk = chunk->nextChunk;
+		this->numFreeChunks--;
+		delete chunk;
+	}
+}
+
+MemoryStream::Chunk* MemoryStream::AcquireChunk()
+{
+	Chunk* chunk = nullptr;
+
+	// A recycled chunk will do as long as it's not smaller than what we'd make now.
+	if (this->firstFreeChunk && this->firstFreeChunk->bufferSize >= this->chunkSize)
+	{
+		chunk = this->firstFreeChunk;
+		this->firstFreeChunk = chunk->nextChunk;
+		this->numFreeChunks--;
+		chunk->startOffset = 0;
+		chunk->endOffset = 0;
+	}
+	else
+	{
+		chunk = new Chunk(this->chunkSize);
+		this->numChunksAllocated++;
+		this->chunkSize = ADL_MIN(uint64_t(double(this->chunkSize) * this->chunkGrowthFactor), this->maxChunkSize);
+	}
+
+	chunk->nextChunk = nullptr;
+	return chunk;
+}
+
+void MemoryStream::ReleaseChunk(Chunk* chunk)
+{
+	if (this->numFreeChunks >= this->maxFreeChunks)
 	{
-		auto iter = this->chunkList.begin();
-		Chunk* chunk = *iter;
 		delete chunk;
-		this->chunkList.erase(iter);
+		return;
+	}
+
+	// Keep the biggest chunks at the front, since they're the most likely to be reusable.
+	if (this->firstFreeChunk && this->firstFreeChunk->bufferSize > chunk->bufferSize)
+	{
+		chunk->nextChunk = this->firstFreeChunk->nextChunk;
+		this->firstFreeChunk->nextChunk = chunk;
+	}
+	else
+	{
+		chunk->nextChunk = this->firstFreeChunk;
+		this->firstFreeChunk = chunk;
 	}
+
+	this->numFreeChunks++;
 }
 
 /*virtual*/ uint64_t MemoryStream::WriteBytesToStream(const uint8_t* buffer, uint64_t bufferSize)
 {
 	uint64_t numBytesWritten = 0;
 
-	if(this->chunkList.size() == 0)
-		this->chunkList.push_back(new Chunk(this->chunkSize));
-
 	while (numBytesWritten < bufferSize)
 	{
-		Chunk* chunk = this->chunkList.back();
-		
-		uint64_t numChunkBytesWritten = chunk->WriteToChunk(&buffer[numBytesWritten], bufferSize - numBytesWritten);
+		uint64_t numChunkBytesWritten = this->lastChunk ? this->lastChunk->WriteToChunk(&buffer[numBytesWritten], bufferSize - numBytesWritten) : 0;
 		if (numChunkBytesWritten > 0)
 			numBytesWritten += numChunkBytesWritten;
 		else
-			this->chunkList.push_back(new Chunk(this->chunkSize));
+		{
+			Chunk* chunk = this->AcquireChunk();
+			if (this->lastChunk)
+				this->lastChunk->nextChunk = chunk;
+			else
+				this->firstChunk = chunk;
+			this->lastChunk = chunk;
+		}
 	}
 
+	this->totalSize += numBytesWritten;
 	return numBytesWritten;
 }
 
@@ -373,36 +1356,122 @@ void MemoryStream::Clear()
 {
 	uint64_t numBytesRead = 0;
 
-	while (numBytesRead < bufferSize && this->chunkList.size() > 0)
+	while (numBytesRead < bufferSize && this->firstChunk)
 	{
-		Chunk* chunk = *this->chunkList.begin();
+		Chunk* chunk = this->firstChunk;
 
 		uint64_t numChunkBytesRead = chunk->ReadFromChunk(&buffer[numBytesRead], bufferSize - numBytesRead);
-		if (numChunkBytesRead > 0)
-			numBytesRead += numChunkBytesRead;
-		else
+		numBytesRead += numChunkBytesRead;
+
+		// Once a chunk is drained, it can go back into circulation, unless it's the one we're still writing to.
+		if (chunk->GetSize() == 0)
 		{
-			delete chunk;
-			this->chunkList.erase(this->chunkList.begin());
+			if (chunk == this->lastChunk)
+			{
+				chunk->startOffset = 0;
+				chunk->endOffset = 0;
+				break;
+			}
+
+			this->firstChunk = chunk->nextChunk;
+			this->ReleaseChunk(chunk);
 		}
 	}
 
+	this->totalSize -= numBytesRead;
 	return numBytesRead;
 }
 
+/*virtual*/ uint64_t MemoryStream::PeekBytesFromStream(uint8_t* buffer, uint64_t bufferSize)
+{
+	uint64_t numBytesPeeked = 0;
+
+	for (const Chunk* chunk = this->firstChunk; chunk && numBytesPeeked < bufferSize; chunk = chunk->nextChunk)
+	{
+		uint64_t numChunkBytes = ADL_MIN(chunk->GetSize(), bufferSize - numBytesPeeked);
+		::memcpy(&buffer[numBytesPeeked], &chunk->buffer[chunk->startOffset], size_t(numChunkBytes));
+		numBytesPeeked += numChunkBytes;
+	}
+
+	return numBytesPeeked;
+}
+
 /*virtual*/ uint64_t MemoryStream::GetSize() const
 {
-	uint64_t totalSizeBytes = 0;
+	return this->totalSize;
+}
+
+/*virtual*/ const uint8_t* MemoryStream::AcquireRead(uint64_t numBytesWanted, uint64_t& numBytesAvailable)
+{
+	numBytesAvailable = 0;
+	if (!this->firstChunk)
+		return nullptr;
+
+	numBytesAvailable = ADL_MIN(numBytesWanted, this->firstChunk->GetSize());
+	return &this->firstChunk->buffer[this->firstChunk->startOffset];
+}
+
+/*virtual*/ void MemoryStream::CommitRead(uint64_t numBytes)
+{
+	Chunk* chunk = this->firstChunk;
+	if (!chunk)
+		return;
 
-	for (const Chunk* chunk : this->chunkList)
-		totalSizeBytes += chunk->GetSize();
+	numBytes = ADL_MIN(numBytes, chunk->GetSize());
+	chunk->startOffset += numBytes;
+	this->totalSize -= numBytes;
 
-	return totalSizeBytes;
+	// This is the same as what ReadBytesFromStream does with a drained chunk.
+	if (chunk->GetSize() == 0)
+	{
+		if (chunk == this->lastChunk)
+		{
+			chunk->startOffset = 0;
+			chunk->endOffset = 0;
+		}
+		else
+		{
+			this->firstChunk = chunk->nextChunk;
+			this->ReleaseChunk(chunk);
+		}
+	}
+}
+
+/*virtual*/ uint8_t* MemoryStream::AcquireWrite(uint64_t numBytesWanted, uint64_t& numBytesAvailable)
+{
+	// Start a new chunk if the last one is full, so that there's always room.
+	if (!this->lastChunk || this->lastChunk->endOffset == this->lastChunk->bufferSize)
+	{
+		Chunk* chunk = this->AcquireChunk();
+		if (this->lastChunk)
+			this->lastChunk->nextChunk = chunk;
+		else
+			this->firstChunk = chunk;
+		this->lastChunk = chunk;
+	}
+
+	numBytesAvailable = ADL_MIN(numBytesWanted, this->lastChunk->bufferSize - this->lastChunk->endOffset);
+	return &this->lastChunk->buffer[this->lastChunk->endOffset];
+}
+
+/*virtual*/ void MemoryStream::CommitWrite(uint64_t numBytes)
+{
+	if (!this->lastChunk)
+		return;
+
+	numBytes = ADL_MIN(numBytes, this->lastChunk->bufferSize - this->lastChunk->endOffset);
+	this->lastChunk->endOffset += numBytes;
+	this->totalSize += numBytes;
+}
+
+/*virtual*/ bool MemoryStream::CanAccessInPlace() const
+{
+	return true;
 }
 
 /*virtual*/ bool MemoryStream::CanRead()
 {
-	return this->GetSize() > 0;
+	return this->totalSize > 0;
 }
 
 /*virtual*/ bool MemoryStream::CanWrite()
@@ -414,11 +1483,12 @@ void MemoryStream::Clear()
 
 MemoryStream::Chunk::Chunk(uint64_t bufferSize)
 {
+	// There's no need to clear the buffer, since nothing is ever read from it that wasn't written to it first.
 	this->bufferSize = bufferSize;
-	this->buffer = new uint8_t[(uint32_t)this->bufferSize];
-	::memset(this->buffer, 0, (uint32_t)this->bufferSize);
+	this->buffer = new uint8_t[this->bufferSize];
 	this->startOffset = 0;
 	this->endOffset = 0;
+	this->nextChunk = nullptr;
 }
 
 /*virtual*/ MemoryStream::Chunk::~Chunk()
@@ -428,20 +1498,18 @@ MemoryStream::Chunk::Chunk(uint64_t bufferSize)
 
 uint64_t MemoryStream::Chunk::WriteToChunk(const uint8_t* givenBuffer, uint64_t givenBufferSize)
 {
-	uint64_t i = 0;
-	while (this->endOffset < this->bufferSize && i < givenBufferSize)
-		this->buffer[this->endOffset++] = givenBuffer[i++];
-
-	return i;
+	uint64_t numBytes = ADL_MIN(givenBufferSize, this->bufferSize - this->endOffset);
+	::memcpy(&this->buffer[this->endOffset], givenBuffer, size_t(numBytes));
+	this->endOffset += numBytes;
+	return numBytes;
 }
 
 uint64_t MemoryStream::Chunk::ReadFromChunk(uint8_t* givenBuffer, uint64_t givenBufferSize)
 {
-	uint64_t i = 0;
-	while (this->startOffset < this->endOffset && i < givenBufferSize)
-		givenBuffer[i++] = this->buffer[this->startOffset++];
-
-	return i;
+	uint64_t numBytes = ADL_MIN(givenBufferSize, this->endOffset - this->startOffset);
+	::memcpy(givenBuffer, &this->buffer[this->startOffset], size_t(numBytes));
+	this->startOffset += numBytes;
+	return numBytes;
 }
 
 uint64_t MemoryStream::Chunk::GetSize() const
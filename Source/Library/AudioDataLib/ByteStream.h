@@ -2,6 +2,10 @@
 
 #include "AudioDataLib/Common.h"
 #include "AudioDataLib/FileDatas/AudioData.h"
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 namespace AudioDataLib
 {
@@ -62,6 +66,49 @@ namespace AudioDataLib
 		 */
 		virtual bool CanWrite() = 0;
 
+		/**
+		 * Get the next contiguous region of the stream that can be read, so that it can be worked on in place.  Nothing is
+		 * consumed until CommitRead is called.  The region may be smaller than what's wanted even if the stream has more to
+		 * give; it just means that the rest isn't next to it in memory, so call again after committing to get it.
+		 *
+		 * Streams that keep their bytes in memory hand out their own memory.  Others fall back on peeking into a buffer
+		 * of ours, which costs a copy, but works for any stream that supports PeekBytesFromStream.  See CanAccessInPlace.
+		 *
+		 * @param[in] numBytesWanted This is the most we'll return.
+		 * @param[out] numBytesAvailable This is the size of the returned region.  It's zero if there's nothing to read.
+		 * @return A pointer to the region is returned.  It's good until the stream is next read, written or committed.
+		 */
+		virtual const uint8_t* AcquireRead(uint64_t numBytesWanted, uint64_t& numBytesAvailable);
+
+		/**
+		 * Consume the given number of bytes from the front of the region returned by AcquireRead.
+		 * This must be no more than what AcquireRead said was available.
+		 */
+		virtual void CommitRead(uint64_t numBytes);
+
+		/**
+		 * Get the next contiguous region of the stream that can be written, so that it can be filled in place.  Nothing is
+		 * added to the stream until CommitWrite is called.  As with AcquireRead, the region may be smaller than what's wanted.
+		 * The fallback here hands out a buffer of ours, which CommitWrite then writes to the stream the usual way.
+		 *
+		 * @param[in] numBytesWanted This is the most we'll return.
+		 * @param[out] numBytesAvailable This is the size of the returned region.  It's zero if the stream can't take any more.
+		 * @return A pointer to the region is returned.  It's good until the stream is next read, written or committed.
+		 */
+		virtual uint8_t* AcquireWrite(uint64_t numBytesWanted, uint64_t& numBytesAvailable);
+
+		/**
+		 * Add the given number of bytes from the front of the region returned by AcquireWrite to the stream.
+		 * This must be no more than what AcquireWrite said was available.
+		 */
+		virtual void CommitWrite(uint64_t numBytes);
+
+		/**
+		 * Tell the caller whether AcquireRead and AcquireWrite hand out the stream's own memory.  If not, they still work,
+		 * but cost a copy, so a caller that's only after speed may as well use ReadBytesFromStream and WriteBytesToStream.
+		 */
+		virtual bool CanAccessInPlace() const;
+
 		/**
 		 * Read an amount of data from the stream equal to the size of the given type.
 		 * Byte-swapping may be a consideration here.  Note that a failed read could
@@ -87,6 +134,10 @@ namespace AudioDataLib
 			uint64_t numBytesWritten = this->WriteBytesToStream((const uint8_t*)value, sizeof(T));
 			return numBytesWritten == sizeof(T);
 		}
+
+	protected:
+		std::vector<uint8_t> readSpanBuffer;		///< This is where the fallback version of AcquireRead puts things.
+		std::vector<uint8_t> writeSpanBuffer;		///< This is where the fallback version of AcquireWrite puts things.
 	};
 
 	/**
@@ -99,7 +150,7 @@ namespace AudioDataLib
 		virtual ~FileStream();
 
 		bool IsOpen();
-		void Close();
+		virtual void Close();
 
 	protected:
 		FILE* fp;
@@ -107,20 +158,64 @@ namespace AudioDataLib
 
 	/**
 	 * @brief This is a file stream that can be used to read bytes from a file.
+	 *
+	 * Reads are served out of a read-ahead buffer of ours, which is filled a block at a time, so reading a file a few
+	 * bytes at a time costs about the same as reading it in big blocks.  Reads bigger than the buffer go straight to
+	 * the file.  The size of the file is taken once, when it's opened, and we keep track of where we are in it ourselves,
+	 * so GetSize and CanRead never touch the file.  This does mean that the file shouldn't grow while we're reading it.
+	 *
+	 * If asked, we can also keep a thread reading the next block of the file while the current one is being consumed.
+	 * That only pays off when the reader has real work to do between reads, but then it hides most of the wait on the disk.
 	 */
 	class AUDIO_DATA_LIB_API FileInputStream : public FileStream
 	{
 	public:
-		FileInputStream(const char* filePath);
+		/**
+		 * @param[in] filePath This is the file to open for reading.
+		 * @param[in] readAheadSize This is how many bytes we read from the file at a time.
+		 * @param[in] prefetch If true, a thread of ours reads the next block of the file ahead of time.
+		 */
+		FileInputStream(const char* filePath, uint64_t readAheadSize = 64 * 1024, bool prefetch = false);
 		virtual ~FileInputStream();
 
 		virtual uint64_t WriteBytesToStream(const uint8_t* buffer, uint64_t bufferSize) override;
 		virtual uint64_t ReadBytesFromStream(uint8_t* buffer, uint64_t bufferSize) override;
+		virtual uint64_t PeekBytesFromStream(uint8_t* buffer, uint64_t bufferSize) override;
 
 		virtual uint64_t GetSize() const override;
 
 		virtual bool CanRead() override;
 		virtual bool CanWrite() override;
+
+		virtual const uint8_t* AcquireRead(uint64_t numBytesWanted, uint64_t& numBytesAvailable) override;
+		virtual void CommitRead(uint64_t numBytes) override;
+		virtual bool CanAccessInPlace() const override;
+
+		virtual void Close() override;
+
+		bool IsPrefetching() const { return this->prefetchThread != nullptr; }
+
+	protected:
+
+		uint64_t FillReadAheadBuffer(uint64_t numBytesWanted);
+		uint64_t ReadFromFile(uint8_t* buffer, uint64_t bufferSize);
+		void PrefetchThreadMain();
+		void StopPrefetching();
+
+		uint64_t fileSize;
+		uint64_t filePosition;					///< This is how much of the file has been consumed by the reader, not how much we've read from it.
+		std::vector<uint8_t> readAheadBuffer;
+		uint64_t readAheadStart;				///< This is where the unconsumed part of the read-ahead buffer starts.
+		uint64_t readAheadEnd;					///< This is where the unconsumed part of the read-ahead buffer ends.
+
+		std::thread* prefetchThread;
+		std::mutex* prefetchMutex;
+		std::condition_variable* prefetchCondition;
+		std::vector<uint8_t> prefetchBuffer;	///< The prefetch thread reads into this, and we take from it.
+		uint64_t prefetchStart;
+		uint64_t prefetchEnd;
+		bool prefetchPending;					///< This is true while the prefetch thread owns the prefetch buffer (and the file.)
+		bool prefetchQuit;
 	};
 
 	/**
@@ -141,6 +236,80 @@ namespace AudioDataLib
 		virtual bool CanWrite() override;
 	};
 
+	/**
+	 * @brief This is a file output stream that never makes the writer wait on the disk.
+	 *
+	 * Writes are copied into one of a fixed number of blocks, and whenever a block fills up, it's queued for a thread
+	 * of ours to write to the file.  All the blocks are allocated up front, so we use the same amount of memory no matter
+	 * how long we run, which is what you want for recording from an audio callback for hours on end.
+	 *
+	 * If the disk falls so far behind that every block is queued, then what happens depends on how we were made.
+	 * By default, a write that doesn't fit is dropped whole (never partly, so audio frames are never split), and counted,
+	 * so that the writer never waits.  Otherwise, the writer waits for room, and we count that instead.  See GetStats.
+	 *
+	 * Only one thread should write to us at a time.  Flush and Close should be called by the writer, or once it's done.
+	 */
+	class AUDIO_DATA_LIB_API AsyncFileOutputStream : public FileOutputStream
+	{
+	public:
+		/**
+		 * @param[in] filePath This is the file to create.
+		 * @param[in] blockSize This is how much is handed to the disk at a time.
+		 * @param[in] numBlocks This is how many blocks we have, counting the one being filled.  It's at least two.
+		 * @param[in] waitWhenFull If true, a write waits for room rather than being dropped when every block is queued.
+		 */
+		AsyncFileOutputStream(const char* filePath, uint64_t blockSize = 256 * 1024, uint32_t numBlocks = 3, bool waitWhenFull = false);
+		virtual ~AsyncFileOutputStream();
+
+		virtual uint64_t WriteBytesToStream(const uint8_t* buffer, uint64_t bufferSize) override;
+
+		virtual void Close() override;
+
+		/**
+		 * Queue whatever has been written so far, and wait for it all to reach the file.
+		 */
+		void Flush();
+
+		/**
+		 * These are the numbers we keep, which tell how well the disk is keeping up.
+		 */
+		struct Stats
+		{
+			uint64_t numBytesWritten;		///< This is how much has made it to the file.
+			uint64_t numBytesDropped;		///< This is how much was thrown away because there was no room for it.
+			uint64_t numWritesDropped;		///< This is how many writes were thrown away because there was no room for them.
+			uint64_t numStalls;				///< This is how many times a writer had to wait for room.
+			uint64_t numWriteErrors;		///< This is how many blocks didn't make it to the file in full.
+			uint32_t maxBlocksQueued;		///< This is the most blocks that were ever waiting on the disk at once.
+		};
+
+		Stats GetStats() const;
+
+	protected:
+
+		void WriterThreadMain();
+		bool QueueFillBlock(bool wait);
+
+		struct Block
+		{
+			std::vector<uint8_t> data;
+			uint64_t size;
+		};
+
+		std::vector<Block> blockArray;		///< The blocks are filled and written in order, round and round.
+		uint32_t fillBlockIndex;			///< This is the block being written to by the writer.  It's always just past the queued ones.
+		uint32_t writeBlockIndex;			///< This is the oldest queued block, which our thread writes next.
+		uint32_t numBlocksQueued;
+		bool waitWhenFull;
+		bool quit;
+		Stats stats;
+
+		std::thread* writerThread;
+		std::mutex* mutex;
+		std::condition_variable* queuedCondition;		///< This is signaled when a block is queued, or when it's time to quit.
+		std::condition_variable* writtenCondition;		///< This is signaled when a queued block has been written.
+	};
+
 	/**
 	 * @brief This is a stream that can be used to read bytes from any location in memory.
 	 */
@@ -160,10 +329,15 @@ namespace AudioDataLib
 		virtual bool CanRead() override;
 		virtual bool CanWrite() override;
 
+		virtual const uint8_t* AcquireRead(uint64_t numBytesWanted, uint64_t& numBytesAvailable) override;
+		virtual void CommitRead(uint64_t numBytes) override;
+		virtual bool CanAccessInPlace() const override;
+
 		uint64_t GetReadOffset() const { return this->readOffset; }
 		bool SetReadOffset(uint64_t readOffset);
 
 		const uint8_t* GetBuffer() const { return this->readOnlyBuffer; }
+		uint64_t GetBufferSize() const { return this->readOnlyBufferSize; }
 
 		void Reset();
 
@@ -173,6 +347,50 @@ namespace AudioDataLib
 		uint64_t readOffset;
 	};
 
+	/**
+	 * @brief This is a read-only stream over a file that has been mapped into memory.
+	 *
+	 * Unlike the FileInputStream class, nothing is copied out of the file until someone asks for it, and
+	 * AcquireRead hands out the mapped memory directly, so a reader like the ChunkParser class can work on
+	 * the file in place.  The OS pages the file in as it's touched, and can be told how we're going to touch
+	 * it so that it reads ahead (or doesn't) accordingly.  See SetAccessPattern.
+	 *
+	 * Empty files can't be mapped, so IsOpen returns false for them.
+	 */
+	class AUDIO_DATA_LIB_API MappedFileInputStream : public ReadOnlyBufferStream
+	{
+	public:
+		enum AccessPattern
+		{
+			NORMAL,			///< Let the OS decide how much to read ahead.
+			SEQUENTIAL,		///< The file will be read from front to back, so read ahead aggressively and drop pages once we're past them.
+			RANDOM			///< The file will be read here and there, so don't bother reading ahead.
+		};
+
+		MappedFileInputStream(const char* filePath, AccessPattern accessPattern = SEQUENTIAL);
+		virtual ~MappedFileInputStream();
+
+		bool IsOpen();
+		void Close();
+
+		/**
+		 * Tell the OS how the rest of the file is going to be read.  This is only a hint.
+		 */
+		void SetAccessPattern(AccessPattern accessPattern);
+
+		/**
+		 * Tell the OS that the given range of the file will be needed soon, so that it can start paging it in now.
+		 * This is only a hint.
+		 */
+		void Prefetch(uint64_t offset, uint64_t numBytes);
+
+		/**
+		 * If the given memory lies entirely within our mapping, return true and tell the caller where in the file it is.
+		 * This is how whoever parsed the file in place can remember where something was, to read it again later.
+		 */
+		bool GetFileOffset(const uint8_t* buffer, uint64_t bufferSize, uint64_t& offset) const;
+	};
+
 	/**
 	 * @brief This is stream that can be used to write bytes to any location in memory.
 	 */
@@ -190,8 +408,12 @@ namespace AudioDataLib
 		virtual bool CanRead() override;
 		virtual bool CanWrite() override;
 
+		virtual uint8_t* AcquireWrite(uint64_t numBytesWanted, uint64_t& numBytesAvailable) override;
+		virtual void CommitWrite(uint64_t numBytes) override;
+		virtual bool CanAccessInPlace() const override;
+
 		uint64_t GetWriteOffset() const { return this->writeOffset; }
-		bool SetWriteOffset(uint64_t readOffset);
+		bool SetWriteOffset(uint64_t writeOffset);
 
 		const uint8_t* GetBuffer() const { return this->writeOnlyBuffer; }
 
@@ -221,16 +443,28 @@ namespace AudioDataLib
 
 		virtual uint64_t WriteBytesToStream(const uint8_t* buffer, uint64_t bufferSize) override;
 		virtual uint64_t ReadBytesFromStream(uint8_t* buffer, uint64_t bufferSize) override;
+		virtual uint64_t PeekBytesFromStream(uint8_t* buffer, uint64_t bufferSize) override;
 
 		virtual uint64_t GetSize() const override;
 
 		virtual bool CanRead() override;
 		virtual bool CanWrite() override;
 
+		virtual const uint8_t* AcquireRead(uint64_t numBytesWanted, uint64_t& numBytesAvailable) override;
+		virtual void CommitRead(uint64_t numBytes) override;
+		virtual uint8_t* AcquireWrite(uint64_t numBytesWanted, uint64_t& numBytesAvailable) override;
+		virtual void CommitWrite(uint64_t numBytes) override;
+		virtual bool CanAccessInPlace() const override;
+
 		const AudioData::Format& GetFormat() const { return this->format; }
 		void SetFormat(const AudioData::Format& format) { this->format = format; }
 
 	protected:
+		/**
+		 * Derivatives can give us a stream of their own to stand in front of, which we then own.
+		 */
+		AudioStream(ByteStream* byteStream, const AudioData::Format& format);
+
 		AudioData::Format format;
 		ByteStream* byteStream;
 	};
@@ -241,7 +475,9 @@ namespace AudioDataLib
 	 * As such, it is a good candidate for connecting any AudioDataLib class that produces or consumes audio
 	 * to some other API that wants to consume or produce audio, respectively.  For example, an audio callback
 	 * (which typically runs on its own time-sensative thread) would read from such a stream while the main
-	 * thread can write to the stream.
+	 * thread can write to the stream.  Note, though, that every call takes a lock and that the underlying
+	 * memory stream allocates as it grows.  If there's just one reader and one writer, the RingBufferAudioStream
+	 * class does the same job without either of those.
 	 */
 	class AUDIO_DATA_LIB_API ThreadSafeAudioStream : public AudioStream
 	{
@@ -251,35 +487,213 @@ namespace AudioDataLib
 
 		virtual uint64_t WriteBytesToStream(const uint8_t* buffer, uint64_t bufferSize) override;
 		virtual uint64_t ReadBytesFromStream(uint8_t* buffer, uint64_t bufferSize) override;
+		virtual uint64_t PeekBytesFromStream(uint8_t* buffer, uint64_t bufferSize) override;
 
 		virtual uint64_t GetSize() const override;
 
 		virtual bool CanRead() override;
 		virtual bool CanWrite() override;
 
+		// The other thread could get at the underlying stream's memory while it's being worked on in place, so these always copy.
+		// Reading and writing stage through different buffers, so the reader and the writer never share one.
+
+		virtual const uint8_t* AcquireRead(uint64_t numBytesWanted, uint64_t& numBytesAvailable) override;
+		virtual void CommitRead(uint64_t numBytes) override;
+		virtual uint8_t* AcquireWrite(uint64_t numBytesWanted, uint64_t& numBytesAvailable) override;
+		virtual void CommitWrite(uint64_t numBytes) override;
+		virtual bool CanAccessInPlace() const override;
+
 	protected:
 		std::shared_ptr<Mutex> mutex;
 	};
 
+	/**
+	 * @brief This is a fixed-size, lock-free audio stream for exactly one writer thread and one reader thread.
+	 *
+	 * It can be used anywhere the ThreadSafeAudioStream class is, but neither side ever waits on the other, and
+	 * nothing is allocated after construction, so it's a better fit for feeding an audio callback.  The catch is
+	 * that it can fill up: a write only writes what fits, so the capacity should be comfortably more than the
+	 * most audio you ever intend to have buffered.
+	 *
+	 * Besides the usual read and write calls, each side can work directly in the ring's memory.  AcquireRead (or
+	 * AcquireWrite) returns the next contiguous region that can be read (or written), and CommitRead (or CommitWrite)
+	 * says how much of it was used.  Only the reader may call the read methods (including GetSize and CanRead, though
+	 * these are fine to call from the writer for a momentary estimate), and only the writer may call the write methods.
+	 */
+	class AUDIO_DATA_LIB_API RingBufferAudioStream : public AudioStream
+	{
+	public:
+		/**
+		 * @param[in] capacityBytes This is the most that can be buffered at once.  It gets rounded up to a power of two.
+		 */
+		RingBufferAudioStream(uint64_t capacityBytes);
+		virtual ~RingBufferAudioStream();
+
+		virtual uint64_t WriteBytesToStream(const uint8_t* buffer, uint64_t bufferSize) override;
+		virtual uint64_t ReadBytesFromStream(uint8_t* buffer, uint64_t bufferSize) override;
+		virtual uint64_t PeekBytesFromStream(uint8_t* buffer, uint64_t bufferSize) override;
+
+		virtual uint64_t GetSize() const override;
+
+		virtual bool CanRead() override;
+		virtual bool CanWrite() override;
+
+		/**
+		 * Return the most that can be buffered at once.
+		 */
+		uint64_t GetCapacity() const { return this->capacity; }
+
+		/**
+		 * Get the next contiguous region of buffered data.  This may be less than is buffered in all, if the data wraps around the end of the ring.
+		 *
+		 * @param[in] numBytesWanted This is the most we'll return.
+		 * @param[out] numBytesAvailable This is the size of the returned region, which could be zero.
+		 * @return A pointer to the region is returned.  It's good until CommitRead is called.
+		 */
+		virtual const uint8_t* AcquireRead(uint64_t numBytesWanted, uint64_t& numBytesAvailable) override;
+
+		/**
+		 * Consume the given number of bytes from the front of the region returned by AcquireRead.
+		 */
+		virtual void CommitRead(uint64_t numBytes) override;
+
+		/**
+		 * Get the next contiguous region of free space.  This may be less than is free in all, if the space wraps around the end of the ring.
+		 *
+		 * @param[in] numBytesWanted This is the most we'll return.
+		 * @param[out] numBytesAvailable This is the size of the returned region, which could be zero.
+		 * @return A pointer to the region is returned.  Whatever is put there isn't seen by the reader until CommitWrite is called.
+		 */
+		virtual uint8_t* AcquireWrite(uint64_t numBytesWanted, uint64_t& numBytesAvailable) override;
+
+		/**
+		 * Publish the given number of bytes from the front of the region returned by AcquireWrite.
+		 */
+		virtual void CommitWrite(uint64_t numBytes) override;
+
+		virtual bool CanAccessInPlace() const override;
+
+	protected:
+		uint8_t* ringBuffer;
+		uint64_t capacity;
+		uint64_t mask;
+
+		// The positions only ever increase, and are wrapped into the ring by the mask.  Each side keeps its own
+		// stale copy of the other's position, so that it only has to look at the other's cache line when it seems
+		// to have run out of room (or data).
+		alignas(ADL_CACHE_LINE_SIZE) std::atomic<uint64_t> writePosition;		///< Only the writer changes this.
+		uint64_t writerReadPosition;											///< This is the writer's copy of the read position.
+		alignas(ADL_CACHE_LINE_SIZE) std::atomic<uint64_t> readPosition;		///< Only the reader changes this.
+		uint64_t readerWritePosition;											///< This is the reader's copy of the write position.
+	};
+
+	/**
+	 * @brief This is a read-only audio stream that reads frames straight out of an audio file as they're asked for.
+	 *
+	 * Nothing of the file is loaded up front but its header.  The file is mapped, so reading from us is just copying
+	 * out of the mapping (or working on it in place with AcquireRead), and the OS pages the audio in as it's reached.
+	 * A stream of an hour-long file opens as fast as one of a second-long file, and costs no more memory.
+	 * Unlike other audio streams, this one can be seeked.  See SeekFrame.
+	 *
+	 * These are made by the OpenAudioStream method of file formats that support it, such as WaveFileFormat.
+	 */
+	class AUDIO_DATA_LIB_API FileAudioStream : public AudioStream
+	{
+	public:
+		/**
+		 * @param[in] mappedFile This is the file the audio is in.  We keep it open for as long as we're around.
+		 * @param[in] dataOffset This is where in the file the first frame is.
+		 * @param[in] dataSize This is how many bytes of audio there are from there.  Any partial frame at the end is ignored.
+		 * @param[in] format This is the format of the audio in the file.
+		 * @param[in] byteSwapped If true, the samples in the file are of the opposite byte-order to ours, and are swapped as they're read.
+		 */
+		FileAudioStream(std::shared_ptr<MappedFileInputStream> mappedFile, uint64_t dataOffset, uint64_t dataSize, const AudioData::Format& format, bool byteSwapped);
+		virtual ~FileAudioStream();
+
+		virtual uint64_t ReadBytesFromStream(uint8_t* buffer, uint64_t bufferSize) override;
+		virtual uint64_t PeekBytesFromStream(uint8_t* buffer, uint64_t bufferSize) override;
+
+		virtual const uint8_t* AcquireRead(uint64_t numBytesWanted, uint64_t& numBytesAvailable) override;
+		virtual void CommitRead(uint64_t numBytes) override;
+		virtual bool CanAccessInPlace() const override;
+
+		/**
+		 * Return the total number of frames in the file.
+		 */
+		uint64_t GetNumFrames() const;
+
+		/**
+		 * Return the frame that will be read next.
+		 */
+		uint64_t GetFramePosition() const;
+
+		/**
+		 * Make the given frame the next one to be read.  We also ask the OS to start paging in the audio from there.
+		 */
+		bool SeekFrame(uint64_t frameNumber);
+
+	protected:
+		std::shared_ptr<MappedFileInputStream> mappedFile;
+		ReadOnlyBufferStream* dataStream;		///< This is our byte stream, over just the audio part of the mapping.
+		bool byteSwapped;
+	};
+
 	/**
 	 * @brief This is a read/write, in-memory stream of bytes that is bounded only by the memory limitations of the operating system.
+	 *
+	 * The bytes are kept in a queue of chunks.  Writing fills the last chunk and adds another when it's full; reading
+	 * drains the first chunk and takes it off the queue when it's empty.  Drained chunks are kept around (up to a point)
+	 * to be written into again, so that a stream that's constantly written and read, like one being recorded into or one
+	 * feeding a device, settles down to not allocating at all.  For long captures, chunks can be made to grow as the
+	 * stream does, so that the number of chunks grows with the log of its size rather than with its size.
 	 */
 	class AUDIO_DATA_LIB_API MemoryStream : public ByteStream
 	{
 	public:
-		MemoryStream();
+		/**
+		 * @param[in] chunkSize This is the size of the first chunk, in bytes.
+		 * @param[in] chunkGrowthFactor Each new chunk is this much bigger than the last, until they're maxChunkSize bytes.  One means chunks don't grow.
+		 * @param[in] maxChunkSize This is the most a chunk can grow to, in bytes.
+		 */
+		MemoryStream(uint64_t chunkSize = 5 * 1024, double chunkGrowthFactor = 1.0, uint64_t maxChunkSize = 4 * 1024 * 1024);
 		virtual ~MemoryStream();
 
 		virtual uint64_t WriteBytesToStream(const uint8_t* buffer, uint64_t bufferSize) override;
 		virtual uint64_t ReadBytesFromStream(uint8_t* buffer, uint64_t bufferSize) override;
+		virtual uint64_t PeekBytesFromStream(uint8_t* buffer, uint64_t bufferSize) override;
 
 		virtual uint64_t GetSize() const override;
 
 		virtual bool CanRead() override;
 		virtual bool CanWrite() override;
 
+		virtual const uint8_t* AcquireRead(uint64_t numBytesWanted, uint64_t& numBytesAvailable) override;
+		virtual void CommitRead(uint64_t numBytes) override;
+		virtual uint8_t* AcquireWrite(uint64_t numBytesWanted, uint64_t& numBytesAvailable) override;
+		virtual void CommitWrite(uint64_t numBytes) override;
+		virtual bool CanAccessInPlace() const override;
+
+		/**
+		 * Throw away everything in the stream.  The chunks are kept for reuse, up to the limit set by SetMaxFreeChunks,
+		 * and the chunk size goes back to what it started as.
+		 */
 		void Clear();
 
+		/**
+		 * Set the size of the next chunk we make, and how chunks grow after that.  See the constructor.
+		 */
+		void SetChunkSize(uint64_t chunkSize, double chunkGrowthFactor = 1.0, uint64_t maxChunkSize = 4 * 1024 * 1024);
+
+		/**
+		 * Set how many drained chunks we hold onto for reuse.  The rest are freed.
+		 */
+		void SetMaxFreeChunks(uint32_t maxFreeChunks);
+
+		/**
+		 * Return how many times we've gone to the heap for a chunk.
+		 */
+		uint64_t GetNumChunksAllocated() const { return this->numChunksAllocated; }
+
 	protected:
 		class Chunk
 		{
@@ -296,9 +710,23 @@ namespace AudioDataLib
 			uint64_t bufferSize;
 			uint64_t startOffset;
 			uint64_t endOffset;
+			Chunk* nextChunk;
 		};
 
-		std::list<Chunk*> chunkList;
-		uint64_t chunkSize;
+		Chunk* AcquireChunk();
+		void ReleaseChunk(Chunk* chunk);
+
+		// The chunks are linked together through themselves, rather than kept in a container, so that queueing one doesn't allocate.
+		Chunk* firstChunk;
+		Chunk* lastChunk;
+		Chunk* firstFreeChunk;
+		uint32_t numFreeChunks;
+		uint32_t maxFreeChunks;
+		uint64_t totalSize;				///< This is how many bytes are in the stream, so that we don't have to add it up.
+		uint64_t initialChunkSize;
+		uint64_t chunkSize;				///< This is the size of the next chunk we'll make.
+		double chunkGrowthFactor;
+		uint64_t maxChunkSize;
+		uint64_t numChunksAllocated;
 	};
 }
\ No newline at end of file
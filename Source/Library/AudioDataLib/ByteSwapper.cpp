@@ -80,7 +80,8 @@ void ByteSwapper::Resolve(uint8_t* buffer, uint32_t bufferSize)
 	if (!this->swapsNeeded)
 		return;
 
-	for (uint32_t i = 0; i < bufferSize; i++)
+	// Only go half way, or everything gets swapped back.
+	for (uint32_t i = 0; i < bufferSize / 2; i++)
 	{
 		uint32_t j = bufferSize - 1 - i;
 
@@ -10,6 +10,7 @@ ChunkParser::ChunkParser()
 	this->rootChunk = nullptr;
 	this->buffer = nullptr;
 	this->bufferSize = 0;
+	this->ownedBuffer = nullptr;
 }
 
 /*virtual*/ ChunkParser::~ChunkParser()
@@ -22,7 +23,8 @@ void ChunkParser::Clear()
 	delete this->rootChunk;
 	this->rootChunk = nullptr;
 
-	delete[] this->buffer;
+	delete[] this->ownedBuffer;
+	this->ownedBuffer = nullptr;
 	this->buffer = nullptr;
 	this->bufferSize = 0;
 }
@@ -31,21 +33,50 @@ bool ChunkParser::ParseStream(ByteStream& inputStream)
 {
 	this->Clear();
 
-	this->bufferSize = (uint32_t)inputStream.GetSize();
-	if (this->bufferSize == 0)
+	uint64_t streamSize = inputStream.GetSize();
+	if (streamSize == 0)
 	{
 		ErrorSystem::Get()->Add("No bytes to read.");
 		return false;
 	}
 
-	this->buffer = new uint8_t[this->bufferSize];
-	uint64_t numBytesRead = inputStream.ReadBytesFromStream(this->buffer, this->bufferSize);
-	if (numBytesRead != this->bufferSize)
+	if (inputStream.CanAccessInPlace())
+	{
+		uint64_t numBytesAvailable = 0;
+		const uint8_t* streamBuffer = inputStream.AcquireRead(streamSize, numBytesAvailable);
+		if (numBytesAvailable == streamSize)
+		{
+			inputStream.CommitRead(streamSize);
+			this->buffer = streamBuffer;
+			this->bufferSize = streamSize;
+			return this->ParseRootChunk();
+		}
+	}
+
+	this->ownedBuffer = new uint8_t[streamSize];
+	uint64_t numBytesRead = inputStream.ReadBytesFromStream(this->ownedBuffer, streamSize);
+	if (numBytesRead != streamSize)
 	{
 		ErrorSystem::Get()->Add("Couldn't read the entire stream.");
 		return false;
 	}
 
+	this->buffer = this->ownedBuffer;
+	this->bufferSize = streamSize;
+	return this->ParseRootChunk();
+}
+
+bool ChunkParser::ParseBuffer(const uint8_t* buffer, uint64_t bufferSize)
+{
+	this->Clear();
+
+	this->buffer = buffer;
+	this->bufferSize = bufferSize;
+	return this->ParseRootChunk();
+}
+
+bool ChunkParser::ParseRootChunk()
+{
 	ReadOnlyBufferStream bufferStream(this->buffer, this->bufferSize);
 
 	this->rootChunk = new Chunk();
@@ -195,6 +226,13 @@ bool ChunkParser::Chunk::ParseStream(ReadOnlyBufferStream& inputStream, ChunkPar
 	this->bufferSize = chunkParser->byteSwapper.Resolve(this->bufferSize);
 	this->buffer = inputStream.GetBuffer() + inputStream.GetReadOffset();
 
+	// The buffer may well be a mapped file, so we can't afford to believe a chunk that says it runs off the end.
+	if (this->bufferSize > inputStream.GetSize())
+	{
+		ErrorSystem::Get()->Add(std::format("Chunk {} claims {} bytes, but only {} are left.", this->name->c_str(), this->bufferSize, inputStream.GetSize()));
+		return false;
+	}
+
 	ReadOnlyBufferStream subInputStream(this->buffer, this->bufferSize);
 
 	if (!chunkParser->ParseChunkData(subInputStream, this))
@@ -7,6 +7,11 @@ namespace AudioDataLib
 {
 	/**
 	 * @brief This class provides commong RIFF-based parsing support.
+	 *
+	 * Chunks never own their data; they point into a buffer held by the parser.  If the stream we're given can hand
+	 * out all of its bytes in place (e.g., MappedFileInputStream), then that buffer is just borrowed from the stream,
+	 * and nothing gets copied.  Either way, the chunks are only good for as long as the parser is, and in the borrowed
+	 * case, for as long as the stream is too.
 	 */
 	class AUDIO_DATA_LIB_API ChunkParser
 	{
@@ -20,7 +25,18 @@ namespace AudioDataLib
 
 		void Clear();
 		void RegisterSubChunks(const std::string& chunkName);
+
+		/**
+		 * Parse everything left in the given stream.  The stream is consumed.  If the stream can give us all of it in
+		 * place, we parse it there, so the stream must outlive any use of our chunks.  Otherwise, we make our own copy.
+		 */
 		bool ParseStream(ByteStream& inputStream);
+
+		/**
+		 * Parse the given bytes in place.  Nothing is copied, so the given buffer must outlive any use of our chunks.
+		 */
+		bool ParseBuffer(const uint8_t* buffer, uint64_t bufferSize);
+
 		const Chunk* FindChunk(const std::string& chunkName, const std::string& formType = "", bool caseSensative = true) const;
 		void FindAllChunks(const std::string& chunkName, std::vector<const Chunk*>& chunkArray, bool caseSensative = true) const;
 		const Chunk* GetRootChunk() const { return this->rootChunk; }
@@ -63,8 +79,11 @@ namespace AudioDataLib
 		ByteSwapper byteSwapper;
 
 	protected:
-		uint8_t* buffer;
-		uint32_t bufferSize;
+		bool ParseRootChunk();
+
+		const uint8_t* buffer;
+		uint64_t bufferSize;
+		uint8_t* ownedBuffer;			///< This is non-null when the buffer is our own copy rather than borrowed.
 		Chunk* rootChunk;
 		std::set<std::string> subChunkSet;
 	};
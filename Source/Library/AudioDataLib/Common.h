@@ -15,6 +15,7 @@
 #define ADL_CLAMP(x, a, b)		ADL_MIN(ADL_MAX(x, a), b)
 #define ADL_PI					3.1415926536
 #define ADL_SEMITONE			1.0594630943592953		// This is the twelth root of 2.
+#define ADL_CACHE_LINE_SIZE		64						// Data shared between threads is padded out to this to keep them from stepping on each other.
 
 #include <stdlib.h>
 #include <string>
@@ -2,6 +2,7 @@
 #include "AudioDataLib/ErrorSystem.h"
 #include "AudioDataLib/MIDI/MidiSynth.h"
 #include "AudioDataLib/WaveForm.h"
+#include "AudioDataLib/ByteStream.h"
 
 using namespace AudioDataLib;
 
@@ -9,6 +10,9 @@ using namespace AudioDataLib;
 
 WaveTableData::WaveTableData()
 {
+	this->residencyBudget = 0;
+	this->streamingPreloadSeconds = 0.0;
+	::memset(&this->residencyStats, 0, sizeof(ResidencyStats));
 }
 
 /*virtual*/ WaveTableData::~WaveTableData()
@@ -56,7 +60,16 @@ WaveTableData::WaveTableData()
 
 void WaveTableData::Clear()
 {
+	for (AudioSampleData* audioSampleData : this->residentList)
+	{
+		audioSampleData->inResidentList = false;
+		audioSampleData->residentSizeCharged = 0;
+	}
+
 	this->audioSampleArray.clear();
+	this->residentList.clear();
+	this->residencyStats.numResidentSamples = 0;
+	this->residencyStats.residentSize = 0;
 }
 
 void WaveTableData::AddSample(std::shared_ptr<AudioSampleData> audioSampleData)
@@ -82,6 +95,27 @@ std::shared_ptr<AudioData> WaveTableData::GetAudioData(uint32_t i) const
 }
 
 const WaveTableData::AudioSampleData* WaveTableData::FindAudioSample(uint8_t instrument, uint16_t midiKey, uint16_t midiVelocity) const
+{
+	AudioSampleData* audioSampleData = this->LookupAudioSample(instrument, midiKey, midiVelocity);
+	if (!audioSampleData)
+		return nullptr;
+
+	if (!this->TouchAudioSample(audioSampleData))
+		return nullptr;
+
+	return audioSampleData;
+}
+
+bool WaveTableData::PrefetchAudioSample(uint8_t instrument, uint16_t midiKey, uint16_t midiVelocity) const
+{
+	AudioSampleData* audioSampleData = this->LookupAudioSample(instrument, midiKey, midiVelocity);
+	if (!audioSampleData)
+		return true;
+
+	return this->TouchAudioSample(audioSampleData);
+}
+
+WaveTableData::AudioSampleData* WaveTableData::LookupAudioSample(uint8_t instrument, uint16_t midiKey, uint16_t midiVelocity) const
 {
 	// TODO: Speed this up with an index?
 
@@ -101,6 +135,105 @@ const WaveTableData::AudioSampleData* WaveTableData::FindAudioSample(uint8_t ins
 	return nullptr;
 }
 
+void WaveTableData::SetResidencyBudget(uint64_t residencyBudget)
+{
+	this->residencyBudget = residencyBudget;
+	this->TrimToResidencyBudget();
+}
+
+bool WaveTableData::TouchAudioSample(AudioSampleData* audioSampleData) const
+{
+	// Samples that were never left in a file don't count against the budget, and neither do streamed ones.
+	if (!audioSampleData->IsDeferred() || audioSampleData->IsStreamed())
+		return true;
+
+	if (audioSampleData->inResidentList)
+	{
+		if (audioSampleData->IsResident())
+		{
+			this->residentList.splice(this->residentList.begin(), this->residentList, audioSampleData->residentListIter);
+			this->residencyStats.numHits++;
+			return true;
+		}
+
+		// Someone let go of it behind our back, so forget what we knew about it.
+		this->EvictAudioSample(audioSampleData);
+	}
+
+	if (!audioSampleData->IsResident())
+	{
+		if (!audioSampleData->MakeResident())
+			return false;
+
+		this->residencyStats.numLoads++;
+		this->residencyStats.numBytesLoaded += audioSampleData->GetDeferredSize();
+	}
+
+	this->residentList.push_front(audioSampleData);
+	audioSampleData->residentListIter = this->residentList.begin();
+	audioSampleData->inResidentList = true;
+	audioSampleData->residentSizeCharged = audioSampleData->GetResidentSize();
+	this->residencyStats.numResidentSamples++;
+	this->residencyStats.residentSize += audioSampleData->residentSizeCharged;
+
+	this->TrimToResidencyBudget();
+	return true;
+}
+
+void WaveTableData::EvictAudioSample(AudioSampleData* audioSampleData) const
+{
+	if (!audioSampleData->inResidentList)
+		return;
+
+	this->residentList.erase(audioSampleData->residentListIter);
+	audioSampleData->inResidentList = false;
+	this->residencyStats.numResidentSamples--;
+	this->residencyStats.residentSize -= audioSampleData->residentSizeCharged;
+	audioSampleData->residentSizeCharged = 0;
+	audioSampleData->MakeNonResident();
+}
+
+void WaveTableData::TrimToResidencyBudget() const
+{
+	if (this->residencyBudget == 0)
+		return;
+
+	// The front of the list is whatever was just found, and whoever found it is about to use it, so it stays.
+	while (this->residencyStats.residentSize > this->residencyBudget && this->residentList.size() > 1)
+	{
+		this->EvictAudioSample(this->residentList.back());
+		this->residencyStats.numEvictions++;
+	}
+}
+
+void WaveTableData::EvictAllAudioSamples() const
+{
+	while (this->residentList.size() > 0)
+		this->EvictAudioSample(this->residentList.back());
+}
+
+bool WaveTableData::SetStreamingPreload(double preloadSeconds)
+{
+	this->streamingPreloadSeconds = ADL_MAX(preloadSeconds, 0.0);
+
+	for (std::shared_ptr<AudioData> audioData : this->audioSampleArray)
+	{
+		AudioSampleData* audioSampleData = dynamic_cast<AudioSampleData*>(audioData.get());
+		if (!audioSampleData || !audioSampleData->IsDeferred())
+			continue;
+
+		uint64_t numFrames = uint64_t(::ceil(this->streamingPreloadSeconds * audioSampleData->GetFormat().framesPerSecond));
+		if (!audioSampleData->SetPreload(numFrames))
+			return false;
+
+		// A sample that's streamed now may have been read in whole before.
+		if (audioSampleData->IsStreamed())
+			this->EvictAudioSample(audioSampleData);
+	}
+
+	return true;
+}
+
 //------------------------------ WaveTableData::AudioSampleData ------------------------------
 
 WaveTableData::AudioSampleData::AudioSampleData()
@@ -114,6 +247,10 @@ WaveTableData::AudioSampleData::AudioSampleData()
 	this->channelType = ChannelType::MONO;
 	this->mode = Mode::GETS_TRAPPED_IN_LOOP;
 	::memset(&this->range, 0, sizeof(range));
+	this->deferredOffset = 0;
+	this->deferredSize = 0;
+	this->inResidentList = false;
+	this->residentSizeCharged = 0;
 }
 
 /*virtual*/ WaveTableData::AudioSampleData::~AudioSampleData()
@@ -137,6 +274,12 @@ std::shared_ptr<WaveForm> WaveTableData::AudioSampleData::GetCachedWaveForm(uint
 {
 	if (!this->cachedWaveForm.get())
 	{
+		if (this->IsDeferred())
+		{
+			ErrorSystem::Get()->Add(std::format("Sample {} hasn't been read in from its file.", this->name->c_str()));
+			return this->cachedWaveForm;
+		}
+
 		this->cachedWaveForm.reset(new WaveForm());
 
 		if (!this->cachedWaveForm->ConvertFromAudioBuffer(this->GetFormat(), this->GetAudioBuffer(), this->GetAudioBufferSize(), channel))
@@ -149,6 +292,123 @@ std::shared_ptr<WaveForm> WaveTableData::AudioSampleData::GetCachedWaveForm(uint
 	return this->cachedWaveForm;
 }
 
+void WaveTableData::AudioSampleData::SetDeferredAudio(std::shared_ptr<MappedFileInputStream> mappedFile, uint64_t offset, uint64_t size)
+{
+	this->mappedFile = mappedFile;
+	this->deferredOffset = offset;
+	this->deferredSize = size;
+
+	this->SetAudioBufferSize(0);
+	this->cachedWaveForm.reset();
+}
+
+bool WaveTableData::AudioSampleData::IsResident() const
+{
+	if (!this->IsDeferred())
+		return true;
+
+	return this->cachedWaveForm.get() != nullptr;
+}
+
+bool WaveTableData::AudioSampleData::MakeResident()
+{
+	if (this->IsResident())
+		return true;
+
+	if (this->deferredOffset + this->deferredSize > this->mappedFile->GetBufferSize())
+	{
+		ErrorSystem::Get()->Add(std::format("The audio of sample {} runs past the end of its file.", this->name->c_str()));
+		return false;
+	}
+
+	// The file is mapped, so we convert straight out of it rather than copy the audio in first and hold onto it twice.
+	std::shared_ptr<WaveForm> waveForm(new WaveForm());
+	if (!waveForm->ConvertFromAudioBuffer(this->GetFormat(), this->mappedFile->GetBuffer() + this->deferredOffset, this->deferredSize, 0))
+	{
+		ErrorSystem::Get()->Add(std::format("Failed to convert sample {} into a wave-form.", this->name->c_str()));
+		return false;
+	}
+
+	this->cachedWaveForm = waveForm;
+	return true;
+}
+
+void WaveTableData::AudioSampleData::MakeNonResident()
+{
+	if (!this->IsDeferred())
+		return;
+
+	this->SetAudioBufferSize(0);
+	this->cachedWaveForm.reset();
+}
+
+uint64_t WaveTableData::AudioSampleData::GetResidentSize() const
+{
+	uint64_t residentSize = this->audioBufferSize;
+
+	if (this->cachedWaveForm.get())
+		residentSize += this->cachedWaveForm->GetNumSamples() * sizeof(double);
+
+	return residentSize;
+}
+
+bool WaveTableData::AudioSampleData::SetPreload(uint64_t numFrames)
+{
+	this->preloadedWaveForm.reset();
+
+	if (!this->IsDeferred() || numFrames == 0)
+		return true;
+
+	numFrames = ADL_MIN(numFrames, this->GetNumDeferredFrames());
+	uint64_t numBytes = numFrames * this->GetFormat().BytesPerFrame();
+
+	if (this->deferredOffset + numBytes > this->mappedFile->GetBufferSize())
+	{
+		ErrorSystem::Get()->Add(std::format("The audio of sample {} runs past the end of its file.", this->name->c_str()));
+		return false;
+	}
+
+	std::shared_ptr<WaveForm> waveForm(new WaveForm());
+	if (!waveForm->ConvertFromAudioBuffer(this->GetFormat(), this->mappedFile->GetBuffer() + this->deferredOffset, numBytes, 0))
+	{
+		ErrorSystem::Get()->Add(std::format("Failed to convert the preload of sample {} into a wave-form.", this->name->c_str()));
+		return false;
+	}
+
+	this->preloadedWaveForm = waveForm;
+	return true;
+}
+
+uint64_t WaveTableData::AudioSampleData::GetNumPreloadedFrames() const
+{
+	if (!this->preloadedWaveForm.get())
+		return 0;
+
+	return this->preloadedWaveForm->GetNumSamples();
+}
+
+bool WaveTableData::AudioSampleData::IsStreamed() const
+{
+	if (!this->preloadedWaveForm.get())
+		return false;
+
+	// A looped sample never gets past the end of its loop.
+	uint64_t numFramesPlayed = (this->mode == Mode::NOT_LOOPED) ? this->GetNumDeferredFrames() : this->loop.endFrame;
+	return this->GetNumPreloadedFrames() < numFramesPlayed;
+}
+
+uint64_t WaveTableData::AudioSampleData::GetNumDeferredFrames() const
+{
+	if (!this->IsDeferred())
+		return this->GetNumFrames();
+
+	uint64_t bytesPerFrame = this->GetFormat().BytesPerFrame();
+	if (bytesPerFrame == 0)
+		return 0;
+
+	return this->deferredSize / bytesPerFrame;
+}
+
 bool WaveTableData::AudioSampleData::Range::Contains(uint16_t key, uint16_t vel) const
 {
 	if (!(this->minKey <= key && key <= this->maxKey))
@@ -6,6 +6,7 @@ namespace AudioDataLib
 {
 	class AudioData;
 	class WaveForm;
+	class MappedFileInputStream;
 
 	/**
 	 * @brief An instance of this class contains just enough data to reasonably synthesize a set of instruments using MIDI messages.
@@ -17,6 +18,14 @@ namespace AudioDataLib
 	 * make up its own system of synthesis that utilizes this data.  Admittedly, some valuable data isn't captured
 	 * as a consequence of this when loading an SF2 or DLS file, but the goal here isn't completeness, but that
 	 * of something simple that works reasonably well, and is easy to understand.
+	 * 
+	 * A big bank can hold far more audio than any one song is going to use.  If the bank is opened with
+	 * FileFormat::OpenWaveTable, then each sample's audio is left in the file until FindAudioSample first picks
+	 * that sample, at which point we read it in.  We then keep the samples that have been read in under a budget
+	 * (see SetResidencyBudget), letting go of the ones used least recently to make room for new ones.
+	 *
+	 * Some samples (a long piano note, say) are too big to be worth reading in whole at all.  For those, we can keep
+	 * just the first moment of the sample in memory and stream the rest from the file as it plays.  See SetStreamingPreload.
 	 */
 	class AUDIO_DATA_LIB_API WaveTableData : public FileData
 	{
@@ -87,6 +96,72 @@ namespace AudioDataLib
 
 			std::shared_ptr<WaveForm> GetCachedWaveForm(uint16_t channel) const;
 
+			/**
+			 * Leave this sample's audio in the given file, rather than in memory, until MakeResident is called.
+			 * The format of the sample should already be set.
+			 * 
+			 * @param[in] mappedFile This is the file the audio is in.  We keep it open for as long as we're around.
+			 * @param[in] offset This is where in the file the audio starts.
+			 * @param[in] size This is how many bytes of audio there are.
+			 */
+			void SetDeferredAudio(std::shared_ptr<MappedFileInputStream> mappedFile, uint64_t offset, uint64_t size);
+
+			/**
+			 * Tell the caller if this sample's audio lives in a file.  If not, the audio is always in memory.
+			 */
+			bool IsDeferred() const { return this->mappedFile.get() != nullptr; }
+
+			/**
+			 * Tell the caller if this sample's audio (and its wave-form) is in memory.
+			 */
+			bool IsResident() const;
+
+			/**
+			 * Make this sample's wave-form straight from its audio in the file.  The audio itself isn't kept, since the
+			 * wave-form is all a voice needs.  This does nothing if we're already resident.
+			 */
+			bool MakeResident();
+
+			/**
+			 * Let go of this sample's audio and wave-form, if it can be read back in from its file later.
+			 * Anyone still holding onto the wave-form (e.g., a voice that's playing it) keeps it until they're done.
+			 */
+			void MakeNonResident();
+
+			/**
+			 * Return how many bytes of memory this sample takes up while it's resident.
+			 */
+			uint64_t GetResidentSize() const;
+
+			/**
+			 * Keep the first so many frames of this sample's audio in memory for good, as a wave-form of its own, so that
+			 * a voice can start playing the sample right away while the rest of it is streamed in from the file (see
+			 * SampleStreamer.)  This only applies to samples left in their file.  Zero frames lets go of the preload.
+			 */
+			bool SetPreload(uint64_t numFrames);
+
+			/**
+			 * Return the wave-form made by SetPreload, if any.
+			 */
+			std::shared_ptr<WaveForm> GetPreloadedWaveForm() const { return this->preloadedWaveForm; }
+
+			uint64_t GetNumPreloadedFrames() const;
+
+			/**
+			 * Tell the caller if this sample should be streamed from its file rather than read in whole.  That's the case
+			 * if it has a preload, and there's more to play than the preload holds.
+			 */
+			bool IsStreamed() const;
+
+			const std::shared_ptr<MappedFileInputStream>& GetDeferredFile() const { return this->mappedFile; }
+			uint64_t GetDeferredOffset() const { return this->deferredOffset; }
+			uint64_t GetDeferredSize() const { return this->deferredSize; }
+
+			/**
+			 * Return how many frames of audio this sample has in its file, whether it's been read in or not.
+			 */
+			uint64_t GetNumDeferredFrames() const;
+
 			void SetName(const std::string& name) { *this->name = name; }
 			const std::string& GetName() const { return *this->name; }
 
@@ -115,17 +190,86 @@ namespace AudioDataLib
 			ChannelType channelType;
 			// TODO: Add envelope for ADSR?
 			mutable std::shared_ptr<WaveForm> cachedWaveForm;
+			std::shared_ptr<MappedFileInputStream> mappedFile;
+			uint64_t deferredOffset;
+			uint64_t deferredSize;
+			std::shared_ptr<WaveForm> preloadedWaveForm;
+
+		private:
+			friend class WaveTableData;
+
+			// The WaveTableData class keeps these, so that it can find us in its list of resident samples without a search,
+			// and take back out of the budget just what it put in, even if we were let go of behind its back.
+			std::list<AudioSampleData*>::iterator residentListIter;
+			bool inResidentList;
+			uint64_t residentSizeCharged;
 		};
 
 		uint32_t GetNumAudioSamples() const { return this->audioSampleArray.size(); }
 		const AudioData* GetAudioSample(uint32_t i) const;
 		std::shared_ptr<AudioData> GetAudioData(uint32_t i) const;
 
+		/**
+		 * Find the sample that should be used to play the given key at the given velocity on the given instrument.
+		 * If the sample's audio is still in its file, it's read in now, which may mean letting go of others.
+		 */
 		const AudioSampleData* FindAudioSample(uint8_t instrument, uint16_t midiKey, uint16_t midiVelocity) const;
 
+		/**
+		 * Do the work FindAudioSample would do for the given key, velocity and instrument, ahead of time, so that
+		 * nobody has to wait on the disk when the note is actually played.  Nothing happens if there's no such sample.
+		 */
+		bool PrefetchAudioSample(uint8_t instrument, uint16_t midiKey, uint16_t midiVelocity) const;
+
+		/**
+		 * Set the most memory (in bytes) that the samples read in from the file are allowed to take up at once.
+		 * Zero means there's no limit.  The sample most recently found is always kept, even if it alone is over the budget.
+		 */
+		void SetResidencyBudget(uint64_t residencyBudget);
+		uint64_t GetResidencyBudget() const { return this->residencyBudget; }
+
+		/**
+		 * Let go of every sample that can be read back in from the file later, e.g., between songs.
+		 */
+		void EvictAllAudioSamples() const;
+
+		/**
+		 * These numbers tell you how well the residency budget is working out.
+		 */
+		struct ResidencyStats
+		{
+			uint64_t numResidentSamples;	///< This is how many samples read in from the file are in memory now.
+			uint64_t residentSize;			///< This is how many bytes those samples take up.
+			uint64_t numHits;				///< This is how many times a sample was found that was already in memory.
+			uint64_t numLoads;				///< This is how many times a sample had to be read in from the file.
+			uint64_t numEvictions;			///< This is how many times a sample was let go of to stay under the budget.
+			uint64_t numBytesLoaded;
+		};
+
+		const ResidencyStats& GetResidencyStats() const { return this->residencyStats; }
+
+		/**
+		 * Keep just the first so many seconds of each sample left in the file in memory, and stream the rest of it as
+		 * it's played, for samples long enough to need it (see AudioSampleData::IsStreamed.)  Streamed samples are never
+		 * read in whole, so they don't count against the residency budget, but their preloads stay put.  The preloads
+		 * are all read in here, so that nobody has to wait on them later.  Zero turns streaming off.
+		 */
+		bool SetStreamingPreload(double preloadSeconds);
+		double GetStreamingPreload() const { return this->streamingPreloadSeconds; }
+
 	private:
 
+		AudioSampleData* LookupAudioSample(uint8_t instrument, uint16_t midiKey, uint16_t midiVelocity) const;
+		bool TouchAudioSample(AudioSampleData* audioSampleData) const;
+		void EvictAudioSample(AudioSampleData* audioSampleData) const;
+		void TrimToResidencyBudget() const;
+
 		std::vector<std::shared_ptr<AudioData>> audioSampleArray;
+
+		uint64_t residencyBudget;
+		double streamingPreloadSeconds;
+		mutable std::list<AudioSampleData*> residentList;		///< These are the samples we've read in, most recently used first.
+		mutable ResidencyStats residencyStats;
 	};
 
 	/**
@@ -30,6 +30,52 @@ AiffFileFormat::AiffFileFormat()
 	if (!parser.ParseStream(inputStream))
 		return false;
 
+	SoundInfo soundInfo;
+	if (!ReadSoundInfo(parser, soundInfo))
+		return false;
+
+	std::shared_ptr<Codec> codec;
+
+	if (0 == ::strlen(soundInfo.compressionType) || 0 == ::strcmp(soundInfo.compressionType, "NONE"))
+		codec.reset(new ByteSwappedAudioCodec(&parser.byteSwapper));
+	else if (0 == ::strcmp(soundInfo.compressionType, "ulaw"))
+		codec.reset(new uLawCodec());
+	else if (0 == ::strcmp(soundInfo.compressionType, "alaw"))
+		codec.reset(new ALawCodec());
+
+	if (!codec.get())
+	{
+		ErrorSystem::Get()->Add(std::format("An audio codec could not be determined for this file.  The comperssion type name is \"{}\".", soundInfo.compressionTypeName.c_str()));
+		return false;
+	}
+
+	ReadOnlyBufferStream soundStream(soundInfo.soundBuffer, soundInfo.soundBufferSize);
+
+	std::unique_ptr<AudioData> audioData;
+
+	const ChunkParser::Chunk* instrumentChunk = parser.FindChunk("INST", "", false);
+	if (!instrumentChunk)
+		audioData.reset(new AudioData());
+	else
+	{
+		WaveTableData::AudioSampleData* audioSampleData = new WaveTableData::AudioSampleData();
+		
+		// TODO: Fill-out looping information here.
+
+		audioData.reset(audioSampleData);
+	}
+
+	audioData->SetFormat(soundInfo.format);
+
+	if(!codec->Decode(soundStream, *audioData))
+		return false;
+
+	fileData.reset(audioData.release());
+	return true;
+}
+
+/*static*/ bool AiffFileFormat::ReadSoundInfo(const AiffChunkParser& parser, SoundInfo& soundInfo)
+{
 	const ChunkParser::Chunk* formChunk = parser.FindChunk("FORM", "", false);
 	if (!formChunk)
 	{
@@ -140,21 +186,6 @@ AiffFileFormat::AiffFileFormat()
 		}
 	}
 
-	std::shared_ptr<Codec> codec;
-
-	if (0 == ::strlen(compressionType) || 0 == ::strcmp(compressionType, "NONE"))
-		codec.reset(new ByteSwappedAudioCodec(&parser.byteSwapper));
-	else if (0 == ::strcmp(compressionType, "ulaw"))
-		codec.reset(new uLawCodec());
-	else if (0 == ::strcmp(compressionType, "alaw"))
-		codec.reset(new ALawCodec());
-
-	if (!codec.get())
-	{
-		ErrorSystem::Get()->Add(std::format("An audio codec could not be determined for this file.  The comperssion type name is \"{}\".", compressionTypeName.c_str()));
-		return false;
-	}
-
 	const ChunkParser::Chunk* soundChunk = parser.FindChunk("SSND", "", false);
 	if (!soundChunk)
 	{
@@ -178,6 +209,9 @@ AiffFileFormat::AiffFileFormat()
 		return false;
 	}
 
+	offset = parser.byteSwapper.Resolve(offset);
+	blockSize = parser.byteSwapper.Resolve(blockSize);
+
 	while (offset-- > 0)
 	{
 		uint8_t padByte = 0;
@@ -188,31 +222,45 @@ AiffFileFormat::AiffFileFormat()
 		}
 	}
 
-	std::unique_ptr<AudioData> audioData;
+	soundInfo.format.bitsPerSample = sampleSizeBits;
+	soundInfo.format.sampleType = AudioData::Format::SampleType::SIGNED_INTEGER;
+	soundInfo.format.numChannels = numChannels;
+	soundInfo.format.framesPerSecond = sampleRate;
+	::memcpy(soundInfo.compressionType, compressionType, sizeof(compressionType));
+	soundInfo.compressionTypeName = compressionTypeName;
+	soundInfo.soundBuffer = soundStream.GetBuffer() + soundStream.GetReadOffset();
+	soundInfo.soundBufferSize = soundStream.GetSize();
+	return true;
+}
 
-	const ChunkParser::Chunk* instrumentChunk = parser.FindChunk("INST", "", false);
-	if (!instrumentChunk)
-		audioData.reset(new AudioData());
-	else
+/*virtual*/ bool AiffFileFormat::OpenAudioStream(const char* filePath, std::shared_ptr<FileAudioStream>& audioStream)
+{
+	std::shared_ptr<MappedFileInputStream> mappedFile(new MappedFileInputStream(filePath));
+	if (!mappedFile->IsOpen())
 	{
-		WaveTableData::AudioSampleData* audioSampleData = new WaveTableData::AudioSampleData();
-		
-		// TODO: Fill-out looping information here.
-
-		audioData.reset(audioSampleData);
+		ErrorSystem::Get()->Add(std::format("Could not open file {}.", filePath));
+		return false;
 	}
 
-	AudioData::Format format;
-	format.bitsPerSample = sampleSizeBits;
-	format.sampleType = AudioData::Format::SampleType::SIGNED_INTEGER;
-	format.numChannels = numChannels;
-	format.framesPerSecond = sampleRate;
-	audioData->SetFormat(format);
+	// As in ReadFromStream, we assume the file is big-endian, which is to say, the opposite of us.
+	AiffChunkParser parser;
+	parser.byteSwapper.swapsNeeded = true;
+	if (!parser.ParseStream(*mappedFile))
+		return false;
 
-	if(!codec->Decode(soundStream, *audioData))
+	SoundInfo soundInfo;
+	if (!ReadSoundInfo(parser, soundInfo))
 		return false;
 
-	fileData.reset(audioData.release());
+	// Compressed samples aren't a fixed size, so there's no telling where a frame is without decoding everything before it.
+	if (0 != ::strlen(soundInfo.compressionType) && 0 != ::strcmp(soundInfo.compressionType, "NONE"))
+	{
+		ErrorSystem::Get()->Add(std::format("Can't stream AIFF files with compression type \"{}\".  Read the whole file instead.", soundInfo.compressionTypeName.c_str()));
+		return false;
+	}
+
+	uint64_t dataOffset = uint64_t(soundInfo.soundBuffer - mappedFile->GetBuffer());
+	audioStream.reset(new FileAudioStream(mappedFile, dataOffset, soundInfo.soundBufferSize, soundInfo.format, parser.byteSwapper.swapsNeeded));
 	return true;
 }
 
@@ -18,6 +18,7 @@ namespace AudioDataLib
 
 		virtual bool ReadFromStream(ByteStream& inputStream, std::unique_ptr<FileData>& fileData) override;
 		virtual bool WriteToStream(ByteStream& outputStream, const FileData* fileData) override;
+		virtual bool OpenAudioStream(const char* filePath, std::shared_ptr<FileAudioStream>& audioStream) override;
 
 	protected:
 		class AiffChunkParser : public ChunkParser
@@ -28,5 +29,19 @@ namespace AudioDataLib
 
 			virtual bool ParseChunkData(ReadOnlyBufferStream& inputStream, Chunk* chunk) override;
 		};
+
+		/**
+		 * This is everything we get out of the header of an AIFF file.
+		 */
+		struct SoundInfo
+		{
+			AudioData::Format format;
+			char compressionType[5];
+			std::string compressionTypeName;
+			const uint8_t* soundBuffer;			///< This points to the first sample in the sound chunk.
+			uint64_t soundBufferSize;
+		};
+
+		static bool ReadSoundInfo(const AiffChunkParser& parser, SoundInfo& soundInfo);
 	};
 }
\ No newline at end of file
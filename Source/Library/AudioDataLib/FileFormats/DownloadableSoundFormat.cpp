@@ -233,10 +233,34 @@ bool DownloadableSoundFormat::LoadInstrument(
 
 		const ChunkParser::Chunk* waveChunk = wavePoolChunk->GetSubChunkArray()[waveLink.tableIndex];
 
-		if (!WaveFileFormat::LoadWaveData(audioSampleData.get(), waveChunk))
+		if (!this->mappedFile)
 		{
-			ErrorSystem::Get()->Add(std::format("Failed to load wave data for instrument {}.", audioSampleData->GetCharacter().instrument));
-			return false;
+			if (!WaveFileFormat::LoadWaveData(audioSampleData.get(), waveChunk))
+			{
+				ErrorSystem::Get()->Add(std::format("Failed to load wave data for instrument {}.", audioSampleData->GetCharacter().instrument));
+				return false;
+			}
+		}
+		else
+		{
+			// Just remember where the audio is, and leave it in the file until it's needed.
+			AudioData::Format format;
+			const ChunkParser::Chunk* dataChunk = nullptr;
+			if (!WaveFileFormat::LoadWaveFormat(format, dataChunk, waveChunk))
+			{
+				ErrorSystem::Get()->Add(std::format("Failed to load wave format for instrument {}.", audioSampleData->GetCharacter().instrument));
+				return false;
+			}
+
+			uint64_t dataOffset = 0;
+			if (!this->mappedFile->GetFileOffset(dataChunk->GetBuffer(), dataChunk->GetBufferSize(), dataOffset))
+			{
+				ErrorSystem::Get()->Add("The wave-pool wasn't read in place, so its samples can't be left in the file.");
+				return false;
+			}
+
+			audioSampleData->SetFormat(format);
+			audioSampleData->SetDeferredAudio(this->mappedFile, dataOffset, dataChunk->GetBufferSize());
 		}
 
 		char sampleName[256];
@@ -249,6 +273,23 @@ bool DownloadableSoundFormat::LoadInstrument(
 	return true;
 }
 
+/*virtual*/ bool DownloadableSoundFormat::OpenWaveTable(const char* filePath, std::unique_ptr<FileData>& fileData)
+{
+	// Samples get read in whatever order the music calls for them, so there's no use in the OS reading ahead.
+	this->mappedFile.reset(new MappedFileInputStream(filePath, MappedFileInputStream::RANDOM));
+	if (!this->mappedFile->IsOpen())
+	{
+		ErrorSystem::Get()->Add(std::format("Could not open file {}.", filePath));
+		this->mappedFile.reset();
+		return false;
+	}
+
+	// The samples are made to point into the file as it's read.  See LoadInstrument.
+	bool success = this->ReadFromStream(*this->mappedFile, fileData);
+	this->mappedFile.reset();
+	return success;
+}
+
 /*virtual*/ bool DownloadableSoundFormat::WriteToStream(ByteStream& outputStream, const FileData* fileData)
 {
 	ErrorSystem::Get()->Add("Not yet implimented.");
@@ -23,6 +23,7 @@ namespace AudioDataLib
 
 		virtual bool ReadFromStream(ByteStream& inputStream, std::unique_ptr<FileData>& fileData) override;
 		virtual bool WriteToStream(ByteStream& outputStream, const FileData* fileData) override;
+		virtual bool OpenWaveTable(const char* filePath, std::unique_ptr<FileData>& fileData) override;
 
 	private:
 
@@ -90,5 +91,7 @@ namespace AudioDataLib
 					const ChunkParser::Chunk* instrumentChunk,
 					const ChunkParser::Chunk* wavePoolChunk,
 					WaveTableData* waveTableData);
+
+		std::shared_ptr<MappedFileInputStream> mappedFile;		///< This is only set while OpenWaveTable is reading the file.
 	};
 }
\ No newline at end of file
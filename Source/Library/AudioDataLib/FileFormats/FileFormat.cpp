@@ -4,6 +4,7 @@
 #include "AudioDataLib/FileFormats/SoundFontFormat.h"
 #include "AudioDataLib/FileFormats/AiffFileFormat.h"
 #include "AudioDataLib/FileFormats/DownloadableSoundFormat.h"
+#include "AudioDataLib/ErrorSystem.h"
 
 using namespace AudioDataLib;
 
@@ -15,6 +16,18 @@ FileFormat::FileFormat()
 {
 }
 
+/*virtual*/ bool FileFormat::OpenAudioStream(const char* filePath, std::shared_ptr<FileAudioStream>& audioStream)
+{
+	ErrorSystem::Get()->Add("This file format doesn't support streaming.");
+	return false;
+}
+
+/*virtual*/ bool FileFormat::OpenWaveTable(const char* filePath, std::unique_ptr<FileData>& fileData)
+{
+	ErrorSystem::Get()->Add("This file format doesn't contain a wave-table.");
+	return false;
+}
+
 /*static*/ std::shared_ptr<FileFormat> FileFormat::CreateForFile(const std::string& filePath)
 {
 	std::shared_ptr<FileFormat> fileFormat;
@@ -6,6 +6,7 @@ namespace AudioDataLib
 {
 	class FileData;
 	class ByteStream;
+	class FileAudioStream;
 
 	/**
 	 * @brief Derivatives of this class must impliment an interface that can be used to read or write file
@@ -36,6 +37,28 @@ namespace AudioDataLib
 		 */
 		virtual bool WriteToStream(ByteStream& outputStream, const FileData* fileData) = 0;
 
+		/**
+		 * Open the given file for streaming, rather than reading it all in.  Only the header of the file is read here;
+		 * the audio is read from the returned stream as it's needed.  Not all file formats support this, and those that
+		 * do may not support it for every file they can read.  By default, this just fails.
+		 * 
+		 * @param[in] filePath This is the file to open.
+		 * @param[out] audioStream On success, this is assigned a stream from which the audio of the file can be read.
+		 * @return True is returned on success; false otherwise.
+		 */
+		virtual bool OpenAudioStream(const char* filePath, std::shared_ptr<FileAudioStream>& audioStream);
+
+		/**
+		 * Read the given wave-table file (e.g., an SF2 or DLS file), but leave the audio of each sample in the file
+		 * until it's needed.  This is much faster than reading the file in, and takes much less memory, since a song
+		 * typically uses just a few of the samples in a bank.  See the WaveTableData class.  By default, this just fails.
+		 * 
+		 * @param[in] filePath This is the file to open.  It stays open for as long as any of its samples are around.
+		 * @param[out] fileData On success, this is assigned the WaveTableData (or derivative) found in the file.
+		 * @return True is returned on success; false otherwise.
+		 */
+		virtual bool OpenWaveTable(const char* filePath, std::unique_ptr<FileData>& fileData);
+
 		/**
 		 * This is a factory method which will create and return a shared pointer to a FileFormat class
 		 * instance derivatve that can handle the given file.
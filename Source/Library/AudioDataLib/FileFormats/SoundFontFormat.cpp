@@ -348,7 +348,19 @@ bool SoundFontFormat::ConstructAudioSamples(
 		format.framesPerSecond = header.sampleRate;
 		format.sampleType = AudioData::Format::SampleType::SIGNED_INTEGER;
 
-		if (!sampleBuffer8)
+		if (!sampleBuffer8 && this->mappedFile)
+		{
+			uint64_t sampleOffset = 0;
+			uint64_t sampleSize = (header.sampleEnd - header.sampleStart) * format.BytesPerFrame();
+			if (!this->mappedFile->GetFileOffset((const uint8_t*)&sampleBuffer16[header.sampleStart], sampleSize, sampleOffset))
+			{
+				ErrorSystem::Get()->Add("The sample chunk wasn't read in place, so its samples can't be left in the file.");
+				return false;
+			}
+
+			audioSampleData->SetDeferredAudio(this->mappedFile, sampleOffset, sampleSize);
+		}
+		else if (!sampleBuffer8)
 		{
 			audioSampleData->SetAudioBufferSize((header.sampleEnd - header.sampleStart) * format.BytesPerFrame());
 			uint64_t numFrames = audioSampleData->GetNumFrames();
@@ -366,6 +378,23 @@ bool SoundFontFormat::ConstructAudioSamples(
 	return true;
 }
 
+/*virtual*/ bool SoundFontFormat::OpenWaveTable(const char* filePath, std::unique_ptr<FileData>& fileData)
+{
+	// Samples get read in whatever order the music calls for them, so there's no use in the OS reading ahead.
+	this->mappedFile.reset(new MappedFileInputStream(filePath, MappedFileInputStream::RANDOM));
+	if (!this->mappedFile->IsOpen())
+	{
+		ErrorSystem::Get()->Add(std::format("Could not open file {}.", filePath));
+		this->mappedFile.reset();
+		return false;
+	}
+
+	// The samples are made to point into the file as it's read.  See ConstructAudioSamples.
+	bool success = this->ReadFromStream(*this->mappedFile, fileData);
+	this->mappedFile.reset();
+	return success;
+}
+
 /*virtual*/ bool SoundFontFormat::WriteToStream(ByteStream& outputStream, const FileData* fileData)
 {
 	ErrorSystem::Get()->Add("Not yet implimented.  (Probably never will be since SF files are insane.");
@@ -41,6 +41,7 @@ namespace AudioDataLib
 
 		virtual bool ReadFromStream(ByteStream& inputStream, std::unique_ptr<FileData>& fileData) override;
 		virtual bool WriteToStream(ByteStream& outputStream, const FileData* fileData) override;
+		virtual bool OpenWaveTable(const char* filePath, std::unique_ptr<FileData>& fileData) override;
 
 	private:
 		class SoundFontChunkParser : public ChunkParser
@@ -124,5 +125,7 @@ namespace AudioDataLib
 
 		typedef std::map<uint32_t, std::shared_ptr<SoundFontData::AudioSampleData>> SampleMap;
 		SampleMap* sampleMap;
+
+		std::shared_ptr<MappedFileInputStream> mappedFile;		///< This is only set while OpenWaveTable is reading the file.
 	};
 }
\ No newline at end of file
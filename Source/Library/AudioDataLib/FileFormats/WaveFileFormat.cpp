@@ -27,7 +27,44 @@ WaveFileFormat::WaveFileFormat()
 	return true;
 }
 
+/*virtual*/ bool WaveFileFormat::OpenAudioStream(const char* filePath, std::shared_ptr<FileAudioStream>& audioStream)
+{
+	std::shared_ptr<MappedFileInputStream> mappedFile(new MappedFileInputStream(filePath));
+	if (!mappedFile->IsOpen())
+	{
+		ErrorSystem::Get()->Add(std::format("Could not open file {}.", filePath));
+		return false;
+	}
+
+	// The parser works on the mapping in place, and only looks at the chunk headers, so the audio is never touched here.
+	WaveChunkParser parser;
+	if (!parser.ParseStream(*mappedFile))
+		return false;
+
+	AudioData::Format format;
+	const ChunkParser::Chunk* dataChunk = nullptr;
+	if (!LoadWaveFormat(format, dataChunk, parser.GetRootChunk()))
+		return false;
+
+	uint64_t dataOffset = uint64_t(dataChunk->GetBuffer() - mappedFile->GetBuffer());
+	audioStream.reset(new FileAudioStream(mappedFile, dataOffset, dataChunk->GetBufferSize(), format, false));
+	return true;
+}
+
 /*static*/ bool WaveFileFormat::LoadWaveData(AudioData* audioData, const ChunkParser::Chunk* waveChunk)
+{
+	AudioData::Format format;
+	const ChunkParser::Chunk* dataChunk = nullptr;
+	if (!LoadWaveFormat(format, dataChunk, waveChunk))
+		return false;
+
+	audioData->SetFormat(format);
+	audioData->SetAudioBufferSize(dataChunk->GetBufferSize());
+	::memcpy(audioData->GetAudioBuffer(), dataChunk->GetBuffer(), dataChunk->GetBufferSize());
+	return true;
+}
+
+/*static*/ bool WaveFileFormat::LoadWaveFormat(AudioData::Format& format, const ChunkParser::Chunk*& dataChunk, const ChunkParser::Chunk* waveChunk)
 {
 	const WaveChunkParser::Chunk* fmtChunk = waveChunk->FindChunk("fmt ", "", true);
 	if (!fmtChunk)
@@ -36,7 +73,7 @@ WaveFileFormat::WaveFileFormat()
 		return false;
 	}
 
-	const WaveChunkParser::Chunk* dataChunk = waveChunk->FindChunk("data", "", true);
+	dataChunk = waveChunk->FindChunk("data", "", true);
 	if (!dataChunk)
 	{
 		ErrorSystem::Get()->Add("Failed to find data chunk.");
@@ -87,7 +124,6 @@ WaveFileFormat::WaveFileFormat()
 		return false;
 	}
 
-	AudioData::Format format;
 	format.numChannels = numChannels;
 	format.framesPerSecond = sampleRateSamplesPerSecondPerChannel;
 	format.bitsPerSample = bitsPerSample;
@@ -179,9 +215,6 @@ WaveFileFormat::WaveFileFormat()
 		}
 	}
 
-	audioData->SetFormat(format);
-	audioData->SetAudioBufferSize(dataChunk->GetBufferSize());
-	::memcpy(audioData->GetAudioBuffer(), dataChunk->GetBuffer(), dataChunk->GetBufferSize());
 	return true;
 }
 
@@ -30,9 +30,11 @@ namespace AudioDataLib
 
 		virtual bool ReadFromStream(ByteStream& inputStream, std::unique_ptr<FileData>& fileData) override;
 		virtual bool WriteToStream(ByteStream& outputStream, const FileData* fileData) override;
+		virtual bool OpenAudioStream(const char* filePath, std::shared_ptr<FileAudioStream>& audioStream) override;
 
 	protected:
 		static bool LoadWaveData(AudioData* audioData, const ChunkParser::Chunk* waveChunk);
+		static bool LoadWaveFormat(AudioData::Format& format, const ChunkParser::Chunk*& dataChunk, const ChunkParser::Chunk* waveChunk);
 
 		class WaveChunkParser : public ChunkParser
 		{
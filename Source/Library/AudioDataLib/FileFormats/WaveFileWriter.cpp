@@ -0,0 +1,231 @@
+#include "AudioDataLib/FileFormats/WaveFileWriter.h"
+#include "AudioDataLib/FileFormats/WaveFileFormat.h"
+#include "AudioDataLib/ErrorSystem.h"
+
+using namespace AudioDataLib;
+
+// This is where everything is in the header we write.  The JUNK chunk becomes the ds64 chunk if we need RF64.
+#define WAVE_WRITER_RIFF_SIZE_OFFSET		4
+#define WAVE_WRITER_JUNK_OFFSET				12
+#define WAVE_WRITER_JUNK_SIZE				28
+#define WAVE_WRITER_FMT_OFFSET				48
+#define WAVE_WRITER_DATA_SIZE_OFFSET		76
+#define WAVE_WRITER_HEADER_SIZE				80
+
+WaveFileWriter::WaveFileWriter(const char* filePath, bool waitWhenFull /*= false*/)
+{
+	this->filePath = filePath;
+	this->finalStats = AsyncFileOutputStream::Stats{};
+	this->formatSet = false;
+	this->dataSize = 0;
+
+	this->outputStream.reset(new AsyncFileOutputStream(filePath, 256 * 1024, 4, waitWhenFull));
+	if (!this->outputStream->IsOpen())
+		this->outputStream.reset();
+}
+
+/*virtual*/ WaveFileWriter::~WaveFileWriter()
+{
+	this->Finalize();
+}
+
+bool WaveFileWriter::SetFormat(const AudioData::Format& format)
+{
+	if (!this->outputStream)
+	{
+		ErrorSystem::Get()->Add(std::format("WAVE file {} isn't open.", this->filePath.c_str()));
+		return false;
+	}
+
+	if (this->formatSet)
+	{
+		ErrorSystem::Get()->Add("The format of a WAVE file can only be set once.");
+		return false;
+	}
+
+	uint16_t type = 0;
+	if (format.sampleType == AudioData::Format::FLOAT && (format.bitsPerSample == 32 || format.bitsPerSample == 64))
+		type = WaveFileFormat::SampleFormat::IEEE_FLOAT;
+	else if (format.sampleType == AudioData::Format::SIGNED_INTEGER && format.bitsPerSample > 8)
+		type = WaveFileFormat::SampleFormat::PCM;
+	else if (format.sampleType == AudioData::Format::UNSIGNED_INTEGER && format.bitsPerSample == 8)
+		type = WaveFileFormat::SampleFormat::PCM;
+	else
+	{
+		// WAVE has no way to say whether integer samples are signed, so it's unsigned at 8 bits and signed otherwise.
+		ErrorSystem::Get()->Add("This format can't be stored in a WAVE file.");
+		return false;
+	}
+
+	if (format.numChannels == 0)
+	{
+		ErrorSystem::Get()->Add("Can't write a WAVE file with no channels.");
+		return false;
+	}
+
+	this->format = format;
+	this->formatSet = true;
+
+	// All the sizes are left zero for now.  See Finalize.
+	uint8_t header[WAVE_WRITER_HEADER_SIZE];
+	::memset(header, 0, sizeof(header));
+	WriteOnlyBufferStream headerStream(header, sizeof(header));
+
+	uint32_t zero = 0;
+	uint32_t junkSize = WAVE_WRITER_JUNK_SIZE;
+	uint32_t fmtSize = 16;
+	uint16_t numChannels = uint16_t(format.numChannels);
+	uint32_t framesPerSecond = uint32_t(format.framesPerSecond);
+	uint32_t bytesPerSecond = uint32_t(format.BytesPerSecond());
+	uint16_t blockAlign = uint16_t(format.BytesPerFrame());
+	uint16_t bitsPerSample = uint16_t(format.bitsPerSample);
+
+	headerStream.WriteBytesToStream((const uint8_t*)"RIFF", 4);
+	headerStream.WriteType(&zero);
+	headerStream.WriteBytesToStream((const uint8_t*)"WAVE", 4);
+	headerStream.WriteBytesToStream((const uint8_t*)"JUNK", 4);
+	headerStream.WriteType(&junkSize);
+	headerStream.SetWriteOffset(WAVE_WRITER_FMT_OFFSET);
+	headerStream.WriteBytesToStream((const uint8_t*)"fmt ", 4);
+	headerStream.WriteType(&fmtSize);
+	headerStream.WriteType(&type);
+	headerStream.WriteType(&numChannels);
+	headerStream.WriteType(&framesPerSecond);
+	headerStream.WriteType(&bytesPerSecond);
+	headerStream.WriteType(&blockAlign);
+	headerStream.WriteType(&bitsPerSample);
+	headerStream.WriteBytesToStream((const uint8_t*)"data", 4);
+	headerStream.WriteType(&zero);
+	assert(headerStream.GetWriteOffset() == WAVE_WRITER_HEADER_SIZE);
+
+	if (sizeof(header) != this->outputStream->WriteBytesToStream(header, sizeof(header)))
+	{
+		ErrorSystem::Get()->Add(std::format("Failed to write header of WAVE file {}.", this->filePath.c_str()));
+		return false;
+	}
+
+	return true;
+}
+
+/*virtual*/ uint64_t WaveFileWriter::WriteBytesToStream(const uint8_t* buffer, uint64_t bufferSize)
+{
+	if (!this->outputStream || !this->formatSet)
+		return 0;
+
+	uint64_t bytesPerFrame = this->format.BytesPerFrame();
+	bufferSize -= bufferSize % bytesPerFrame;
+
+	uint64_t numBytesWritten = this->outputStream->WriteBytesToStream(buffer, bufferSize);
+	this->dataSize += numBytesWritten;
+	return numBytesWritten;
+}
+
+/*virtual*/ uint64_t WaveFileWriter::ReadBytesFromStream(uint8_t* buffer, uint64_t bufferSize)
+{
+	return 0;
+}
+
+/*virtual*/ uint64_t WaveFileWriter::GetSize() const
+{
+	return this->dataSize;
+}
+
+/*virtual*/ bool WaveFileWriter::CanRead()
+{
+	return false;
+}
+
+/*virtual*/ bool WaveFileWriter::CanWrite()
+{
+	return this->outputStream && this->formatSet;
+}
+
+uint64_t WaveFileWriter::GetNumFramesWritten() const
+{
+	if (!this->formatSet)
+		return 0;
+
+	return this->dataSize / this->format.BytesPerFrame();
+}
+
+AsyncFileOutputStream::Stats WaveFileWriter::GetStats() const
+{
+	if (this->outputStream)
+		return this->outputStream->GetStats();
+
+	return this->finalStats;
+}
+
+bool WaveFileWriter::Finalize()
+{
+	if (!this->outputStream)
+		return true;
+
+	if (!this->formatSet)
+	{
+		// We never got going, so there's nothing worth keeping.
+		this->outputStream.reset();
+		::remove(this->filePath.c_str());
+		return true;
+	}
+
+	// Chunks have to be an even number of bytes long, but the size we give doesn't include the padding.
+	// We flush first so that there's sure to be room for the pad byte.
+	uint64_t padSize = this->dataSize & 1;
+	if (padSize > 0)
+	{
+		this->outputStream->Flush();
+		uint8_t pad = 0;
+		this->outputStream->WriteBytesToStream(&pad, 1);
+	}
+
+	this->outputStream->Close();
+	this->finalStats = this->outputStream->GetStats();
+	this->outputStream.reset();
+
+	if (this->finalStats.numWriteErrors > 0)
+	{
+		ErrorSystem::Get()->Add(std::format("Not all of WAVE file {} made it to the disk.", this->filePath.c_str()));
+		return false;
+	}
+
+	FILE* fp = fopen(this->filePath.c_str(), "r+b");
+	if (!fp)
+	{
+		ErrorSystem::Get()->Add(std::format("Could not reopen WAVE file {} to finish its header.", this->filePath.c_str()));
+		return false;
+	}
+
+	bool success = true;
+	uint64_t riffSize = (WAVE_WRITER_HEADER_SIZE - 8) + this->dataSize + padSize;
+
+	if (riffSize <= 0xFFFFFFFF)
+	{
+		uint32_t riffSize32 = uint32_t(riffSize);
+		uint32_t dataSize32 = uint32_t(this->dataSize);
+
+		success &= (0 == fseek(fp, WAVE_WRITER_RIFF_SIZE_OFFSET, SEEK_SET)) && (1 == fwrite(&riffSize32, 4, 1, fp));
+		success &= (0 == fseek(fp, WAVE_WRITER_DATA_SIZE_OFFSET, SEEK_SET)) && (1 == fwrite(&dataSize32, 4, 1, fp));
+	}
+	else
+	{
+		// In RF64, the 32-bit sizes are all ones, and the real sizes are found in the ds64 chunk.
+		uint32_t allOnes = 0xFFFFFFFF;
+		uint64_t numFrames = this->GetNumFramesWritten();
+		uint32_t tableSize = 0;
+
+		success &= (0 == fseek(fp, 0, SEEK_SET)) && (1 == fwrite("RF64", 4, 1, fp)) && (1 == fwrite(&allOnes, 4, 1, fp));
+		success &= (0 == fseek(fp, WAVE_WRITER_JUNK_OFFSET, SEEK_SET)) && (1 == fwrite("ds64", 4, 1, fp));
+		success &= (0 == fseek(fp, WAVE_WRITER_JUNK_OFFSET + 8, SEEK_SET));
+		success &= (1 == fwrite(&riffSize, 8, 1, fp)) && (1 == fwrite(&this->dataSize, 8, 1, fp));
+		success &= (1 == fwrite(&numFrames, 8, 1, fp)) && (1 == fwrite(&tableSize, 4, 1, fp));
+		success &= (0 == fseek(fp, WAVE_WRITER_DATA_SIZE_OFFSET, SEEK_SET)) && (1 == fwrite(&allOnes, 4, 1, fp));
+	}
+
+	success &= (0 == fclose(fp));
+
+	if (!success)
+		ErrorSystem::Get()->Add(std::format("Failed to finish the header of WAVE file {}.", this->filePath.c_str()));
+
+	return success;
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "AudioDataLib/ByteStream.h"
+#include "AudioDataLib/FileDatas/AudioData.h"
+
+namespace AudioDataLib
+{
+	/**
+	 * @brief This writes a WAVE file as the audio arrives, rather than all at once like the WaveFileFormat class does.
+	 *
+	 * Once we're given the format, we write a header with the sizes left blank, and then every write to us is appended
+	 * to the file as frames in that format.  Finalize goes back and fills in the sizes.  Nothing is ever held in memory
+	 * but a few blocks on their way to the disk, so a recording can be as long as the disk is big.  Writes go through
+	 * an AsyncFileOutputStream, so this is safe to write to from an audio callback.
+	 *
+	 * A plain WAVE file can't be bigger than 4 GB.  If we go over that, Finalize turns the file into an RF64 file,
+	 * which is the same thing with 64-bit sizes.  We leave room for that in the header up front (as a JUNK chunk,
+	 * which every reader skips), so nothing has to be moved when that happens.
+	 */
+	class AUDIO_DATA_LIB_API WaveFileWriter : public ByteStream
+	{
+	public:
+		/**
+		 * @param[in] filePath This is the file to create.
+		 * @param[in] waitWhenFull See the AsyncFileOutputStream class.  By default, audio is dropped rather than waited on if the disk can't keep up.
+		 */
+		WaveFileWriter(const char* filePath, bool waitWhenFull = false);
+		virtual ~WaveFileWriter();
+
+		bool IsOpen() const { return this->outputStream.get() != nullptr; }
+
+		/**
+		 * Set the format of the audio that will be written to us, and write the header.  This has to be called once,
+		 * before any audio is written, and can't be called again.
+		 */
+		bool SetFormat(const AudioData::Format& format);
+
+		const AudioData::Format& GetFormat() const { return this->format; }
+
+		/**
+		 * Append the given audio to the file.  Only whole frames are taken; anything left over is ignored.
+		 */
+		virtual uint64_t WriteBytesToStream(const uint8_t* buffer, uint64_t bufferSize) override;
+		virtual uint64_t ReadBytesFromStream(uint8_t* buffer, uint64_t bufferSize) override;
+
+		/**
+		 * Return the number of bytes of audio in the file so far.
+		 */
+		virtual uint64_t GetSize() const override;
+
+		virtual bool CanRead() override;
+		virtual bool CanWrite() override;
+
+		/**
+		 * Wait for everything written so far to reach the disk, and then fill in the sizes in the header.
+		 * Whoever is writing to us must be done before this is called, and nothing more can be written after.
+		 * This is called for you on destruction if you don't call it.
+		 */
+		bool Finalize();
+
+		uint64_t GetNumFramesWritten() const;
+
+		/**
+		 * Get the numbers from the stream underneath us, which will tell you if any audio was dropped.
+		 * Once we're finalized, these are the final numbers.
+		 */
+		AsyncFileOutputStream::Stats GetStats() const;
+
+	protected:
+		std::string filePath;
+		std::unique_ptr<AsyncFileOutputStream> outputStream;
+		AsyncFileOutputStream::Stats finalStats;
+		AudioData::Format format;
+		bool formatSet;
+		uint64_t dataSize;				///< This is how many bytes of audio have made it into the output stream.
+	};
+}
\ No newline at end of file
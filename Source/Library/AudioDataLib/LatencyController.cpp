@@ -0,0 +1,83 @@
+#include "AudioDataLib/LatencyController.h"
+
+using namespace AudioDataLib;
+
+LatencyController::LatencyController(double minTargetSeconds /*= 0.005*/, double maxTargetSeconds /*= 0.25*/, double initialTargetSeconds /*= 0.1*/)
+{
+	this->minTargetSeconds = minTargetSeconds;
+	this->maxTargetSeconds = ADL_MAX(minTargetSeconds, maxTargetSeconds);
+	this->refillFraction = 0.25;
+	this->settleTimeSeconds = 2.0;
+	this->growthFactor = 1.5;
+	this->numUnderruns = 0;
+	this->numOverruns = 0;
+	this->Reset(initialTargetSeconds);
+}
+
+/*virtual*/ LatencyController::~LatencyController()
+{
+}
+
+void LatencyController::SetBounds(double minTargetSeconds, double maxTargetSeconds)
+{
+	this->minTargetSeconds = minTargetSeconds;
+	this->maxTargetSeconds = ADL_MAX(minTargetSeconds, maxTargetSeconds);
+	this->SetTarget(this->targetSeconds);
+}
+
+void LatencyController::GetBounds(double& minTargetSeconds, double& maxTargetSeconds) const
+{
+	minTargetSeconds = this->minTargetSeconds;
+	maxTargetSeconds = this->maxTargetSeconds;
+}
+
+void LatencyController::Reset(double initialTargetSeconds)
+{
+	this->numUnderrunsHandled = this->numUnderruns;
+	this->SetTarget(initialTargetSeconds);
+}
+
+void LatencyController::ReportUnderrun()
+{
+	this->numUnderruns++;
+}
+
+void LatencyController::ReportOverrun()
+{
+	this->numOverruns++;
+}
+
+void LatencyController::ReportFillLevel(double secondsBuffered)
+{
+	// Underruns come in from the consumer's thread, so we only act on them here, on the producer's thread.
+	uint64_t numUnderruns = this->numUnderruns;
+	if (numUnderruns != this->numUnderrunsHandled)
+	{
+		this->numUnderrunsHandled = numUnderruns;
+		this->SetTarget(this->targetSeconds * this->growthFactor);
+		return;
+	}
+
+	// The most we ever ask for is the target plus one refill, so twice that is more than we can account for.
+	if (secondsBuffered > 2.0 * (this->targetSeconds + this->GetMinSecondsAddedPerMix()))
+		this->numOverruns++;
+
+	this->lowestFillSeconds = ADL_MIN(this->lowestFillSeconds, secondsBuffered);
+
+	// If the buffer never got below some level in all that time, then that much of it wasn't doing us any good.
+	// We only give back half of it, though, since the next while may not go as smoothly as the last.
+	if (this->settleTimer.GetElapsedTimeSeconds() >= this->settleTimeSeconds)
+		this->SetTarget(this->targetSeconds - 0.5 * this->lowestFillSeconds);
+}
+
+void LatencyController::SetTarget(double targetSeconds)
+{
+	this->targetSeconds = ADL_MAX(this->minTargetSeconds, ADL_MIN(targetSeconds, this->maxTargetSeconds));
+	this->StartSettling();
+}
+
+void LatencyController::StartSettling()
+{
+	this->lowestFillSeconds = std::numeric_limits<double>::max();
+	this->settleTimer.Start();
+}
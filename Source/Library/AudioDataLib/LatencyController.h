@@ -0,0 +1,110 @@
+#pragma once
+
+#include "AudioDataLib/Common.h"
+#include "AudioDataLib/Timer.h"
+#include <atomic>
+
+namespace AudioDataLib
+{
+	/**
+	 * @brief This decides how much audio to keep buffered ahead of the device, so that nobody has to tune it by hand.
+	 *
+	 * Whoever produces the audio (e.g., AudioSink::GenerateAudio or MidiSynth::Process) tells us how much is buffered
+	 * each time it's about to top up the buffer, and whoever consumes it (typically an audio device callback) tells us
+	 * whenever it found the buffer empty.  In return, we say how much should be buffered.
+	 *
+	 * The idea is to run with as little latency as the machine can take.  Every underrun grows the target right away,
+	 * since a drop-out is the worst thing that can happen.  If things have been running smoothly for a while, though,
+	 * the target is shrunk by half of the smallest amount that was left in the buffer in that time, which is to say,
+	 * by half of what we could have done without.  The target never leaves the bounds it's given.
+	 *
+	 * Underruns can be reported from any thread.  Everything else is meant to be called by the producer.
+	 */
+	class AUDIO_DATA_LIB_API LatencyController
+	{
+	public:
+		/**
+		 * @param[in] minTargetSeconds This is the least we'll ever try to keep buffered.
+		 * @param[in] maxTargetSeconds This is the most we'll ever try to keep buffered.
+		 * @param[in] initialTargetSeconds This is where we start.  It's best to start high and let us work our way down.
+		 */
+		LatencyController(double minTargetSeconds = 0.005, double maxTargetSeconds = 0.25, double initialTargetSeconds = 0.1);
+		virtual ~LatencyController();
+
+		/**
+		 * Change the range the target is allowed to be in.  The target is clamped to it right away.
+		 */
+		void SetBounds(double minTargetSeconds, double maxTargetSeconds);
+
+		/**
+		 * Get the range the target is allowed to be in.
+		 */
+		void GetBounds(double& minTargetSeconds, double& maxTargetSeconds) const;
+
+		/**
+		 * Start over at the given target, forgetting everything we've seen.
+		 */
+		void Reset(double initialTargetSeconds);
+
+		/**
+		 * The consumer calls this whenever it wanted audio and there wasn't enough.  This is safe to call from any thread.
+		 */
+		void ReportUnderrun();
+
+		/**
+		 * The consumer may call this whenever it had to throw audio away because it was handed too much.
+		 * This is safe to call from any thread.
+		 */
+		void ReportOverrun();
+
+		/**
+		 * The producer calls this right before it tops up the buffer, with how much is in the buffer at the moment.
+		 * This is where the target gets adjusted.  We also count it as an overrun if the buffer is holding a lot more
+		 * than we ever asked for, since that's latency we didn't plan on.
+		 */
+		void ReportFillLevel(double secondsBuffered);
+
+		/**
+		 * Return how much audio we'd like to have buffered.  The producer should top up whenever there's less than this.
+		 */
+		double GetTargetSeconds() const { return this->targetSeconds; }
+
+		/**
+		 * Return the least amount of audio the producer should add whenever it tops up.  Topping up a little past the
+		 * target like this keeps the producer from having to wake up for every little bit the consumer takes.
+		 */
+		double GetMinSecondsAddedPerMix() const { return this->targetSeconds * this->refillFraction; }
+
+		uint64_t GetNumUnderruns() const { return this->numUnderruns; }
+		uint64_t GetNumOverruns() const { return this->numOverruns; }
+
+		/**
+		 * Set how long things have to run smoothly before we'll shrink the target.
+		 */
+		void SetSettleTimeSeconds(double settleTimeSeconds) { this->settleTimeSeconds = settleTimeSeconds; }
+		double GetSettleTimeSeconds() const { return this->settleTimeSeconds; }
+
+		/**
+		 * Set how much the target is multiplied by on an underrun.  This should be greater than one.
+		 */
+		void SetGrowthFactor(double growthFactor) { this->growthFactor = growthFactor; }
+		double GetGrowthFactor() const { return this->growthFactor; }
+
+	private:
+
+		void SetTarget(double targetSeconds);
+		void StartSettling();
+
+		double minTargetSeconds;
+		double maxTargetSeconds;
+		double targetSeconds;
+		double refillFraction;					///< See GetMinSecondsAddedPerMix.
+		double settleTimeSeconds;
+		double growthFactor;
+		double lowestFillSeconds;				///< This is the least that was buffered at any fill since we started settling.
+		std::atomic<uint64_t> numUnderruns;
+		std::atomic<uint64_t> numOverruns;
+		uint64_t numUnderrunsHandled;			///< This is how many of the underruns we've grown the target for.
+		HighResTimer settleTimer;				///< This measures how long it has been since the target last changed.
+	};
+}
@@ -3,6 +3,7 @@
 #include "AudioDataLib/SynthModules/SynthModule.h"
 #include "AudioDataLib/WaveForm.h"
 #include "AudioDataLib/FileFormats/WaveFileFormat.h"
+#include "AudioDataLib/PCMConverter.h"
 
 using namespace AudioDataLib;
 
@@ -10,6 +11,8 @@ MidiSynth::MidiSynth()
 {
 	this->minLatencySeconds = 0.05;
 	this->maxLatencySeconds = 0.10;
+	this->synthesisRate = 0.0;
+	this->resamplerQuality = Resampler::Quality::SINC_32;
 }
 
 /*virtual*/ MidiSynth::~MidiSynth()
@@ -34,28 +37,100 @@ void MidiSynth::GetMinMaxLatency(double& minLatencySeconds, double& maxLatencySe
 	maxLatencySeconds = this->maxLatencySeconds;
 }
 
+void MidiSynth::SetSynthesisRate(double samplesPerSecond, Resampler::Quality quality /*= Resampler::Quality::SINC_32*/)
+{
+	MutexScopeLock scopeLock(&this->renderMutex);
+
+	this->synthesisRate = samplesPerSecond;
+	this->resamplerQuality = quality;
+
+	// Force the resamplers to get reconfigured on the next render pass.
+	this->resamplerArray.clear();
+}
+
 /*virtual*/ bool MidiSynth::Process()
 {
 	if (!this->audioStream)
 		return true;
 
-	if (this->maxLatencySeconds <= this->minLatencySeconds || this->minLatencySeconds <= 0.0)
+	const AudioData::Format& format = this->audioStream->GetFormat();
+	uint64_t currentStreamSizeBytes = this->audioStream->GetSize();
+	double currentBufferedTimeSeconds = format.BytesToSeconds(currentStreamSizeBytes);
+
+	double minLatencySeconds = this->minLatencySeconds;
+	double maxLatencySeconds = this->maxLatencySeconds;
+	if (this->latencyController)
+	{
+		this->latencyController->ReportFillLevel(currentBufferedTimeSeconds);
+		minLatencySeconds = this->latencyController->GetTargetSeconds();
+		maxLatencySeconds = minLatencySeconds + this->latencyController->GetMinSecondsAddedPerMix();
+	}
+
+	if (maxLatencySeconds <= minLatencySeconds || minLatencySeconds <= 0.0)
 	{
 		ErrorSystem::Get()->Add("Min/max latency parameters are not set correctly.");
 		return false;
 	}
 
-	const AudioData::Format& format = this->audioStream->GetFormat();
-	uint64_t currentStreamSizeBytes = this->audioStream->GetSize();
-	double currentBufferedTimeSeconds = format.BytesToSeconds(currentStreamSizeBytes);
-	if (currentBufferedTimeSeconds >= this->minLatencySeconds)
+	if (currentBufferedTimeSeconds >= minLatencySeconds)
+		return true;
+
+	double timeNeededSeconds = maxLatencySeconds - currentBufferedTimeSeconds;
+	uint64_t numFrames = uint64_t(timeNeededSeconds * double(format.SamplesPerSecondPerChannel()));
+	if (numFrames == 0)
 		return true;
 
-	double timeNeededSeconds = this->maxLatencySeconds - currentBufferedTimeSeconds;
+	MutexScopeLock scopeLock(&this->renderMutex);
+
+	// Everything the synth modules need for this pass should come out of our arena.
+	this->renderArena.Reset();
+	RenderArena::Scope renderArenaScope(&this->renderArena);
+
+	uint64_t audioBufferSize = numFrames * format.BytesPerFrame();
+	uint8_t* audioBuffer = this->renderArena.AllocateArray<uint8_t>(audioBufferSize);
+	if (!this->RenderFrames(format, audioBuffer, numFrames))
+		return false;
+
+	this->audioStream->WriteBytesToStream(audioBuffer, audioBufferSize);
+	return true;
+}
+
+bool MidiSynth::Render(const AudioData::Format& format, uint8_t* audioBuffer, uint64_t audioBufferSize)
+{
+	MutexScopeLock scopeLock(&this->renderMutex);
+
+	this->renderArena.Reset();
+	RenderArena::Scope renderArenaScope(&this->renderArena);
+
+	// Whatever doesn't make up a whole frame is left silent.
+	uint64_t numFrames = audioBufferSize / format.BytesPerFrame();
+	uint64_t numBytesRendered = numFrames * format.BytesPerFrame();
+	if (numBytesRendered < audioBufferSize)
+		::memset(&audioBuffer[numBytesRendered], 0, size_t(audioBufferSize - numBytesRendered));
+
+	if (numFrames == 0)
+		return true;
 
-	uint64_t audioBufferSize = format.BytesFromSeconds(timeNeededSeconds);
-	uint8_t* audioBuffer = new uint8_t[audioBufferSize];
-	::memset(audioBuffer, 0, audioBufferSize);
+	if (!this->RenderFrames(format, audioBuffer, numFrames))
+	{
+		::memset(audioBuffer, 0, size_t(numBytesRendered));
+		return false;
+	}
+
+	return true;
+}
+
+bool MidiSynth::RenderFrames(const AudioData::Format& format, uint8_t* audioBuffer, uint64_t numFrames)
+{
+	if (this->synthesisRate > 0.0 && this->synthesisRate != double(format.SamplesPerSecondPerChannel()))
+		return this->RenderFramesResampled(format, audioBuffer, numFrames);
+
+	// The synth modules advance their notion of time by exactly as much as we ask for, so asking for a
+	// whole number of frames keeps one pass lined up with the next.
+	double streamRate = double(format.SamplesPerSecondPerChannel());
+	double durationSeconds = double(numFrames) / streamRate;
+	uint64_t audioBufferSize = numFrames * format.BytesPerFrame();
+	::memset(audioBuffer, 0, size_t(audioBufferSize));
 
 	for (uint16_t i = 0; i < format.numChannels; i++)
 	{
@@ -63,26 +138,87 @@ void MidiSynth::GetMinMaxLatency(double& minLatencySeconds, double& maxLatencySe
 		if (!synthModule)
 			continue;
 
-		WaveForm waveForm;
-		if (!synthModule->GenerateSound(timeNeededSeconds, format.SamplesPerSecondPerChannel(), waveForm, nullptr))
+		RenderArena::ScratchWaveForm waveForm;
+		if (!synthModule->GenerateSound(durationSeconds, streamRate, *waveForm, nullptr))
 		{
 			ErrorSystem::Get()->Add(std::format("Failed to generate wave-form for channel {}.", i));
-			break;
+			return false;
 		}
 
-		if (!waveForm.ConvertToAudioBuffer(format, audioBuffer, audioBufferSize, i))
+		if (!waveForm->ConvertToAudioBuffer(format, audioBuffer, audioBufferSize, i))
 		{
 			ErrorSystem::Get()->Add(std::format("Failed to generate audio for channel {}.", i));
-			break;
+			return false;
 		}
 	}
 
-	if (!ErrorSystem::Get()->Errors())
-		this->audioStream->WriteBytesToStream(audioBuffer, audioBufferSize);
+	return true;
+}
+
+bool MidiSynth::RenderFramesResampled(const AudioData::Format& format, uint8_t* audioBuffer, uint64_t numFrames)
+{
+	double streamRate = double(format.SamplesPerSecondPerChannel());
+
+	// The resamplers are set up just once, and from then on they carry their state from one call to the next.
+	if (this->resamplerArray.size() != format.numChannels || this->resamplerArray[0].GetOutputRate() != streamRate)
+	{
+		this->resamplerArray.resize(format.numChannels);
+		for (Resampler& resampler : this->resamplerArray)
+			if (!resampler.Configure(this->synthesisRate, streamRate, this->resamplerQuality))
+				return false;
+
+		this->resampledArray.resize(format.numChannels);
+	}
+
+	// All the resamplers have been fed the same amount so far, so they all need the same amount more to give us
+	// exactly the frames we want.  That's how much the synth modules synthesize.
+	uint64_t numInputSamples = this->resamplerArray[0].GetInputNeeded(numFrames);
+	double durationSeconds = double(numInputSamples) / this->synthesisRate;
 
-	delete[] audioBuffer;
+	PCMConverter converter;
+	if (!converter.Configure(format))
+		return false;
+
+	::memset(audioBuffer, 0, size_t(numFrames * format.BytesPerFrame()));
+
+	for (uint16_t i = 0; i < format.numChannels; i++)
+	{
+		SynthModule* synthModule = this->GetRootModule(i);
+		if (!synthModule)
+			continue;
+
+		RenderArena::ScratchWaveForm scratchWaveForm;
+		WaveForm& waveForm = *scratchWaveForm;
+		if (!synthModule->GenerateSound(durationSeconds, this->synthesisRate, waveForm, nullptr))
+		{
+			ErrorSystem::Get()->Add(std::format("Failed to generate wave-form for channel {}.", i));
+			return false;
+		}
+
+		const double* inputBuffer = nullptr;
+		if (waveForm.IsUniform() && waveForm.GetUniformSampleRate() == this->synthesisRate && waveForm.GetStartTime() == 0.0 && waveForm.GetAmplitudeArray().size() >= numInputSamples)
+			inputBuffer = waveForm.GetAmplitudeArray().data();
+		else
+		{
+			if (this->resamplerInputBuffer.size() < numInputSamples)
+				this->resamplerInputBuffer.resize(numInputSamples);
+			waveForm.EvaluateBlock(0.0, 1.0 / this->synthesisRate, this->resamplerInputBuffer.data(), numInputSamples);
+			inputBuffer = this->resamplerInputBuffer.data();
+		}
+
+		std::vector<double>& resampledBuffer = this->resampledArray[i];
+		if (resampledBuffer.size() < numFrames)
+			resampledBuffer.resize(numFrames);
+
+		uint64_t numInputSamplesConsumed = 0;
+		uint64_t numOutputSamples = this->resamplerArray[i].Process(inputBuffer, numInputSamples, resampledBuffer.data(), numFrames, numInputSamplesConsumed);
+		for (uint64_t j = numOutputSamples; j < numFrames; j++)
+			resampledBuffer[j] = 0.0;
+
+		converter.EncodeChannel(resampledBuffer.data(), audioBuffer, i, numFrames);
+	}
 
-	return !ErrorSystem::Get()->Errors();
+	return true;
 }
 
 /*static*/ double MidiSynth::MidiPitchToFrequency(uint8_t pitchValue)
@@ -3,6 +3,10 @@
 #include "AudioDataLib/MIDI/MidiMsgDestination.h"
 #include "AudioDataLib/ByteStream.h"
 #include "AudioDataLib/FileDatas/AudioData.h"
+#include "AudioDataLib/Resampler.h"
+#include "AudioDataLib/RenderArena.h"
+#include "AudioDataLib/Mutex.h"
+#include "AudioDataLib/LatencyController.h"
 
 namespace AudioDataLib
 {
@@ -33,6 +37,28 @@ namespace AudioDataLib
 		 */
 		virtual bool Process() override;
 
+		/**
+		 * This is the pull-mode alternative to Process.  Rather than keep our audio stream topped up, synthesize
+		 * exactly as much audio as fits in the given buffer, in the given format, straight into it.  This is meant
+		 * to be called from an audio device callback, so that latency is just one device period and nothing gets
+		 * copied in between.  Leave the audio stream unset if you do this, so that Process doesn't also synthesize.
+		 *
+		 * Note that this typically runs on a different thread than the one receiving MIDI messages, which is
+		 * what the render mutex is for.
+		 *
+		 * @param[in] format This is the format of the audio to synthesize.
+		 * @param[out] audioBuffer This receives the audio.  It is silenced if synthesis fails.
+		 * @param[in] audioBufferSize This is the size of the given buffer in bytes.
+		 * @return True is returned on success; false otherwise.
+		 */
+		bool Render(const AudioData::Format& format, uint8_t* audioBuffer, uint64_t audioBufferSize);
+
+		/**
+		 * This is held while we synthesize.  Derived classes hold it while they change their synth modules
+		 * (e.g., in response to a MIDI message), so that this can be done while another thread is rendering.
+		 */
+		Mutex* GetRenderMutex() { return &this->renderMutex; }
+
 		/**
 		 * A derived class must impliment this method to provide a SynthModule that can
 		 * feed the given channel.  Note that the term "channel" is overloaded.  It can
@@ -44,7 +70,7 @@ namespace AudioDataLib
 
 		/**
 		 * The goal of this class is to feed the given AudioStream class.
-		 * Typically this is chosen as a ThreadSafeAudioStream, because, while it is
+		 * Typically this is chosen as a RingBufferAudioStream (or ThreadSafeAudioStream), because, while it is
 		 * fed on the main thread, it is usually consumed in a time-sensative audio callback
 		 * running on a dedicated audio thread.
 		 */
@@ -92,11 +118,54 @@ namespace AudioDataLib
 		 */
 		void GetMinMaxLatency(double& minLatencySeconds, double& maxLatencySeconds) const;
 
+		/**
+		 * Let the given controller decide the latency range instead, as the machine allows.  Whoever consumes our
+		 * audio stream should report underruns to it.  Pass null to go back to the range given to SetMinMaxLatency.
+		 */
+		void SetLatencyController(std::shared_ptr<LatencyController> latencyController) { this->latencyController = latencyController; }
+
+		std::shared_ptr<LatencyController> GetLatencyController() { return this->latencyController; }
+
+		/**
+		 * Run the synth modules at the given sample-rate instead of at the rate of our audio stream, and
+		 * then stream what they generate through a resampler on its way out.  This is handy if the device
+		 * insists on a rate that doesn't suit the synthesis, or to save some CPU by synthesizing at a lower
+		 * rate.  The resampler keeps its state from one call of Process to the next, so there are no seams.
+		 *
+		 * @param samplesPerSecond This is the rate at which to synthesize.  Pass zero to just synthesize at the rate of the audio stream.
+		 * @param quality This is the kind of resampling to do.
+		 */
+		void SetSynthesisRate(double samplesPerSecond, Resampler::Quality quality = Resampler::Quality::SINC_32);
+
+		/**
+		 * Return the rate at which we synthesize, or zero if we synthesize at the rate of the audio stream.
+		 */
+		double GetSynthesisRate() const { return this->synthesisRate; }
+
+		/**
+		 * Return the arena that our synth modules get their scratch memory from during Process.
+		 * Its statistics tell you whether rendering is still touching the heap.
+		 */
+		const RenderArena& GetRenderArena() const { return this->renderArena; }
+
 	protected:
 
+		bool RenderFrames(const AudioData::Format& format, uint8_t* audioBuffer, uint64_t numFrames);
+		bool RenderFramesResampled(const AudioData::Format& format, uint8_t* audioBuffer, uint64_t numFrames);
+
 		std::shared_ptr<AudioStream> audioStream;
 
 		double minLatencySeconds;		///< This is the minimum amount of audio (measured in seconds) that should always be buffered at any given time.
 		double maxLatencySeconds;		///< This is the maximum amount of audio (measured in seconds) that should always be buffered at any given time.
+		std::shared_ptr<LatencyController> latencyController;	///< If we have one of these, it overrides the latency range.
+
+		double synthesisRate;								///< If non-zero, this is the rate at which we synthesize before resampling to the rate of the audio stream.
+		Resampler::Quality resamplerQuality;
+		std::vector<Resampler> resamplerArray;				///< There is one resampler per channel of the audio stream.
+		std::vector<std::vector<double>> resampledArray;	///< These receive the resampled audio for each channel.  They only ever grow.
+		std::vector<double> resamplerInputBuffer;			///< This is used when a generated wave-form isn't already on the grid we want.
+
+		RenderArena renderArena;							///< This is reset and made current at the start of every render pass.
+		StandardMutex renderMutex;
 	};
 }
\ No newline at end of file
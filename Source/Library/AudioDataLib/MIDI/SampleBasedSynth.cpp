@@ -1,5 +1,6 @@
 #include "AudioDataLib/MIDI/SampleBasedSynth.h"
 #include "AudioDataLib/SynthModules/LoopedAudioModule.h"
+#include "AudioDataLib/SynthModules/StreamedAudioModule.h"
 #include "AudioDataLib/SynthModules/PitchShiftModule.h"
 #include "AudioDataLib/SynthModules/AttenuationModule.h"
 #include "AudioDataLib/SynthModules/ReverbModule.h"
@@ -16,7 +17,10 @@ SampleBasedSynth::SampleBasedSynth()
 {
 	this->reverbEnabled = false;
 	this->estimateFrequencies = false;
+	this->interpMethod = WaveForm::InterpolationMethod::HERMITE;
 	this->waveTableData = nullptr;
+	this->streamingPreloadSeconds = 0.0;
+	this->sampleStreamer = nullptr;
 
 	this->SetReverbEnabled(false);
 }
@@ -24,6 +28,9 @@ SampleBasedSynth::SampleBasedSynth()
 /*virtual*/ SampleBasedSynth::~SampleBasedSynth()
 {
 	this->Clear();
+
+	// Any voices still around hold onto their streams, which are fine without us.
+	delete this->sampleStreamer;
 }
 
 bool SampleBasedSynth::SetWaveTableData(std::unique_ptr<FileData>& fileData)
@@ -48,17 +55,24 @@ std::shared_ptr<WaveTableData> SampleBasedSynth::GetWaveTableData()
 
 /*virtual*/ bool SampleBasedSynth::Process()
 {
-	MixerModule* leftMixerModule = this->leftEarRootModule->FindModule<MixerModule>();
-	leftMixerModule->PruneDeadBranches();
+	{
+		MutexScopeLock scopeLock(this->GetRenderMutex());
 
-	MixerModule* rightMixerModule = this->rightEarRootModule->FindModule<MixerModule>();
-	rightMixerModule->PruneDeadBranches();
+		MixerModule* leftMixerModule = this->leftEarRootModule->FindModule<MixerModule>();
+		leftMixerModule->PruneDeadBranches();
+
+		MixerModule* rightMixerModule = this->rightEarRootModule->FindModule<MixerModule>();
+		rightMixerModule->PruneDeadBranches();
+	}
 
 	return MidiSynth::Process();
 }
 
 /*virtual*/ bool SampleBasedSynth::ReceiveMessage(double deltaTimeSeconds, const uint8_t* message, uint64_t messageSize)
 {
+	// Finding a sample can mean reading it in from its file, so that's done under our own lock, not the render lock.
+	MutexScopeLock sampleScopeLock(&this->sampleMutex);
+
 	if (!this->waveTableData)
 	{
 		ErrorSystem::Get()->Add("No wave-table set!");
@@ -80,6 +94,34 @@ std::shared_ptr<WaveTableData> SampleBasedSynth::GetWaveTableData()
 		return false;
 	}
 
+	// A new note's voice is built before the render lock is taken, so that the audio thread never waits on the disk.
+	Note note;
+	if (channelEvent.type == MidiData::ChannelEvent::NOTE_ON)
+	{
+		uint8_t pitchValue = channelEvent.param1;
+		uint8_t velocityValue = channelEvent.param2;
+
+		double noteFrequency = this->MidiPitchToFrequency(pitchValue);
+		double noteVolume = this->MidiVelocityToAmplitude(velocityValue);
+
+		const WaveTableData::AudioSampleData* audioSampleData = this->waveTableData->FindAudioSample(instrument, pitchValue, velocityValue);
+		if (!audioSampleData)
+		{
+			ErrorSystem::Get()->Add(std::format("Failed to find audio sample for pitch {} ({}) and volume {} ({}).", pitchValue, noteFrequency, velocityValue, noteVolume));
+			return false;
+		}
+
+		if (!this->GenerateModuleGraph(audioSampleData, noteFrequency, note.leftEarModule))
+			return false;
+
+		if(!this->reverbEnabled)
+			if (!this->GenerateModuleGraph(audioSampleData, noteFrequency, note.rightEarModule))
+				return false;
+	}
+
+	// The audio thread may be rendering our modules as we change them.
+	MutexScopeLock scopeLock(this->GetRenderMutex());
+
 	switch (channelEvent.type)
 	{
 		case MidiData::ChannelEvent::PROGRAM_CHANGE:
@@ -92,7 +134,6 @@ std::shared_ptr<WaveTableData> SampleBasedSynth::GetWaveTableData()
 		case MidiData::ChannelEvent::NOTE_ON:
 		{
 			uint8_t pitchValue = channelEvent.param1;
-			uint8_t velocityValue = channelEvent.param2;
 
 			NoteMap::iterator iter = this->noteMap.find(pitchValue);
 			if (iter != this->noteMap.end())
@@ -103,25 +144,6 @@ std::shared_ptr<WaveTableData> SampleBasedSynth::GetWaveTableData()
 				return false;
 			}
 
-			double noteFrequency = this->MidiPitchToFrequency(pitchValue);
-			double noteVolume = this->MidiVelocityToAmplitude(velocityValue);
-
-			const WaveTableData::AudioSampleData* audioSampleData = this->waveTableData->FindAudioSample(instrument, pitchValue, velocityValue);
-			if (!audioSampleData)
-			{
-				ErrorSystem::Get()->Add(std::format("Failed to find audio sample for pitch {} ({}) and volume {} ({}).", pitchValue, noteFrequency, velocityValue, noteVolume));
-				return false;
-			}
-
-			Note note;
-
-			if (!this->GenerateModuleGraph(audioSampleData, noteFrequency, note.leftEarModule))
-				return false;
-
-			if(!this->reverbEnabled)
-				if (!this->GenerateModuleGraph(audioSampleData, noteFrequency, note.rightEarModule))
-					return false;
-
 			this->noteMap.insert(std::pair<uint8_t, Note>(pitchValue, note));
 
 			MixerModule* leftMixerModule = this->leftEarRootModule->FindModule<MixerModule>();
@@ -184,16 +206,37 @@ std::shared_ptr<WaveTableData> SampleBasedSynth::GetWaveTableData()
 
 bool SampleBasedSynth::GenerateModuleGraph(const WaveTableData::AudioSampleData* audioSampleData, double noteFrequency, std::shared_ptr<SynthModule>& synthModule)
 {
-	auto loopedAudioModule = new LoopedAudioModule();
-	if (!loopedAudioModule->UseLoopedAudioData(audioSampleData, 0))
+	std::shared_ptr<SynthModule> audioModule;
+	double sourceFrequency = audioSampleData->GetMetaData().pitch;
+
+	if (this->sampleStreamer && audioSampleData->IsStreamed())
 	{
-		delete loopedAudioModule;
-		return false;
+		auto streamedAudioModule = new StreamedAudioModule();
+		audioModule.reset(streamedAudioModule);
+		if (!streamedAudioModule->UseStreamedAudioData(audioSampleData, this->sampleStreamer, (sourceFrequency > 0.0) ? (noteFrequency / sourceFrequency) : 1.0))
+			return false;
+
+		std::shared_ptr<WaveForm> preloadedWaveForm = audioSampleData->GetPreloadedWaveForm();
+		if (preloadedWaveForm->GetInterpolationMethod() != this->interpMethod)
+			preloadedWaveForm->SetInterpolateionMethod(this->interpMethod);
+	}
+	else
+	{
+		auto loopedAudioModule = new LoopedAudioModule();
+		audioModule.reset(loopedAudioModule);
+		if (!loopedAudioModule->UseLoopedAudioData(audioSampleData, 0))
+			return false;
+
+		// The sample may have only just been read in, so this is the first chance we get to set this.  Voices already
+		// playing the sample may be reading its wave-form as we go, which is why we don't touch it unless we have to.
+		std::shared_ptr<WaveForm> waveForm = audioSampleData->GetCachedWaveForm(0);
+		if (waveForm->GetInterpolationMethod() != this->interpMethod)
+			waveForm->SetInterpolateionMethod(this->interpMethod);
 	}
 
 	auto pitchShiftModule = new PitchShiftModule();
-	pitchShiftModule->SetSourceAndTargetFrequencies(audioSampleData->GetMetaData().pitch, noteFrequency);
-	pitchShiftModule->AddDependentModule(std::shared_ptr<SynthModule>(loopedAudioModule));
+	pitchShiftModule->SetSourceAndTargetFrequencies(sourceFrequency, noteFrequency);
+	pitchShiftModule->AddDependentModule(audioModule);
 
 	auto attenuationModule = new AttenuationModule();
 	attenuationModule->AddDependentModule(std::shared_ptr<SynthModule>(pitchShiftModule));
@@ -217,6 +260,10 @@ bool SampleBasedSynth::GenerateModuleGraph(const WaveTableData::AudioSampleData*
 
 void SampleBasedSynth::SetReverbEnabled(bool reverbEnabled)
 {
+	// Whether there's reverb decides what voices ReceiveMessage builds, and it builds them under the sample lock.
+	MutexScopeLock sampleScopeLock(&this->sampleMutex);
+	MutexScopeLock scopeLock(this->GetRenderMutex());
+
 	this->reverbEnabled = reverbEnabled;
 
 	this->leftEarRootModule.reset();
@@ -259,6 +306,13 @@ void SampleBasedSynth::SetReverbEnabled(bool reverbEnabled)
 		return false;
 	}
 
+	if (this->streamingPreloadSeconds > 0.0 && !this->sampleStreamer)
+		this->sampleStreamer = new SampleStreamer();
+
+	if (this->waveTableData->GetStreamingPreload() != this->streamingPreloadSeconds)
+		if (!this->waveTableData->SetStreamingPreload(this->streamingPreloadSeconds))
+			return false;
+
 	for (uint32_t i = 0; i < this->waveTableData->GetNumAudioSamples(); i++)
 	{
 		auto audioSampleData = dynamic_cast<const WaveTableData::AudioSampleData*>(this->waveTableData->GetAudioSample(i));
@@ -290,12 +344,70 @@ void SampleBasedSynth::SetReverbEnabled(bool reverbEnabled)
 			audioSampleData->SetMetaData(metaData);
 		}
 
-		audioSampleData->GetCachedWaveForm(0);
+		// Samples still in their file are left there until they're played.  See PrefetchSamples.
+		if (audioSampleData->IsResident())
+		{
+			std::shared_ptr<WaveForm> waveForm = audioSampleData->GetCachedWaveForm(0);
+			if (waveForm)
+				waveForm->SetInterpolateionMethod(this->interpMethod);
+		}
+
+		std::shared_ptr<WaveForm> preloadedWaveForm = audioSampleData->GetPreloadedWaveForm();
+		if (preloadedWaveForm)
+			preloadedWaveForm->SetInterpolateionMethod(this->interpMethod);
 	}
 
 	return true;
 }
 
+bool SampleBasedSynth::PrefetchSamples(const MidiData* midiData)
+{
+	MutexScopeLock scopeLock(&this->sampleMutex);
+
+	if (!this->waveTableData)
+	{
+		ErrorSystem::Get()->Add("No wave-table set!");
+		return false;
+	}
+
+	for (uint32_t i = 0; i < midiData->GetNumTracks(); i++)
+	{
+		const MidiData::Track* track = midiData->GetTrack(i);
+
+		// Program changes are played out here just as ReceiveMessage would, but without touching the real mapping.
+		ChannelMap channelMap = this->channelMap;
+
+		for (const MidiData::Event* event : track->GetEventArray())
+		{
+			auto channelEvent = dynamic_cast<const MidiData::ChannelEvent*>(event);
+			if (!channelEvent)
+				continue;
+
+			if (channelEvent->type == MidiData::ChannelEvent::PROGRAM_CHANGE)
+				channelMap[channelEvent->channel + 1] = channelEvent->param1 + 1;
+			else if (channelEvent->type == MidiData::ChannelEvent::NOTE_ON && channelEvent->param2 > 0)
+			{
+				ChannelMap::iterator iter = channelMap.find(channelEvent->channel + 1);
+				if (iter == channelMap.end())
+					continue;
+
+				if (!this->waveTableData->PrefetchAudioSample(iter->second, channelEvent->param1, channelEvent->param2))
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+SampleStreamer::Stats SampleBasedSynth::GetStreamingStats() const
+{
+	if (!this->sampleStreamer)
+		return SampleStreamer::Stats{};
+
+	return this->sampleStreamer->GetStats();
+}
+
 bool SampleBasedSynth::SetChannelInstrument(uint8_t channel, uint8_t instrument)
 {
 	if (!(1 <= channel && channel <= 16))
@@ -2,11 +2,14 @@
 
 #include "AudioDataLib/MIDI/MidiSynth.h"
 #include "AudioDataLib/FileDatas/WaveTableData.h"
+#include "AudioDataLib/WaveForm.h"
+#include "AudioDataLib/SampleStreamer.h"
 
 namespace AudioDataLib
 {
 	class MixerModule;
 	class SoundFontData;
+	class MidiData;
 
 	/**
 	 * @brief This class knows how to synthesize real-time sound as a function of MIDI messages and WaveTableData.
@@ -33,9 +36,45 @@ namespace AudioDataLib
 		void SetReverbEnabled(bool reverbEnabled);
 		bool GetReverbEnabled() { return this->reverbEnabled; }
 
+		/**
+		 * Choose how the wave-table samples get interpolated when they're played back at a pitch other
+		 * than their own.  Linear is cheapest, but dulls the highs and aliases more than the cubic methods do.
+		 * This takes effect on the next note played.
+		 */
+		void SetInterpolationMethod(WaveForm::InterpolationMethod interpMethod) { this->interpMethod = interpMethod; }
+		WaveForm::InterpolationMethod GetInterpolationMethod() const { return this->interpMethod; }
+
+		/**
+		 * Read in every sample of our wave-table that the given MIDI data is going to play, given how channels are
+		 * currently mapped to instruments (and how the MIDI data changes that mapping as it goes.)  This only matters
+		 * if the wave-table was opened with FileFormat::OpenWaveTable, where samples are otherwise read in as their
+		 * first note is played.  Rendering goes on while this works, but notes played in the meantime wait for it, so
+		 * call this before playback.  Note that if the wave-table's residency budget is too small for everything, the
+		 * samples read in first are let go of again.
+		 */
+		bool PrefetchSamples(const MidiData* midiData);
+
+		/**
+		 * Stream long samples from their file as they're played, rather than reading them in whole.  Only the first
+		 * preloadSeconds of each such sample is kept in memory, which is enough for a note to start right away while
+		 * a thread of ours reads in the rest (see SampleStreamer.)  This only matters if the wave-table was opened with
+		 * FileFormat::OpenWaveTable.  Call this before Initialize, which reads in the preloads.  Zero turns streaming off.
+		 */
+		void SetStreamingPreload(double streamingPreloadSeconds) { this->streamingPreloadSeconds = streamingPreloadSeconds; }
+		double GetStreamingPreload() const { return this->streamingPreloadSeconds; }
+
+		/**
+		 * Get the numbers that tell you how well the disk is keeping up with the streamed samples.
+		 * A voice that gets ahead of the disk plays silence for a moment, which shows up here as an underrun.
+		 */
+		SampleStreamer::Stats GetStreamingStats() const;
+
 	private:
 		bool estimateFrequencies;
 		bool reverbEnabled;
+		WaveForm::InterpolationMethod interpMethod;
+		double streamingPreloadSeconds;
+		SampleStreamer* sampleStreamer;
 
 		// This maps channel to instrument number.
 		typedef std::map<uint8_t, uint8_t> ChannelMap;
@@ -43,6 +82,10 @@ namespace AudioDataLib
 
 		std::shared_ptr<WaveTableData> waveTableData;
 
+		// This guards the wave-table's residency and the channel mapping, which the audio thread never touches.
+		// When both this and the render mutex are needed, this one is always taken first.
+		StandardMutex sampleMutex;
+
 		struct Note
 		{
 			std::shared_ptr<SynthModule> leftEarModule;
@@ -28,6 +28,9 @@ SimpleSynth::SimpleSynth()
 
 /*virtual*/ bool SimpleSynth::ReceiveMessage(double deltaTimeSeconds, const uint8_t* message, uint64_t messageSize)
 {
+	// The audio thread may be rendering our modules as we change them.
+	MutexScopeLock scopeLock(this->GetRenderMutex());
+
 	MidiData::ChannelEvent channelEvent;
 	ReadOnlyBufferStream bufferStream(message, messageSize);
 	if (!channelEvent.Decode(bufferStream))
@@ -0,0 +1,712 @@
+#include "AudioDataLib/PCMConverter.h"
+#include "AudioDataLib/ErrorSystem.h"
+#include "AudioDataLib/SIMD.h"
+#include <atomic>
+
+using namespace AudioDataLib;
+
+//---------------------------------- Scalar Kernels ----------------------------------
+
+// Signed integers normalize by their maximum; unsigned integers get mapped from [0,max] onto [-1,1].
+template<typename T>
+constexpr double DecodeScale()
+{
+	return std::is_signed_v<T> ? (1.0 / double(std::numeric_limits<T>::max())) : (2.0 / double(std::numeric_limits<T>::max()));
+}
+
+template<typename T>
+constexpr double DecodeOffset()
+{
+	return std::is_signed_v<T> ? 0.0 : -1.0;
+}
+
+template<typename T>
+constexpr double EncodeScale()
+{
+	return std::is_signed_v<T> ? double(std::numeric_limits<T>::max()) : (double(std::numeric_limits<T>::max()) / 2.0);
+}
+
+template<typename T>
+constexpr double EncodeOffset()
+{
+	return std::is_signed_v<T> ? 0.0 : (double(std::numeric_limits<T>::max()) / 2.0);
+}
+
+template<typename T>
+static void DecodeIntegerScalar(const uint8_t* sampleBuffer, uint64_t strideBytes, double* amplitudeBuffer, uint64_t numSamples)
+{
+	constexpr double scale = DecodeScale<T>();
+	constexpr double offset = DecodeOffset<T>();
+
+	for (uint64_t i = 0; i < numSamples; i++)
+	{
+		T sample = 0;
+		::memcpy(&sample, &sampleBuffer[i * strideBytes], sizeof(T));
+		amplitudeBuffer[i] = double(sample) * scale + offset;
+	}
+}
+
+template<typename T>
+static void EncodeIntegerScalar(const double* amplitudeBuffer, uint8_t* sampleBuffer, uint64_t strideBytes, uint64_t numSamples)
+{
+	constexpr double scale = EncodeScale<T>();
+	constexpr double offset = EncodeOffset<T>();
+	constexpr double minSample = double(std::numeric_limits<T>::min());
+	constexpr double maxSample = double(std::numeric_limits<T>::max());
+
+	for (uint64_t i = 0; i < numSamples; i++)
+	{
+		double value = amplitudeBuffer[i] * scale + offset;
+		value = ADL_CLAMP(value, minSample, maxSample);
+		T sample = T(int64_t(value));
+		::memcpy(&sampleBuffer[i * strideBytes], &sample, sizeof(T));
+	}
+}
+
+template<typename T>
+static void DecodeFloatScalar(const uint8_t* sampleBuffer, uint64_t strideBytes, double* amplitudeBuffer, uint64_t numSamples)
+{
+	if constexpr (std::is_same_v<T, double>)
+	{
+		if (strideBytes == sizeof(T))
+		{
+			::memcpy(amplitudeBuffer, sampleBuffer, numSamples * sizeof(T));
+			return;
+		}
+	}
+
+	for (uint64_t i = 0; i < numSamples; i++)
+	{
+		T sample = 0;
+		::memcpy(&sample, &sampleBuffer[i * strideBytes], sizeof(T));
+		amplitudeBuffer[i] = double(sample);
+	}
+}
+
+template<typename T>
+static void EncodeFloatScalar(const double* amplitudeBuffer, uint8_t* sampleBuffer, uint64_t strideBytes, uint64_t numSamples)
+{
+	if constexpr (std::is_same_v<T, double>)
+	{
+		if (strideBytes == sizeof(T))
+		{
+			::memcpy(sampleBuffer, amplitudeBuffer, numSamples * sizeof(T));
+			return;
+		}
+	}
+
+	for (uint64_t i = 0; i < numSamples; i++)
+	{
+		T sample = T(amplitudeBuffer[i]);
+		::memcpy(&sampleBuffer[i * strideBytes], &sample, sizeof(T));
+	}
+}
+
+#if defined ADL_SIMD_X86
+
+//---------------------------------- SSE2 Kernels ----------------------------------
+
+// The vector kernels all work by widening samples to 32-bit integers, since that's what the CPU knows how to convert to doubles.
+// Unsigned 32-bit samples don't fit, so they get their top bit flipped (subtracting 2^31), which we then account for in the offset.
+template<typename T>
+constexpr double DecodeVectorOffset()
+{
+	return std::is_same_v<T, uint32_t> ? (DecodeOffset<T>() + 2147483648.0 * DecodeScale<T>()) : DecodeOffset<T>();
+}
+
+template<typename T>
+static inline __m128i LoadFourAsInt32SSE2(const uint8_t* sampleBuffer)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	if constexpr (sizeof(T) == 1)
+	{
+		int32_t fourBytes = 0;
+		::memcpy(&fourBytes, sampleBuffer, sizeof(int32_t));
+		__m128i sample = _mm_cvtsi32_si128(fourBytes);
+		if constexpr (std::is_signed_v<T>)
+		{
+			sample = _mm_unpacklo_epi8(sample, sample);
+			sample = _mm_unpacklo_epi16(sample, sample);
+			return _mm_srai_epi32(sample, 24);
+		}
+		else
+		{
+			sample = _mm_unpacklo_epi8(sample, zero);
+			return _mm_unpacklo_epi16(sample, zero);
+		}
+	}
+	else if constexpr (sizeof(T) == 2)
+	{
+		__m128i sample = _mm_loadl_epi64((const __m128i*)sampleBuffer);
+		if constexpr (std::is_signed_v<T>)
+			return _mm_srai_epi32(_mm_unpacklo_epi16(sample, sample), 16);
+		else
+			return _mm_unpacklo_epi16(sample, zero);
+	}
+	else
+	{
+		__m128i sample = _mm_loadu_si128((const __m128i*)sampleBuffer);
+		if constexpr (std::is_signed_v<T>)
+			return sample;
+		else
+			return _mm_xor_si128(sample, _mm_set1_epi32(int32_t(0x80000000)));
+	}
+}
+
+template<typename T>
+static inline void StoreFourFromInt32SSE2(uint8_t* sampleBuffer, __m128i sample)
+{
+	if constexpr (sizeof(T) == 1)
+	{
+		__m128i packed = _mm_packs_epi32(sample, sample);
+		if constexpr (std::is_signed_v<T>)
+			packed = _mm_packs_epi16(packed, packed);
+		else
+			packed = _mm_packus_epi16(packed, packed);
+		int32_t fourBytes = _mm_cvtsi128_si32(packed);
+		::memcpy(sampleBuffer, &fourBytes, sizeof(int32_t));
+	}
+	else if constexpr (sizeof(T) == 2)
+	{
+		if constexpr (std::is_signed_v<T>)
+			_mm_storel_epi64((__m128i*)sampleBuffer, _mm_packs_epi32(sample, sample));
+		else
+		{
+			// SSE2 only has a signed 32-to-16 pack, so shift into signed range, pack, then shift back.
+			sample = _mm_sub_epi32(sample, _mm_set1_epi32(32768));
+			__m128i packed = _mm_packs_epi32(sample, sample);
+			_mm_storel_epi64((__m128i*)sampleBuffer, _mm_xor_si128(packed, _mm_set1_epi16(int16_t(0x8000))));
+		}
+	}
+	else
+	{
+		_mm_storeu_si128((__m128i*)sampleBuffer, sample);
+	}
+}
+
+// Stereo is by far the most common interleaved layout, so here we handle two interleaved channels of 16 or 32-bit samples.
+// Note that each load here reaches a little past the last sample it needs, which is why we always leave at least one sample for the scalar tail.
+template<typename T>
+static uint64_t DecodeTwoChannelSSE2(const uint8_t* sampleBuffer, double* amplitudeBuffer, uint64_t numSamples)
+{
+	uint64_t i = 0;
+
+	if constexpr (sizeof(T) == 2)
+	{
+		const __m128d scale = _mm_set1_pd(DecodeScale<T>());
+		const __m128d offset = _mm_set1_pd(DecodeOffset<T>());
+
+		for (; i + 4 < numSamples; i += 4)
+		{
+			// Our samples are in the low halves of each 32-bit lane.
+			__m128i frames = _mm_loadu_si128((const __m128i*)&sampleBuffer[i * 2 * sizeof(T)]);
+			__m128i sample;
+			if constexpr (std::is_signed_v<T>)
+				sample = _mm_srai_epi32(_mm_slli_epi32(frames, 16), 16);
+			else
+				sample = _mm_and_si128(frames, _mm_set1_epi32(0xFFFF));
+			__m128d amplitudeLow = _mm_cvtepi32_pd(sample);
+			__m128d amplitudeHigh = _mm_cvtepi32_pd(_mm_shuffle_epi32(sample, _MM_SHUFFLE(1, 0, 3, 2)));
+			_mm_storeu_pd(&amplitudeBuffer[i], _mm_add_pd(_mm_mul_pd(amplitudeLow, scale), offset));
+			_mm_storeu_pd(&amplitudeBuffer[i + 2], _mm_add_pd(_mm_mul_pd(amplitudeHigh, scale), offset));
+		}
+	}
+	else if constexpr (sizeof(T) == 4)
+	{
+		for (; i + 4 < numSamples; i += 4)
+		{
+			// Our samples are in the even 32-bit lanes of each pair of loads.
+			__m128 framesA = _mm_loadu_ps((const float*)&sampleBuffer[i * 2 * sizeof(T)]);
+			__m128 framesB = _mm_loadu_ps((const float*)&sampleBuffer[(i + 2) * 2 * sizeof(T)]);
+			__m128 sample = _mm_shuffle_ps(framesA, framesB, _MM_SHUFFLE(2, 0, 2, 0));
+
+			if constexpr (std::is_same_v<T, float>)
+			{
+				_mm_storeu_pd(&amplitudeBuffer[i], _mm_cvtps_pd(sample));
+				_mm_storeu_pd(&amplitudeBuffer[i + 2], _mm_cvtps_pd(_mm_movehl_ps(sample, sample)));
+			}
+			else
+			{
+				const __m128d scale = _mm_set1_pd(DecodeScale<T>());
+				const __m128d offset = _mm_set1_pd(DecodeVectorOffset<T>());
+				__m128i sampleInt = _mm_castps_si128(sample);
+				if constexpr (!std::is_signed_v<T>)
+					sampleInt = _mm_xor_si128(sampleInt, _mm_set1_epi32(int32_t(0x80000000)));
+				__m128d amplitudeLow = _mm_cvtepi32_pd(sampleInt);
+				__m128d amplitudeHigh = _mm_cvtepi32_pd(_mm_shuffle_epi32(sampleInt, _MM_SHUFFLE(1, 0, 3, 2)));
+				_mm_storeu_pd(&amplitudeBuffer[i], _mm_add_pd(_mm_mul_pd(amplitudeLow, scale), offset));
+				_mm_storeu_pd(&amplitudeBuffer[i + 2], _mm_add_pd(_mm_mul_pd(amplitudeHigh, scale), offset));
+			}
+		}
+	}
+
+	return i;
+}
+
+// When encoding into one of two interleaved 16-bit channels, we have to leave the other channel alone, so we blend our samples in.
+template<typename T>
+static uint64_t EncodeTwoChannelSSE2(const double* amplitudeBuffer, uint8_t* sampleBuffer, uint64_t numSamples)
+{
+	uint64_t i = 0;
+
+	if constexpr (sizeof(T) == 2)
+	{
+		const __m128d scale = _mm_set1_pd(EncodeScale<T>());
+		const __m128d offset = _mm_set1_pd(EncodeOffset<T>());
+		const __m128d minSample = _mm_set1_pd(double(std::numeric_limits<T>::min()));
+		const __m128d maxSample = _mm_set1_pd(double(std::numeric_limits<T>::max()));
+		const __m128i ourMask = _mm_set1_epi32(0x0000FFFF);
+
+		for (; i + 4 < numSamples; i += 4)
+		{
+			__m128d valueLow = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(&amplitudeBuffer[i]), scale), offset);
+			__m128d valueHigh = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(&amplitudeBuffer[i + 2]), scale), offset);
+			valueLow = _mm_min_pd(_mm_max_pd(valueLow, minSample), maxSample);
+			valueHigh = _mm_min_pd(_mm_max_pd(valueHigh, minSample), maxSample);
+			__m128i sample = _mm_unpacklo_epi64(_mm_cvttpd_epi32(valueLow), _mm_cvttpd_epi32(valueHigh));
+
+			__m128i* frames = (__m128i*)&sampleBuffer[i * 2 * sizeof(T)];
+			__m128i otherChannel = _mm_andnot_si128(ourMask, _mm_loadu_si128(frames));
+			_mm_storeu_si128(frames, _mm_or_si128(otherChannel, _mm_and_si128(sample, ourMask)));
+		}
+	}
+
+	return i;
+}
+
+template<typename T>
+static void DecodeIntegerSSE2(const uint8_t* sampleBuffer, uint64_t strideBytes, double* amplitudeBuffer, uint64_t numSamples)
+{
+	uint64_t i = 0;
+
+	if (strideBytes == sizeof(T))
+	{
+		const __m128d scale = _mm_set1_pd(DecodeScale<T>());
+		const __m128d offset = _mm_set1_pd(DecodeVectorOffset<T>());
+
+		for (; i + 4 <= numSamples; i += 4)
+		{
+			__m128i sample = LoadFourAsInt32SSE2<T>(&sampleBuffer[i * sizeof(T)]);
+			__m128d amplitudeLow = _mm_cvtepi32_pd(sample);
+			__m128d amplitudeHigh = _mm_cvtepi32_pd(_mm_shuffle_epi32(sample, _MM_SHUFFLE(1, 0, 3, 2)));
+			_mm_storeu_pd(&amplitudeBuffer[i], _mm_add_pd(_mm_mul_pd(amplitudeLow, scale), offset));
+			_mm_storeu_pd(&amplitudeBuffer[i + 2], _mm_add_pd(_mm_mul_pd(amplitudeHigh, scale), offset));
+		}
+	}
+	else if (strideBytes == 2 * sizeof(T))
+	{
+		i = DecodeTwoChannelSSE2<T>(sampleBuffer, amplitudeBuffer, numSamples);
+	}
+
+	DecodeIntegerScalar<T>(&sampleBuffer[i * strideBytes], strideBytes, &amplitudeBuffer[i], numSamples - i);
+}
+
+template<typename T>
+static void EncodeIntegerSSE2(const double* amplitudeBuffer, uint8_t* sampleBuffer, uint64_t strideBytes, uint64_t numSamples)
+{
+	uint64_t i = 0;
+
+	if (strideBytes == sizeof(T))
+	{
+		const __m128d scale = _mm_set1_pd(EncodeScale<T>());
+		const __m128d offset = _mm_set1_pd(EncodeOffset<T>());
+		const __m128d minSample = _mm_set1_pd(double(std::numeric_limits<T>::min()));
+		const __m128d maxSample = _mm_set1_pd(double(std::numeric_limits<T>::max()));
+
+		for (; i + 4 <= numSamples; i += 4)
+		{
+			__m128d valueLow = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(&amplitudeBuffer[i]), scale), offset);
+			__m128d valueHigh = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(&amplitudeBuffer[i + 2]), scale), offset);
+			valueLow = _mm_min_pd(_mm_max_pd(valueLow, minSample), maxSample);
+			valueHigh = _mm_min_pd(_mm_max_pd(valueHigh, minSample), maxSample);
+			__m128i sample = _mm_unpacklo_epi64(_mm_cvttpd_epi32(valueLow), _mm_cvttpd_epi32(valueHigh));
+			StoreFourFromInt32SSE2<T>(&sampleBuffer[i * sizeof(T)], sample);
+		}
+	}
+	else if (strideBytes == 2 * sizeof(T))
+	{
+		i = EncodeTwoChannelSSE2<T>(amplitudeBuffer, sampleBuffer, numSamples);
+	}
+
+	EncodeIntegerScalar<T>(&amplitudeBuffer[i], &sampleBuffer[i * strideBytes], strideBytes, numSamples - i);
+}
+
+static void DecodeFloat32SSE2(const uint8_t* sampleBuffer, uint64_t strideBytes, double* amplitudeBuffer, uint64_t numSamples)
+{
+	uint64_t i = 0;
+
+	if (strideBytes == sizeof(float))
+	{
+		for (; i + 4 <= numSamples; i += 4)
+		{
+			__m128 sample = _mm_loadu_ps((const float*)&sampleBuffer[i * sizeof(float)]);
+			_mm_storeu_pd(&amplitudeBuffer[i], _mm_cvtps_pd(sample));
+			_mm_storeu_pd(&amplitudeBuffer[i + 2], _mm_cvtps_pd(_mm_movehl_ps(sample, sample)));
+		}
+	}
+	else if (strideBytes == 2 * sizeof(float))
+	{
+		i = DecodeTwoChannelSSE2<float>(sampleBuffer, amplitudeBuffer, numSamples);
+	}
+
+	DecodeFloatScalar<float>(&sampleBuffer[i * strideBytes], strideBytes, &amplitudeBuffer[i], numSamples - i);
+}
+
+static void EncodeFloat32SSE2(const double* amplitudeBuffer, uint8_t* sampleBuffer, uint64_t strideBytes, uint64_t numSamples)
+{
+	uint64_t i = 0;
+
+	if (strideBytes == sizeof(float))
+	{
+		for (; i + 4 <= numSamples; i += 4)
+		{
+			__m128 sampleLow = _mm_cvtpd_ps(_mm_loadu_pd(&amplitudeBuffer[i]));
+			__m128 sampleHigh = _mm_cvtpd_ps(_mm_loadu_pd(&amplitudeBuffer[i + 2]));
+			_mm_storeu_ps((float*)&sampleBuffer[i * sizeof(float)], _mm_movelh_ps(sampleLow, sampleHigh));
+		}
+	}
+
+	EncodeFloatScalar<float>(&amplitudeBuffer[i], &sampleBuffer[i * strideBytes], strideBytes, numSamples - i);
+}
+
+//---------------------------------- AVX2 Kernels ----------------------------------
+
+template<typename T>
+ADL_AVX2_FUNC static inline __m256i LoadEightAsInt32AVX2(const uint8_t* sampleBuffer)
+{
+	if constexpr (sizeof(T) == 1)
+	{
+		__m128i sample = _mm_loadl_epi64((const __m128i*)sampleBuffer);
+		if constexpr (std::is_signed_v<T>)
+			return _mm256_cvtepi8_epi32(sample);
+		else
+			return _mm256_cvtepu8_epi32(sample);
+	}
+	else if constexpr (sizeof(T) == 2)
+	{
+		__m128i sample = _mm_loadu_si128((const __m128i*)sampleBuffer);
+		if constexpr (std::is_signed_v<T>)
+			return _mm256_cvtepi16_epi32(sample);
+		else
+			return _mm256_cvtepu16_epi32(sample);
+	}
+	else
+	{
+		__m256i sample = _mm256_loadu_si256((const __m256i*)sampleBuffer);
+		if constexpr (std::is_signed_v<T>)
+			return sample;
+		else
+			return _mm256_xor_si256(sample, _mm256_set1_epi32(int32_t(0x80000000)));
+	}
+}
+
+template<typename T>
+ADL_AVX2_FUNC static void DecodeIntegerAVX2(const uint8_t* sampleBuffer, uint64_t strideBytes, double* amplitudeBuffer, uint64_t numSamples)
+{
+	uint64_t i = 0;
+
+	if (strideBytes == sizeof(T))
+	{
+		const __m256d scale = _mm256_set1_pd(DecodeScale<T>());
+		const __m256d offset = _mm256_set1_pd(DecodeVectorOffset<T>());
+
+		for (; i + 8 <= numSamples; i += 8)
+		{
+			__m256i sample = LoadEightAsInt32AVX2<T>(&sampleBuffer[i * sizeof(T)]);
+			__m256d amplitudeLow = _mm256_cvtepi32_pd(_mm256_castsi256_si128(sample));
+			__m256d amplitudeHigh = _mm256_cvtepi32_pd(_mm256_extracti128_si256(sample, 1));
+			_mm256_storeu_pd(&amplitudeBuffer[i], _mm256_add_pd(_mm256_mul_pd(amplitudeLow, scale), offset));
+			_mm256_storeu_pd(&amplitudeBuffer[i + 4], _mm256_add_pd(_mm256_mul_pd(amplitudeHigh, scale), offset));
+		}
+	}
+	else if (strideBytes == 2 * sizeof(T))
+	{
+		i = DecodeTwoChannelSSE2<T>(sampleBuffer, amplitudeBuffer, numSamples);
+	}
+
+	DecodeIntegerScalar<T>(&sampleBuffer[i * strideBytes], strideBytes, &amplitudeBuffer[i], numSamples - i);
+}
+
+template<typename T>
+ADL_AVX2_FUNC static void EncodeIntegerAVX2(const double* amplitudeBuffer, uint8_t* sampleBuffer, uint64_t strideBytes, uint64_t numSamples)
+{
+	uint64_t i = 0;
+
+	if (strideBytes == sizeof(T))
+	{
+		const __m256d scale = _mm256_set1_pd(EncodeScale<T>());
+		const __m256d offset = _mm256_set1_pd(EncodeOffset<T>());
+		const __m256d minSample = _mm256_set1_pd(double(std::numeric_limits<T>::min()));
+		const __m256d maxSample = _mm256_set1_pd(double(std::numeric_limits<T>::max()));
+
+		for (; i + 4 <= numSamples; i += 4)
+		{
+			__m256d value = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(&amplitudeBuffer[i]), scale), offset);
+			value = _mm256_min_pd(_mm256_max_pd(value, minSample), maxSample);
+			StoreFourFromInt32SSE2<T>(&sampleBuffer[i * sizeof(T)], _mm256_cvttpd_epi32(value));
+		}
+	}
+	else if (strideBytes == 2 * sizeof(T))
+	{
+		i = EncodeTwoChannelSSE2<T>(amplitudeBuffer, sampleBuffer, numSamples);
+	}
+
+	EncodeIntegerScalar<T>(&amplitudeBuffer[i], &sampleBuffer[i * strideBytes], strideBytes, numSamples - i);
+}
+
+ADL_AVX2_FUNC static void DecodeFloat32AVX2(const uint8_t* sampleBuffer, uint64_t strideBytes, double* amplitudeBuffer, uint64_t numSamples)
+{
+	uint64_t i = 0;
+
+	if (strideBytes == sizeof(float))
+	{
+		for (; i + 8 <= numSamples; i += 8)
+		{
+			__m256 sample = _mm256_loadu_ps((const float*)&sampleBuffer[i * sizeof(float)]);
+			_mm256_storeu_pd(&amplitudeBuffer[i], _mm256_cvtps_pd(_mm256_castps256_ps128(sample)));
+			_mm256_storeu_pd(&amplitudeBuffer[i + 4], _mm256_cvtps_pd(_mm256_extractf128_ps(sample, 1)));
+		}
+	}
+	else if (strideBytes == 2 * sizeof(float))
+	{
+		i = DecodeTwoChannelSSE2<float>(sampleBuffer, amplitudeBuffer, numSamples);
+	}
+
+	DecodeFloatScalar<float>(&sampleBuffer[i * strideBytes], strideBytes, &amplitudeBuffer[i], numSamples - i);
+}
+
+ADL_AVX2_FUNC static void EncodeFloat32AVX2(const double* amplitudeBuffer, uint8_t* sampleBuffer, uint64_t strideBytes, uint64_t numSamples)
+{
+	uint64_t i = 0;
+
+	if (strideBytes == sizeof(float))
+	{
+		for (; i + 4 <= numSamples; i += 4)
+			_mm_storeu_ps((float*)&sampleBuffer[i * sizeof(float)], _mm256_cvtpd_ps(_mm256_loadu_pd(&amplitudeBuffer[i])));
+	}
+
+	EncodeFloatScalar<float>(&amplitudeBuffer[i], &sampleBuffer[i * strideBytes], strideBytes, numSamples - i);
+}
+
+#endif //ADL_SIMD_X86
+
+//---------------------------------- PCMConverter ----------------------------------
+
+// Converters may be used from several threads at once, so this is read and set atomically.
+static std::atomic<int32_t> activeInstructionSet(-1);
+
+PCMConverter::PCMConverter()
+{
+	this->decodeKernel = nullptr;
+	this->encodeKernel = nullptr;
+	this->bytesPerSample = 0;
+	this->bytesPerFrame = 0;
+}
+
+/*virtual*/ PCMConverter::~PCMConverter()
+{
+}
+
+// Note that this macro isn't quite branch-free, but it only ever gets evaluated once per call to Configure.
+#if defined ADL_SIMD_X86
+#	define ADL_PICK_KERNEL(scalarKernel, sse2Kernel, avx2Kernel) \
+		((instructionSet == InstructionSet::AVX2) ? (avx2Kernel) : ((instructionSet == InstructionSet::SSE2) ? (sse2Kernel) : (scalarKernel)))
+#else
+#	define ADL_PICK_KERNEL(scalarKernel, sse2Kernel, avx2Kernel)		(scalarKernel)
+#endif
+
+bool PCMConverter::Configure(const AudioData::Format& format)
+{
+	this->decodeKernel = nullptr;
+	this->encodeKernel = nullptr;
+	this->bytesPerSample = format.BytesPerSample();
+	this->bytesPerFrame = format.BytesPerFrame();
+
+	InstructionSet instructionSet = GetInstructionSet();
+
+	switch (format.sampleType)
+	{
+		case AudioData::Format::SIGNED_INTEGER:
+		{
+			switch (format.bitsPerSample)
+			{
+				case 8:
+				{
+					this->decodeKernel = ADL_PICK_KERNEL(&DecodeIntegerScalar<int8_t>, &DecodeIntegerSSE2<int8_t>, &DecodeIntegerAVX2<int8_t>);
+					this->encodeKernel = ADL_PICK_KERNEL(&EncodeIntegerScalar<int8_t>, &EncodeIntegerSSE2<int8_t>, &EncodeIntegerAVX2<int8_t>);
+					break;
+				}
+				case 16:
+				{
+					this->decodeKernel = ADL_PICK_KERNEL(&DecodeIntegerScalar<int16_t>, &DecodeIntegerSSE2<int16_t>, &DecodeIntegerAVX2<int16_t>);
+					this->encodeKernel = ADL_PICK_KERNEL(&EncodeIntegerScalar<int16_t>, &EncodeIntegerSSE2<int16_t>, &EncodeIntegerAVX2<int16_t>);
+					break;
+				}
+				case 32:
+				{
+					this->decodeKernel = ADL_PICK_KERNEL(&DecodeIntegerScalar<int32_t>, &DecodeIntegerSSE2<int32_t>, &DecodeIntegerAVX2<int32_t>);
+					this->encodeKernel = ADL_PICK_KERNEL(&EncodeIntegerScalar<int32_t>, &EncodeIntegerSSE2<int32_t>, &EncodeIntegerAVX2<int32_t>);
+					break;
+				}
+				default:
+				{
+					ErrorSystem::Get()->Add(std::format("Bad bit-depth ({}) for signed integers.", format.bitsPerSample));
+					return false;
+				}
+			}
+			break;
+		}
+		case AudioData::Format::UNSIGNED_INTEGER:
+		{
+			switch (format.bitsPerSample)
+			{
+				case 8:
+				{
+					this->decodeKernel = ADL_PICK_KERNEL(&DecodeIntegerScalar<uint8_t>, &DecodeIntegerSSE2<uint8_t>, &DecodeIntegerAVX2<uint8_t>);
+					this->encodeKernel = ADL_PICK_KERNEL(&EncodeIntegerScalar<uint8_t>, &EncodeIntegerSSE2<uint8_t>, &EncodeIntegerAVX2<uint8_t>);
+					break;
+				}
+				case 16:
+				{
+					this->decodeKernel = ADL_PICK_KERNEL(&DecodeIntegerScalar<uint16_t>, &DecodeIntegerSSE2<uint16_t>, &DecodeIntegerAVX2<uint16_t>);
+					this->encodeKernel = ADL_PICK_KERNEL(&EncodeIntegerScalar<uint16_t>, &EncodeIntegerSSE2<uint16_t>, &EncodeIntegerAVX2<uint16_t>);
+					break;
+				}
+				case 32:
+				{
+					// There's no cheap way to truncate doubles to unsigned 32-bit integers with these instruction sets, so encoding stays scalar.
+					this->decodeKernel = ADL_PICK_KERNEL(&DecodeIntegerScalar<uint32_t>, &DecodeIntegerSSE2<uint32_t>, &DecodeIntegerAVX2<uint32_t>);
+					this->encodeKernel = &EncodeIntegerScalar<uint32_t>;
+					break;
+				}
+				default:
+				{
+					ErrorSystem::Get()->Add(std::format("Bad bit-depth ({}) for unsigned integers.", format.bitsPerSample));
+					return false;
+				}
+			}
+			break;
+		}
+		case AudioData::Format::FLOAT:
+		{
+			switch (format.bitsPerSample)
+			{
+				case 32:
+				{
+					this->decodeKernel = ADL_PICK_KERNEL(&DecodeFloatScalar<float>, &DecodeFloat32SSE2, &DecodeFloat32AVX2);
+					this->encodeKernel = ADL_PICK_KERNEL(&EncodeFloatScalar<float>, &EncodeFloat32SSE2, &EncodeFloat32AVX2);
+					break;
+				}
+				case 64:
+				{
+					// This is just a copy when the samples are contiguous, and memcpy is already as fast as we're going to get.
+					this->decodeKernel = &DecodeFloatScalar<double>;
+					this->encodeKernel = &EncodeFloatScalar<double>;
+					break;
+				}
+				default:
+				{
+					ErrorSystem::Get()->Add(std::format("Bad bit-depth ({}) for floats.", format.bitsPerSample));
+					return false;
+				}
+			}
+			break;
+		}
+		default:
+		{
+			ErrorSystem::Get()->Add(std::format("Unknown sample type ({}) encountered.", int(format.sampleType)));
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void PCMConverter::Decode(const uint8_t* sampleBuffer, uint64_t strideBytes, double* amplitudeBuffer, uint64_t numSamples) const
+{
+	assert(this->decodeKernel != nullptr);
+	this->decodeKernel(sampleBuffer, strideBytes, amplitudeBuffer, numSamples);
+}
+
+void PCMConverter::Encode(const double* amplitudeBuffer, uint8_t* sampleBuffer, uint64_t strideBytes, uint64_t numSamples) const
+{
+	assert(this->encodeKernel != nullptr);
+	this->encodeKernel(amplitudeBuffer, sampleBuffer, strideBytes, numSamples);
+}
+
+void PCMConverter::DecodeChannel(const uint8_t* audioBuffer, uint16_t channel, double* amplitudeBuffer, uint64_t numFrames) const
+{
+	this->Decode(&audioBuffer[channel * this->bytesPerSample], this->bytesPerFrame, amplitudeBuffer, numFrames);
+}
+
+void PCMConverter::EncodeChannel(const double* amplitudeBuffer, uint8_t* audioBuffer, uint16_t channel, uint64_t numFrames) const
+{
+	this->Encode(amplitudeBuffer, &audioBuffer[channel * this->bytesPerSample], this->bytesPerFrame, numFrames);
+}
+
+/*static*/ PCMConverter::InstructionSet PCMConverter::GetInstructionSet()
+{
+	int32_t instructionSet = activeInstructionSet.load();
+	if (instructionSet < 0)
+	{
+		// Only fill in the detected set if nobody got here first, so that we never stomp on a call to SetInstructionSet.
+		int32_t detectedInstructionSet = int32_t(DetectInstructionSet());
+		if (activeInstructionSet.compare_exchange_strong(instructionSet, detectedInstructionSet))
+			instructionSet = detectedInstructionSet;
+	}
+
+	return InstructionSet(instructionSet);
+}
+
+/*static*/ void PCMConverter::SetInstructionSet(InstructionSet instructionSet)
+{
+	InstructionSet supportedInstructionSet = DetectInstructionSet();
+	if (int32_t(instructionSet) > int32_t(supportedInstructionSet))
+		instructionSet = supportedInstructionSet;
+
+	activeInstructionSet.store(int32_t(instructionSet));
+}
+
+/*static*/ PCMConverter::InstructionSet PCMConverter::DetectInstructionSet()
+{
+#if defined ADL_SIMD_X86
+#	if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxFunctionId = info[0];
+
+	// AVX2 needs both the CPU to support it and the OS to save the YMM registers on a context switch.
+	if (maxFunctionId >= 7)
+	{
+		__cpuid(info, 1);
+		bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+		__cpuidex(info, 7, 0);
+		bool avx2 = (info[1] & (1 << 5)) != 0;
+		if (osSavesYmm && avx2)
+			return InstructionSet::AVX2;
+	}
+#	else
+	if (__builtin_cpu_supports("avx2"))
+		return InstructionSet::AVX2;
+#	endif
+	return InstructionSet::SSE2;
+#else
+	return InstructionSet::SCALAR;
+#endif
+}
+
+/*static*/ const char* PCMConverter::GetInstructionSetName(InstructionSet instructionSet)
+{
+	switch (instructionSet)
+	{
+		case InstructionSet::SCALAR:
+			return "scalar";
+		case InstructionSet::SSE2:
+			return "SSE2";
+		case InstructionSet::AVX2:
+			return "AVX2";
+	}
+
+	return "?";
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "AudioDataLib/FileDatas/AudioData.h"
+
+namespace AudioDataLib
+{
+	/**
+	 * @brief This class converts raw PCM audio to and from normalized amplitudes.
+	 *
+	 * Converting audio to and from wave-forms used to mean switching on the sample type and bit-depth
+	 * for every single sample.  Here, the right conversion kernel is picked just once for a given
+	 * format, and then whole runs of samples are converted at a time.  Where the CPU supports it, the
+	 * kernels use SSE2 or AVX2 instructions; otherwise, they fall back to plain scalar loops.
+	 *
+	 * Each kernel takes a stride (in bytes) between samples, so that it works just as well on planar
+	 * data (where the stride is just the size of a sample) as it does on interleaved data (where the
+	 * stride is the size of a frame.)  The vectorized paths kick in when the samples are contiguous.
+	 */
+	class AUDIO_DATA_LIB_API PCMConverter
+	{
+	public:
+		PCMConverter();
+		virtual ~PCMConverter();
+
+		/**
+		 * These are the instruction sets we have kernels for.  They're in order of preference.
+		 */
+		enum InstructionSet
+		{
+			SCALAR,		///< Plain C++ loops.  These work everywhere.
+			SSE2,		///< 128-bit vector instructions, available on any x86-64 CPU.
+			AVX2		///< 256-bit vector instructions, available on most x86-64 CPUs made in the last decade.
+		};
+
+		typedef void (*DecodeKernel)(const uint8_t* sampleBuffer, uint64_t strideBytes, double* amplitudeBuffer, uint64_t numSamples);
+		typedef void (*EncodeKernel)(const double* amplitudeBuffer, uint8_t* sampleBuffer, uint64_t strideBytes, uint64_t numSamples);
+
+		/**
+		 * Pick the kernels to use for the given format.  This needs to be called before any decoding or encoding is done.
+		 *
+		 * @param[in] format This is the format of the raw audio data we'll be converting to or from.
+		 * @return True is returned on success; false otherwise, such as when the format isn't supported.
+		 */
+		bool Configure(const AudioData::Format& format);
+
+		/**
+		 * Convert the given raw samples into normalized amplitudes.
+		 *
+		 * @param[in] sampleBuffer This points to the first sample to convert.
+		 * @param[in] strideBytes This is the number of bytes from one sample to the next.
+		 * @param[out] amplitudeBuffer This receives the amplitudes, which will typically be in the range [-1,1].
+		 * @param[in] numSamples This is the number of samples to convert.
+		 */
+		void Decode(const uint8_t* sampleBuffer, uint64_t strideBytes, double* amplitudeBuffer, uint64_t numSamples) const;
+
+		/**
+		 * Convert the given normalized amplitudes into raw samples.  Amplitudes outside the range of the format get clamped.
+		 *
+		 * @param[in] amplitudeBuffer These are the amplitudes to convert.
+		 * @param[out] sampleBuffer This points to where the first sample should go.
+		 * @param[in] strideBytes This is the number of bytes from one sample to the next.
+		 * @param[in] numSamples This is the number of samples to convert.
+		 */
+		void Encode(const double* amplitudeBuffer, uint8_t* sampleBuffer, uint64_t strideBytes, uint64_t numSamples) const;
+
+		/**
+		 * This is just a convenience for decoding one channel of interleaved audio data in the configured format.
+		 */
+		void DecodeChannel(const uint8_t* audioBuffer, uint16_t channel, double* amplitudeBuffer, uint64_t numFrames) const;
+
+		/**
+		 * This is just a convenience for encoding one channel of interleaved audio data in the configured format.
+		 */
+		void EncodeChannel(const double* amplitudeBuffer, uint8_t* audioBuffer, uint16_t channel, uint64_t numFrames) const;
+
+		/**
+		 * Return the best instruction set supported by the CPU we're running on, or whatever was last forced.
+		 */
+		static InstructionSet GetInstructionSet();
+
+		/**
+		 * Force the use of a particular instruction set for any subsequent calls to Configure.  This is mainly
+		 * here so that the different kernels can be compared against one another.  If the given instruction set
+		 * is not supported by the CPU, then the best one that is supported is used instead.
+		 */
+		static void SetInstructionSet(InstructionSet instructionSet);
+
+		/**
+		 * Ask the CPU what it can do.
+		 */
+		static InstructionSet DetectInstructionSet();
+
+		/**
+		 * Return a human-readable name for the given instruction set.
+		 */
+		static const char* GetInstructionSetName(InstructionSet instructionSet);
+
+	private:
+		DecodeKernel decodeKernel;
+		EncodeKernel encodeKernel;
+		uint64_t bytesPerSample;
+		uint64_t bytesPerFrame;
+	};
+}
@@ -4,7 +4,7 @@ using namespace AudioDataLib;
 
 //--------------------------------- RecursiveFilter ---------------------------------
 
-RecursiveFilter::RecursiveFilter() : originalSignal(2, 0.5), filteredSignal(2, 0.5)
+RecursiveFilter::RecursiveFilter() : originalSignal(1.0), filteredSignal(1.0)
 {
 	this->params.scale = 1.0;
 	this->params.timeDelaySeconds = 0.0;
@@ -9,11 +9,10 @@ namespace AudioDataLib
 	 * The resursion involved here is not that in the computer-science sense, but in the sense that
 	 * results of previous evaluations of the function are used to produce current evaluations.
 	 * 
-	 * Since we're based on the WaveForm class here, we don't have the best time-complexity, admittedly.
-	 * Evaluating the signal at a given descrete time could be O(1), but we are using an O(log N) operation.
-	 * My view is that if it's fast enough, then I favor the simplicity that can sometimes prevail over the complications
-	 * that can arise in trying to be as fast as computerly-possible.  Comb and all-pass filters can sometimes be used as the
-	 * building-blocks of a reverberator, and that is the motivation here behind this class and its derivatives.
+	 * The signals are kept in WaveFormStream instances, which are ring-buffers, so looking back in time by the
+	 * filter delay is O(1), and the cost of filtering is linear in the number of samples.  Note that the delay
+	 * can't be longer than the history the streams keep, which is one second.  Comb and all-pass filters can sometimes
+	 * be used as the building-blocks of a reverberator, and that is the motivation here behind this class and its derivatives.
 	 */
 	class AUDIO_DATA_LIB_API RecursiveFilter : public Function
 	{
@@ -0,0 +1,169 @@
+#include "AudioDataLib/RenderArena.h"
+#include "AudioDataLib/WaveForm.h"
+
+using namespace AudioDataLib;
+
+// Each thread renders with at most one arena at a time.
+static thread_local RenderArena* currentRenderArena = nullptr;
+
+// This lets us remember how much storage a wave-form had when it was checked out, so that we can tell if it grew.
+class RenderArena::PooledWaveForm : public WaveForm
+{
+public:
+	uint64_t capacityBytesWhenAcquired;
+};
+
+//---------------------------------- RenderArena ----------------------------------
+
+RenderArena::RenderArena(uint64_t initialCapacityBytes /*= 64 * 1024*/)
+{
+	this->stats = Stats{};
+
+	this->blockOffset = 0;
+	this->bytesAllocatedThisPass = 0;
+	this->numHeapAllocationsAtLastReset = 0;
+
+	Block block;
+	block.size = ADL_MAX(initialCapacityBytes, 1024);
+	block.memory = new uint8_t[block.size];
+	this->blockArray.push_back(block);
+	this->stats.capacityBytes = block.size;
+}
+
+/*virtual*/ RenderArena::~RenderArena()
+{
+	for (Block& block : this->blockArray)
+		delete[] block.memory;
+
+	for (PooledWaveForm* waveForm : this->waveFormPool)
+		delete waveForm;
+}
+
+void RenderArena::Reset()
+{
+	this->stats.highWaterMarkBytes = ADL_MAX(this->stats.highWaterMarkBytes, this->bytesAllocatedThisPass);
+
+	// If we overflowed during the last pass, replace all our blocks with one that's big enough for everything.
+	if (this->blockArray.size() > 1)
+	{
+		uint64_t totalSize = 0;
+		for (Block& block : this->blockArray)
+		{
+			totalSize += block.size;
+			delete[] block.memory;
+		}
+
+		this->blockArray.resize(1);
+		Block& block = this->blockArray[0];
+		block.size = totalSize;
+		block.memory = new uint8_t[block.size];
+		this->stats.capacityBytes = block.size;
+		this->NoteHeapAllocation();
+	}
+
+	this->blockOffset = 0;
+	this->bytesAllocatedThisPass = 0;
+
+	this->stats.numPasses++;
+	this->stats.numHeapAllocationsLastPass = this->stats.numHeapAllocations - this->numHeapAllocationsAtLastReset;
+	this->numHeapAllocationsAtLastReset = this->stats.numHeapAllocations;
+}
+
+void* RenderArena::Allocate(uint64_t numBytes, uint64_t alignment /*= 64*/)
+{
+	assert((alignment & (alignment - 1)) == 0);
+
+	Block* block = &this->blockArray[this->blockArray.size() - 1];
+	uintptr_t address = uintptr_t(block->memory) + this->blockOffset;
+	uintptr_t alignedAddress = (address + alignment - 1) & ~uintptr_t(alignment - 1);
+
+	if (alignedAddress + numBytes > uintptr_t(block->memory) + block->size)
+	{
+		// We're out of room, so start a new block.  Make it at least as big as the last one so that
+		// a pass that needs a lot of little allocations doesn't make a lot of little blocks.
+		Block newBlock;
+		newBlock.size = ADL_MAX(numBytes + alignment, block->size);
+		newBlock.memory = new uint8_t[newBlock.size];
+		this->blockArray.push_back(newBlock);
+		this->NoteHeapAllocation();
+
+		block = &this->blockArray[this->blockArray.size() - 1];
+		address = uintptr_t(block->memory);
+		alignedAddress = (address + alignment - 1) & ~uintptr_t(alignment - 1);
+	}
+
+	this->blockOffset = uint64_t(alignedAddress + numBytes - uintptr_t(block->memory));
+	this->bytesAllocatedThisPass += numBytes;
+
+	return reinterpret_cast<void*>(alignedAddress);
+}
+
+WaveForm* RenderArena::AcquireWaveForm()
+{
+	PooledWaveForm* waveForm = nullptr;
+
+	if (this->freeWaveFormArray.size() > 0)
+	{
+		waveForm = this->freeWaveFormArray.back();
+		this->freeWaveFormArray.pop_back();
+	}
+	else
+	{
+		waveForm = new PooledWaveForm();
+		this->waveFormPool.push_back(waveForm);
+		this->freeWaveFormArray.reserve(this->waveFormPool.size());
+		this->stats.numPooledWaveForms = uint32_t(this->waveFormPool.size());
+		this->NoteHeapAllocation();
+	}
+
+	waveForm->capacityBytesWhenAcquired = waveForm->GetCapacityBytes();
+	return waveForm;
+}
+
+void RenderArena::ReleaseWaveForm(WaveForm* waveForm)
+{
+	auto pooledWaveForm = static_cast<PooledWaveForm*>(waveForm);
+
+	if (pooledWaveForm->GetCapacityBytes() > pooledWaveForm->capacityBytesWhenAcquired)
+		this->NoteHeapAllocation();
+
+	this->freeWaveFormArray.push_back(pooledWaveForm);
+}
+
+/*static*/ RenderArena* RenderArena::GetCurrent()
+{
+	return currentRenderArena;
+}
+
+//---------------------------------- RenderArena::Scope ----------------------------------
+
+RenderArena::Scope::Scope(RenderArena* renderArena)
+{
+	this->previousArena = currentRenderArena;
+	currentRenderArena = renderArena;
+}
+
+/*virtual*/ RenderArena::Scope::~Scope()
+{
+	currentRenderArena = this->previousArena;
+}
+
+//---------------------------------- RenderArena::ScratchWaveForm ----------------------------------
+
+RenderArena::ScratchWaveForm::ScratchWaveForm()
+{
+	this->renderArena = currentRenderArena;
+
+	if (this->renderArena)
+		this->waveForm = this->renderArena->AcquireWaveForm();
+	else
+		this->waveForm = new WaveForm();
+}
+
+/*virtual*/ RenderArena::ScratchWaveForm::~ScratchWaveForm()
+{
+	if (this->renderArena)
+		this->renderArena->ReleaseWaveForm(this->waveForm);
+	else
+		delete this->waveForm;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "AudioDataLib/Common.h"
+
+namespace AudioDataLib
+{
+	class WaveForm;
+
+	/**
+	 * @brief This is scratch memory for one render pass of a synth module graph.
+	 *
+	 * Rendering audio happens over and over, typically on a thread that can't afford to wait on the heap.
+	 * So rather than have every synth module allocate its own temporary buffers and wave-forms on every
+	 * pass, they can get them from here.  Raw buffers come from a bump allocator that is reset all at once
+	 * at the start of each pass, and wave-forms come from a pool whose members keep their storage from one
+	 * pass to the next.  Once the arena has grown to fit what a pass needs, it stops touching the heap.
+	 *
+	 * The arena counts every heap allocation it makes or sees happen (including wave-form storage that had to
+	 * grow while checked out of the pool), so that you can verify that steady-state rendering doesn't allocate.
+	 *
+	 * Synth modules don't get handed an arena directly.  Whoever drives the render pass (e.g., the MidiSynth class)
+	 * makes its arena current on the rendering thread with a RenderArena::Scope, and the modules find it with GetCurrent.
+	 */
+	class AUDIO_DATA_LIB_API RenderArena
+	{
+	public:
+		RenderArena(uint64_t initialCapacityBytes = 64 * 1024);
+		virtual ~RenderArena();
+
+		/**
+		 * Call this once at the start of every render pass.  Everything handed out by Allocate is reclaimed,
+		 * so none of it should be in use anymore.  If the last pass overflowed our memory, this is where we
+		 * grow to fit it, so that the next pass won't have to.
+		 */
+		void Reset();
+
+		/**
+		 * Get a block of memory that's good until the next call to Reset.  This never fails, but it will go to the
+		 * heap if we've run out of room, which gets counted.
+		 *
+		 * @param[in] numBytes This is how many bytes are needed.
+		 * @param[in] alignment This is the desired alignment of the returned address, which must be a power of two.
+		 */
+		void* Allocate(uint64_t numBytes, uint64_t alignment = 64);
+
+		/**
+		 * This is a convenience wrapper around Allocate for arrays of the given type.  Note that no constructors are run.
+		 */
+		template<typename T>
+		T* AllocateArray(uint64_t count)
+		{
+			static_assert(std::is_trivially_destructible<T>::value, "Only trivial types can live in a render arena.");
+			return static_cast<T*>(this->Allocate(count * sizeof(T), ADL_MAX(alignof(T), 64)));
+		}
+
+		/**
+		 * Check a wave-form out of our pool.  Its contents are unspecified, so clear it or make it uniform before use.
+		 * It must be given back by calling ReleaseWaveForm, typically by way of a ScratchWaveForm.
+		 */
+		WaveForm* AcquireWaveForm();
+
+		/**
+		 * Give back a wave-form that was gotten from AcquireWaveForm.  It keeps its storage for the next time it's used.
+		 */
+		void ReleaseWaveForm(WaveForm* waveForm);
+
+		/**
+		 * These are the numbers we keep track of so that allocation behavior can be checked.
+		 */
+		struct Stats
+		{
+			uint64_t numHeapAllocations;			///< This is the total number of heap allocations made or detected by the arena.
+			uint64_t numHeapAllocationsLastPass;	///< This is how many of those happened between the last two calls to Reset.
+			uint64_t numPasses;						///< This is how many times Reset has been called.
+			uint64_t capacityBytes;					///< This is the size of the bump allocator's memory.
+			uint64_t highWaterMarkBytes;			///< This is the most bump-allocated memory any one pass has needed.
+			uint32_t numPooledWaveForms;			///< This is how many wave-forms the pool has ever had to make.
+		};
+
+		/**
+		 * Get the statistics for this arena.  Note that numHeapAllocationsLastPass is only brought up to date by Reset.
+		 */
+		const Stats& GetStats() const { return this->stats; }
+
+		/**
+		 * Return the arena that has been made current on the calling thread, if any.
+		 */
+		static RenderArena* GetCurrent();
+
+		/**
+		 * @brief Make an arena current on the calling thread for as long as this object lives.
+		 */
+		class AUDIO_DATA_LIB_API Scope
+		{
+		public:
+			Scope(RenderArena* renderArena);
+			virtual ~Scope();
+
+		private:
+			RenderArena* previousArena;
+		};
+
+		/**
+		 * @brief This is a wave-form that's checked out of the current arena's pool for as long as this object lives.
+		 *
+		 * If no arena is current on the calling thread, then the wave-form is just allocated on the heap, so that
+		 * synth modules still work when they're used outside of a render pass.
+		 */
+		class AUDIO_DATA_LIB_API ScratchWaveForm
+		{
+		public:
+			ScratchWaveForm();
+			ScratchWaveForm(const ScratchWaveForm&) = delete;
+			virtual ~ScratchWaveForm();
+
+			ScratchWaveForm& operator=(const ScratchWaveForm&) = delete;
+
+			WaveForm& operator*() { return *this->waveForm; }
+			WaveForm* operator->() { return this->waveForm; }
+			WaveForm* Get() { return this->waveForm; }
+
+		private:
+			RenderArena* renderArena;
+			WaveForm* waveForm;
+		};
+
+	private:
+
+		void NoteHeapAllocation() { this->stats.numHeapAllocations++; }
+
+		struct Block
+		{
+			uint8_t* memory;
+			uint64_t size;
+		};
+
+		std::vector<Block> blockArray;			///< The first block is our main memory.  Any others are overflow from the current pass.
+		uint64_t blockOffset;					///< This is how much of the last block in the array is used.
+		uint64_t bytesAllocatedThisPass;
+		uint64_t numHeapAllocationsAtLastReset;
+
+		class PooledWaveForm;
+		std::vector<PooledWaveForm*> waveFormPool;		///< This owns every wave-form we've ever made.
+		std::vector<PooledWaveForm*> freeWaveFormArray;	///< These are the wave-forms not checked out at the moment.
+
+		Stats stats;
+	};
+}
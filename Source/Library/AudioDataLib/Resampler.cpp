@@ -0,0 +1,385 @@
+#include "AudioDataLib/Resampler.h"
+#include "AudioDataLib/PCMConverter.h"
+#include "AudioDataLib/ErrorSystem.h"
+#include "AudioDataLib/SIMD.h"
+
+// This is how many input samples we can take on at a time beyond the filter window.
+#define ADL_RESAMPLER_BLOCK_SIZE		1024
+
+// This is how many fractional offsets between input samples we precompute filter coefficients for.
+// We linearly interpolate between neighboring phases, so this doesn't need to be huge.
+#define ADL_RESAMPLER_NUM_PHASES		128
+
+using namespace AudioDataLib;
+
+//---------------------------------- Dot Product Kernels ----------------------------------
+
+// We dot the samples against two rows of coefficients at once, because we always need
+// the two phases on either side of the fractional offset, and this way we only load
+// the samples once.
+
+static void DotProductPairScalar(const double* sampleBuffer, const double* coefficientsA, const double* coefficientsB, uint64_t numTaps, double& sumA, double& sumB)
+{
+	sumA = 0.0;
+	sumB = 0.0;
+	for (uint64_t i = 0; i < numTaps; i++)
+	{
+		sumA += sampleBuffer[i] * coefficientsA[i];
+		sumB += sampleBuffer[i] * coefficientsB[i];
+	}
+}
+
+#if defined ADL_SIMD_X86
+
+static void DotProductPairSSE2(const double* sampleBuffer, const double* coefficientsA, const double* coefficientsB, uint64_t numTaps, double& sumA, double& sumB)
+{
+	__m128d accumulatorA = _mm_setzero_pd();
+	__m128d accumulatorB = _mm_setzero_pd();
+
+	uint64_t i = 0;
+	for (; i + 2 <= numTaps; i += 2)
+	{
+		__m128d samples = _mm_loadu_pd(&sampleBuffer[i]);
+		accumulatorA = _mm_add_pd(accumulatorA, _mm_mul_pd(samples, _mm_loadu_pd(&coefficientsA[i])));
+		accumulatorB = _mm_add_pd(accumulatorB, _mm_mul_pd(samples, _mm_loadu_pd(&coefficientsB[i])));
+	}
+
+	double partialA[2], partialB[2];
+	_mm_storeu_pd(partialA, accumulatorA);
+	_mm_storeu_pd(partialB, accumulatorB);
+	sumA = partialA[0] + partialA[1];
+	sumB = partialB[0] + partialB[1];
+
+	for (; i < numTaps; i++)
+	{
+		sumA += sampleBuffer[i] * coefficientsA[i];
+		sumB += sampleBuffer[i] * coefficientsB[i];
+	}
+}
+
+ADL_AVX2_FUNC static void DotProductPairAVX2(const double* sampleBuffer, const double* coefficientsA, const double* coefficientsB, uint64_t numTaps, double& sumA, double& sumB)
+{
+	__m256d accumulatorA = _mm256_setzero_pd();
+	__m256d accumulatorB = _mm256_setzero_pd();
+
+	uint64_t i = 0;
+	for (; i + 4 <= numTaps; i += 4)
+	{
+		__m256d samples = _mm256_loadu_pd(&sampleBuffer[i]);
+		accumulatorA = _mm256_add_pd(accumulatorA, _mm256_mul_pd(samples, _mm256_loadu_pd(&coefficientsA[i])));
+		accumulatorB = _mm256_add_pd(accumulatorB, _mm256_mul_pd(samples, _mm256_loadu_pd(&coefficientsB[i])));
+	}
+
+	double partialA[4], partialB[4];
+	_mm256_storeu_pd(partialA, accumulatorA);
+	_mm256_storeu_pd(partialB, accumulatorB);
+	sumA = (partialA[0] + partialA[1]) + (partialA[2] + partialA[3]);
+	sumB = (partialB[0] + partialB[1]) + (partialB[2] + partialB[3]);
+
+	for (; i < numTaps; i++)
+	{
+		sumA += sampleBuffer[i] * coefficientsA[i];
+		sumB += sampleBuffer[i] * coefficientsB[i];
+	}
+}
+
+#endif //ADL_SIMD_X86
+
+//---------------------------------- Resampler ----------------------------------
+
+Resampler::Resampler()
+{
+	this->quality = Quality::LINEAR;
+	this->inputRate = 0.0;
+	this->outputRate = 0.0;
+	this->numTaps = 2;
+	this->numPhases = 0;
+	this->dotProductKernel = &DotProductPairScalar;
+	this->historyCount = 0;
+	this->windowStart = 0;
+	this->fraction = 0.0;
+	this->stepWhole = 1;
+	this->stepFraction = 0.0;
+}
+
+/*virtual*/ Resampler::~Resampler()
+{
+}
+
+bool Resampler::Configure(double inputRate, double outputRate, Quality quality /*= Quality::SINC_32*/)
+{
+	if (inputRate <= 0.0 || outputRate <= 0.0)
+	{
+		ErrorSystem::Get()->Add(std::format("Can't resample from {} Hz to {} Hz.", inputRate, outputRate));
+		return false;
+	}
+
+	// The wider the filter, the steeper we can make its roll-off, so the closer we can put the cut-off to Nyquist.
+	double rollOff = 1.0;
+	switch (quality)
+	{
+		case Quality::LINEAR:
+			this->numTaps = 2;
+			break;
+		case Quality::CUBIC:
+			this->numTaps = 4;
+			break;
+		case Quality::SINC_16:
+			this->numTaps = 16;
+			rollOff = 0.85;
+			break;
+		case Quality::SINC_32:
+			this->numTaps = 32;
+			rollOff = 0.91;
+			break;
+		case Quality::SINC_64:
+			this->numTaps = 64;
+			rollOff = 0.95;
+			break;
+		default:
+			ErrorSystem::Get()->Add(std::format("Unknown resampler quality: {}", int(quality)));
+			return false;
+	}
+
+	this->quality = quality;
+	this->inputRate = inputRate;
+	this->outputRate = outputRate;
+
+	double step = inputRate / outputRate;
+	this->stepWhole = uint64_t(::floor(step));
+	this->stepFraction = step - double(this->stepWhole);
+
+	this->coefficientTable.clear();
+	this->numPhases = 0;
+	if (this->numTaps > 4)
+	{
+		// When decimating, the cut-off has to come down to the output's Nyquist frequency, or we'll alias.
+		double cutoff = ADL_MIN(1.0, outputRate / inputRate) * rollOff;
+		this->numPhases = ADL_RESAMPLER_NUM_PHASES;
+		this->GenerateCoefficientTable(cutoff);
+	}
+
+	this->dotProductKernel = &DotProductPairScalar;
+#if defined ADL_SIMD_X86
+	switch (PCMConverter::GetInstructionSet())
+	{
+		case PCMConverter::InstructionSet::AVX2:
+			this->dotProductKernel = &DotProductPairAVX2;
+			break;
+		case PCMConverter::InstructionSet::SSE2:
+			this->dotProductKernel = &DotProductPairSSE2;
+			break;
+		default:
+			break;
+	}
+#endif //ADL_SIMD_X86
+
+	this->historyBuffer.resize(this->numTaps + ADL_RESAMPLER_BLOCK_SIZE);
+	this->Reset();
+	return true;
+}
+
+void Resampler::GenerateCoefficientTable(double cutoff)
+{
+	// Each row is a Blackman-windowed sinc, shifted by the row's fractional offset.  Tap j of a
+	// row sits at distance (j - (halfTaps - 1) - fraction) from the point being evaluated.
+	int64_t halfTaps = int64_t(this->numTaps / 2);
+	this->coefficientTable.resize((this->numPhases + 1) * this->numTaps);
+
+	for (uint64_t phase = 0; phase <= this->numPhases; phase++)
+	{
+		double phaseFraction = double(phase) / double(this->numPhases);
+		double* row = &this->coefficientTable[phase * this->numTaps];
+		double rowSum = 0.0;
+
+		for (uint64_t j = 0; j < this->numTaps; j++)
+		{
+			double distance = double(int64_t(j) - (halfTaps - 1)) - phaseFraction;
+
+			double x = cutoff * distance;
+			double sinc = (::fabs(x) < 1e-9) ? 1.0 : (::sin(ADL_PI * x) / (ADL_PI * x));
+
+			double y = ADL_CLAMP(distance / double(halfTaps), -1.0, 1.0);
+			double window = 0.42 + 0.5 * ::cos(ADL_PI * y) + 0.08 * ::cos(2.0 * ADL_PI * y);
+
+			row[j] = cutoff * sinc * window;
+			rowSum += row[j];
+		}
+
+		// Normalize each row so that a constant signal comes out at the same level it went in.
+		if (rowSum != 0.0)
+			for (uint64_t j = 0; j < this->numTaps; j++)
+				row[j] /= rowSum;
+	}
+}
+
+void Resampler::Reset()
+{
+	// Prime the history with enough silence that the first input sample we're given
+	// lands right where the first output sample gets evaluated.
+	this->historyCount = this->numTaps / 2 - 1;
+	for (uint64_t i = 0; i < this->historyCount; i++)
+		this->historyBuffer[i] = 0.0;
+
+	this->windowStart = 0;
+	this->fraction = 0.0;
+}
+
+double Resampler::InterpolateSample(const double* window) const
+{
+	double t = this->fraction;
+
+	switch (this->quality)
+	{
+		case Quality::LINEAR:
+		{
+			return window[0] + t * (window[1] - window[0]);
+		}
+		case Quality::CUBIC:
+		{
+			// This is a Catmull-Rom spline through the 4 samples, evaluated between the middle two.
+			double a = -0.5 * window[0] + 1.5 * window[1] - 1.5 * window[2] + 0.5 * window[3];
+			double b = window[0] - 2.5 * window[1] + 2.0 * window[2] - 0.5 * window[3];
+			double c = -0.5 * window[0] + 0.5 * window[2];
+			double d = window[1];
+			return ((a * t + b) * t + c) * t + d;
+		}
+		default:
+		{
+			double phasePosition = t * double(this->numPhases);
+			uint64_t phase = uint64_t(phasePosition);
+			if (phase >= this->numPhases)
+				phase = this->numPhases - 1;
+			double blend = phasePosition - double(phase);
+
+			const double* coefficientsA = &this->coefficientTable[phase * this->numTaps];
+			const double* coefficientsB = coefficientsA + this->numTaps;
+
+			double sumA = 0.0, sumB = 0.0;
+			this->dotProductKernel(window, coefficientsA, coefficientsB, this->numTaps, sumA, sumB);
+			return sumA + blend * (sumB - sumA);
+		}
+	}
+}
+
+uint64_t Resampler::Process(const double* inputBuffer, uint64_t numInputSamples, double* outputBuffer, uint64_t maxOutputSamples, uint64_t& numInputSamplesConsumed)
+{
+	numInputSamplesConsumed = 0;
+	uint64_t numOutputSamples = 0;
+
+	if (this->historyBuffer.size() == 0)
+	{
+		ErrorSystem::Get()->Add("Resampler was not configured.");
+		return 0;
+	}
+
+	while (numOutputSamples < maxOutputSamples)
+	{
+		// Produce an output sample if the whole filter window is buffered.
+		if (this->windowStart + this->numTaps <= this->historyCount)
+		{
+			outputBuffer[numOutputSamples++] = this->InterpolateSample(&this->historyBuffer[this->windowStart]);
+
+			this->windowStart += this->stepWhole;
+			this->fraction += this->stepFraction;
+			if (this->fraction >= 1.0)
+			{
+				this->fraction -= 1.0;
+				this->windowStart++;
+			}
+
+			continue;
+		}
+
+		if (numInputSamplesConsumed == numInputSamples)
+			break;
+
+		uint64_t numInputSamplesLeft = numInputSamples - numInputSamplesConsumed;
+
+		// When decimating hard enough, the window can jump clear past everything we've buffered,
+		// in which case there's no point in copying the input that it skips over.
+		if (this->windowStart > this->historyCount)
+		{
+			this->windowStart -= this->historyCount;
+			this->historyCount = 0;
+
+			uint64_t numToSkip = ADL_MIN(this->windowStart, numInputSamplesLeft);
+			this->windowStart -= numToSkip;
+			numInputSamplesConsumed += numToSkip;
+			continue;
+		}
+
+		// Slide what's left of the window down to the front of the history to make room for more input.
+		// This is never more than a window's worth of samples.
+		if (this->windowStart > 0)
+		{
+			uint64_t numToKeep = this->historyCount - this->windowStart;
+			::memmove(this->historyBuffer.data(), &this->historyBuffer[this->windowStart], numToKeep * sizeof(double));
+			this->historyCount = numToKeep;
+			this->windowStart = 0;
+		}
+
+		uint64_t numToCopy = ADL_MIN(uint64_t(this->historyBuffer.size()) - this->historyCount, numInputSamplesLeft);
+		::memcpy(&this->historyBuffer[this->historyCount], &inputBuffer[numInputSamplesConsumed], numToCopy * sizeof(double));
+		this->historyCount += numToCopy;
+		numInputSamplesConsumed += numToCopy;
+	}
+
+	return numOutputSamples;
+}
+
+uint64_t Resampler::GetInputNeeded(uint64_t numOutputSamples) const
+{
+	if (numOutputSamples == 0)
+		return 0;
+
+	// Step forward exactly the way Process does so that we never disagree with it by a sample due to round-off.
+	uint64_t lastWindowStart = this->windowStart;
+	double lastFraction = this->fraction;
+	for (uint64_t i = 1; i < numOutputSamples; i++)
+	{
+		lastWindowStart += this->stepWhole;
+		lastFraction += this->stepFraction;
+		if (lastFraction >= 1.0)
+		{
+			lastFraction -= 1.0;
+			lastWindowStart++;
+		}
+	}
+
+	uint64_t windowEnd = lastWindowStart + this->numTaps;
+	return (windowEnd > this->historyCount) ? (windowEnd - this->historyCount) : 0;
+}
+
+/*static*/ const char* Resampler::GetQualityName(Quality quality)
+{
+	switch (quality)
+	{
+		case Quality::LINEAR:
+			return "linear";
+		case Quality::CUBIC:
+			return "cubic";
+		case Quality::SINC_16:
+			return "sinc16";
+		case Quality::SINC_32:
+			return "sinc32";
+		case Quality::SINC_64:
+			return "sinc64";
+	}
+
+	return "?";
+}
+
+/*static*/ bool Resampler::GetQualityFromName(const std::string& name, Quality& quality)
+{
+	for (int32_t i = int32_t(Quality::LINEAR); i <= int32_t(Quality::SINC_64); i++)
+	{
+		if (name == GetQualityName(Quality(i)))
+		{
+			quality = Quality(i);
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "AudioDataLib/Common.h"
+
+namespace AudioDataLib
+{
+	/**
+	 * @brief This class converts a single channel of audio from one sample-rate to another.
+	 *
+	 * Unlike WaveForm::EvaluateAt, which only ever sees the one wave-form it's given, a resampler
+	 * remembers the tail end of whatever it was last fed, so that you can stream audio through it a block
+	 * at a time without getting clicks at the block boundaries.  The filter state carries over from one
+	 * call of Process to the next until Reset is called.
+	 *
+	 * The sinc-based quality tiers use a windowed-sinc low-pass filter whose coefficients are all
+	 * worked out up front (in Configure) for a fixed number of fractional offsets, or phases, between
+	 * input samples.  At run-time we just pick the two nearest phases, take dot products and blend.
+	 * The dot products are vectorized using the same instruction set that the PCMConverter class uses.
+	 *
+	 * All memory the resampler needs is allocated by Configure, so calls to Process never touch the heap.
+	 * That makes it safe to use on an audio thread.
+	 */
+	class AUDIO_DATA_LIB_API Resampler
+	{
+	public:
+		Resampler();
+		virtual ~Resampler();
+
+		/**
+		 * These are the available quality tiers, from cheapest to most expensive.
+		 */
+		enum Quality
+		{
+			LINEAR,		///< Straight-line interpolation between neighboring samples.  Cheap, but lets a lot of aliasing through.
+			CUBIC,		///< Catmull-Rom interpolation over 4 neighboring samples.  Smoother, but still no real anti-aliasing.
+			SINC_16,	///< Windowed-sinc filter with 16 taps.
+			SINC_32,	///< Windowed-sinc filter with 32 taps.  This is a good default.
+			SINC_64		///< Windowed-sinc filter with 64 taps.  Use this for offline conversion.
+		};
+
+		typedef void (*DotProductKernel)(const double* sampleBuffer, const double* coefficientsA, const double* coefficientsB, uint64_t numTaps, double& sumA, double& sumB);
+
+		/**
+		 * Set up the resampler to convert between the given rates.  This is where all allocation happens.
+		 * The resampler is also reset, so any previously buffered audio is thrown away.
+		 *
+		 * @param[in] inputRate This is the sample-rate of the audio that will be fed to Process, in samples per second.
+		 * @param[in] outputRate This is the sample-rate of the audio that Process should produce, in samples per second.
+		 * @param[in] quality This is the kind of interpolation to use.
+		 * @return True is returned on success; false otherwise, such as when the given rates make no sense.
+		 */
+		bool Configure(double inputRate, double outputRate, Quality quality = Quality::SINC_32);
+
+		/**
+		 * Forget all buffered input, as if we were just configured.  Call this when seeking or when
+		 * starting a new, unrelated stream of audio.
+		 */
+		void Reset();
+
+		/**
+		 * Feed the given input samples through the resampler.  Output samples are produced until either
+		 * the output buffer is full or there isn't enough input to produce another one.  Any input that
+		 * is consumed but not yet needed is kept internally for the next call.
+		 *
+		 * Note that the first output sample lines up with the first input sample given after a reset,
+		 * but some look-ahead (see GetLatencySamples) is needed before it can be produced.
+		 *
+		 * @param[in] inputBuffer These are the input samples to resample.
+		 * @param[in] numInputSamples This is the number of samples in the given input buffer.
+		 * @param[out] outputBuffer This receives the resampled audio.
+		 * @param[in] maxOutputSamples This is the room available in the given output buffer.
+		 * @param[out] numInputSamplesConsumed This is how many of the given input samples were used up.  Any that weren't should be given again on the next call.
+		 * @return The number of output samples produced is returned.
+		 */
+		uint64_t Process(const double* inputBuffer, uint64_t numInputSamples, double* outputBuffer, uint64_t maxOutputSamples, uint64_t& numInputSamplesConsumed);
+
+		/**
+		 * Return exactly how many more input samples Process needs to be fed in order to produce the
+		 * given number of output samples.  This lets a caller pull a precise amount from its source.
+		 */
+		uint64_t GetInputNeeded(uint64_t numOutputSamples) const;
+
+		/**
+		 * Return how many input samples of look-ahead the filter needs beyond the point being evaluated.
+		 */
+		uint64_t GetLatencySamples() const { return this->numTaps / 2; }
+
+		/**
+		 * Return the quality tier we were configured with.
+		 */
+		Quality GetQuality() const { return this->quality; }
+
+		double GetInputRate() const { return this->inputRate; }
+		double GetOutputRate() const { return this->outputRate; }
+
+		/**
+		 * Return a human-readable name for the given quality tier.
+		 */
+		static const char* GetQualityName(Quality quality);
+
+		/**
+		 * Return the quality tier with the given name, or false if there isn't one by that name.
+		 */
+		static bool GetQualityFromName(const std::string& name, Quality& quality);
+
+	private:
+
+		void GenerateCoefficientTable(double cutoff);
+		double InterpolateSample(const double* window) const;
+
+		Quality quality;
+		double inputRate;
+		double outputRate;
+		uint64_t numTaps;					///< This is the number of input samples that contribute to each output sample.
+		uint64_t numPhases;					///< This is the number of fractional offsets between input samples for which we've precomputed coefficients.
+		std::vector<double> coefficientTable;	///< There are (numPhases + 1) rows of numTaps coefficients each.
+		DotProductKernel dotProductKernel;
+
+		std::vector<double> historyBuffer;	///< This holds the input samples we're working on, plus some room to take on more.
+		uint64_t historyCount;				///< This is how many samples in the history buffer are valid.
+		uint64_t windowStart;				///< This is where, in the history buffer, the filter window for the next output sample begins.  It can run past the buffered data when decimating.
+		double fraction;					///< This is how far between input samples the next output sample falls, in [0,1).
+		uint64_t stepWhole;					///< This is the whole part of how far we move through the input for each output sample.
+		double stepFraction;				///< This is the fractional part of how far we move through the input for each output sample.
+	};
+}
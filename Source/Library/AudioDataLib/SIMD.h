@@ -0,0 +1,16 @@
+#pragma once
+
+// This is meant to be included only by translation units that have vectorized kernels in them.
+// The kernels are compiled for whatever instruction sets we know about, but which one actually
+// gets used is decided at run-time; see PCMConverter::GetInstructionSet.
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#	define ADL_SIMD_X86
+#	include <immintrin.h>
+#	if defined(_MSC_VER)
+#		include <intrin.h>
+#		define ADL_AVX2_FUNC
+#	else
+#		define ADL_AVX2_FUNC		__attribute__((target("avx2")))
+#	endif
+#endif
@@ -0,0 +1,324 @@
+#include "AudioDataLib/SampleStreamer.h"
+#include "AudioDataLib/ByteStream.h"
+#include "AudioDataLib/ErrorSystem.h"
+
+using namespace AudioDataLib;
+
+// This is how long our thread sleeps when every stream is as full as it needs to be.
+#define SAMPLE_STREAMER_IDLE_WAIT_MS		5
+
+//------------------------- SampleStreamer -------------------------
+
+SampleStreamer::SampleStreamer(double bufferSeconds /*= 0.25*/, uint64_t chunkFrames /*= 4096*/)
+{
+	this->bufferSeconds = bufferSeconds;
+	this->chunkFrames = ADL_MAX(chunkFrames, 1);
+	this->stats = Stats{};
+	this->quit = false;
+
+	this->mutex = new std::mutex();
+	this->workCondition = new std::condition_variable();
+	this->streamerThread = new std::thread([this]() { this->StreamerThreadMain(); });
+}
+
+/*virtual*/ SampleStreamer::~SampleStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(*this->mutex);
+		this->quit = true;
+	}
+
+	this->workCondition->notify_all();
+	this->streamerThread->join();
+	delete this->streamerThread;
+
+	delete this->mutex;
+	delete this->workCondition;
+}
+
+std::shared_ptr<SampleStreamer::Stream> SampleStreamer::OpenStream(const WaveTableData::AudioSampleData* audioSampleData, uint64_t firstFrame, double playbackRate)
+{
+	std::shared_ptr<Stream> stream;
+
+	if (!audioSampleData->IsDeferred())
+	{
+		ErrorSystem::Get()->Add(std::format("Sample {} isn't in a file, so it can't be streamed.", audioSampleData->GetName().c_str()));
+		return stream;
+	}
+
+	const AudioData::Format& format = audioSampleData->GetFormat();
+	stream.reset(new Stream());
+
+	if (!stream->converter.Configure(format))
+	{
+		ErrorSystem::Get()->Add(std::format("The format of sample {} can't be streamed.", audioSampleData->GetName().c_str()));
+		stream.reset();
+		return stream;
+	}
+
+	stream->mappedFile = audioSampleData->GetDeferredFile();
+	stream->fileOffset = audioSampleData->GetDeferredOffset();
+	stream->numFileFrames = audioSampleData->GetNumDeferredFrames();
+	stream->bytesPerFrame = format.BytesPerFrame();
+	stream->framesPerSecond = format.framesPerSecond;
+
+	if (stream->fileOffset + stream->numFileFrames * stream->bytesPerFrame > stream->mappedFile->GetBufferSize())
+	{
+		ErrorSystem::Get()->Add(std::format("The audio of sample {} runs past the end of its file.", audioSampleData->GetName().c_str()));
+		stream.reset();
+		return stream;
+	}
+
+	// This is the same as what the LoopedAudioModule class does: anything but NOT_LOOPED loops until the note fades.
+	stream->looped = (audioSampleData->GetMode() != WaveTableData::AudioSampleData::Mode::NOT_LOOPED);
+	if (!stream->looped)
+		stream->numFrames = stream->numFileFrames;
+	else
+	{
+		const WaveTableData::AudioSampleData::Loop& loop = audioSampleData->GetLoop();
+		if (loop.startFrame >= loop.endFrame || loop.endFrame > stream->numFileFrames)
+		{
+			ErrorSystem::Get()->Add(std::format("The loop ([{}, {}]) of sample {} doesn't make sense.", loop.startFrame, loop.endFrame, audioSampleData->GetName().c_str()));
+			stream.reset();
+			return stream;
+		}
+
+		stream->loopStartFrame = loop.startFrame;
+		stream->loopEndFrame = loop.endFrame;
+		stream->numFrames = std::numeric_limits<uint64_t>::max();
+	}
+
+	uint64_t minCapacity = ADL_MAX(uint64_t(this->bufferSeconds * stream->framesPerSecond), 2 * this->chunkFrames);
+	stream->ringCapacity = 1;
+	while (stream->ringCapacity < minCapacity)
+		stream->ringCapacity <<= 1;
+
+	stream->ringBuffer.resize(size_t(2 * stream->ringCapacity));
+
+	firstFrame = ADL_MIN(firstFrame, stream->numFrames);
+	stream->readFrame = firstFrame;
+	stream->writeFrame = firstFrame;
+	stream->playbackRate = playbackRate;
+
+	{
+		std::lock_guard<std::mutex> lock(*this->mutex);
+		this->streamArray.push_back(stream);
+		this->stats.numStreamsOpened++;
+	}
+
+	this->workCondition->notify_one();
+	return stream;
+}
+
+SampleStreamer::Stats SampleStreamer::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(*this->mutex);
+
+	Stats stats = this->stats;
+	for (const std::shared_ptr<Stream>& stream : this->streamArray)
+	{
+		stats.numUnderruns += stream->numUnderruns;
+		stats.numFramesMissed += stream->numFramesMissed;
+	}
+
+	return stats;
+}
+
+void SampleStreamer::StreamerThreadMain()
+{
+	while (true)
+	{
+		{
+			std::lock_guard<std::mutex> lock(*this->mutex);
+			if (this->quit)
+				break;
+
+			// Let go of the streams whose voices are done with them, but keep what they had to say.
+			for (uint32_t i = 0; i < this->streamArray.size(); i++)
+			{
+				Stream* stream = this->streamArray[i].get();
+				if (stream->closed)
+				{
+					this->stats.numUnderruns += stream->numUnderruns;
+					this->stats.numFramesMissed += stream->numFramesMissed;
+					this->streamArray[i] = this->streamArray[this->streamArray.size() - 1];
+					this->streamArray.pop_back();
+					i--;
+				}
+			}
+
+			this->stats.numActiveStreams = this->streamArray.size();
+			this->serviceArray = this->streamArray;
+		}
+
+		// The disk can take as long as it likes here, since the voices never wait on us.
+		Stream* stream = this->FindNeediestStream();
+		if (stream)
+		{
+			uint64_t numFramesRead = stream->Fill(this->chunkFrames);
+
+			std::lock_guard<std::mutex> lock(*this->mutex);
+			this->stats.numChunksRead++;
+			this->stats.numFramesStreamed += numFramesRead;
+			continue;
+		}
+
+		// Every stream is full enough for now, so there's nothing to do until the voices have played some more.
+		// We don't want to keep closed streams alive while we sleep, though.
+		this->serviceArray.clear();
+
+		std::unique_lock<std::mutex> lock(*this->mutex);
+		if (!this->quit)
+			this->workCondition->wait_for(lock, std::chrono::milliseconds(SAMPLE_STREAMER_IDLE_WAIT_MS));
+	}
+
+	this->serviceArray.clear();
+}
+
+SampleStreamer::Stream* SampleStreamer::FindNeediestStream()
+{
+	Stream* neediestStream = nullptr;
+	double minSecondsLeft = std::numeric_limits<double>::max();
+
+	for (const std::shared_ptr<Stream>& stream : this->serviceArray)
+	{
+		if (stream->IsFinished())
+			continue;
+
+		// It's not worth going to the disk for a stream until there's room for a whole chunk, unless it's near its end.
+		uint64_t numFramesWanted = stream->GetNumFramesWanted();
+		uint64_t numFramesToEnd = stream->numFrames - ADL_MAX(stream->writeFrame.load(), stream->readFrame.load());
+		if (numFramesWanted == 0 || numFramesWanted < ADL_MIN(this->chunkFrames, numFramesToEnd))
+			continue;
+
+		double secondsLeft = stream->GetSecondsLeft();
+		if (secondsLeft < minSecondsLeft)
+		{
+			minSecondsLeft = secondsLeft;
+			neediestStream = stream.get();
+		}
+	}
+
+	return neediestStream;
+}
+
+//------------------------- SampleStreamer::Stream -------------------------
+
+SampleStreamer::Stream::Stream()
+{
+	this->fileOffset = 0;
+	this->numFileFrames = 0;
+	this->bytesPerFrame = 0;
+	this->framesPerSecond = 0.0;
+	this->looped = false;
+	this->loopStartFrame = 0;
+	this->loopEndFrame = 0;
+	this->numFrames = 0;
+	this->ringCapacity = 0;
+	this->readFrame = 0;
+	this->writeFrame = 0;
+	this->playbackRate = 1.0;
+	this->closed = false;
+	this->numUnderruns = 0;
+	this->numFramesMissed = 0;
+}
+
+/*virtual*/ SampleStreamer::Stream::~Stream()
+{
+}
+
+const double* SampleStreamer::Stream::GetBufferedFrames(uint64_t& firstFrame, uint64_t& numFrames) const
+{
+	// The write frame is only moved forward once the frames before it are in the ring.
+	firstFrame = this->readFrame.load(std::memory_order_relaxed);
+	uint64_t writeFrame = this->writeFrame.load(std::memory_order_acquire);
+	numFrames = (writeFrame > firstFrame) ? (writeFrame - firstFrame) : 0;
+
+	if (this->ringCapacity == 0)
+		return nullptr;
+
+	return &this->ringBuffer[size_t(firstFrame & (this->ringCapacity - 1))];
+}
+
+void SampleStreamer::Stream::ReleaseFrames(uint64_t frame)
+{
+	// Once the read frame moves forward, our thread is free to overwrite what came before it.
+	if (frame > this->readFrame.load(std::memory_order_relaxed))
+		this->readFrame.store(frame, std::memory_order_release);
+}
+
+void SampleStreamer::Stream::ReportUnderrun(uint64_t numFramesMissed)
+{
+	this->numUnderruns++;
+	this->numFramesMissed += numFramesMissed;
+}
+
+bool SampleStreamer::Stream::IsFinished() const
+{
+	return this->closed || this->writeFrame >= this->numFrames;
+}
+
+uint64_t SampleStreamer::Stream::GetNumFramesWanted() const
+{
+	uint64_t readFrame = this->readFrame.load(std::memory_order_acquire);
+	uint64_t writeFrame = ADL_MAX(this->writeFrame.load(std::memory_order_relaxed), readFrame);
+	return ADL_MIN(this->ringCapacity - (writeFrame - readFrame), this->numFrames - writeFrame);
+}
+
+double SampleStreamer::Stream::GetSecondsLeft() const
+{
+	uint64_t readFrame = this->readFrame.load(std::memory_order_relaxed);
+	uint64_t writeFrame = this->writeFrame.load(std::memory_order_relaxed);
+	if (writeFrame <= readFrame)
+		return 0.0;
+
+	return double(writeFrame - readFrame) / (this->framesPerSecond * ADL_MAX(this->playbackRate.load(), 1e-6));
+}
+
+uint64_t SampleStreamer::Stream::GetFileFrame(uint64_t frame) const
+{
+	if (!this->looped || frame < this->loopEndFrame)
+		return frame;
+
+	return this->loopStartFrame + (frame - this->loopStartFrame) % (this->loopEndFrame - this->loopStartFrame);
+}
+
+uint64_t SampleStreamer::Stream::Fill(uint64_t maxFrames)
+{
+	// If the voice got ahead of us, then there's no point reading what it has already gone without.
+	uint64_t readFrame = this->readFrame.load(std::memory_order_acquire);
+	uint64_t writeFrame = ADL_MAX(this->writeFrame.load(std::memory_order_relaxed), readFrame);
+	uint64_t numFramesToRead = ADL_MIN(maxFrames, this->GetNumFramesWanted());
+
+	const uint8_t* fileBuffer = this->mappedFile->GetBuffer() + this->fileOffset;
+	uint64_t mask = this->ringCapacity - 1;
+	uint64_t numFramesRead = 0;
+
+	while (numFramesRead < numFramesToRead)
+	{
+		// A run stops at the end of the ring, and at the end of the loop (or the audio.)
+		uint64_t frame = writeFrame + numFramesRead;
+		uint64_t fileFrame = this->GetFileFrame(frame);
+		uint64_t ringIndex = frame & mask;
+		uint64_t runLength = numFramesToRead - numFramesRead;
+		runLength = ADL_MIN(runLength, this->ringCapacity - ringIndex);
+		runLength = ADL_MIN(runLength, (this->looped ? this->loopEndFrame : this->numFileFrames) - fileFrame);
+
+		double* ringSlot = &this->ringBuffer[size_t(ringIndex)];
+		this->converter.DecodeChannel(&fileBuffer[fileFrame * this->bytesPerFrame], 0, ringSlot, runLength);
+		::memcpy(ringSlot + this->ringCapacity, ringSlot, size_t(runLength * sizeof(double)));
+
+		numFramesRead += runLength;
+	}
+
+	this->writeFrame.store(writeFrame + numFramesRead, std::memory_order_release);
+
+	// Get the OS started on our next read for this stream while the voice works through this one.
+	if (writeFrame + numFramesRead < this->numFrames)
+	{
+		uint64_t nextFileFrame = this->GetFileFrame(writeFrame + numFramesRead);
+		this->mappedFile->Prefetch(this->fileOffset + nextFileFrame * this->bytesPerFrame, maxFrames * this->bytesPerFrame);
+	}
+
+	return numFramesRead;
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "AudioDataLib/FileDatas/WaveTableData.h"
+#include "AudioDataLib/PCMConverter.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace AudioDataLib
+{
+	class MappedFileInputStream;
+
+	/**
+	 * @brief This is a thread that reads wave-table samples off the disk as they're being played.
+	 *
+	 * Each voice that plays a streamed sample gets its own Stream from us, which is a ring buffer of decoded audio.
+	 * The voice reads from the front of the ring while our thread fills in the back, straight from the sample's file.
+	 * Whenever we have a moment, we top up whichever stream is going to run dry soonest, going by how much it has left
+	 * and how fast its voice is getting through it.  A chunk at a time is read, so that no one stream hogs the disk.
+	 *
+	 * The voice side of a stream never takes a lock or waits on us.  If a voice gets to audio we haven't read yet,
+	 * it's up to the voice to carry on without it and tell the stream, which we count as an underrun.  See GetStats.
+	 */
+	class AUDIO_DATA_LIB_API SampleStreamer
+	{
+	public:
+		/**
+		 * @param[in] bufferSeconds This is about how much audio each stream holds, ahead of its voice, when it's full.
+		 * @param[in] chunkFrames This is the most we read for one stream before seeing who needs us most.
+		 */
+		SampleStreamer(double bufferSeconds = 0.25, uint64_t chunkFrames = 4096);
+		virtual ~SampleStreamer();
+
+		/**
+		 * @brief This is the ring buffer between one voice and our thread.
+		 *
+		 * Frames are numbered in the order they're played, starting from the start of the sample.  If the sample is looped,
+		 * then the numbers just keep going around the loop, so that the voice never has to know about it.
+		 */
+		class AUDIO_DATA_LIB_API Stream
+		{
+			friend class SampleStreamer;
+
+		public:
+			Stream();
+			virtual ~Stream();
+
+			/**
+			 * Return the frames we have ready for the voice, which are contiguous in memory.  These stay put
+			 * until the voice calls ReleaseFrames.  Zero frames may be returned.
+			 *
+			 * @param[out] firstFrame This is the number of the first frame returned.
+			 * @param[out] numFrames This is how many frames are returned.
+			 */
+			const double* GetBufferedFrames(uint64_t& firstFrame, uint64_t& numFrames) const;
+
+			/**
+			 * Tell us that the voice is done with everything before the given frame, so that we can reuse the room.
+			 * Everything from there on is what the voice is waiting for, even if we haven't read it yet.
+			 */
+			void ReleaseFrames(uint64_t frame);
+
+			/**
+			 * The voice calls this when it gets to frames we didn't read in time.
+			 */
+			void ReportUnderrun(uint64_t numFramesMissed);
+
+			/**
+			 * Tell us how many frames of the sample the voice plays per frame of the sample's own rate.
+			 * This is how we know who will run dry first.
+			 */
+			void SetPlaybackRate(double playbackRate) { this->playbackRate = playbackRate; }
+
+			/**
+			 * The voice calls this when it's done with us, so that our thread can stop reading for it.
+			 */
+			void Close() { this->closed = true; }
+
+			/**
+			 * Return how many frames there are to play, which is forever if the sample is looped.
+			 */
+			uint64_t GetNumFrames() const { return this->numFrames; }
+
+		private:
+
+			bool IsFinished() const;
+			uint64_t GetNumFramesWanted() const;
+			double GetSecondsLeft() const;
+			uint64_t GetFileFrame(uint64_t frame) const;
+			uint64_t Fill(uint64_t maxFrames);
+
+			std::shared_ptr<MappedFileInputStream> mappedFile;
+			uint64_t fileOffset;					///< This is where in the file the sample's audio starts.
+			uint64_t numFileFrames;					///< This is how many frames of audio the sample has in the file.
+			uint64_t bytesPerFrame;
+			double framesPerSecond;
+			PCMConverter converter;
+			bool looped;
+			uint64_t loopStartFrame;
+			uint64_t loopEndFrame;
+			uint64_t numFrames;
+
+			// The ring is stored twice over, back to back, so that any span of it is contiguous in memory.
+			std::vector<double> ringBuffer;
+			uint64_t ringCapacity;					///< This is how many frames the ring holds.  It's a power of two.
+
+			std::atomic<uint64_t> readFrame;		///< The voice is done with everything before this frame.
+			std::atomic<uint64_t> writeFrame;		///< We've read in everything from the read frame up to this frame.
+			std::atomic<double> playbackRate;
+			std::atomic<bool> closed;
+			std::atomic<uint64_t> numUnderruns;
+			std::atomic<uint64_t> numFramesMissed;
+		};
+
+		/**
+		 * Make a stream for a voice that's going to play the given sample, and start filling it.  The sample's audio
+		 * has to have been left in its file (see FileFormat::OpenWaveTable.)  This doesn't touch the disk itself.
+		 *
+		 * @param[in] audioSampleData This is the sample to stream.  It can go away before the stream does.
+		 * @param[in] firstFrame This is the first frame the voice will need from the stream.  Typically, the voice plays everything before this from the sample's preload.
+		 * @param[in] playbackRate See Stream::SetPlaybackRate.
+		 */
+		std::shared_ptr<Stream> OpenStream(const WaveTableData::AudioSampleData* audioSampleData, uint64_t firstFrame, double playbackRate);
+
+		/**
+		 * These are the numbers we keep, which tell you how well the disk is keeping up.
+		 */
+		struct Stats
+		{
+			uint64_t numStreamsOpened;		///< This is how many streams were ever made.
+			uint64_t numActiveStreams;		///< This is how many streams we're still reading for.
+			uint64_t numChunksRead;			///< This is how many times we read from the disk for a stream.
+			uint64_t numFramesStreamed;		///< This is how many frames we've read in, all streams together.
+			uint64_t numUnderruns;			///< This is how many times a voice got to audio before we did.
+			uint64_t numFramesMissed;		///< This is how many frames voices had to go without.
+		};
+
+		Stats GetStats() const;
+
+	private:
+
+		void StreamerThreadMain();
+		Stream* FindNeediestStream();
+
+		double bufferSeconds;
+		uint64_t chunkFrames;
+
+		std::vector<std::shared_ptr<Stream>> streamArray;		///< These are the streams we're reading for.  Only touch this with the lock held.
+		std::vector<std::shared_ptr<Stream>> serviceArray;		///< This is our thread's copy of the streams, so that it can read without the lock.
+		Stats stats;											///< The underrun counts here are only for the streams we've let go of.
+
+		std::thread* streamerThread;
+		std::mutex* mutex;
+		std::condition_variable* workCondition;		///< This is signaled when a stream is opened, or when it's time to quit.
+		bool quit;
+	};
+}
\ No newline at end of file
@@ -39,14 +39,13 @@ AttenuationModule::AttenuationModule()
 		return false;
 	}
 
-	std::vector<WaveForm::Sample>& sampleArray = waveForm.GetSampleArray();
-	for (uint32_t i = 0; i < sampleArray.size(); i++)
+	uint64_t numSamples = waveForm.GetNumSamples();
+	for (uint64_t i = 0; i < numSamples; i++)
 	{
 		double attenuationFactor = this->attenuationFunction->EvaluateAt(this->fallOffTimeSeconds);
-		WaveForm::Sample& sample = sampleArray[i];
-		sample.amplitude *= attenuationFactor;
-		if (i + 1 < sampleArray.size())
-			this->fallOffTimeSeconds += sampleArray[i + 1].timeSeconds - sample.timeSeconds;
+		waveForm.SetAmplitude(i, waveForm.GetAmplitude(i) * attenuationFactor);
+		if (i + 1 < numSamples)
+			this->fallOffTimeSeconds += waveForm.GetSampleTime(i + 1) - waveForm.GetSampleTime(i);
 	}
 
 	return true;
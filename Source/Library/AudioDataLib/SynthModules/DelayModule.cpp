@@ -1,9 +1,10 @@
 #include "AudioDataLib/SynthModules/DelayModule.h"
 #include "AudioDataLib/ErrorSystem.h"
+#include "AudioDataLib/RenderArena.h"
 
 using namespace AudioDataLib;
 
-DelayModule::DelayModule() : waveFormStream(2, 0.5)
+DelayModule::DelayModule() : waveFormStream(1.0)
 {
 	this->delaySeconds = 0.0;
 	this->localTimeSeconds = 0.0;
@@ -23,37 +24,41 @@ DelayModule::DelayModule() : waveFormStream(2, 0.5)
 
 	SynthModule* dependentModule = this->dependentModulesArray[0].get();
 
-	WaveForm dependentWaveForm;
-	if (!dependentModule->GenerateSound(durationSeconds, samplesPerSecond, dependentWaveForm, this))
+	// We only need to look at the dependent sound, so we take a view of it.  If the dependent is shared
+	// (through a DuplicationModule), then this saves us from copying it.
+	RenderArena::ScratchWaveForm scratchWaveForm;
+	WaveFormView dependentView;
+	if (!dependentModule->GenerateSoundView(durationSeconds, samplesPerSecond, *scratchWaveForm, dependentView, this))
 		return false;
 
-	dependentWaveForm.PadWithSilence(durationSeconds, samplesPerSecond);
-
 	double endTimeSeconds = this->waveFormStream.GetEndTimeSeconds();
 
-	for (const WaveForm::Sample& sample : dependentWaveForm.GetSampleArray())
+	// We can't pad a view with silence, so we pad as we go instead, at the rate of the view, just as WaveForm::PadWithSilence would.
+	double dependentStartTimeSeconds = dependentView.GetStartTime();
+	double dependentSamplesPerSecond = (dependentView.GetSampleRate() > 0.0) ? dependentView.GetSampleRate() : samplesPerSecond;
+	uint64_t numSamples = dependentView.GetNumSamples();
+	while (((numSamples > 0) ? double(numSamples - 1) / dependentSamplesPerSecond : 0.0) < durationSeconds)
+		numSamples++;
+
+	for (uint64_t i = 0; i < numSamples; i++)
 	{
 		WaveForm::Sample newSample;
-		newSample.amplitude = sample.amplitude;
-		newSample.timeSeconds = sample.timeSeconds + endTimeSeconds;
+		newSample.timeSeconds = dependentStartTimeSeconds + double(i) / dependentSamplesPerSecond + endTimeSeconds;
+		newSample.amplitude = (i < dependentView.GetNumSamples()) ? dependentView.GetAmplitude(i) : 0.0;
 		this->waveFormStream.AddSample(newSample);
 	}
 
-	waveForm.Clear();
+	// Evenly spread the samples across [0, durationSeconds] so that the output can be uniform.
+	uint64_t numSteps = uint64_t(::ceil(durationSeconds * samplesPerSecond));
+	double deltaTimeSeconds = (numSteps > 0) ? (durationSeconds / double(numSteps)) : (1.0 / samplesPerSecond);
+
+	waveForm.MakeUniform(0.0, 1.0 / deltaTimeSeconds, numSteps + 1);
+	std::vector<double>& amplitudeArray = waveForm.GetAmplitudeArray();
 
-	double timeSeconds = 0.0;
-	double deltaTimeSeconds = 1.0 / samplesPerSecond;
-	while (timeSeconds <= durationSeconds)
+	for (uint64_t i = 0; i <= numSteps; i++)
 	{
-		WaveForm::Sample delayedSample;
-		delayedSample.timeSeconds = timeSeconds;
-		delayedSample.amplitude = this->waveFormStream.EvaluateAt(this->localTimeSeconds - this->delaySeconds + timeSeconds);
-		waveForm.AddSample(delayedSample);
-		if (timeSeconds == durationSeconds)
-			break;
-		timeSeconds += deltaTimeSeconds;
-		if (timeSeconds > durationSeconds)
-			timeSeconds = durationSeconds;
+		double timeSeconds = (i == numSteps) ? durationSeconds : double(i) * deltaTimeSeconds;
+		amplitudeArray[i] = this->waveFormStream.EvaluateAt(this->localTimeSeconds - this->delaySeconds + timeSeconds);
 	}
 
 	this->localTimeSeconds += durationSeconds;
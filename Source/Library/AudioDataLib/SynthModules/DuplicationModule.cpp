@@ -13,6 +13,25 @@ DuplicationModule::DuplicationModule()
 }
 
 /*virtual*/ bool DuplicationModule::GenerateSound(double durationSeconds, double samplesPerSecond, WaveForm& waveForm, SynthModule* callingModule)
+{
+	if (!this->UpdateCache(durationSeconds, samplesPerSecond, callingModule))
+		return false;
+
+	waveForm.Copy(&this->cachedWaveForm);
+	return true;
+}
+
+/*virtual*/ bool DuplicationModule::GenerateSoundView(double durationSeconds, double samplesPerSecond, WaveForm& scratchWaveForm, WaveFormView& waveFormView, SynthModule* callingModule)
+{
+	if (!this->UpdateCache(durationSeconds, samplesPerSecond, callingModule))
+		return false;
+
+	// Everyone gets to look at the same buffer here, which is the whole point of this module.
+	waveFormView = this->cachedWaveForm.GetView();
+	return true;
+}
+
+bool DuplicationModule::UpdateCache(double durationSeconds, double samplesPerSecond, SynthModule* callingModule)
 {
 	if (this->GetNumDependentModules() != 1)
 	{
@@ -25,17 +44,20 @@ DuplicationModule::DuplicationModule()
 	if (!this->masterModule)
 		this->masterModule = callingModule;
 
-	if (callingModule == this->masterModule)
-		if (!dependentModule->GenerateSound(durationSeconds, samplesPerSecond, this->cachedWaveForm, this))
-			return false;
-
 	// The main assumptions we're working with here are that...
 	//   1. The number of modules dependent on this module doesn't change over time,
 	//   2. Each is asking in cyclical order, and...
 	//   3. Each is asking for the same duration and sample-rate each time.
 	// If these assumptions are not true, then not only would this complicate the module implimentation,
 	// but I would be concerned about dependent modules becoming out of sync over time.
-	waveForm.Copy(&this->cachedWaveForm);
+	if (callingModule == this->masterModule)
+	{
+		if (!dependentModule->GenerateSound(durationSeconds, samplesPerSecond, this->cachedWaveForm, this))
+			return false;
+
+		this->cachedWaveForm.ConvertToUniform(samplesPerSecond);
+	}
+
 	return true;
 }
 
@@ -18,9 +18,12 @@ namespace AudioDataLib
 		virtual ~DuplicationModule();
 
 		virtual bool GenerateSound(double durationSeconds, double samplesPerSecond, WaveForm& waveForm, SynthModule* callingModule) override;
+		virtual bool GenerateSoundView(double durationSeconds, double samplesPerSecond, WaveForm& scratchWaveForm, WaveFormView& waveFormView, SynthModule* callingModule) override;
 		virtual bool MoreSoundAvailable() override;
 
 	private:
+		bool UpdateCache(double durationSeconds, double samplesPerSecond, SynthModule* callingModule);
+
 		SynthModule* masterModule;
 		WaveForm cachedWaveForm;
 	};
@@ -25,32 +25,44 @@ LoopedAudioModule::LoopedAudioModule()
 		return false;
 	}
 
-	waveForm.Clear();
+	// Spread the samples evenly across [0, durationSeconds] so that both end-points are hit
+	// exactly and the generated wave-form can stay in the uniform representation.
+	uint64_t numSteps = uint64_t(::ceil(durationSeconds * samplesPerSecond));
+	double deltaTimeSeconds = (numSteps > 0) ? (durationSeconds / double(numSteps)) : (1.0 / samplesPerSecond);
 
-	double generatedSoundTimeSeconds = 0.0;
-	double deltaTimeSeconds = 1.0 / samplesPerSecond;
+	waveForm.MakeUniform(0.0, 1.0 / deltaTimeSeconds, numSteps + 1);
+	waveForm.SetInterpolateionMethod(this->loopedWaveForm->GetInterpolationMethod());
+	std::vector<double>& amplitudeArray = waveForm.GetAmplitudeArray();
 
-	while (generatedSoundTimeSeconds <= durationSeconds)
+	uint64_t i = 0;
+	while (i <= numSteps)
 	{
-		WaveForm::Sample sample;
-		sample.timeSeconds = generatedSoundTimeSeconds;
-		sample.amplitude = this->loopedWaveForm->EvaluateAt(this->localTimeSeconds);
-		waveForm.AddSample(sample);
-
-		if (generatedSoundTimeSeconds == durationSeconds)
-			break;
-
-		if (generatedSoundTimeSeconds + deltaTimeSeconds > durationSeconds)
+		// Evaluate as long a run of samples as we can in one go, which is up until the local
+		// time would pass the end of the loop (or the end of the audio, if we're not looping.)
+		// Once non-looped audio has run out, the local time just stays put at the end.
+		uint64_t runLength = numSteps + 1 - i;
+		double runDeltaTimeSeconds = deltaTimeSeconds;
+		double limitTimeSeconds = this->loopEnabled ? this->endTimeSeconds : this->totalTimeSeconds;
+		if (this->loopEnabled || this->localTimeSeconds < this->totalTimeSeconds)
 		{
-			deltaTimeSeconds = durationSeconds - generatedSoundTimeSeconds;
-			generatedSoundTimeSeconds = durationSeconds;
+			double numStepsToLimit = ::floor((limitTimeSeconds - this->localTimeSeconds) / deltaTimeSeconds) + 1.0;
+			if (numStepsToLimit < double(runLength))
+				runLength = uint64_t(ADL_MAX(numStepsToLimit, 1.0));
 		}
 		else
+			runDeltaTimeSeconds = 0.0;
+
+		this->loopedWaveForm->EvaluateBlock(this->localTimeSeconds, runDeltaTimeSeconds, &amplitudeArray[i], runLength);
+		i += runLength;
+
+		// Note that we leave the local time at the last sample we generated, because the next call picks up from there.
+		if (i > numSteps)
 		{
-			generatedSoundTimeSeconds += deltaTimeSeconds;
+			this->localTimeSeconds += double(runLength - 1) * runDeltaTimeSeconds;
+			break;
 		}
 
-		this->localTimeSeconds += deltaTimeSeconds;
+		this->localTimeSeconds += double(runLength) * runDeltaTimeSeconds;
 
 		if (this->loopEnabled)
 		{
@@ -109,7 +121,8 @@ bool LoopedAudioModule::UseLoopedAudioData(const WaveTableData::AudioSampleData*
 
 	const AudioData::Format& format = audioSampleData->GetFormat();
 
-	this->totalTimeSeconds = audioSampleData->GetTimeSeconds();
+	// A sample read in from its file keeps only its wave-form, not its audio buffer, so we go by its frame count.
+	this->totalTimeSeconds = double(audioSampleData->GetNumDeferredFrames()) / double(format.framesPerSecond);
 
 	this->startTimeSeconds = format.BytesPerChannelToSeconds(audioSampleData->GetLoop().startFrame * format.BytesPerFrame());
 	this->endTimeSeconds = format.BytesPerChannelToSeconds(audioSampleData->GetLoop().endFrame * format.BytesPerFrame());
@@ -1,6 +1,7 @@
 #include "AudioDataLib/SynthModules/MixerModule.h"
 #include "AudioDataLib/WaveForm.h"
 #include "AudioDataLib/ErrorSystem.h"
+#include "AudioDataLib/RenderArena.h"
 
 using namespace AudioDataLib;
 
@@ -14,25 +15,20 @@ MixerModule::MixerModule()
 
 /*virtual*/ bool MixerModule::GenerateSound(double durationSeconds, double samplesPerSecond, WaveForm& waveForm, SynthModule* callingModule)
 {
-	std::list<WaveForm*> waveFormList;
+	waveForm.Clear();
 
+	// We add each component into the mix as soon as it's generated, so the one component wave-form gets reused.
+	RenderArena::ScratchWaveForm waveFormComponent;
 	for (std::shared_ptr<SynthModule>& synthModule : this->dependentModulesArray)
 	{
 		if (synthModule->MoreSoundAvailable())
 		{
-			WaveForm* waveFormComponent = new WaveForm;
 			if (synthModule->GenerateSound(durationSeconds, samplesPerSecond, *waveFormComponent, this))
-				waveFormList.push_back(waveFormComponent);
-			else
-				delete waveFormComponent;
+				waveForm.Accumulate(waveFormComponent.Get());
 		}
 	}
 
-	waveForm.SumTogether(waveFormList);
-	// TODO: Scale sum by 1.0 / waveFormList.size()?
-
-	for (WaveForm* waveFormComponent : waveFormList)
-		delete waveFormComponent;
+	// TODO: Scale sum by 1.0 / number of components?
 
 	return !ErrorSystem::Get()->Errors();
 }
\ No newline at end of file
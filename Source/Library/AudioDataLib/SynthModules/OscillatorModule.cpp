@@ -17,20 +17,23 @@ OscillatorModule::OscillatorModule()
 
 /*virtual*/ bool OscillatorModule::GenerateSound(double durationSeconds, double samplesPerSecond, WaveForm& waveForm, SynthModule* callingModule)
 {
-	waveForm.Clear();
-
 	uint64_t numSamples = ::floor(durationSeconds * samplesPerSecond);
 
+	if (numSamples == 0)
+		waveForm.MakeUniform(0.0, samplesPerSecond, 0);
+	else
+		waveForm.MakeUniform(0.0, double(numSamples) / durationSeconds, numSamples);
+
+	std::vector<double>& amplitudeArray = waveForm.GetAmplitudeArray();
+
 	switch (this->waveParams.waveType)
 	{
 		case WaveType::SINE:
 		{
 			for (uint64_t i = 0; i < numSamples; i++)
 			{
-				WaveForm::Sample sample;
-				sample.timeSeconds = (double(i) / double(numSamples)) * durationSeconds;
-				sample.amplitude = this->waveParams.amplitude * ::sin(2.0 * ADL_PI * (this->lifeTimeSeconds + sample.timeSeconds) * this->waveParams.frequency);
-				waveForm.AddSample(sample);
+				double timeSeconds = waveForm.GetSampleTime(i);
+				amplitudeArray[i] = this->waveParams.amplitude * ::sin(2.0 * ADL_PI * (this->lifeTimeSeconds + timeSeconds) * this->waveParams.frequency);
 			}
 			break;
 		}
@@ -38,14 +41,12 @@ OscillatorModule::OscillatorModule()
 		{
 			for (uint64_t i = 0; i < numSamples; i++)
 			{
-				WaveForm::Sample sample;
-				sample.timeSeconds = (double(i) / double(numSamples)) * durationSeconds;
-				sample.amplitude = ::sin(2.0 * ADL_PI * (this->lifeTimeSeconds + sample.timeSeconds) * this->waveParams.frequency);
-				if (sample.amplitude >= 0.0)
-					sample.amplitude = this->waveParams.amplitude;
+				double timeSeconds = waveForm.GetSampleTime(i);
+				double amplitude = ::sin(2.0 * ADL_PI * (this->lifeTimeSeconds + timeSeconds) * this->waveParams.frequency);
+				if (amplitude >= 0.0)
+					amplitudeArray[i] = this->waveParams.amplitude;
 				else
-					sample.amplitude = -this->waveParams.amplitude;
-				waveForm.AddSample(sample);
+					amplitudeArray[i] = -this->waveParams.amplitude;
 			}
 			break;
 		}
@@ -53,11 +54,9 @@ OscillatorModule::OscillatorModule()
 		{
 			for (uint64_t i = 0; i < numSamples; i++)
 			{
-				WaveForm::Sample sample;
-				sample.timeSeconds = (double(i) / double(numSamples)) * durationSeconds;
-				double angle = ::fmod(2.0 * ADL_PI * (this->lifeTimeSeconds + sample.timeSeconds) * this->waveParams.frequency, 2.0 * ADL_PI);
-				sample.amplitude = (1.0 - angle / ADL_PI) * this->waveParams.amplitude;
-				waveForm.AddSample(sample);
+				double timeSeconds = waveForm.GetSampleTime(i);
+				double angle = ::fmod(2.0 * ADL_PI * (this->lifeTimeSeconds + timeSeconds) * this->waveParams.frequency, 2.0 * ADL_PI);
+				amplitudeArray[i] = (1.0 - angle / ADL_PI) * this->waveParams.amplitude;
 			}
 			break;
 		}
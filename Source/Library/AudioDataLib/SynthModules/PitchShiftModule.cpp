@@ -50,6 +50,14 @@ PitchShiftModule::PitchShiftModule()
 	double startTimeSeconds = waveForm.GetStartTime();
 	double endTimeSeconds = waveForm.GetEndTime();
 
+	if (waveForm.IsUniform())
+	{
+		// A uniform wave-form stretches uniformly, so all we have to do is change the grid.
+		if (endTimeSeconds > startTimeSeconds && durationSeconds > 0.0)
+			waveForm.SetUniformTiming(0.0, waveForm.GetUniformSampleRate() * (endTimeSeconds - startTimeSeconds) / durationSeconds);
+		return true;
+	}
+
 	for (WaveForm::Sample& sample : waveForm.GetSampleArray())
 	{
 		double alpha = (sample.timeSeconds - startTimeSeconds) / (endTimeSeconds - startTimeSeconds);
@@ -1,6 +1,7 @@
 #include "AudioDataLib/SynthModules/ReverbModule.h"
 #include "AudioDataLib/WaveForm.h"
 #include "AudioDataLib/ErrorSystem.h"
+#include "AudioDataLib/RenderArena.h"
 
 using namespace AudioDataLib;
 
@@ -60,19 +61,23 @@ ReverbModule::ReverbModule(uint8_t variation)
 		return true;
 	}
 
-	WaveForm originalWaveForm;
+	RenderArena::ScratchWaveForm scratchWaveForm;
+	WaveForm& originalWaveForm = *scratchWaveForm;
 	if (!dependentModule->GenerateSound(durationSeconds, samplesPerSecond, originalWaveForm, this))
 		return false;
 
 	originalWaveForm.PadWithSilence(durationSeconds, samplesPerSecond);
 
-	waveForm.Clear();
+	// Our output lands on the same grid as our input, so if that's uniform, we can be uniform too.
+	if (originalWaveForm.IsUniform())
+		waveForm.MakeUniform(originalWaveForm.GetStartTime(), originalWaveForm.GetUniformSampleRate());
+	else
+		waveForm.Clear();
 
-	for (const WaveForm::Sample& sample : originalWaveForm.GetSampleArray())
+	for (uint64_t j = 0; j < originalWaveForm.GetNumSamples(); j++)
 	{
-		WaveForm::Sample originalSample;
-		originalSample.amplitude = sample.amplitude;
-		originalSample.timeSeconds = sample.timeSeconds + this->localTimeBaseSeconds;
+		WaveForm::Sample originalSample = originalWaveForm.GetSample(j);
+		originalSample.timeSeconds += this->localTimeBaseSeconds;
 
 		WaveForm::Sample reverbSample;
 		reverbSample.amplitude = 0.0;
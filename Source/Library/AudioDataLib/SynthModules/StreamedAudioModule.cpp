@@ -0,0 +1,159 @@
+#include "AudioDataLib/SynthModules/StreamedAudioModule.h"
+#include "AudioDataLib/ErrorSystem.h"
+
+using namespace AudioDataLib;
+
+// To evaluate at a frame, we may need the frame before it and the two after it (see WaveForm::InterpolationMethod.)
+#define STREAMED_AUDIO_FRAMES_BEHIND		1
+#define STREAMED_AUDIO_FRAMES_AHEAD			2
+
+StreamedAudioModule::StreamedAudioModule()
+{
+	this->numPreloadedFrames = 0;
+	this->framesPerSecond = 0.0;
+	this->localTimeSeconds = 0.0;
+	this->totalTimeSeconds = 0.0;
+	this->loopEnabled = false;
+}
+
+/*virtual*/ StreamedAudioModule::~StreamedAudioModule()
+{
+	if (this->stream)
+		this->stream->Close();
+}
+
+bool StreamedAudioModule::UseStreamedAudioData(const WaveTableData::AudioSampleData* audioSampleData, SampleStreamer* sampleStreamer, double playbackRate)
+{
+	this->preloadedWaveForm = audioSampleData->GetPreloadedWaveForm();
+	if (!this->preloadedWaveForm.get())
+	{
+		ErrorSystem::Get()->Add(std::format("Sample {} has no preload, so it can't be streamed.", audioSampleData->GetName().c_str()));
+		return false;
+	}
+
+	this->numPreloadedFrames = audioSampleData->GetNumPreloadedFrames();
+	this->framesPerSecond = audioSampleData->GetFormat().framesPerSecond;
+
+	// The stream overlaps the end of the preload by enough that we can make the switch without missing a beat.
+	uint64_t overlapFrames = STREAMED_AUDIO_FRAMES_BEHIND + STREAMED_AUDIO_FRAMES_AHEAD + 1;
+	uint64_t firstFrame = (this->numPreloadedFrames > overlapFrames) ? (this->numPreloadedFrames - overlapFrames) : 0;
+
+	if (this->stream)
+		this->stream->Close();
+
+	this->stream = sampleStreamer->OpenStream(audioSampleData, firstFrame, playbackRate);
+	if (!this->stream)
+		return false;
+
+	this->loopEnabled = (this->stream->GetNumFrames() == std::numeric_limits<uint64_t>::max());
+	this->totalTimeSeconds = double(audioSampleData->GetNumDeferredFrames()) / this->framesPerSecond;
+	this->localTimeSeconds = 0.0;
+
+	return true;
+}
+
+/*virtual*/ bool StreamedAudioModule::GenerateSound(double durationSeconds, double samplesPerSecond, WaveForm& waveForm, SynthModule* callingModule)
+{
+	if (!this->preloadedWaveForm || !this->stream)
+	{
+		ErrorSystem::Get()->Add("No streamed sample we can use to generate audio.");
+		return false;
+	}
+
+	// This is laid out just like it is in LoopedAudioModule::GenerateSound.
+	uint64_t numSteps = uint64_t(::ceil(durationSeconds * samplesPerSecond));
+	double deltaTimeSeconds = (numSteps > 0) ? (durationSeconds / double(numSteps)) : (1.0 / samplesPerSecond);
+
+	waveForm.MakeUniform(0.0, 1.0 / deltaTimeSeconds, numSteps + 1);
+	waveForm.SetInterpolateionMethod(this->preloadedWaveForm->GetInterpolationMethod());
+	std::vector<double>& amplitudeArray = waveForm.GetAmplitudeArray();
+
+	uint64_t i = 0;
+	while (i <= numSteps)
+	{
+		// Frames are numbered in the order they're played, so time here just keeps going, even if the sample is looped.
+		uint64_t runLength = numSteps + 1 - i;
+		double runDeltaTimeSeconds = deltaTimeSeconds;
+		uint64_t frame = uint64_t(this->localTimeSeconds * this->framesPerSecond);
+
+		if (!this->loopEnabled && this->localTimeSeconds >= this->totalTimeSeconds)
+		{
+			// The sample has run out, so the local time just stays put at the end.
+			runDeltaTimeSeconds = 0.0;
+			for (uint64_t j = 0; j < runLength; j++)
+				amplitudeArray[i + j] = 0.0;
+		}
+		else if (frame + STREAMED_AUDIO_FRAMES_AHEAD < this->numPreloadedFrames)
+		{
+			// We can play from the preload up until we'd need a frame past the end of it.
+			double limitTimeSeconds = double(this->numPreloadedFrames - STREAMED_AUDIO_FRAMES_AHEAD) / this->framesPerSecond;
+			double numStepsToLimit = ::ceil((limitTimeSeconds - this->localTimeSeconds) / deltaTimeSeconds);
+			if (numStepsToLimit < double(runLength))
+				runLength = uint64_t(ADL_MAX(numStepsToLimit, 1.0));
+
+			this->preloadedWaveForm->EvaluateBlock(this->localTimeSeconds, runDeltaTimeSeconds, &amplitudeArray[i], runLength);
+		}
+		else
+		{
+			uint64_t firstFrame = 0, numFrames = 0;
+			const double* bufferedFrames = this->stream->GetBufferedFrames(firstFrame, numFrames);
+			uint64_t endFrame = firstFrame + numFrames;
+			bool reachedEnd = (endFrame >= this->stream->GetNumFrames());
+
+			if (numFrames == 0 || frame < firstFrame || (!reachedEnd && frame + STREAMED_AUDIO_FRAMES_AHEAD >= endFrame))
+			{
+				// The streamer didn't make it in time.  Rather than wait, we go without for the rest of this block.
+				this->stream->ReportUnderrun(runLength);
+				for (uint64_t j = 0; j < runLength; j++)
+					amplitudeArray[i + j] = 0.0;
+			}
+			else
+			{
+				// We can play from the stream up until we'd need a frame it doesn't have yet.
+				double numStepsToLimit = 0.0;
+				if (reachedEnd)
+					numStepsToLimit = ::floor((this->totalTimeSeconds - this->localTimeSeconds) / deltaTimeSeconds) + 1.0;
+				else
+				{
+					double limitTimeSeconds = double(endFrame - STREAMED_AUDIO_FRAMES_AHEAD) / this->framesPerSecond;
+					numStepsToLimit = ::ceil((limitTimeSeconds - this->localTimeSeconds) / deltaTimeSeconds);
+				}
+
+				if (numStepsToLimit < double(runLength))
+					runLength = uint64_t(ADL_MAX(numStepsToLimit, 1.0));
+
+				WaveFormView view(bufferedFrames, numFrames, double(firstFrame) / this->framesPerSecond, this->framesPerSecond, this->preloadedWaveForm->GetInterpolationMethod());
+				view.EvaluateBlock(this->localTimeSeconds, runDeltaTimeSeconds, &amplitudeArray[i], runLength);
+			}
+		}
+
+		i += runLength;
+
+		// Note that we leave the local time at the last sample we generated, because the next call picks up from there.
+		if (i > numSteps)
+		{
+			this->localTimeSeconds += double(runLength - 1) * runDeltaTimeSeconds;
+			break;
+		}
+
+		this->localTimeSeconds += double(runLength) * runDeltaTimeSeconds;
+
+		if (!this->loopEnabled && this->localTimeSeconds > this->totalTimeSeconds)
+			this->localTimeSeconds = this->totalTimeSeconds;
+	}
+
+	// Let the streamer have back the room taken up by everything we won't need again.
+	uint64_t frame = uint64_t(this->localTimeSeconds * this->framesPerSecond);
+	if (frame > STREAMED_AUDIO_FRAMES_BEHIND)
+		this->stream->ReleaseFrames(frame - STREAMED_AUDIO_FRAMES_BEHIND);
+
+	return true;
+}
+
+/*virtual*/ bool StreamedAudioModule::MoreSoundAvailable()
+{
+	if (this->loopEnabled)
+		return true;
+
+	return this->localTimeSeconds < this->totalTimeSeconds;
+}
\ No newline at end of file
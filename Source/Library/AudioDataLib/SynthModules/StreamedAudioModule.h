@@ -0,0 +1,45 @@
+#pragma once
+
+#include "AudioDataLib/SynthModules/SynthModule.h"
+#include "AudioDataLib/FileDatas/WaveTableData.h"
+#include "AudioDataLib/SampleStreamer.h"
+#include "AudioDataLib/WaveForm.h"
+
+namespace AudioDataLib
+{
+	/**
+	 * @brief This plays a wave-table sample that's streamed in from its file, rather than held in memory.
+	 *
+	 * It sounds just like the LoopedAudioModule class would with the same sample.  The start of the sample comes
+	 * from its preload (see WaveTableData::AudioSampleData::SetPreload), and the rest comes from a stream given to
+	 * us by a SampleStreamer, which has the length of the preload to get going.  We never wait on the stream.  If we
+	 * get to audio it doesn't have yet, we play silence in its place, and carry on from wherever we'd be by now.
+	 */
+	class AUDIO_DATA_LIB_API StreamedAudioModule : public SynthModule
+	{
+	public:
+		StreamedAudioModule();
+		virtual ~StreamedAudioModule();
+
+		virtual bool GenerateSound(double durationSeconds, double samplesPerSecond, WaveForm& waveForm, SynthModule* callingModule) override;
+		virtual bool MoreSoundAvailable() override;
+
+		/**
+		 * Get set up to play the given sample, which should be streamed (see WaveTableData::AudioSampleData::IsStreamed.)
+		 *
+		 * @param[in] audioSampleData This is the sample to play.
+		 * @param[in] sampleStreamer This is who will read the sample in for us.
+		 * @param[in] playbackRate This is how much faster than its own rate the sample is being played (e.g., once pitch-shifted.)
+		 */
+		bool UseStreamedAudioData(const WaveTableData::AudioSampleData* audioSampleData, SampleStreamer* sampleStreamer, double playbackRate);
+
+	private:
+		std::shared_ptr<WaveForm> preloadedWaveForm;
+		std::shared_ptr<SampleStreamer::Stream> stream;
+		uint64_t numPreloadedFrames;
+		double framesPerSecond;
+		double localTimeSeconds;
+		double totalTimeSeconds;
+		bool loopEnabled;
+	};
+}
\ No newline at end of file
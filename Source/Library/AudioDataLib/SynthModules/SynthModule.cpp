@@ -1,4 +1,5 @@
 #include "AudioDataLib/SynthModules/SynthModule.h"
+#include "AudioDataLib/WaveForm.h"
 
 using namespace AudioDataLib;
 
@@ -10,6 +11,17 @@ SynthModule::SynthModule()
 {
 }
 
+/*virtual*/ bool SynthModule::GenerateSoundView(double durationSeconds, double samplesPerSecond, WaveForm& scratchWaveForm, WaveFormView& waveFormView, SynthModule* callingModule)
+{
+	if (!this->GenerateSound(durationSeconds, samplesPerSecond, scratchWaveForm, callingModule))
+		return false;
+
+	// Views only work with uniform sound, which is what almost every module makes anyway.
+	scratchWaveForm.ConvertToUniform(samplesPerSecond);
+	waveFormView = scratchWaveForm.GetView();
+	return true;
+}
+
 /*virtual*/ bool SynthModule::MoreSoundAvailable()
 {
 	// Some modules are "fire and forget".  So this method can be
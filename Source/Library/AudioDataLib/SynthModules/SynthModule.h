@@ -5,6 +5,7 @@
 namespace AudioDataLib
 {
 	class WaveForm;
+	class WaveFormView;
 	class Error;
 
 	// These are the building-blocks of sound synthesis.
@@ -19,6 +20,13 @@ namespace AudioDataLib
 		// of continuity, call to call.  In most cases, the callingModule parameter is not used.  If it is used,
 		// then its usage is defined by the module implimentation.
 		virtual bool GenerateSound(double durationSeconds, double samplesPerSecond, WaveForm& waveForm, SynthModule* callingModule) = 0;
+
+		// This is like GenerateSound, except that the caller only gets to look at the result.  The given view is
+		// pointed at the sound, which may live in the given scratch wave-form or somewhere else entirely, e.g., in a
+		// buffer that several callers share, so that nothing has to be copied.  Either way, the view is only good
+		// until the scratch wave-form is touched or this module is asked for sound again.  The default implementation
+		// just generates into the scratch wave-form.
+		virtual bool GenerateSoundView(double durationSeconds, double samplesPerSecond, WaveForm& scratchWaveForm, WaveFormView& waveFormView, SynthModule* callingModule);
 		virtual bool MoreSoundAvailable();
 
 		void AddDependentModule(std::shared_ptr<SynthModule> synthModule);
@@ -0,0 +1,107 @@
+#include "AudioDataLib/ThreadPool.h"
+
+using namespace AudioDataLib;
+
+ThreadPool::ThreadPool(uint32_t numThreads)
+{
+	this->mutex = new std::mutex();
+	this->workCondition = new std::condition_variable();
+	this->doneCondition = new std::condition_variable();
+	this->batchNumber = 0;
+	this->numThreadsFinished = 0;
+	this->quit = false;
+	this->taskFunction = nullptr;
+	this->context = nullptr;
+	this->numTasks = 0;
+	this->nextTaskIndex = 0;
+
+	for (uint32_t i = 0; i < numThreads; i++)
+		this->threadArray.push_back(new std::thread([this]() { this->WorkerThreadMain(); }));
+}
+
+/*virtual*/ ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(*this->mutex);
+		this->quit = true;
+	}
+
+	this->workCondition->notify_all();
+
+	for (std::thread* thread : this->threadArray)
+	{
+		thread->join();
+		delete thread;
+	}
+
+	delete this->mutex;
+	delete this->workCondition;
+	delete this->doneCondition;
+}
+
+void ThreadPool::Run(uint32_t numTasks, TaskFunction taskFunction, void* context)
+{
+	if (this->threadArray.size() == 0 || numTasks <= 1)
+	{
+		for (uint32_t i = 0; i < numTasks; i++)
+			taskFunction(context, i);
+
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(*this->mutex);
+		this->taskFunction = taskFunction;
+		this->context = context;
+		this->numTasks = numTasks;
+		this->nextTaskIndex = 0;
+		this->numThreadsFinished = 0;
+		this->batchNumber++;
+	}
+
+	this->workCondition->notify_all();
+
+	this->RunTasks();
+
+	// Every worker thread checks in for every batch, even if there was nothing left for it to do.
+	// That way, none of them can still be looking at this batch once the next one is set up.
+	std::unique_lock<std::mutex> lock(*this->mutex);
+	this->doneCondition->wait(lock, [this]() { return this->numThreadsFinished == uint32_t(this->threadArray.size()); });
+}
+
+void ThreadPool::RunTasks()
+{
+	while (true)
+	{
+		uint32_t taskIndex = this->nextTaskIndex.fetch_add(1);
+		if (taskIndex >= this->numTasks)
+			break;
+
+		this->taskFunction(this->context, taskIndex);
+	}
+}
+
+void ThreadPool::WorkerThreadMain()
+{
+	uint64_t lastBatchNumber = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(*this->mutex);
+			this->workCondition->wait(lock, [this, lastBatchNumber]() { return this->quit || this->batchNumber != lastBatchNumber; });
+			if (this->quit)
+				return;
+
+			lastBatchNumber = this->batchNumber;
+		}
+
+		this->RunTasks();
+
+		{
+			std::lock_guard<std::mutex> lock(*this->mutex);
+			if (++this->numThreadsFinished == uint32_t(this->threadArray.size()))
+				this->doneCondition->notify_one();
+		}
+	}
+}
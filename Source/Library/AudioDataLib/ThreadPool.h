@@ -0,0 +1,62 @@
+#pragma once
+
+#include "AudioDataLib/Common.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace AudioDataLib
+{
+	/**
+	 * @brief This is a handful of worker threads that can be put to work on a batch of independent tasks.
+	 *
+	 * The threads are made once, up front, and then sleep until there is work for them to do.
+	 * A batch is given to Run, which hands out the tasks to whichever threads (the calling thread included)
+	 * come asking for them, and then returns once every task is done.  Nothing is allocated per batch, so
+	 * this is fine to use for every mix on an audio thread.
+	 */
+	class AUDIO_DATA_LIB_API ThreadPool
+	{
+	public:
+		/**
+		 * This is what gets called for each task in a batch.  The context is whatever was given to Run.
+		 */
+		typedef void (*TaskFunction)(void* context, uint32_t taskIndex);
+
+		/**
+		 * @param[in] numThreads This is how many worker threads to make.  The thread calling Run also works, so this can be zero.
+		 */
+		ThreadPool(uint32_t numThreads);
+		virtual ~ThreadPool();
+
+		/**
+		 * Call the given function once for every task index in [0, numTasks), spread across our threads
+		 * and the calling thread, and return when they've all been called.  The tasks may run in any order.
+		 */
+		void Run(uint32_t numTasks, TaskFunction taskFunction, void* context);
+
+		/**
+		 * Return the number of worker threads we have, not counting whoever calls Run.
+		 */
+		uint32_t GetNumThreads() const { return uint32_t(this->threadArray.size()); }
+
+	private:
+
+		void WorkerThreadMain();
+		void RunTasks();
+
+		std::vector<std::thread*> threadArray;
+		std::mutex* mutex;
+		std::condition_variable* workCondition;		///< This is signaled when a batch starts, or when it's time to quit.
+		std::condition_variable* doneCondition;		///< This is signaled when the last worker thread finishes with a batch.
+		uint64_t batchNumber;
+		uint32_t numThreadsFinished;
+		bool quit;
+
+		TaskFunction taskFunction;
+		void* context;
+		uint32_t numTasks;
+		std::atomic<uint32_t> nextTaskIndex;
+	};
+}
@@ -1,14 +1,476 @@
 #include "AudioDataLib/WaveForm.h"
 #include "AudioDataLib/Math/ComplexNumber.h"
 #include "AudioDataLib/ErrorSystem.h"
+#include "AudioDataLib/PCMConverter.h"
+#include "AudioDataLib/RenderArena.h"
+#include "AudioDataLib/SIMD.h"
 
 using namespace AudioDataLib;
 
+// This is how close (as a fraction of the sample period) a time needs to be to a grid point of a uniform wave-form to count as being on it.
+#define ADL_UNIFORM_GRID_TOLERANCE		1e-4
+
+//---------------------------------- Interpolation Kernels ----------------------------------
+
+// For the cubic methods, we evaluate between samples p[i] and p[i+1] using p[i-1] through p[i+2].
+// Row j of each of these tables gives the weight of sample p[i-1+j] as a cubic in the fractional
+// offset t, with the coefficients of 1, t, t^2 and t^3 in that order.  Working this out once here
+// is what spares us from fitting a polynomial (inverting a Vandermonde matrix) for every sample.
+
+static const double cubicLagrangeWeights[4][4] =
+{
+	{ 0.0, -1.0 / 3.0,  0.5, -1.0 / 6.0 },
+	{ 1.0, -0.5,       -1.0,  0.5 },
+	{ 0.0,  1.0,        0.5, -0.5 },
+	{ 0.0, -1.0 / 6.0,  0.0,  1.0 / 6.0 }
+};
+
+static const double cubicHermiteWeights[4][4] =
+{
+	{ 0.0, -0.5,  1.0, -0.5 },
+	{ 1.0,  0.0, -2.5,  1.5 },
+	{ 0.0,  0.5,  2.0, -1.5 },
+	{ 0.0,  0.0, -0.5,  0.5 }
+};
+
+static inline double CubicWeight(const double* weights, double t)
+{
+	return ((weights[3] * t + weights[2]) * t + weights[1]) * t + weights[0];
+}
+
+// Evaluate a uniform wave-form at the given (fractional) sample index.  This is the reference
+// behavior that the block kernels must match.  We're zero outside the time-span.  Where the cubic
+// methods would reach past either end, we extrapolate a sample that makes them degrade the same
+// way the irregular case does: to a quadratic for Lagrange, or a one-sided tangent for Hermite.
+static double EvaluateUniformAt(const double* amplitudes, uint64_t numSamples, double x, WaveForm::InterpolationMethod interpMethod)
+{
+	if (numSamples == 0)
+		return 0.0;
+
+	if (x < -ADL_UNIFORM_GRID_TOLERANCE || x > double(numSamples - 1) + ADL_UNIFORM_GRID_TOLERANCE)
+		return 0.0;
+
+	if (x <= 0.0)
+		return amplitudes[0];
+
+	uint64_t i = uint64_t(x);
+	if (i >= numSamples - 1)
+		return amplitudes[numSamples - 1];
+
+	double t = x - double(i);
+
+	if (interpMethod == WaveForm::InterpolationMethod::LINEAR)
+		return amplitudes[i] + t * (amplitudes[i + 1] - amplitudes[i]);
+
+	const double (*weights)[4] = (interpMethod == WaveForm::InterpolationMethod::HERMITE) ? cubicHermiteWeights : cubicLagrangeWeights;
+
+	double previous = 0.0;
+	if (i > 0)
+		previous = amplitudes[i - 1];
+	else if (interpMethod == WaveForm::InterpolationMethod::CUBIC && numSamples >= 3)
+		previous = 3.0 * amplitudes[0] - 3.0 * amplitudes[1] + amplitudes[2];
+	else
+		previous = 2.0 * amplitudes[0] - amplitudes[1];
+
+	double next = 0.0;
+	if (i + 2 < numSamples)
+		next = amplitudes[i + 2];
+	else if (interpMethod == WaveForm::InterpolationMethod::CUBIC && numSamples >= 3)
+		next = 3.0 * amplitudes[i + 1] - 3.0 * amplitudes[i] + amplitudes[i - 1];
+	else
+		next = 2.0 * amplitudes[i + 1] - amplitudes[i];
+
+	double amplitude = CubicWeight(weights[0], t) * previous;
+	amplitude += CubicWeight(weights[1], t) * amplitudes[i];
+	amplitude += CubicWeight(weights[2], t) * amplitudes[i + 1];
+	amplitude += CubicWeight(weights[3], t) * next;
+	return amplitude;
+}
+
+// These evaluate the outputs in [kBegin, kEnd), where the caller guarantees that every fractional index
+// x = x0 + k * dx lands in the interior of the wave-form, so that all the samples we touch are real and
+// there's no clamping or extrapolating to do.  For the cubic methods, that means 1 <= x < numSamples - 2.
+
+static void EvaluateUniformLinearInterior(const double* amplitudes, double x0, double dx, uint64_t kBegin, uint64_t kEnd, double* amplitudeBuffer)
+{
+	for (uint64_t k = kBegin; k < kEnd; k++)
+	{
+		double x = x0 + double(k) * dx;
+		uint64_t i = uint64_t(x);
+		double t = x - double(i);
+		amplitudeBuffer[k] = amplitudes[i] + t * (amplitudes[i + 1] - amplitudes[i]);
+	}
+}
+
+static void EvaluateUniformCubicInterior(const double* amplitudes, double x0, double dx, uint64_t kBegin, uint64_t kEnd, const double (*weights)[4], double* amplitudeBuffer)
+{
+	for (uint64_t k = kBegin; k < kEnd; k++)
+	{
+		double x = x0 + double(k) * dx;
+		uint64_t i = uint64_t(x);
+		double t = x - double(i);
+
+		double amplitude = CubicWeight(weights[0], t) * amplitudes[i - 1];
+		amplitude += CubicWeight(weights[1], t) * amplitudes[i];
+		amplitude += CubicWeight(weights[2], t) * amplitudes[i + 1];
+		amplitude += CubicWeight(weights[3], t) * amplitudes[i + 2];
+		amplitudeBuffer[k] = amplitude;
+	}
+}
+
+#if defined ADL_SIMD_X86
+
+// This does 4 outputs at a time, gathering the 4 samples around each one.  The weights are worked out
+// for all 4 outputs at once too.  Any outputs left over at the end are done by the scalar kernel.
+ADL_AVX2_FUNC static void EvaluateUniformCubicInteriorAVX2(const double* amplitudes, double x0, double dx, uint64_t kBegin, uint64_t kEnd, const double (*weights)[4], double* amplitudeBuffer)
+{
+	__m256d weightArray[4][4];
+	for (int j = 0; j < 4; j++)
+		for (int n = 0; n < 4; n++)
+			weightArray[j][n] = _mm256_set1_pd(weights[j][n]);
+
+	__m256d originX = _mm256_set1_pd(x0);
+	__m256d deltaX = _mm256_set1_pd(dx);
+	__m256d indexOffsets = _mm256_set_pd(double(kBegin + 3), double(kBegin + 2), double(kBegin + 1), double(kBegin));
+	__m256d four = _mm256_set1_pd(4.0);
+
+	uint64_t k = kBegin;
+	for (; k + 4 <= kEnd; k += 4)
+	{
+		__m256d x = _mm256_add_pd(originX, _mm256_mul_pd(indexOffsets, deltaX));
+		__m256d floorX = _mm256_floor_pd(x);
+		__m256d t = _mm256_sub_pd(x, floorX);
+		__m256i i = _mm256_cvtepi32_epi64(_mm256_cvttpd_epi32(floorX));
+
+		__m256d amplitude = _mm256_setzero_pd();
+		for (int j = 0; j < 4; j++)
+		{
+			__m256d weight = _mm256_add_pd(_mm256_mul_pd(weightArray[j][3], t), weightArray[j][2]);
+			weight = _mm256_add_pd(_mm256_mul_pd(weight, t), weightArray[j][1]);
+			weight = _mm256_add_pd(_mm256_mul_pd(weight, t), weightArray[j][0]);
+
+			__m256d sample = _mm256_i64gather_pd(amplitudes + j - 1, i, sizeof(double));
+			amplitude = (j == 0) ? _mm256_mul_pd(weight, sample) : _mm256_add_pd(amplitude, _mm256_mul_pd(weight, sample));
+		}
+
+		_mm256_storeu_pd(&amplitudeBuffer[k], amplitude);
+		indexOffsets = _mm256_add_pd(indexOffsets, four);
+	}
+
+	EvaluateUniformCubicInterior(amplitudes, x0, dx, k, kEnd, weights, amplitudeBuffer);
+}
+
+#endif //ADL_SIMD_X86
+
+// Evaluate a uniform wave-form at the fractional sample indices x0 + k * dx for k in [0, numAmplitudes).
+static void EvaluateUniformBlock(const double* amplitudes, uint64_t numSamples, double x0, double dx, WaveForm::InterpolationMethod interpMethod, double* amplitudeBuffer, uint64_t numAmplitudes)
+{
+	// Find the run of outputs that fall in the interior of the wave-form, where the kernels need no edge handling.
+	// Everything outside of that run (typically just a few outputs at either end) is handled one at a time.
+	bool linear = (interpMethod == WaveForm::InterpolationMethod::LINEAR);
+	double minX = linear ? 0.0 : 1.0;
+	double maxX = linear ? double(numSamples) - 1.0 : double(numSamples) - 2.0;
+	uint64_t kBegin = 0, kEnd = 0;
+	if (maxX > minX && numSamples < uint64_t(std::numeric_limits<int32_t>::max()))
+	{
+		auto isInterior = [=](uint64_t k) -> bool { double x = x0 + double(k) * dx; return minX <= x && x < maxX; };
+
+		if (dx == 0.0)
+			kEnd = isInterior(0) ? numAmplitudes : 0;
+		else
+		{
+			// Estimate the run, and then nudge its ends so that they agree exactly with the per-output test.
+			double firstK = ((dx > 0.0) ? (minX - x0) : (maxX - x0)) / dx;
+			double lastK = ((dx > 0.0) ? (maxX - x0) : (minX - x0)) / dx;
+			kBegin = uint64_t(ADL_CLAMP(::ceil(firstK), 0.0, double(numAmplitudes)));
+			kEnd = uint64_t(ADL_CLAMP(::ceil(lastK), 0.0, double(numAmplitudes)));
+			while (kBegin > 0 && isInterior(kBegin - 1))
+				kBegin--;
+			while (kBegin < kEnd && !isInterior(kBegin))
+				kBegin++;
+			while (kEnd < numAmplitudes && kEnd > kBegin && isInterior(kEnd))
+				kEnd++;
+			while (kEnd > kBegin && !isInterior(kEnd - 1))
+				kEnd--;
+		}
+
+		if (kEnd < kBegin)
+			kEnd = kBegin;
+	}
+
+	for (uint64_t k = 0; k < kBegin; k++)
+		amplitudeBuffer[k] = EvaluateUniformAt(amplitudes, numSamples, x0 + double(k) * dx, interpMethod);
+
+	if (linear)
+		EvaluateUniformLinearInterior(amplitudes, x0, dx, kBegin, kEnd, amplitudeBuffer);
+	else
+	{
+		const double (*weights)[4] = (interpMethod == WaveForm::InterpolationMethod::HERMITE) ? cubicHermiteWeights : cubicLagrangeWeights;
+#if defined ADL_SIMD_X86
+		if (PCMConverter::GetInstructionSet() == PCMConverter::InstructionSet::AVX2)
+			EvaluateUniformCubicInteriorAVX2(amplitudes, x0, dx, kBegin, kEnd, weights, amplitudeBuffer);
+		else
+#endif //ADL_SIMD_X86
+			EvaluateUniformCubicInterior(amplitudes, x0, dx, kBegin, kEnd, weights, amplitudeBuffer);
+	}
+
+	for (uint64_t k = kEnd; k < numAmplitudes; k++)
+		amplitudeBuffer[k] = EvaluateUniformAt(amplitudes, numSamples, x0 + double(k) * dx, interpMethod);
+}
+
+// Find the range [i, j] of grid points of a uniform wave-form that fall in the given time range.
+// If none do, then i > j.  This is shared by the trimming routines of WaveForm and WaveFormView.
+static void CalcUniformTrimRange(double gridStartTimeSeconds, double samplesPerSecond, uint64_t numSamples, double startTimeSeconds, double stopTimeSeconds, int64_t& i, int64_t& j)
+{
+	// Clamp before converting to integers so that huge (or infinite) times are safe to give.
+	double firstX = ::ceil((startTimeSeconds - gridStartTimeSeconds) * samplesPerSecond - ADL_UNIFORM_GRID_TOLERANCE);
+	double lastX = ::floor((stopTimeSeconds - gridStartTimeSeconds) * samplesPerSecond + ADL_UNIFORM_GRID_TOLERANCE);
+	i = int64_t(ADL_CLAMP(firstX, 0.0, double(numSamples)));
+	j = int64_t(ADL_CLAMP(lastX, -1.0, double(numSamples) - 1.0));
+}
+
+//---------------------------------- Accumulation Kernels ----------------------------------
+
+// These all do destination[i] += scale * source[i] for i in [0, count).  Mixing is mostly just this.
+
+static void AccumulateScalar(double* destination, const double* source, double scale, uint64_t count)
+{
+	for (uint64_t i = 0; i < count; i++)
+		destination[i] += scale * source[i];
+}
+
+#if defined ADL_SIMD_X86
+
+static void AccumulateSSE2(double* destination, const double* source, double scale, uint64_t count)
+{
+	__m128d scaleVec = _mm_set1_pd(scale);
+
+	uint64_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128d sumA = _mm_add_pd(_mm_loadu_pd(&destination[i]), _mm_mul_pd(scaleVec, _mm_loadu_pd(&source[i])));
+		__m128d sumB = _mm_add_pd(_mm_loadu_pd(&destination[i + 2]), _mm_mul_pd(scaleVec, _mm_loadu_pd(&source[i + 2])));
+		_mm_storeu_pd(&destination[i], sumA);
+		_mm_storeu_pd(&destination[i + 2], sumB);
+	}
+
+	AccumulateScalar(&destination[i], &source[i], scale, count - i);
+}
+
+ADL_AVX2_FUNC static void AccumulateAVX2(double* destination, const double* source, double scale, uint64_t count)
+{
+	__m256d scaleVec = _mm256_set1_pd(scale);
+
+	uint64_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256d sumA = _mm256_add_pd(_mm256_loadu_pd(&destination[i]), _mm256_mul_pd(scaleVec, _mm256_loadu_pd(&source[i])));
+		__m256d sumB = _mm256_add_pd(_mm256_loadu_pd(&destination[i + 4]), _mm256_mul_pd(scaleVec, _mm256_loadu_pd(&source[i + 4])));
+		_mm256_storeu_pd(&destination[i], sumA);
+		_mm256_storeu_pd(&destination[i + 4], sumB);
+	}
+
+	AccumulateScalar(&destination[i], &source[i], scale, count - i);
+}
+
+#endif //ADL_SIMD_X86
+
+static void Accumulate(double* destination, const double* source, double scale, uint64_t count)
+{
+#if defined ADL_SIMD_X86
+	switch (PCMConverter::GetInstructionSet())
+	{
+		case PCMConverter::InstructionSet::AVX2:
+			AccumulateAVX2(destination, source, scale, count);
+			return;
+		case PCMConverter::InstructionSet::SSE2:
+			AccumulateSSE2(destination, source, scale, count);
+			return;
+		default:
+			break;
+	}
+#endif //ADL_SIMD_X86
+
+	AccumulateScalar(destination, source, scale, count);
+}
+
+//---------------------------------- Statistics Kernels ----------------------------------
+
+struct StatisticsSums
+{
+	double minAmplitude = std::numeric_limits<double>::max();
+	double maxAmplitude = -std::numeric_limits<double>::max();
+	double sumOfSquares = 0.0;
+	double sumOfPeaks = 0.0;
+	uint64_t numPeaks = 0;
+};
+
+// Fold amplitude i into the sums, and if it's a peak or valley, count it.  Time always moves forward by the same
+// amount in a uniform wave-form, so the sign of each slope is just the sign of the change in amplitude.
+static inline void GatherUniformStatistic(const double* amplitudes, uint64_t numSamples, uint64_t i, StatisticsSums& sums)
+{
+	double amplitude = amplitudes[i];
+	sums.minAmplitude = ADL_MIN(sums.minAmplitude, amplitude);
+	sums.maxAmplitude = ADL_MAX(sums.maxAmplitude, amplitude);
+	sums.sumOfSquares += amplitude * amplitude;
+
+	if (0 < i && i + 1 < numSamples)
+	{
+		bool fallingA = (amplitude - amplitudes[i - 1]) < 0.0;
+		bool fallingB = (amplitudes[i + 1] - amplitude) < 0.0;
+		if (fallingA != fallingB)
+		{
+			sums.sumOfPeaks += ::fabs(amplitude);
+			sums.numPeaks++;
+		}
+	}
+}
+
+// These all do the interior samples [1, numSamples - 1) in bulk, and leave the rest to GatherUniformStatistic.
+// They return the index of the first sample they didn't get to.
+
+static uint64_t GatherUniformStatisticsScalar(const double* amplitudes, uint64_t numSamples, StatisticsSums& sums)
+{
+	uint64_t i = 1;
+	for (; i + 1 < numSamples; i++)
+		GatherUniformStatistic(amplitudes, numSamples, i, sums);
+	return i;
+}
+
+#if defined ADL_SIMD_X86
+
+static uint64_t GatherUniformStatisticsSSE2(const double* amplitudes, uint64_t numSamples, StatisticsSums& sums)
+{
+	__m128d minAmplitude = _mm_set1_pd(sums.minAmplitude);
+	__m128d maxAmplitude = _mm_set1_pd(sums.maxAmplitude);
+	__m128d sumOfSquares = _mm_setzero_pd();
+	__m128d sumOfPeaks = _mm_setzero_pd();
+	__m128d numPeaks = _mm_setzero_pd();
+	__m128d zero = _mm_setzero_pd();
+	__m128d one = _mm_set1_pd(1.0);
+	__m128d signBit = _mm_set1_pd(-0.0);
+
+	uint64_t i = 1;
+	for (; i + 2 < numSamples; i += 2)
+	{
+		__m128d previous = _mm_loadu_pd(&amplitudes[i - 1]);
+		__m128d current = _mm_loadu_pd(&amplitudes[i]);
+		__m128d next = _mm_loadu_pd(&amplitudes[i + 1]);
+
+		minAmplitude = _mm_min_pd(minAmplitude, current);
+		maxAmplitude = _mm_max_pd(maxAmplitude, current);
+		sumOfSquares = _mm_add_pd(sumOfSquares, _mm_mul_pd(current, current));
+
+		__m128d fallingA = _mm_cmplt_pd(_mm_sub_pd(current, previous), zero);
+		__m128d fallingB = _mm_cmplt_pd(_mm_sub_pd(next, current), zero);
+		__m128d turning = _mm_xor_pd(fallingA, fallingB);
+		sumOfPeaks = _mm_add_pd(sumOfPeaks, _mm_and_pd(turning, _mm_andnot_pd(signBit, current)));
+		numPeaks = _mm_add_pd(numPeaks, _mm_and_pd(turning, one));
+	}
+
+	double lanes[5][2];
+	_mm_storeu_pd(lanes[0], minAmplitude);
+	_mm_storeu_pd(lanes[1], maxAmplitude);
+	_mm_storeu_pd(lanes[2], sumOfSquares);
+	_mm_storeu_pd(lanes[3], sumOfPeaks);
+	_mm_storeu_pd(lanes[4], numPeaks);
+	sums.minAmplitude = ADL_MIN(lanes[0][0], lanes[0][1]);
+	sums.maxAmplitude = ADL_MAX(lanes[1][0], lanes[1][1]);
+	sums.sumOfSquares += lanes[2][0] + lanes[2][1];
+	sums.sumOfPeaks += lanes[3][0] + lanes[3][1];
+	sums.numPeaks += uint64_t(lanes[4][0] + lanes[4][1]);
+
+	return i;
+}
+
+ADL_AVX2_FUNC static uint64_t GatherUniformStatisticsAVX2(const double* amplitudes, uint64_t numSamples, StatisticsSums& sums)
+{
+	__m256d minAmplitude = _mm256_set1_pd(sums.minAmplitude);
+	__m256d maxAmplitude = _mm256_set1_pd(sums.maxAmplitude);
+	__m256d sumOfSquares = _mm256_setzero_pd();
+	__m256d sumOfPeaks = _mm256_setzero_pd();
+	__m256d numPeaks = _mm256_setzero_pd();
+	__m256d zero = _mm256_setzero_pd();
+	__m256d one = _mm256_set1_pd(1.0);
+	__m256d signBit = _mm256_set1_pd(-0.0);
+
+	uint64_t i = 1;
+	for (; i + 4 < numSamples; i += 4)
+	{
+		__m256d previous = _mm256_loadu_pd(&amplitudes[i - 1]);
+		__m256d current = _mm256_loadu_pd(&amplitudes[i]);
+		__m256d next = _mm256_loadu_pd(&amplitudes[i + 1]);
+
+		minAmplitude = _mm256_min_pd(minAmplitude, current);
+		maxAmplitude = _mm256_max_pd(maxAmplitude, current);
+		sumOfSquares = _mm256_add_pd(sumOfSquares, _mm256_mul_pd(current, current));
+
+		__m256d fallingA = _mm256_cmp_pd(_mm256_sub_pd(current, previous), zero, _CMP_LT_OQ);
+		__m256d fallingB = _mm256_cmp_pd(_mm256_sub_pd(next, current), zero, _CMP_LT_OQ);
+		__m256d turning = _mm256_xor_pd(fallingA, fallingB);
+		sumOfPeaks = _mm256_add_pd(sumOfPeaks, _mm256_and_pd(turning, _mm256_andnot_pd(signBit, current)));
+		numPeaks = _mm256_add_pd(numPeaks, _mm256_and_pd(turning, one));
+	}
+
+	double lanes[5][4];
+	_mm256_storeu_pd(lanes[0], minAmplitude);
+	_mm256_storeu_pd(lanes[1], maxAmplitude);
+	_mm256_storeu_pd(lanes[2], sumOfSquares);
+	_mm256_storeu_pd(lanes[3], sumOfPeaks);
+	_mm256_storeu_pd(lanes[4], numPeaks);
+	for (int j = 0; j < 4; j++)
+	{
+		sums.minAmplitude = ADL_MIN(sums.minAmplitude, lanes[0][j]);
+		sums.maxAmplitude = ADL_MAX(sums.maxAmplitude, lanes[1][j]);
+		sums.sumOfSquares += lanes[2][j];
+		sums.sumOfPeaks += lanes[3][j];
+		sums.numPeaks += uint64_t(lanes[4][j]);
+	}
+
+	return i;
+}
+
+#endif //ADL_SIMD_X86
+
+static void GatherUniformStatistics(const double* amplitudes, uint64_t numSamples, StatisticsSums& sums)
+{
+	if (numSamples == 0)
+		return;
+
+	uint64_t i = 1;
+#if defined ADL_SIMD_X86
+	switch (PCMConverter::GetInstructionSet())
+	{
+		case PCMConverter::InstructionSet::AVX2:
+			i = GatherUniformStatisticsAVX2(amplitudes, numSamples, sums);
+			break;
+		case PCMConverter::InstructionSet::SSE2:
+			i = GatherUniformStatisticsSSE2(amplitudes, numSamples, sums);
+			break;
+		default:
+			i = GatherUniformStatisticsScalar(amplitudes, numSamples, sums);
+			break;
+	}
+#else
+	i = GatherUniformStatisticsScalar(amplitudes, numSamples, sums);
+#endif //ADL_SIMD_X86
+
+	// Pick up whatever the bulk kernel left over, as well as the two end samples.
+	for (; i < numSamples; i++)
+		GatherUniformStatistic(amplitudes, numSamples, i, sums);
+
+	GatherUniformStatistic(amplitudes, numSamples, 0, sums);
+}
+
 //---------------------------------- WaveForm ----------------------------------
 
 WaveForm::WaveForm()
 {
 	this->interpMethod = InterpolationMethod::LINEAR;
+	this->uniform = false;
+	this->startTimeSeconds = 0.0;
+	this->samplesPerSecond = 0.0;
+	this->statisticsValid = false;
 }
 
 /*virtual*/ WaveForm::~WaveForm()
@@ -17,31 +479,200 @@ WaveForm::WaveForm()
 
 void WaveForm::Clear()
 {
+	this->statisticsValid = false;
+
 	this->sampleArray.clear();
+	this->amplitudeArray.clear();
+	this->uniform = false;
+	this->startTimeSeconds = 0.0;
+	this->samplesPerSecond = 0.0;
 }
 
 void WaveForm::AddSample(const Sample& sample)
 {
+	this->statisticsValid = false;
+
+	if (this->uniform)
+	{
+		if (this->amplitudeArray.size() == 0)
+		{
+			this->startTimeSeconds = sample.timeSeconds;
+			this->amplitudeArray.push_back(sample.amplitude);
+			return;
+		}
+
+		int64_t i = 0;
+		if (this->FindUniformIndex(sample.timeSeconds, i) && i == (int64_t)this->amplitudeArray.size())
+		{
+			this->amplitudeArray.push_back(sample.amplitude);
+			return;
+		}
+
+		this->MakeIrregular();
+	}
+
 	this->sampleArray.push_back(sample);
 }
 
-void WaveForm::MakeSilence(double samplesPerSecond, double totalSeconds)
+void WaveForm::MakeUniform(double startTimeSeconds, double samplesPerSecond, uint64_t numSamples /*= 0*/)
 {
 	this->Clear();
 
+	this->uniform = true;
+	this->startTimeSeconds = startTimeSeconds;
+	this->samplesPerSecond = samplesPerSecond;
+	this->amplitudeArray.resize(numSamples, 0.0);
+}
+
+void WaveForm::MakeIrregular()
+{
+	if (!this->uniform)
+		return;
+
+	this->sampleArray.resize(this->amplitudeArray.size());
+	for (uint64_t i = 0; i < this->amplitudeArray.size(); i++)
+	{
+		Sample& sample = this->sampleArray[i];
+		sample.timeSeconds = this->GetSampleTime(i);
+		sample.amplitude = this->amplitudeArray[i];
+	}
+
+	this->amplitudeArray.clear();
+	this->amplitudeArray.shrink_to_fit();
+	this->uniform = false;
+}
+
+void WaveForm::SetUniformTiming(double startTimeSeconds, double samplesPerSecond)
+{
+	if (!this->uniform)
+		return;
+
+	this->startTimeSeconds = startTimeSeconds;
+	this->samplesPerSecond = samplesPerSecond;
+}
+
+void WaveForm::ConvertToUniform(double samplesPerSecond)
+{
+	this->statisticsValid = false;
+
+	if (this->uniform)
+		return;
+
+	uint64_t numSamples = 0;
+	double startTimeSeconds = this->GetStartTime();
+	if (this->sampleArray.size() > 0)
+		numSamples = uint64_t(::floor(this->GetTimespan() * samplesPerSecond + ADL_UNIFORM_GRID_TOLERANCE)) + 1;
+
+	std::vector<double> newAmplitudeArray(numSamples);
+	this->EvaluateBlock(startTimeSeconds, 1.0 / samplesPerSecond, newAmplitudeArray.data(), numSamples);
+
+	this->sampleArray.clear();
+	this->amplitudeArray.swap(newAmplitudeArray);
+	this->uniform = true;
+	this->startTimeSeconds = startTimeSeconds;
+	this->samplesPerSecond = samplesPerSecond;
+}
+
+WaveFormView WaveForm::GetView() const
+{
+	if (!this->uniform)
+		return WaveFormView();
+
+	return WaveFormView(this->amplitudeArray.data(), this->amplitudeArray.size(), this->startTimeSeconds, this->samplesPerSecond, this->interpMethod);
+}
+
+WaveFormView WaveForm::GetView(double startTimeSeconds, double stopTimeSeconds) const
+{
+	return this->GetView().Slice(startTimeSeconds, stopTimeSeconds);
+}
+
+void WaveForm::AddAmplitude(double amplitude)
+{
+	this->statisticsValid = false;
+
+	if (this->uniform)
+		this->amplitudeArray.push_back(amplitude);
+	else
+		this->AddSample(Sample{ this->GetSampleTime(this->sampleArray.size()), amplitude });
+}
+
+WaveForm::Sample WaveForm::GetSample(uint64_t i) const
+{
+	if (!this->uniform)
+		return this->sampleArray[i];
+
+	return Sample{ this->GetSampleTime(i), this->amplitudeArray[i] };
+}
+
+double WaveForm::GetSampleTime(uint64_t i) const
+{
+	if (this->uniform)
+		return this->startTimeSeconds + double(i) / this->samplesPerSecond;
+
+	if (i < this->sampleArray.size())
+		return this->sampleArray[i].timeSeconds;
+
+	// Extrapolate past the end at the average rate.  This only really happens when someone adds an amplitude to an irregular wave-form.
+	if (this->sampleArray.size() == 0)
+		return 0.0;
+
+	double averageSampleRate = this->AverageSampleRate();
+	if (averageSampleRate == 0.0)
+		return this->GetEndTime();
+
+	return this->GetEndTime() + double(i - this->sampleArray.size() + 1) / averageSampleRate;
+}
+
+double WaveForm::GetAmplitude(uint64_t i) const
+{
+	if (this->uniform)
+		return this->amplitudeArray[i];
+
+	return this->sampleArray[i].amplitude;
+}
+
+void WaveForm::SetAmplitude(uint64_t i, double amplitude)
+{
+	this->statisticsValid = false;
+
+	if (this->uniform)
+		this->amplitudeArray[i] = amplitude;
+	else
+		this->sampleArray[i].amplitude = amplitude;
+}
+
+bool WaveForm::FindUniformIndex(double timeSeconds, int64_t& i) const
+{
+	if (!this->uniform || this->samplesPerSecond <= 0.0)
+		return false;
+
+	double x = (timeSeconds - this->startTimeSeconds) * this->samplesPerSecond;
+	double nearestX = ::round(x);
+	if (::fabs(x - nearestX) > ADL_UNIFORM_GRID_TOLERANCE)
+		return false;
+
+	i = int64_t(nearestX);
+	return true;
+}
+
+void WaveForm::MakeSilence(double samplesPerSecond, double totalSeconds)
+{
+	this->statisticsValid = false;
+
 	uint64_t numSamples = uint64_t(samplesPerSecond * totalSeconds);
-	for (uint64_t i = 0; i < numSamples; i++)
+	if (numSamples <= 1)
 	{
-		Sample sample;
-		sample.amplitude = 0.0;
-		sample.timeSeconds = (double(i) / double(numSamples - 1)) * totalSeconds;
-		this->sampleArray.push_back(sample);
+		this->MakeUniform(0.0, samplesPerSecond, numSamples);
+		return;
 	}
+
+	// Note that we're spreading the samples so that the last one lands exactly on the given total time.
+	this->MakeUniform(0.0, double(numSamples - 1) / totalSeconds, numSamples);
 }
 
 uint64_t WaveForm::GetSizeBytes(const AudioData::Format& format, bool allChannels) const
 {
-	if (this->sampleArray.size() == 0)
+	if (this->GetNumSamples() == 0)
 		return 0;
 
 	uint64_t numBytes = format.BytesPerChannelFromSeconds(this->GetTimespan());
@@ -55,111 +686,22 @@ uint64_t WaveForm::GetSizeBytes(const AudioData::Format& format, bool allChannel
 
 bool WaveForm::ConvertFromAudioBuffer(const AudioData::Format& format, const uint8_t* audioBuffer, uint64_t audioBufferSize, uint16_t channel)
 {
+	this->statisticsValid = false;
+
 	if (channel >= format.numChannels)
 	{
 		ErrorSystem::Get()->Add(std::format("Invalid channel: {}.", channel));
 		return false;
 	}
 
-	this->Clear();
-
-	uint64_t bytesPerSample = format.BytesPerSample();
-	uint64_t samplesPerFrame = format.SamplesPerFrame();
-	uint64_t bytesPerFrame = bytesPerSample * samplesPerFrame;
-
-	uint64_t i = 0;
-	uint32_t number = 0;
-	while (i < audioBufferSize)
-	{
-		Sample sample;
-		sample.timeSeconds = format.BytesToSeconds(i);
-
-		const uint8_t* frameBuf = &audioBuffer[i];
-		const uint8_t* sampleBuf = &frameBuf[bytesPerSample * channel];
-
-		if (format.sampleType == AudioData::Format::SIGNED_INTEGER)
-		{
-			switch (format.bitsPerSample)
-			{
-				case 8:
-				{
-					sample.amplitude = this->CopyIntSampleFromBuffer<int8_t>(sampleBuf);
-					break;
-				}
-				case 16:
-				{
-					sample.amplitude = this->CopyIntSampleFromBuffer<int16_t>(sampleBuf);
-					break;
-				}
-				case 32:
-				{
-					sample.amplitude = this->CopyIntSampleFromBuffer<int32_t>(sampleBuf);
-					break;
-				}
-				default:
-				{
-					ErrorSystem::Get()->Add(std::format("Bad bit-depth ({}) for signed integers.", format.bitsPerSample));
-					break;
-				}
-			}
-		}
-		else if (format.sampleType == AudioData::Format::UNSIGNED_INTEGER)
-		{
-			switch (format.bitsPerSample)
-			{
-				case 8:
-				{
-					sample.amplitude = this->CopyUIntSampleFromBuffer<uint8_t>(sampleBuf);
-					break;
-				}
-				case 16:
-				{
-					sample.amplitude = this->CopyUIntSampleFromBuffer<uint16_t>(sampleBuf);
-					break;
-				}
-				case 32:
-				{
-					sample.amplitude = this->CopyUIntSampleFromBuffer<uint32_t>(sampleBuf);
-					break;
-				}
-				default:
-				{
-					ErrorSystem::Get()->Add(std::format("Bad bit-depth ({}) for unsigned integers.", format.bitsPerSample));
-					break;
-				}
-			}
-		}
-		else if (format.sampleType == AudioData::Format::FLOAT)
-		{
-			switch (format.bitsPerSample)
-			{
-				case 32:
-				{
-					sample.amplitude = this->CopyFloatSampleFromBuffer<float>(sampleBuf);
-					break;
-				}
-				case 64:
-				{
-					sample.amplitude = this->CopyFloatSampleFromBuffer<double>(sampleBuf);
-					break;
-				}
-				default:
-				{
-					ErrorSystem::Get()->Add(std::format("Bad bit-depth ({}) for floats.", format.bitsPerSample));
-					break;
-				}
-			}
-		}
-		else
-		{
-			ErrorSystem::Get()->Add(std::format("Unknown sample type ({}) encountered.", int(format.sampleType)));
-			return false;
-		}
-
-		this->sampleArray.push_back(sample);
-		i += bytesPerFrame;
-	}
+	PCMConverter converter;
+	if (!converter.Configure(format))
+		return false;
 
+	// Raw audio data is always uniformly sampled, so we always get the fast representation here.
+	uint64_t numFrames = audioBufferSize / format.BytesPerFrame();
+	this->MakeUniform(0.0, double(format.framesPerSecond), numFrames);
+	converter.DecodeChannel(audioBuffer, channel, this->amplitudeArray.data(), numFrames);
 	return true;
 }
 
@@ -171,100 +713,57 @@ bool WaveForm::ConvertToAudioBuffer(const AudioData::Format& format, uint8_t* au
 		return false;
 	}
 
-	uint64_t bytesPerSample = format.BytesPerSample();
-	uint64_t samplesPerFrame = format.SamplesPerFrame();
-	uint64_t bytesPerFrame = bytesPerSample * samplesPerFrame;
+	PCMConverter converter;
+	if (!converter.Configure(format))
+		return false;
 
-	uint64_t i = 0;
-	uint32_t number = 0;
-	while (i < audioBufferSize)
+	// If we're uniform on the same grid as the audio buffer, then there's no need to evaluate
+	// anything; each frame just maps to one of our amplitudes.
+	bool onSameGrid = false;
+	int64_t frameOffset = 0;
+	if (this->uniform && this->samplesPerSecond == double(format.framesPerSecond))
 	{
-		uint8_t* frameBuf = &audioBuffer[i];
-		uint8_t* sampleBuf = &frameBuf[bytesPerSample * channel];
-
-		double timeSeconds = format.BytesToSeconds(i);
-		double amplitude = this->EvaluateAt(timeSeconds);
-		
-		if (format.sampleType == AudioData::Format::SIGNED_INTEGER)
-		{
-			switch (format.bitsPerSample)
-			{
-				case 8:
-				{
-					this->CopyIntSampleToBuffer<int8_t>(sampleBuf, amplitude);
-					break;
-				}
-				case 16:
-				{
-					this->CopyIntSampleToBuffer<int16_t>(sampleBuf, amplitude);
-					break;
-				}
-				case 32:
-				{
-					this->CopyIntSampleToBuffer<int32_t>(sampleBuf, amplitude);
-					break;
-				}
-				default:
-				{
-					ErrorSystem::Get()->Add(std::format("Bad bit-depth ({}) for signed integers.", format.bitsPerSample));
-					return false;
-				}
-			}
-		}
-		else if (format.sampleType == AudioData::Format::UNSIGNED_INTEGER)
+		double x = this->startTimeSeconds * this->samplesPerSecond;
+		double nearestX = ::round(x);
+		if (::fabs(x - nearestX) <= ADL_UNIFORM_GRID_TOLERANCE)
 		{
-			switch (format.bitsPerSample)
-			{
-				case 8:
-				{
-					this->CopyUIntSampleToBuffer<uint8_t>(sampleBuf, amplitude);
-					break;
-				}
-				case 16:
-				{
-					this->CopyUIntSampleToBuffer<uint16_t>(sampleBuf, amplitude);
-					break;
-				}
-				case 32:
-				{
-					this->CopyUIntSampleToBuffer<uint32_t>(sampleBuf, amplitude);
-					break;
-				}
-				default:
-				{
-					ErrorSystem::Get()->Add(std::format("Bad bit-depth ({}) for unsigned integers.", format.bitsPerSample));
-					break;
-				}
-			}
+			onSameGrid = true;
+			frameOffset = int64_t(nearestX);
 		}
-		else if (format.sampleType == AudioData::Format::FLOAT)
+	}
+
+	// We work in blocks here so that the converter can chew through a bunch of samples at a time.
+	constexpr uint64_t blockSize = 256;
+	double amplitudeBlock[blockSize];
+
+	uint64_t bytesPerFrame = format.BytesPerFrame();
+	uint64_t numFrames = audioBufferSize / bytesPerFrame;
+	int64_t numAmplitudes = (int64_t)this->amplitudeArray.size();
+	uint64_t frame = 0;
+
+	while (frame < numFrames)
+	{
+		uint64_t count = ADL_MIN(blockSize, numFrames - frame);
+		const double* amplitudes = amplitudeBlock;
+
+		if (onSameGrid)
 		{
-			switch (format.bitsPerSample)
+			int64_t j = int64_t(frame) - frameOffset;
+			if (0 <= j && j + int64_t(count) <= numAmplitudes)
+				amplitudes = &this->amplitudeArray[j];
+			else
 			{
-				case 32:
-				{
-					this->CopyFloatSampleToBuffer<float>(sampleBuf, amplitude);
-					break;
-				}
-				case 64:
-				{
-					this->CopyFloatSampleToBuffer<double>(sampleBuf, amplitude);
-					break;
-				}
-				default:
-				{
-					ErrorSystem::Get()->Add(std::format("Bad bit-depth ({}) for floats.", format.bitsPerSample));
-					return false;
-				}
+				for (uint64_t k = 0; k < count; k++, j++)
+					amplitudeBlock[k] = (0 <= j && j < numAmplitudes) ? this->amplitudeArray[j] : 0.0;
 			}
 		}
 		else
 		{
-			ErrorSystem::Get()->Add(std::format("Unknown sample type ({}) encountered.", int(format.sampleType)));
-			return false;
+			this->EvaluateBlock(double(frame) / double(format.framesPerSecond), 1.0 / double(format.framesPerSecond), amplitudeBlock, count);
 		}
 
-		i += bytesPerFrame;
+		converter.EncodeChannel(amplitudes, &audioBuffer[frame * bytesPerFrame], channel, count);
+		frame += count;
 	}
 
 	return true;
@@ -280,6 +779,15 @@ void WaveForm::Interpolate(const SampleBounds& sampleBounds, double timeSeconds,
 		return;
 	}
 
+	// The cubic methods reach past the bounds to their neighbors.  The bounds of a uniform wave-form are just
+	// copies of two grid points, so we go back to the grid itself, where the neighbors are.
+	if (this->uniform && this->interpMethod != InterpolationMethod::LINEAR)
+	{
+		double x = (timeSeconds - this->startTimeSeconds) * this->samplesPerSecond;
+		interpolatedSample.amplitude = EvaluateUniformAt(this->amplitudeArray.data(), this->amplitudeArray.size(), x, this->interpMethod);
+		return;
+	}
+
 	switch (this->interpMethod)
 	{
 		case InterpolationMethod::LINEAR:
@@ -290,10 +798,59 @@ void WaveForm::Interpolate(const SampleBounds& sampleBounds, double timeSeconds,
 		}
 		case InterpolationMethod::CUBIC:
 		{
-			uint64_t i = sampleBounds.minSample - this->sampleArray.data();
-			uint64_t j = sampleBounds.maxSample - this->sampleArray.data();
+			// Gather up to 4 samples around the given bounds: one before, the bounds themselves, and one after.
+			// We use the Lagrange form of the polynomial through them, which avoids having to solve for its
+			// coefficients.  Near either end of the wave-form we just have fewer points and a lower degree.
+			const Sample* firstSample = this->sampleArray.data();
+			const Sample* lastSample = firstSample + this->sampleArray.size() - 1;
+
+			const Sample* nodeArray[4];
+			int numNodes = 0;
+			if (sampleBounds.minSample > firstSample && (sampleBounds.minSample - 1)->timeSeconds < sampleBounds.minSample->timeSeconds)
+				nodeArray[numNodes++] = sampleBounds.minSample - 1;
+			nodeArray[numNodes++] = sampleBounds.minSample;
+			nodeArray[numNodes++] = sampleBounds.maxSample;
+			if (sampleBounds.maxSample < lastSample && (sampleBounds.maxSample + 1)->timeSeconds > sampleBounds.maxSample->timeSeconds)
+				nodeArray[numNodes++] = sampleBounds.maxSample + 1;
+
+			interpolatedSample.amplitude = 0.0;
+			for (int a = 0; a < numNodes; a++)
+			{
+				double weight = 1.0;
+				for (int b = 0; b < numNodes; b++)
+					if (b != a)
+						weight *= (timeSeconds - nodeArray[b]->timeSeconds) / (nodeArray[a]->timeSeconds - nodeArray[b]->timeSeconds);
+
+				interpolatedSample.amplitude += weight * nodeArray[a]->amplitude;
+			}
 
-			// TODO: Write this.  Extend given sample bounds left/right until we have 4 samples across which we can interpolate.  Invert Vandermonde matrix.
+			break;
+		}
+		case InterpolationMethod::HERMITE:
+		{
+			// The tangent at each bound is the slope between its neighbors, or the slope of the span itself
+			// where there is no neighbor.  On a uniform grid, this is exactly the Catmull-Rom spline.
+			const Sample* firstSample = this->sampleArray.data();
+			const Sample* lastSample = firstSample + this->sampleArray.size() - 1;
+
+			const Sample* sampleA = sampleBounds.minSample;
+			const Sample* sampleB = sampleBounds.maxSample;
+			const Sample* previousSample = (sampleA > firstSample) ? (sampleA - 1) : sampleA;
+			const Sample* nextSample = (sampleB < lastSample) ? (sampleB + 1) : sampleB;
+
+			double spanSeconds = sampleB->timeSeconds - sampleA->timeSeconds;
+			double tangentA = (sampleB->amplitude - previousSample->amplitude) / (sampleB->timeSeconds - previousSample->timeSeconds);
+			double tangentB = (nextSample->amplitude - sampleA->amplitude) / (nextSample->timeSeconds - sampleA->timeSeconds);
+
+			double t = (timeSeconds - sampleA->timeSeconds) / spanSeconds;
+			double tt = t * t;
+			double ttt = tt * t;
+
+			interpolatedSample.amplitude =
+				(2.0 * ttt - 3.0 * tt + 1.0) * sampleA->amplitude +
+				(ttt - 2.0 * tt + t) * spanSeconds * tangentA +
+				(-2.0 * ttt + 3.0 * tt) * sampleB->amplitude +
+				(ttt - tt) * spanSeconds * tangentB;
 			break;
 		}
 	}
@@ -301,6 +858,12 @@ void WaveForm::Interpolate(const SampleBounds& sampleBounds, double timeSeconds,
 
 /*virtual*/ double WaveForm::EvaluateAt(double timeSeconds) const
 {
+	if (this->uniform)
+	{
+		double x = (timeSeconds - this->startTimeSeconds) * this->samplesPerSecond;
+		return EvaluateUniformAt(this->amplitudeArray.data(), this->amplitudeArray.size(), x, this->interpMethod);
+	}
+
 	SampleBounds sampleBounds{ nullptr, nullptr };
 	if (!this->FindTightestSampleBounds(timeSeconds, sampleBounds))
 		return 0.0;
@@ -311,6 +874,98 @@ void WaveForm::Interpolate(const SampleBounds& sampleBounds, double timeSeconds,
 	return interpolatedSample.amplitude;
 }
 
+void WaveForm::EvaluateBlock(double startTimeSeconds, double deltaTimeSeconds, double* amplitudeBuffer, uint64_t numAmplitudes) const
+{
+	if (this->uniform)
+	{
+		// Work in units of samples so that each output is just an index plus a fraction.
+		const double* amplitudes = this->amplitudeArray.data();
+		uint64_t numSamples = this->amplitudeArray.size();
+		double x0 = (startTimeSeconds - this->startTimeSeconds) * this->samplesPerSecond;
+		double dx = deltaTimeSeconds * this->samplesPerSecond;
+
+		EvaluateUniformBlock(amplitudes, numSamples, x0, dx, this->interpMethod, amplitudeBuffer, numAmplitudes);
+		return;
+	}
+
+	// For irregular wave-forms, we do one binary search to get started, and then just walk from
+	// one pair of samples to the next as the times progress.
+	uint64_t numSamples = this->sampleArray.size();
+	if (numSamples == 0)
+	{
+		for (uint64_t k = 0; k < numAmplitudes; k++)
+			amplitudeBuffer[k] = 0.0;
+		return;
+	}
+
+	const Sample* samples = this->sampleArray.data();
+	uint64_t i = 0;
+	SampleBounds sampleBounds{ nullptr, nullptr };
+	if (this->FindTightestSampleBounds(startTimeSeconds, sampleBounds))
+		i = sampleBounds.minSample - samples;
+
+	for (uint64_t k = 0; k < numAmplitudes; k++)
+	{
+		double timeSeconds = startTimeSeconds + double(k) * deltaTimeSeconds;
+		if (timeSeconds < samples[0].timeSeconds || timeSeconds > samples[numSamples - 1].timeSeconds)
+		{
+			amplitudeBuffer[k] = 0.0;
+			continue;
+		}
+
+		if (numSamples == 1)
+		{
+			amplitudeBuffer[k] = samples[0].amplitude;
+			continue;
+		}
+
+		while (i + 2 < numSamples && samples[i + 1].timeSeconds < timeSeconds)
+			i++;
+		while (i > 0 && samples[i].timeSeconds > timeSeconds)
+			i--;
+
+		Sample interpolatedSample;
+		this->Interpolate(SampleBounds{ &samples[i], &samples[i + 1] }, timeSeconds, interpolatedSample);
+		amplitudeBuffer[k] = interpolatedSample.amplitude;
+	}
+}
+
+WaveForm::SampleBounds::SampleBounds()
+{
+	this->minSample = nullptr;
+	this->maxSample = nullptr;
+}
+
+WaveForm::SampleBounds::SampleBounds(const Sample* minSample, const Sample* maxSample)
+{
+	this->minSample = minSample;
+	this->maxSample = maxSample;
+}
+
+WaveForm::SampleBounds::SampleBounds(const SampleBounds& sampleBounds)
+{
+	*this = sampleBounds;
+}
+
+WaveForm::SampleBounds& WaveForm::SampleBounds::operator=(const SampleBounds& sampleBounds)
+{
+	this->gridSampleArray[0] = sampleBounds.gridSampleArray[0];
+	this->gridSampleArray[1] = sampleBounds.gridSampleArray[1];
+
+	// Bounds that point at their own grid samples have to point at ours now, not theirs.
+	this->minSample = sampleBounds.minSample;
+	this->maxSample = sampleBounds.maxSample;
+	for (int i = 0; i < 2; i++)
+	{
+		if (sampleBounds.minSample == &sampleBounds.gridSampleArray[i])
+			this->minSample = &this->gridSampleArray[i];
+		if (sampleBounds.maxSample == &sampleBounds.gridSampleArray[i])
+			this->maxSample = &this->gridSampleArray[i];
+	}
+
+	return *this;
+}
+
 bool WaveForm::SampleBounds::ContainsTime(double timeSeconds) const
 {
 	return this->minSample->timeSeconds <= timeSeconds && timeSeconds <= this->maxSample->timeSeconds;
@@ -318,6 +973,29 @@ bool WaveForm::SampleBounds::ContainsTime(double timeSeconds) const
 
 bool WaveForm::FindTightestSampleBounds(double timeSeconds, SampleBounds& sampleBounds) const
 {
+	if (this->uniform)
+	{
+		// The bounding grid points are found directly, but there are no samples to point at, so we give back copies.
+		uint64_t numSamples = this->amplitudeArray.size();
+		if (numSamples == 0 || this->samplesPerSecond <= 0.0)
+			return false;
+
+		if (timeSeconds < this->GetSampleTime(0) || timeSeconds > this->GetSampleTime(numSamples - 1))
+			return false;
+
+		double x = (timeSeconds - this->startTimeSeconds) * this->samplesPerSecond;
+		uint64_t i = (x > 0.0) ? uint64_t(x) : 0;
+		if (i + 1 >= numSamples)
+			i = (numSamples > 1) ? (numSamples - 2) : 0;
+		uint64_t j = (i + 1 < numSamples) ? (i + 1) : i;
+
+		sampleBounds.gridSampleArray[0] = this->GetSample(i);
+		sampleBounds.gridSampleArray[1] = this->GetSample(j);
+		sampleBounds.minSample = &sampleBounds.gridSampleArray[0];
+		sampleBounds.maxSample = (i == j) ? sampleBounds.minSample : &sampleBounds.gridSampleArray[1];
+		return true;
+	}
+
 	if (this->sampleArray.size() == 0)
 		return false;
 
@@ -358,14 +1036,37 @@ void WaveForm::Copy(const WaveForm* waveForm)
 {
 	this->Clear();
 
-	for (const Sample& sample : waveForm->sampleArray)
-		this->sampleArray.push_back(sample);
+	this->uniform = waveForm->uniform;
+	this->startTimeSeconds = waveForm->startTimeSeconds;
+	this->samplesPerSecond = waveForm->samplesPerSecond;
+
+	if (this->uniform)
+		this->amplitudeArray = waveForm->amplitudeArray;
+	else
+		this->sampleArray = waveForm->sampleArray;
 }
 
 uint64_t WaveForm::PadWithSilence(double desiredDurationSeconds, double sampleRate)
 {
+	this->statisticsValid = false;
+
 	uint64_t numSamplesAdded = 0;
 
+	if (this->uniform)
+	{
+		// We pad at our own rate here so that we stay uniform.  This means we may overshoot the desired duration by a fraction of a sample.
+		if (this->samplesPerSecond <= 0.0)
+			this->samplesPerSecond = sampleRate;
+
+		while (this->GetTimespan() < desiredDurationSeconds)
+		{
+			this->amplitudeArray.push_back(0.0);
+			numSamplesAdded++;
+		}
+
+		return numSamplesAdded;
+	}
+
 	if (this->GetTimespan() < desiredDurationSeconds)
 	{
 		while (this->GetTimespan() < desiredDurationSeconds)
@@ -394,7 +1095,9 @@ uint64_t WaveForm::PadWithSilence(double desiredDurationSeconds, double sampleRa
 
 bool WaveForm::Trim(double startTimeSeconds, double stopTimeSeconds, bool rebaseTime)
 {
-	if (this->sampleArray.size() == 0)
+	this->statisticsValid = false;
+
+	if (this->GetNumSamples() == 0)
 	{
 		ErrorSystem::Get()->Add("Nothing to trim.");
 		return false;
@@ -406,12 +1109,42 @@ bool WaveForm::Trim(double startTimeSeconds, double stopTimeSeconds, bool rebase
 		return false;
 	}
 
-	std::vector<Sample> newSampleArray;
-	for (const Sample& sample : this->sampleArray)
-		if (startTimeSeconds <= sample.timeSeconds && sample.timeSeconds <= stopTimeSeconds)
-			newSampleArray.push_back(sample);
+	if (this->uniform)
+	{
+		// Here we can figure out which samples survive without having to look at any of them.
+		// Note that trimming the front still has to move the survivors down.  Use a WaveFormView if that matters.
+		int64_t numSamples = (int64_t)this->amplitudeArray.size();
+		int64_t i = 0, j = 0;
+		CalcUniformTrimRange(this->startTimeSeconds, this->samplesPerSecond, this->amplitudeArray.size(), startTimeSeconds, stopTimeSeconds, i, j);
+
+		if (i > j)
+			this->amplitudeArray.clear();
+		else
+		{
+			if (j + 1 < numSamples)
+				this->amplitudeArray.resize(j + 1);
+			if (i > 0)
+				this->amplitudeArray.erase(this->amplitudeArray.begin(), this->amplitudeArray.begin() + i);
+			this->startTimeSeconds += double(i) / this->samplesPerSecond;
+		}
+
+		if (rebaseTime)
+			this->startTimeSeconds = 0.0;
+
+		return true;
+	}
+
+	// The samples are in order, so the survivors are a contiguous run that we can find with a couple of
+	// binary searches, and then cut out in place without allocating anything.
+	auto firstIter = std::lower_bound(this->sampleArray.begin(), this->sampleArray.end(), startTimeSeconds, [](const Sample& sample, double timeSeconds) -> bool {
+		return sample.timeSeconds < timeSeconds;
+	});
+	auto lastIter = std::upper_bound(firstIter, this->sampleArray.end(), stopTimeSeconds, [](double timeSeconds, const Sample& sample) -> bool {
+		return timeSeconds < sample.timeSeconds;
+	});
 
-	this->sampleArray = newSampleArray;
+	this->sampleArray.erase(lastIter, this->sampleArray.end());
+	this->sampleArray.erase(this->sampleArray.begin(), this->sampleArray.begin() + (firstIter - this->sampleArray.begin()));
 
 	if (rebaseTime && this->sampleArray.size() > 0)
 	{
@@ -425,9 +1158,42 @@ bool WaveForm::Trim(double startTimeSeconds, double stopTimeSeconds, bool rebase
 
 void WaveForm::QuickTrim(double timeSeconds, TrimSection trimSection)
 {
-	if (this->sampleArray.size() == 0)
+	this->statisticsValid = false;
+
+	if (this->GetNumSamples() == 0)
 		return;
 
+	if (this->uniform)
+	{
+		// We can stay uniform as long as the trim point lands on the grid or outside our time-span.
+		if (!this->ContainsTime(timeSeconds))
+		{
+			if ((timeSeconds < this->GetStartTime() && trimSection == TrimSection::AFTER) ||
+				(timeSeconds > this->GetEndTime() && trimSection == TrimSection::BEFORE))
+			{
+				this->amplitudeArray.clear();
+			}
+
+			return;
+		}
+
+		int64_t i = 0;
+		if (this->FindUniformIndex(timeSeconds, i))
+		{
+			if (trimSection == TrimSection::AFTER)
+				this->amplitudeArray.resize(i + 1);
+			else if (trimSection == TrimSection::BEFORE)
+			{
+				this->amplitudeArray.erase(this->amplitudeArray.begin(), this->amplitudeArray.begin() + i);
+				this->startTimeSeconds += double(i) / this->samplesPerSecond;
+			}
+
+			return;
+		}
+
+		this->MakeIrregular();
+	}
+
 	SampleBounds sampleBounds;
 	if (!this->FindTightestSampleBounds(timeSeconds, sampleBounds))
 	{
@@ -463,6 +1229,11 @@ void WaveForm::QuickTrim(double timeSeconds, TrimSection trimSection)
 
 void WaveForm::SortSamples()
 {
+	this->statisticsValid = false;
+
+	if (this->uniform)
+		return;
+
 	std::sort(this->sampleArray.begin(), this->sampleArray.end(), [](const Sample& sampleA, const Sample& sampleB) -> bool {
 		return sampleA.timeSeconds < sampleB.timeSeconds;
 	});
@@ -481,8 +1252,52 @@ void WaveForm::SumTogether(const std::list<WaveForm*>& waveFormList)
 		return;
 	}
 
+	// If everyone is uniform on the same grid, then we can just add up amplitudes without evaluating anything.
+	const WaveForm* firstWaveForm = *waveFormList.begin();
+	bool allOnSameGrid = true;
 	double minStartTime = std::numeric_limits<double>::max();
-	double maxEndTime = std::numeric_limits<double>::min();
+	double maxEndTime = -std::numeric_limits<double>::max();
+	for (const WaveForm* waveForm : waveFormList)
+	{
+		if (!allOnSameGrid)
+			break;
+
+		if (!firstWaveForm->SharesGridWith(waveForm))
+			allOnSameGrid = false;
+
+		if (waveForm->GetNumSamples() > 0)
+		{
+			minStartTime = ADL_MIN(minStartTime, waveForm->GetStartTime());
+			maxEndTime = ADL_MAX(maxEndTime, waveForm->GetEndTime());
+		}
+	}
+
+	if (allOnSameGrid)
+	{
+		if (minStartTime > maxEndTime)
+		{
+			this->MakeUniform(0.0, firstWaveForm->samplesPerSecond);
+			return;
+		}
+
+		uint64_t numSamples = uint64_t(::round((maxEndTime - minStartTime) * firstWaveForm->samplesPerSecond)) + 1;
+		this->MakeUniform(minStartTime, firstWaveForm->samplesPerSecond, numSamples);
+
+		for (const WaveForm* waveForm : waveFormList)
+		{
+			if (waveForm->amplitudeArray.size() == 0)
+				continue;
+
+			uint64_t offset = uint64_t(::round((waveForm->startTimeSeconds - minStartTime) * this->samplesPerSecond));
+			uint64_t count = ADL_MIN(waveForm->amplitudeArray.size(), numSamples - offset);
+			::Accumulate(&this->amplitudeArray[offset], waveForm->amplitudeArray.data(), 1.0, count);
+		}
+
+		return;
+	}
+
+	minStartTime = std::numeric_limits<double>::max();
+	maxEndTime = std::numeric_limits<double>::min();
 	double maxAvgSamplesPerSecond = std::numeric_limits<double>::min();
 	for (const WaveForm* waveForm : waveFormList)
 	{
@@ -499,21 +1314,112 @@ void WaveForm::SumTogether(const std::list<WaveForm*>& waveFormList)
 			maxEndTime = endTime;
 	}
 
+	// The result is uniform either way, even if the inputs aren't.  Uniform inputs are at least O(1) to evaluate.
 	double timeSpanSeconds = maxEndTime - minStartTime;
 	uint32_t numSamples = uint32_t(timeSpanSeconds * maxAvgSamplesPerSecond);
-	for (uint32_t i = 0; i < numSamples; i++)
+	if (numSamples <= 1)
 	{
-		Sample sample;
-		sample.timeSeconds = minStartTime + (double(i) / double(numSamples - 1)) * timeSpanSeconds;
-		sample.amplitude = 0.0;
-		for (const WaveForm* waveForm : waveFormList)
-			sample.amplitude += waveForm->EvaluateAt(sample.timeSeconds);
-		this->sampleArray.push_back(sample);
+		this->MakeUniform(minStartTime, maxAvgSamplesPerSecond, 0);
+		return;
+	}
+
+	// Rather than evaluate every input at every output time, we evaluate each input across the whole
+	// output grid in one go, which does only one search per input, and then add it in.
+	double samplesPerSecond = double(numSamples - 1) / timeSpanSeconds;
+	this->MakeUniform(minStartTime, samplesPerSecond, numSamples);
+
+	// The evaluation block is scratch memory, so take it from the render pass if we're in one, or else reuse our own.
+	double* amplitudeBlock = nullptr;
+	RenderArena* renderArena = RenderArena::GetCurrent();
+	if (renderArena)
+		amplitudeBlock = renderArena->AllocateArray<double>(numSamples);
+	else
+	{
+		if (this->scratchAmplitudeArray.size() < numSamples)
+			this->scratchAmplitudeArray.resize(numSamples);
+		amplitudeBlock = this->scratchAmplitudeArray.data();
+	}
+
+	for (const WaveForm* waveForm : waveFormList)
+	{
+		waveForm->EvaluateBlock(minStartTime, 1.0 / samplesPerSecond, amplitudeBlock, numSamples);
+		::Accumulate(this->amplitudeArray.data(), amplitudeBlock, 1.0, numSamples);
+	}
+}
+
+void WaveForm::Accumulate(const WaveForm* waveForm, double scale /*= 1.0*/)
+{
+	this->statisticsValid = false;
+
+	if (waveForm == this || waveForm->GetNumSamples() == 0)
+	{
+		if (waveForm == this)
+			this->Scale(1.0 + scale);
+
+		return;
+	}
+
+	if (this->GetNumSamples() == 0)
+	{
+		this->Copy(waveForm);
+		if (scale != 1.0)
+			this->Scale(scale);
+
+		return;
 	}
+
+	if (!this->SharesGridWith(waveForm))
+	{
+		// This is the slow path.  It shouldn't come up much when mixing synthesized audio.
+		WaveForm thisWaveForm, givenWaveForm;
+		thisWaveForm.Copy(this);
+		givenWaveForm.Copy(waveForm);
+		givenWaveForm.interpMethod = waveForm->interpMethod;
+		if (scale != 1.0)
+			givenWaveForm.Scale(scale);
+
+		std::list<WaveForm*> waveFormList;
+		waveFormList.push_back(&thisWaveForm);
+		waveFormList.push_back(&givenWaveForm);
+		this->SumTogether(waveFormList);
+		return;
+	}
+
+	// Grow our grid at either end, if needed, to cover the given wave-form, then add it in.
+	int64_t offset = int64_t(::round((waveForm->startTimeSeconds - this->startTimeSeconds) * this->samplesPerSecond));
+	if (offset < 0)
+	{
+		this->amplitudeArray.insert(this->amplitudeArray.begin(), uint64_t(-offset), 0.0);
+		this->startTimeSeconds = waveForm->startTimeSeconds;
+		offset = 0;
+	}
+
+	uint64_t numSamplesNeeded = uint64_t(offset) + waveForm->amplitudeArray.size();
+	if (this->amplitudeArray.size() < numSamplesNeeded)
+		this->amplitudeArray.resize(numSamplesNeeded, 0.0);
+
+	::Accumulate(&this->amplitudeArray[offset], waveForm->amplitudeArray.data(), scale, waveForm->amplitudeArray.size());
+}
+
+bool WaveForm::SharesGridWith(const WaveForm* waveForm) const
+{
+	if (!this->uniform || !waveForm->uniform || this->samplesPerSecond <= 0.0)
+		return false;
+
+	if (waveForm->samplesPerSecond != this->samplesPerSecond)
+		return false;
+
+	double x = (waveForm->startTimeSeconds - this->startTimeSeconds) * this->samplesPerSecond;
+	return ::fabs(x - ::round(x)) <= ADL_UNIFORM_GRID_TOLERANCE;
 }
 
 void WaveForm::Clamp(double minAmplitude, double maxAmplitude)
 {
+	this->statisticsValid = false;
+
+	for (double& amplitude : this->amplitudeArray)
+		amplitude = ADL_CLAMP(amplitude, minAmplitude, maxAmplitude);
+
 	for (Sample& sample : this->sampleArray)
 	{
 		if (sample.amplitude < minAmplitude)
@@ -525,6 +1431,9 @@ void WaveForm::Clamp(double minAmplitude, double maxAmplitude)
 
 double WaveForm::AverageSampleRate() const
 {
+	if (this->uniform)
+		return this->samplesPerSecond;
+
 	double timeSpanSeconds = this->GetTimespan();
 	if (timeSpanSeconds == 0.0)
 		return 0.0;
@@ -535,45 +1444,85 @@ double WaveForm::AverageSampleRate() const
 
 double WaveForm::CalcAverageVolume() const
 {
-	double averageVolume = 0.0;
-	double numPeaksAndVallies = 0.0;
+	return this->GetStatistics().averageVolume;
+}
 
-	for (uint32_t i = 1; i < this->sampleArray.size() - 1; i++)
-	{
-		const Sample& sampleA = this->sampleArray[i - 1];
-		const Sample& sampleB = this->sampleArray[i];
-		const Sample& sampleC = this->sampleArray[i + 1];
+const WaveForm::Statistics& WaveForm::GetStatistics() const
+{
+	if (this->statisticsValid)
+		return this->statistics;
 
-		double slopeA = (sampleB.amplitude - sampleA.amplitude) / (sampleB.timeSeconds - sampleA.timeSeconds);
-		double slopeB = (sampleC.amplitude - sampleB.amplitude) / (sampleC.timeSeconds - sampleB.timeSeconds);
+	StatisticsSums sums;
+	uint64_t numSamples = this->GetNumSamples();
 
-		if (ADL_SIGN(slopeA) != ADL_SIGN(slopeB))
+	if (this->uniform)
+		GatherUniformStatistics(this->amplitudeArray.data(), numSamples, sums);
+	else
+	{
+		// Irregular wave-forms get a scalar pass.  Note that we only need the sign of each slope,
+		// so there's no need to divide by the change in time to get the slope itself.
+		const Sample* samples = this->sampleArray.data();
+		for (uint64_t i = 0; i < numSamples; i++)
 		{
-			averageVolume += ::abs(sampleB.amplitude);
-			numPeaksAndVallies += 1.0;
+			double amplitude = samples[i].amplitude;
+			sums.minAmplitude = ADL_MIN(sums.minAmplitude, amplitude);
+			sums.maxAmplitude = ADL_MAX(sums.maxAmplitude, amplitude);
+			sums.sumOfSquares += amplitude * amplitude;
+
+			if (0 < i && i + 1 < numSamples)
+			{
+				double deltaA = amplitude - samples[i - 1].amplitude;
+				double deltaB = samples[i + 1].amplitude - amplitude;
+				bool fallingA = deltaA != 0.0 && ((deltaA < 0.0) != (samples[i].timeSeconds - samples[i - 1].timeSeconds < 0.0));
+				bool fallingB = deltaB != 0.0 && ((deltaB < 0.0) != (samples[i + 1].timeSeconds - samples[i].timeSeconds < 0.0));
+				if (fallingA != fallingB)
+				{
+					sums.sumOfPeaks += ::fabs(amplitude);
+					sums.numPeaks++;
+				}
+			}
 		}
 	}
 
-	if (numPeaksAndVallies != 0.0)
-		averageVolume /= numPeaksAndVallies;
+	Statistics& statistics = this->statistics;
+	if (numSamples == 0)
+	{
+		// These are what the min/max functions have always given back for an empty wave-form.
+		statistics.minAmplitude = std::numeric_limits<double>::max();
+		statistics.maxAmplitude = std::numeric_limits<double>::min();
+		statistics.peakAmplitude = 0.0;
+		statistics.rmsAmplitude = 0.0;
+	}
+	else
+	{
+		statistics.minAmplitude = sums.minAmplitude;
+		statistics.maxAmplitude = sums.maxAmplitude;
+		statistics.peakAmplitude = ADL_MAX(ADL_ABS(sums.minAmplitude), ADL_ABS(sums.maxAmplitude));
+		statistics.rmsAmplitude = ::sqrt(sums.sumOfSquares / double(numSamples));
+	}
+
+	statistics.numPeaksAndValleys = sums.numPeaks;
+	statistics.averageVolume = (sums.numPeaks > 0) ? (sums.sumOfPeaks / double(sums.numPeaks)) : 0.0;
 
-	return averageVolume;
+	this->statisticsValid = true;
+	return statistics;
 }
 
 double WaveForm::GetStartTime() const
 {
-	if (this->sampleArray.size() == 0)
+	if (this->GetNumSamples() == 0)
 		return 0.0;
 
-	return this->sampleArray[0].timeSeconds;
+	return this->GetSampleTime(0);
 }
 
 double WaveForm::GetEndTime() const
 {
-	if (this->sampleArray.size() == 0)
+	uint64_t numSamples = this->GetNumSamples();
+	if (numSamples == 0)
 		return 0.0;
 
-	return this->sampleArray[this->sampleArray.size() - 1].timeSeconds;
+	return this->GetSampleTime(numSamples - 1);
 }
 
 double WaveForm::GetTimespan() const
@@ -583,34 +1532,25 @@ double WaveForm::GetTimespan() const
 
 uint64_t WaveForm::GetNumSamples() const
 {
+	if (this->uniform)
+		return this->amplitudeArray.size();
+
 	return this->sampleArray.size();
 }
 
 double WaveForm::GetMaxAmplitude() const
 {
-	double maxAmplitude = std::numeric_limits<double>::min();
-	for (const Sample& sample : this->sampleArray)
-		if (sample.amplitude > maxAmplitude)
-			maxAmplitude = sample.amplitude;
-
-	return maxAmplitude;
+	return this->GetStatistics().maxAmplitude;
 }
 
 double WaveForm::GetMinAmplitude() const
 {
-	double minAmplitude = std::numeric_limits<double>::max();
-	for (const Sample& sample : this->sampleArray)
-		if (sample.amplitude < minAmplitude)
-			minAmplitude = sample.amplitude;
-
-	return minAmplitude;
+	return this->GetStatistics().minAmplitude;
 }
 
 bool WaveForm::Renormalize()
 {
-	double minAmplitude = this->GetMinAmplitude();
-	double maxAmplitude = this->GetMaxAmplitude();
-	double absAmplitude = ADL_MAX(ADL_ABS(minAmplitude), ADL_ABS(maxAmplitude));
+	double absAmplitude = this->GetStatistics().peakAmplitude;
 	if (absAmplitude == 0.0)
 		return false;
 
@@ -624,6 +1564,11 @@ bool WaveForm::Renormalize()
 
 void WaveForm::Scale(double scale)
 {
+	this->statisticsValid = false;
+
+	for (double& amplitude : this->amplitudeArray)
+		amplitude *= scale;
+
 	for (Sample& sample : this->sampleArray)
 		sample.amplitude *= scale;
 }
@@ -636,67 +1581,310 @@ bool WaveForm::ContainsTime(double timeSeconds) const
 	return startTimeSeconds <= timeSeconds && timeSeconds <= endTimeSeconds;
 }
 
+//---------------------------------- WaveFormView ----------------------------------
+
+WaveFormView::WaveFormView()
+{
+	this->amplitudes = nullptr;
+	this->numSamples = 0;
+	this->startTimeSeconds = 0.0;
+	this->samplesPerSecond = 0.0;
+	this->interpMethod = WaveForm::InterpolationMethod::LINEAR;
+}
+
+WaveFormView::WaveFormView(const double* amplitudes, uint64_t numSamples, double startTimeSeconds, double samplesPerSecond, WaveForm::InterpolationMethod interpMethod /*= WaveForm::InterpolationMethod::LINEAR*/)
+{
+	this->amplitudes = amplitudes;
+	this->numSamples = numSamples;
+	this->startTimeSeconds = startTimeSeconds;
+	this->samplesPerSecond = samplesPerSecond;
+	this->interpMethod = interpMethod;
+}
+
+double WaveFormView::GetEndTime() const
+{
+	if (this->numSamples == 0)
+		return this->startTimeSeconds;
+
+	return this->GetSampleTime(this->numSamples - 1);
+}
+
+double WaveFormView::GetTimespan() const
+{
+	return this->GetEndTime() - this->startTimeSeconds;
+}
+
+double WaveFormView::EvaluateAt(double timeSeconds) const
+{
+	if (this->numSamples == 0)
+		return 0.0;
+
+	double x = (timeSeconds - this->startTimeSeconds) * this->samplesPerSecond;
+	return EvaluateUniformAt(this->amplitudes, this->numSamples, x, this->interpMethod);
+}
+
+void WaveFormView::EvaluateBlock(double startTimeSeconds, double deltaTimeSeconds, double* amplitudeBuffer, uint64_t numAmplitudes) const
+{
+	if (this->numSamples == 0)
+	{
+		for (uint64_t k = 0; k < numAmplitudes; k++)
+			amplitudeBuffer[k] = 0.0;
+		return;
+	}
+
+	double x0 = (startTimeSeconds - this->startTimeSeconds) * this->samplesPerSecond;
+	double dx = deltaTimeSeconds * this->samplesPerSecond;
+	EvaluateUniformBlock(this->amplitudes, this->numSamples, x0, dx, this->interpMethod, amplitudeBuffer, numAmplitudes);
+}
+
+WaveFormView WaveFormView::Slice(double startTimeSeconds, double stopTimeSeconds) const
+{
+	WaveFormView view(*this);
+	view.Trim(startTimeSeconds, stopTimeSeconds, false);
+	return view;
+}
+
+bool WaveFormView::Trim(double startTimeSeconds, double stopTimeSeconds, bool rebaseTime)
+{
+	if (startTimeSeconds > stopTimeSeconds)
+	{
+		ErrorSystem::Get()->Add(std::format("Given time bounds ([{}, {}]) doesn't make sense.", startTimeSeconds, stopTimeSeconds));
+		return false;
+	}
+
+	if (this->numSamples > 0)
+	{
+		int64_t i = 0, j = 0;
+		CalcUniformTrimRange(this->startTimeSeconds, this->samplesPerSecond, this->numSamples, startTimeSeconds, stopTimeSeconds, i, j);
+
+		if (i > j)
+			this->numSamples = 0;
+		else
+		{
+			this->amplitudes += i;
+			this->numSamples = uint64_t(j - i + 1);
+			this->startTimeSeconds += double(i) / this->samplesPerSecond;
+		}
+	}
+
+	if (rebaseTime)
+		this->startTimeSeconds = 0.0;
+
+	return true;
+}
+
+void WaveFormView::QuickTrim(double timeSeconds, WaveForm::TrimSection trimSection)
+{
+	if (trimSection == WaveForm::TrimSection::BEFORE)
+		this->Trim(timeSeconds, std::numeric_limits<double>::max(), false);
+	else if (trimSection == WaveForm::TrimSection::AFTER)
+		this->Trim(-std::numeric_limits<double>::max(), timeSeconds, false);
+}
+
+void WaveFormView::CopyTo(WaveForm& waveForm) const
+{
+	waveForm.MakeUniform(this->startTimeSeconds, this->samplesPerSecond, this->numSamples);
+	waveForm.SetInterpolateionMethod(this->interpMethod);
+	if (this->numSamples > 0)
+		::memcpy(waveForm.GetAmplitudeArray().data(), this->amplitudes, this->numSamples * sizeof(double));
+}
+
 //---------------------------------- WaveFormStream ----------------------------------
 
-WaveFormStream::WaveFormStream(uint32_t maxWaveForms, double maxWaveFormSizeSeconds)
+// This is how quiet a sample must be to be considered inaudible.
+#define ADL_STREAM_AUDIBLE_THRESHOLD		1e-3
+
+// This keeps a bogus rate (e.g., from two samples that happened to be very close together) from eating all our memory.
+#define ADL_STREAM_MAX_CAPACITY				(uint64_t(1) << 24)
+
+WaveFormStream::WaveFormStream(double historySeconds, double samplesPerSecond /*= 0.0*/)
 {
-	this->maxWaveForms = maxWaveForms;
-	this->maxWaveFormSizeSeconds = maxWaveFormSizeSeconds;
+	this->historySeconds = historySeconds;
+	this->samplesPerSecond = 0.0;
+	this->requestedSamplesPerSecond = samplesPerSecond;
+	this->ringMask = 0;
+
+	this->Clear();
 }
 
 /*virtual*/ WaveFormStream::~WaveFormStream()
 {
-	this->Clear();
 }
 
 void WaveFormStream::Clear()
 {
-	for (WaveForm* waveForm : this->waveFormList)
-		delete waveForm;
+	this->startTimeSeconds = 0.0;
+	this->numSamplesAdded = 0;
+	this->numSamplesWritten = 0;
+	this->lastTimeSeconds = 0.0;
+	this->lastAmplitude = 0.0;
+	this->lastAudibleIndex = -1;
+
+	if (this->samplesPerSecond != this->requestedSamplesPerSecond)
+	{
+		this->samplesPerSecond = this->requestedSamplesPerSecond;
+		if (this->samplesPerSecond > 0.0)
+			this->AllocateRingBuffer();
+	}
+}
+
+void WaveFormStream::SetSampleRate(double samplesPerSecond)
+{
+	this->requestedSamplesPerSecond = samplesPerSecond;
+	this->samplesPerSecond = 0.0;
+	this->Clear();
+}
+
+void WaveFormStream::AllocateRingBuffer()
+{
+	// One extra sample is needed to interpolate at the far end of the history.
+	double idealCapacity = ::ceil(this->historySeconds * this->samplesPerSecond) + 2.0;
+	uint64_t neededCapacity = (idealCapacity < double(ADL_STREAM_MAX_CAPACITY)) ? uint64_t(idealCapacity) : ADL_STREAM_MAX_CAPACITY;
 
-	this->waveFormList.clear();
+	// The buffer only ever grows, so going back and forth between rates doesn't thrash the heap.
+	uint64_t capacity = 1;
+	while (capacity < neededCapacity)
+		capacity <<= 1;
+
+	if (capacity > this->ringBuffer.size())
+		this->ringBuffer.resize(capacity);
+
+	this->ringMask = this->ringBuffer.size() - 1;
 }
 
-/*virtual*/ double WaveFormStream::EvaluateAt(double timeSeconds) const
+void WaveFormStream::WriteSample(double amplitude)
 {
-	// This is effectively an O(log N) operation if this->maxWaveForms is set to 2.
-	for (const WaveForm* waveForm : this->waveFormList)
-		if (waveForm->ContainsTime(timeSeconds))
-			return waveForm->EvaluateAt(timeSeconds);	// This is O(log N).
+	this->ringBuffer[this->numSamplesWritten & this->ringMask] = amplitude;
+
+	if (::fabs(amplitude) >= ADL_STREAM_AUDIBLE_THRESHOLD)
+		this->lastAudibleIndex = int64_t(this->numSamplesWritten);
 
-	return 0.0;
+	this->numSamplesWritten++;
+}
+
+uint64_t WaveFormStream::GetOldestIndex() const
+{
+	// Keep one slot in reserve so that the oldest sample isn't being overwritten while it's still considered part of the history.
+	uint64_t capacity = this->ringBuffer.size() - 1;
+	return (this->numSamplesWritten > capacity) ? (this->numSamplesWritten - capacity) : 0;
 }
 
 void WaveFormStream::AddSample(const WaveForm::Sample& sample)
 {
-	if (this->waveFormList.size() == 0)
+	if (this->numSamplesAdded == 0)
 	{
-		auto waveForm = new WaveForm();
-		waveForm->AddSample(sample);
-		this->waveFormList.push_back(waveForm);
+		this->numSamplesAdded = 1;
+		this->startTimeSeconds = sample.timeSeconds;
+		this->lastTimeSeconds = sample.timeSeconds;
+		this->lastAmplitude = sample.amplitude;
+
+		if (this->samplesPerSecond > 0.0)
+			this->WriteSample(sample.amplitude);
+
 		return;
 	}
 
-	WaveForm* waveForm = this->waveFormList.back();
-	if (waveForm->GetTimespan() < this->maxWaveFormSizeSeconds)
+	if (this->samplesPerSecond == 0.0)
+	{
+		// We don't have a grid yet, so let the first two samples define it.
+		double deltaTimeSeconds = sample.timeSeconds - this->lastTimeSeconds;
+		if (deltaTimeSeconds <= 0.0)
+		{
+			this->lastAmplitude = sample.amplitude;
+			return;
+		}
+
+		this->samplesPerSecond = 1.0 / deltaTimeSeconds;
+		this->AllocateRingBuffer();
+		this->WriteSample(this->lastAmplitude);
+	}
+
+	this->numSamplesAdded++;
+
+	double periodSeconds = 1.0 / this->samplesPerSecond;
+	double toleranceSeconds = ADL_UNIFORM_GRID_TOLERANCE * periodSeconds;
+
+	if (sample.timeSeconds <= this->lastTimeSeconds + toleranceSeconds)
 	{
-		waveForm->AddSample(sample);
+		if (sample.timeSeconds >= this->lastTimeSeconds - toleranceSeconds)
+		{
+			// This replaces the latest sample, and it's grid point too, if it was on one.
+			this->lastAmplitude = sample.amplitude;
+			uint64_t i = this->numSamplesWritten - 1;
+			if (::fabs(this->startTimeSeconds + double(i) * periodSeconds - this->lastTimeSeconds) <= toleranceSeconds)
+			{
+				this->numSamplesWritten = i;
+				this->WriteSample(sample.amplitude);
+			}
+		}
+
 		return;
 	}
 
-	const WaveForm::Sample& lastSample = waveForm->GetSampleArray()[waveForm->GetNumSamples() - 1];
+	// Fill in every grid point between the last sample and this one.  Typically, there is exactly one, and it's right on this sample.
+	double spanSeconds = sample.timeSeconds - this->lastTimeSeconds;
+	while (true)
+	{
+		double gridTimeSeconds = this->startTimeSeconds + double(this->numSamplesWritten) * periodSeconds;
+		if (gridTimeSeconds > sample.timeSeconds + toleranceSeconds)
+			break;
+
+		double alpha = ADL_CLAMP((gridTimeSeconds - this->lastTimeSeconds) / spanSeconds, 0.0, 1.0);
+		this->WriteSample(this->lastAmplitude + alpha * (sample.amplitude - this->lastAmplitude));
+	}
+
+	this->lastTimeSeconds = sample.timeSeconds;
+	this->lastAmplitude = sample.amplitude;
+}
+
+/*virtual*/ double WaveFormStream::EvaluateAt(double timeSeconds) const
+{
+	if (this->numSamplesWritten == 0)
+		return (this->numSamplesAdded > 0 && timeSeconds == this->lastTimeSeconds) ? this->lastAmplitude : 0.0;
+
+	return this->EvaluateAtIndex((timeSeconds - this->startTimeSeconds) * this->samplesPerSecond);
+}
+
+double WaveFormStream::EvaluateAtIndex(double sampleIndex) const
+{
+	if (this->numSamplesWritten == 0)
+		return 0.0;
+
+	// Being a hair outside of the history is just round-off, so let that slide.
+	double oldestIndex = double(this->GetOldestIndex());
+	double lastIndex = (this->lastTimeSeconds - this->startTimeSeconds) * this->samplesPerSecond;
+	if (sampleIndex < oldestIndex)
+	{
+		if (sampleIndex < oldestIndex - ADL_UNIFORM_GRID_TOLERANCE)
+			return 0.0;
+		sampleIndex = oldestIndex;
+	}
+	else if (sampleIndex > lastIndex)
+	{
+		if (sampleIndex > lastIndex + ADL_UNIFORM_GRID_TOLERANCE)
+			return 0.0;
+		sampleIndex = lastIndex;
+	}
 
-	waveForm = new WaveForm();
-	waveForm->AddSample(lastSample);		// Adjacent wave-forms need to share a sample where they meet.
-	waveForm->AddSample(sample);
-	this->waveFormList.push_back(waveForm);
+	uint64_t i = uint64_t(sampleIndex);
+	double alpha = sampleIndex - double(i);
+	uint64_t latestWrittenIndex = this->numSamplesWritten - 1;
 
-	if (this->waveFormList.size() > this->maxWaveForms)
+	if (i < latestWrittenIndex)
 	{
-		waveForm = *this->waveFormList.begin();
-		delete waveForm;
-		this->waveFormList.pop_front();
+		double amplitudeA = this->ringBuffer[i & this->ringMask];
+		double amplitudeB = this->ringBuffer[(i + 1) & this->ringMask];
+		return amplitudeA + alpha * (amplitudeB - amplitudeA);
 	}
+
+	// We're between the latest grid point and the latest sample, which might not be on the grid.
+	double amplitudeA = this->ringBuffer[latestWrittenIndex & this->ringMask];
+	double spanIndices = lastIndex - double(latestWrittenIndex);
+	if (spanIndices <= ADL_UNIFORM_GRID_TOLERANCE)
+		return amplitudeA;
+
+	alpha = ADL_CLAMP((sampleIndex - double(latestWrittenIndex)) / spanIndices, 0.0, 1.0);
+	return amplitudeA + alpha * (this->lastAmplitude - amplitudeA);
 }
 
 double WaveFormStream::GetDurationSeconds() const
@@ -706,41 +1894,24 @@ double WaveFormStream::GetDurationSeconds() const
 
 double WaveFormStream::GetStartTimeSeconds() const
 {
-	if (this->waveFormList.size() == 0)
-		return 0.0;
+	if (this->numSamplesWritten == 0)
+		return this->lastTimeSeconds;
 
-	const WaveForm* firstWaveForm = *this->waveFormList.begin();
-	if (firstWaveForm->GetSampleArray().size() == 0)
-		return 0.0;
-
-	const WaveForm::Sample& firstSample = firstWaveForm->GetSampleArray()[0];
-	return firstSample.timeSeconds;
+	return this->startTimeSeconds + double(this->GetOldestIndex()) / this->samplesPerSecond;
 }
 
 double WaveFormStream::GetEndTimeSeconds() const
 {
-	if (this->waveFormList.size() == 0)
-		return 0.0;
-
-	const WaveForm* lastWaveForm = this->waveFormList.back();
-	if (lastWaveForm->GetSampleArray().size() == 0)
-		return 0.0;
-
-	const WaveForm::Sample& lastSample = lastWaveForm->GetSampleArray()[lastWaveForm->GetSampleArray().size() - 1];
-	return lastSample.timeSeconds;
+	return this->lastTimeSeconds;
 }
 
 bool WaveFormStream::AnyAudibleSampleFound() const
 {
-	for (const WaveForm* waveForm : this->waveFormList)
-	{
-		for (const WaveForm::Sample& sample : waveForm->GetSampleArray())
-		{
-			constexpr double threshold = 1e-3;	// TODO: Should this be a global define somewhere?
-			if (::fabs(sample.amplitude) >= threshold)
-				return true;
-		}
-	}
+	if (this->numSamplesAdded == 0)
+		return false;
+
+	if (::fabs(this->lastAmplitude) >= ADL_STREAM_AUDIBLE_THRESHOLD)
+		return true;
 
-	return false;
+	return this->lastAudibleIndex >= 0 && uint64_t(this->lastAudibleIndex) >= this->GetOldestIndex();
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 namespace AudioDataLib
 {
 	class Error;
+	class WaveFormView;
 
 	/**
 	 * @brief This is the time-domain representation of a wave-form.
@@ -18,6 +19,13 @@ namespace AudioDataLib
 	 * 
 	 * A wave-form, therefore, is just a list of audio samples, each being a time and "amplitude" pair.
 	 * Most operations assume that the samples are in chronological order.
+	 * 
+	 * Having said all that, almost every wave-form we ever make is sampled at a uniform rate, and in that
+	 * case it's wasteful to store a time with every sample.  So a wave-form can also be put into a uniform
+	 * representation (see MakeUniform), where all we store is a start time, a sample rate, and a contiguous
+	 * array of amplitudes.  Evaluation then becomes simple index arithmetic, and we use half the memory.
+	 * The irregular representation is still there as a fallback for anything that needs to move samples
+	 * around in time independently of one another.
 	 */
 	class AUDIO_DATA_LIB_API WaveForm : public Function
 	{
@@ -29,11 +37,24 @@ namespace AudioDataLib
 
 		/**
 		 * Return the amplitude of the wave-form at the given time (in seconds.)
-		 * Note that this has O(log N) time-complexity, which is usually reasonably,
-		 * but clearly not as fast as O(1), which can be achieved with raw audio data.
+		 * Note that this has O(log N) time-complexity for irregular wave-forms, which is usually reasonable,
+		 * but clearly not as fast as the O(1) we get from uniform wave-forms.
 		 */
 		virtual double EvaluateAt(double timeSeconds) const override;
 
+		/**
+		 * Evaluate this wave-form at a whole run of evenly spaced times.  This gives the same results as calling
+		 * EvaluateAt for each of those times, but it's a lot cheaper, especially for the cubic interpolation
+		 * methods, where uniform wave-forms get a vectorized kernel that works on several outputs at once, and
+		 * irregular wave-forms only need one binary search for the whole run rather than one per output.
+		 *
+		 * @param[in] startTimeSeconds This is the time of the first amplitude to produce.
+		 * @param[in] deltaTimeSeconds This is the time between one amplitude and the next.
+		 * @param[out] amplitudeBuffer This receives the amplitudes.
+		 * @param[in] numAmplitudes This is how many amplitudes to produce.
+		 */
+		void EvaluateBlock(double startTimeSeconds, double deltaTimeSeconds, double* amplitudeBuffer, uint64_t numAmplitudes) const;
+
 		/**
 		 * Return the number of bytes required to represent this wave-form in the given format for 1 or all channels.
 		 * 
@@ -77,18 +98,33 @@ namespace AudioDataLib
 			double amplitude;	// TODO: This term isn't quite right.  What's a better term?  "Value"?
 		};
 
-		struct SampleBounds
+		/**
+		 * @brief This is a pair of samples bounding some time, as found by FindTightestSampleBounds.
+		 * 
+		 * An irregular wave-form's bounds point into its sample array.  A uniform wave-form doesn't have one,
+		 * so its bounds point at copies of the two grid points kept in here instead.  Copying the bounds
+		 * keeps them pointing at their own copies.
+		 */
+		struct AUDIO_DATA_LIB_API SampleBounds
 		{
+			SampleBounds();
+			SampleBounds(const Sample* minSample, const Sample* maxSample);
+			SampleBounds(const SampleBounds& sampleBounds);
+
+			SampleBounds& operator=(const SampleBounds& sampleBounds);
+
+			bool ContainsTime(double timeSeconds) const;
+
 			const Sample* minSample;
 			const Sample* maxSample;
-			
-			bool ContainsTime(double timeSeconds) const;
+			Sample gridSampleArray[2];
 		};
 
 		enum InterpolationMethod
 		{
 			LINEAR,		///< Use the line containing two different samples as the means of interpolation.
-			CUBIC		///< Use the cubic polynomial fitting four different samples as the means of interpolation.  This is more expensive.
+			CUBIC,		///< Use the cubic polynomial fitting four different samples (Lagrange interpolation) as the means of interpolation.  This is more expensive.
+			HERMITE		///< Use a cubic Hermite spline whose tangents come from the neighboring samples (Catmull-Rom.)  This costs the same as CUBIC, but is smoother from one span to the next.
 		};
 
 		enum TrimSection
@@ -108,10 +144,86 @@ namespace AudioDataLib
 		void Copy(const WaveForm* waveForm);
 
 		/**
-		 * Add a sample to the end of this wave-form's list of samples.
+		 * Add a sample to the end of this wave-form's list of samples.  If this wave-form is uniform and the given
+		 * sample falls on the next point of the grid, then it stays uniform.  Otherwise, it gets converted to the
+		 * irregular representation first.
 		 */
 		void AddSample(const Sample& sample);
 
+		/**
+		 * Clear this wave-form and put it into the uniform representation.  The amplitudes all start out at zero.
+		 * 
+		 * @param[in] startTimeSeconds This is the time (in seconds) of the first sample.
+		 * @param[in] samplesPerSecond This is the sampling rate; the reciprocal of the time between adjacent samples.
+		 * @param[in] numSamples This is how many samples to allocate.  More can be added later with AddSample or AddAmplitude.
+		 */
+		void MakeUniform(double startTimeSeconds, double samplesPerSecond, uint64_t numSamples = 0);
+
+		/**
+		 * Convert this wave-form from the uniform representation to the irregular one.
+		 * This is a no-op if the wave-form is already irregular.
+		 */
+		void MakeIrregular();
+
+		/**
+		 * Return true if and only if this wave-form is in the uniform representation.
+		 */
+		bool IsUniform() const { return this->uniform; }
+
+		/**
+		 * Return the sampling rate of a uniform wave-form, or zero if the wave-form is irregular.
+		 */
+		double GetUniformSampleRate() const { return this->uniform ? this->samplesPerSecond : 0.0; }
+
+		/**
+		 * Move the grid of a uniform wave-form without touching its amplitudes.  This is how you'd
+		 * stretch or squash a uniform wave-form in time without losing its uniformity.
+		 */
+		void SetUniformTiming(double startTimeSeconds, double samplesPerSecond);
+
+		/**
+		 * Put an irregular wave-form onto a uniform grid at the given rate, spanning the same time as before,
+		 * by evaluating it at each point of the grid.  This is a no-op if the wave-form is already uniform.
+		 */
+		void ConvertToUniform(double samplesPerSecond);
+
+		/**
+		 * Return a view of all the amplitudes of this uniform wave-form.  No samples are copied, so the view is
+		 * only good for as long as this wave-form is left alone.  An irregular wave-form gives back an empty view.
+		 */
+		WaveFormView GetView() const;
+
+		/**
+		 * Return a view of just the amplitudes of this uniform wave-form that fall in the given time range.
+		 * This is O(1).  See WaveFormView::Trim.
+		 */
+		WaveFormView GetView(double startTimeSeconds, double stopTimeSeconds) const;
+
+		/**
+		 * Add an amplitude to the end of a uniform wave-form.  This is the fast way to build one up.
+		 */
+		void AddAmplitude(double amplitude);
+
+		/**
+		 * Return the i-th sample of this wave-form, regardless of representation.
+		 */
+		Sample GetSample(uint64_t i) const;
+
+		/**
+		 * Return the time (in seconds) of the i-th sample of this wave-form, regardless of representation.
+		 */
+		double GetSampleTime(uint64_t i) const;
+
+		/**
+		 * Return the amplitude of the i-th sample of this wave-form, regardless of representation.
+		 */
+		double GetAmplitude(uint64_t i) const;
+
+		/**
+		 * Set the amplitude of the i-th sample of this wave-form, regardless of representation.
+		 */
+		void SetAmplitude(uint64_t i, double amplitude);
+
 		/**
 		 * Make this wave-form a flat light representing silence for the given time period.
 		 * 
@@ -127,9 +239,18 @@ namespace AudioDataLib
 		 */
 		void SumTogether(const std::list<WaveForm*>& waveFormList);
 
+		/**
+		 * Add the given wave-form into this one, in place, after scaling it by the given factor.  This wave-form
+		 * grows as needed to cover the time-span of the given one.  If both are uniform on the same grid, which
+		 * is the normal case when mixing synthesized audio, this is a straight vectorized add of the amplitudes
+		 * and no evaluation or allocation happens beyond what's needed for growth.  Otherwise, it falls back to
+		 * SumTogether.  If this wave-form is empty, it just becomes a (scaled) copy of the given one.
+		 */
+		void Accumulate(const WaveForm* waveForm, double scale = 1.0);
+
 		/**
 		 * Find the pair of adjacent samples that bounds the given time.
-		 * This is an O(log N) operation, where N is the number of samples in the wave-form.
+		 * This is an O(log N) operation, where N is the number of samples in the wave-form, or O(1) if it's uniform.
 		 */
 		bool FindTightestSampleBounds(double timeSeconds, SampleBounds& sampleBounds) const;
 
@@ -207,6 +328,36 @@ namespace AudioDataLib
 		 */
 		uint64_t GetNumSamples() const;
 
+		/**
+		 * Return how many bytes of sample storage this wave-form has allocated, whether or not it's all in use.
+		 */
+		uint64_t GetCapacityBytes() const { return this->amplitudeArray.capacity() * sizeof(double) + this->sampleArray.capacity() * sizeof(Sample); }
+
+		/**
+		 * These are the statistics we can gather about a wave-form's amplitudes.
+		 */
+		struct Statistics
+		{
+			double minAmplitude;			///< This is the most negative amplitude.
+			double maxAmplitude;			///< This is the most positive amplitude.
+			double peakAmplitude;			///< This is the largest absolute amplitude.
+			double rmsAmplitude;			///< This is the root-mean-square of the amplitudes, taken per sample (not weighted by time.)
+			double averageVolume;			///< This is the mean absolute amplitude of the peaks and valleys.  See CalcAverageVolume.
+			uint64_t numPeaksAndValleys;	///< This is how many samples went into the average volume.
+		};
+
+		/**
+		 * Return the statistics of this wave-form.  They're all gathered in one (vectorized, where possible) pass over
+		 * the samples, and then cached until this wave-form is changed, so asking again is free.
+		 */
+		const Statistics& GetStatistics() const;
+
+		/**
+		 * Forget the cached statistics.  This happens automatically whenever the wave-form is changed through one
+		 * of its own methods, so you only need to call it if you've changed samples through a held-on-to array.
+		 */
+		void InvalidateStatistics() { this->statisticsValid = false; }
+
 		/**
 		 * Find and return the most positive amplitude found in this wave-form's list of samples.
 		 */
@@ -218,6 +369,7 @@ namespace AudioDataLib
 		double GetMinAmplitude() const;
 
 		/**
+		 * This is the average absolute amplitude of all the peaks and valleys of the wave-form.
 		 * This function is not very well defined.  I may remove it at some point.
 		 */
 		double CalcAverageVolume() const;
@@ -238,14 +390,28 @@ namespace AudioDataLib
 		void SetInterpolateionMethod(InterpolationMethod interpMethod) { this->interpMethod = interpMethod; }
 
 		/**
-		 * Get read-only access to this wave-form's sample array.
+		 * Get read-only access to this wave-form's sample array.  Only irregular wave-forms have one, so this
+		 * must not be called on a uniform wave-form.  Use GetSample and GetNumSamples to read either kind, or
+		 * call MakeIrregular first.
+		 */
+		const std::vector<Sample>& GetSampleArray() const { assert(!this->uniform); return this->sampleArray; }
+
+		/**
+		 * Get read/write access to this wave-form's sample array.  Note that this forces the wave-form
+		 * into the irregular representation, so prefer GetSample, GetAmplitude, etc., where you can.
 		 */
-		const std::vector<Sample>& GetSampleArray() const { return this->sampleArray; }
+		std::vector<Sample>& GetSampleArray() { this->MakeIrregular(); this->statisticsValid = false; return this->sampleArray; }
 
 		/**
-		 * Get read/write access to this wave-form's sample array.
+		 * Get read-only access to the amplitudes of a uniform wave-form.  This is empty for irregular wave-forms.
 		 */
-		std::vector<Sample>& GetSampleArray() { return this->sampleArray; }
+		const std::vector<double>& GetAmplitudeArray() const { return this->amplitudeArray; }
+
+		/**
+		 * Get read/write access to the amplitudes of a uniform wave-form.  This is empty for irregular wave-forms.
+		 * If you hang on to the returned array and change it after asking for statistics, call InvalidateStatistics.
+		 */
+		std::vector<double>& GetAmplitudeArray() { this->statisticsValid = false; return this->amplitudeArray; }
 
 		/**
 		 * Evaluate this wave-form at the given time, between the two given samples, using the set interpolation method.
@@ -261,102 +427,132 @@ namespace AudioDataLib
 
 	protected:
 
-		// TODO: Add byte-swapping here.
-		template<typename T>
-		void CopyIntSampleToBuffer(uint8_t* sampleBuffer, double sampleNormalized) const
-		{
-			constexpr int64_t minSample = std::numeric_limits<T>::min();
-			constexpr int64_t maxSample = std::numeric_limits<T>::max();
-
-			int64_t sampleWide = int64_t(sampleNormalized * double(maxSample));
-
-			if (sampleWide > maxSample)
-				sampleWide = maxSample;
-			if (sampleWide < minSample)
-				sampleWide = minSample;
-
-			T sampleNarrow = T(sampleWide);
-			::memcpy(sampleBuffer, (const void*)&sampleNarrow, sizeof(T));
-		}
-
-		// TODO: Add byte-swapping here.
-		template<typename T>
-		void CopyUIntSampleToBuffer(uint8_t* sampleBuffer, double sampleNormalized) const
-		{
-			constexpr uint64_t maxSample = std::numeric_limits<T>::max();
-
-			uint64_t sampleWide = uint64_t((sampleNormalized + 1.0) * double(maxSample) / 2.0);
-
-			if (sampleWide > maxSample)
-				sampleWide = maxSample;
+		/**
+		 * If this wave-form is uniform and the given time lands (close enough) on one of its grid
+		 * points, then return true and give back that point's index.
+		 */
+		bool FindUniformIndex(double timeSeconds, int64_t& i) const;
 
-			T sampleNarrow = T(sampleWide);
-			::memcpy(sampleBuffer, (const void*)&sampleNarrow, sizeof(T));
-		}
+		/**
+		 * Return true if and only if both this and the given wave-form are uniform, have the same sample rate,
+		 * and have grid points that line up, so that their amplitudes can be added index by index.
+		 */
+		bool SharesGridWith(const WaveForm* waveForm) const;
 
-		// TODO: Add byte-swapping here.
-		template<typename T>
-		void CopyFloatSampleToBuffer(uint8_t* sampleBuffer, double sampleNormalized) const
-		{
-			T sampleFloat = T(sampleNormalized);
-			::memcpy(sampleBuffer, (const void*)&sampleFloat, sizeof(float));
-		}
+		// We assume the samples are all in order according to time.  Only one of these two arrays is used at a time,
+		// depending on the representation.
+		std::vector<Sample> sampleArray;
+		std::vector<double> amplitudeArray;
+		bool uniform;
+		double startTimeSeconds;
+		double samplesPerSecond;
+		InterpolationMethod interpMethod;
+		mutable Statistics statistics;
+		mutable bool statisticsValid;
+		std::vector<double> scratchAmplitudeArray;	///< SumTogether evaluates its inputs into this when no render arena is current.
+	};
 
-		// TODO: Add byte-swapping here.
-		template<typename T>
-		double CopyIntSampleFromBuffer(const uint8_t* sampleBuffer)
-		{
-			constexpr int64_t maxSample = std::numeric_limits<T>::max();
+	/**
+	 * @brief This is a non-owning look at a run of uniformly spaced samples, such as all or part of a uniform WaveForm.
+	 *
+	 * A view is just a pointer, a count, a start time and a sample rate, so it's cheap to copy and pass around,
+	 * and slicing or trimming one is O(1), because no samples ever move.  The catch is that whoever owns the
+	 * samples has to keep them alive and unchanged for as long as the view is in use.
+	 */
+	class AUDIO_DATA_LIB_API WaveFormView
+	{
+	public:
+		WaveFormView();
+		WaveFormView(const double* amplitudes, uint64_t numSamples, double startTimeSeconds, double samplesPerSecond, WaveForm::InterpolationMethod interpMethod = WaveForm::InterpolationMethod::LINEAR);
+
+		uint64_t GetNumSamples() const { return this->numSamples; }
+		const double* GetAmplitudes() const { return this->amplitudes; }
+		double GetAmplitude(uint64_t i) const { return this->amplitudes[i]; }
+		double GetSampleTime(uint64_t i) const { return this->startTimeSeconds + double(i) / this->samplesPerSecond; }
+		double GetSampleRate() const { return this->samplesPerSecond; }
+		double GetStartTime() const { return this->startTimeSeconds; }
+		double GetEndTime() const;
+		double GetTimespan() const;
+		WaveForm::InterpolationMethod GetInterpolationMethod() const { return this->interpMethod; }
 
-			T sampleNarrow = 0;
-			::memcpy(&sampleNarrow, sampleBuffer, sizeof(T));
+		/**
+		 * Evaluate the viewed samples at the given time, just as WaveForm::EvaluateAt would.
+		 */
+		double EvaluateAt(double timeSeconds) const;
 
-			double sampleFloat = double(sampleNarrow);
-			double sampleNormalized = sampleFloat / double(maxSample);
-			return sampleNormalized;
-		}
+		/**
+		 * Evaluate the viewed samples at evenly spaced times, just as WaveForm::EvaluateBlock would.
+		 */
+		void EvaluateBlock(double startTimeSeconds, double deltaTimeSeconds, double* amplitudeBuffer, uint64_t numAmplitudes) const;
 
-		// TODO: Add byte-swapping here.
-		template<typename T>
-		double CopyUIntSampleFromBuffer(const uint8_t* sampleBuffer)
-		{
-			constexpr uint64_t maxSample = std::numeric_limits<T>::max();
+		/**
+		 * Return a view of just those samples that fall in the given time range.
+		 */
+		WaveFormView Slice(double startTimeSeconds, double stopTimeSeconds) const;
 
-			T sampleNarrow = 0;
-			::memcpy(&sampleNarrow, sampleBuffer, sizeof(T));
+		/**
+		 * Narrow this view to the samples in the given time range.  Unlike WaveForm::Trim, this is O(1).
+		 *
+		 * @param[in] startTimeSeconds Drop everything before this time.
+		 * @param[in] stopTimeSeconds Drop everything after this time.
+		 * @param[in] rebaseTime If true, shift the view so that it starts at the origin.
+		 * @return False is returned if an error occurrs; true otherwise.
+		 */
+		bool Trim(double startTimeSeconds, double stopTimeSeconds, bool rebaseTime);
 
-			double sampleFloat = double(sampleNarrow);
-			double sampleNormalized = (sampleFloat / double(maxSample)) * 2.0 - 1.0;
-			return sampleNormalized;
-		}
+		/**
+		 * Drop everything before or after the given time.  This is O(1), but since a view can't make up new samples,
+		 * a time that falls between grid points doesn't get an interpolated end-point like it would with WaveForm::QuickTrim.
+		 * We just keep the samples on the kept side of the given time.
+		 */
+		void QuickTrim(double timeSeconds, WaveForm::TrimSection trimSection);
 
-		// TODO: Add byte-swapping here.
-		template<typename T>
-		double CopyFloatSampleFromBuffer(const uint8_t* sampleBuffer)
-		{
-			T sampleFloat = 0.0f;
-			::memcpy(&sampleFloat, sampleBuffer, sizeof(float));
-			double sampleNormalized = double(sampleFloat);
-			return sampleNormalized;
-		}
+		/**
+		 * Make the given wave-form a uniform copy of the viewed samples.
+		 */
+		void CopyTo(WaveForm& waveForm) const;
 
-		// We assume the samples are all in order according to time.
-		std::vector<Sample> sampleArray;
-		InterpolationMethod interpMethod;
+	private:
+		const double* amplitudes;
+		uint64_t numSamples;
+		double startTimeSeconds;
+		double samplesPerSecond;
+		WaveForm::InterpolationMethod interpMethod;
 	};
 
 	/**
 	 * If you want to continuously add samples to a wave-form, but you also
 	 * don't want it to grow without bound, then this class may be helpful.
+	 *
+	 * Samples are kept in a fixed-size circular buffer on a uniform grid, so that the most recent
+	 * history can be looked up by sample index rather than searched for by time.  Adding a sample and
+	 * evaluating the stream (at any fractional delay within the history) are both O(1), and once the
+	 * buffer has been sized (which happens when the sample rate becomes known), nothing is allocated.
+	 *
+	 * The sample rate can be given up-front, or it is taken from the spacing of the first two samples.
+	 * Samples that don't land exactly on the grid (e.g., because the caller's rate drifts slightly
+	 * from one chunk to the next) are linearly resampled onto it as they come in.  Samples are expected
+	 * to arrive in time order.  One given again at the time of the latest sample replaces it, and
+	 * anything older than that is ignored, since we can't rewrite history.
 	 */
 	class AUDIO_DATA_LIB_API WaveFormStream : public Function
 	{
 	public:
-		WaveFormStream(uint32_t maxWaveForms, double maxWaveFormSizeSeconds);
+		/**
+		 * @param[in] historySeconds This is (at least) how far back from the latest sample the stream remembers.
+		 * @param[in] samplesPerSecond This is the rate of the grid, or zero if it should be taken from the samples.
+		 */
+		WaveFormStream(double historySeconds, double samplesPerSecond = 0.0);
 		virtual ~WaveFormStream();
 
 		virtual double EvaluateAt(double timeSeconds) const override;
 
+		/**
+		 * Evaluate the stream at the given (possibly fractional) index into the grid, where index zero
+		 * is the first sample ever added.  Anything outside of the remembered history evaluates to zero.
+		 */
+		double EvaluateAtIndex(double sampleIndex) const;
+
 		void AddSample(const WaveForm::Sample& sample);
 		void Clear();
 		double GetDurationSeconds() const;
@@ -364,10 +560,42 @@ namespace AudioDataLib
 		double GetEndTimeSeconds() const;
 		bool AnyAudibleSampleFound() const;
 
+		/**
+		 * Fix the rate of the grid and size the buffer for it.  This clears the stream.
+		 */
+		void SetSampleRate(double samplesPerSecond);
+
+		/**
+		 * Return the rate of the grid, or zero if it isn't known yet.
+		 */
+		double GetSampleRate() const { return this->samplesPerSecond; }
+
+		/**
+		 * Return how many grid samples have been written since the stream was last cleared.
+		 */
+		uint64_t GetNumSamplesWritten() const { return this->numSamplesWritten; }
+
+		/**
+		 * Return how many grid samples the stream can remember.
+		 */
+		uint64_t GetCapacity() const { return this->ringBuffer.size(); }
+
 	protected:
-		
-		uint32_t maxWaveForms;
-		double maxWaveFormSizeSeconds;
-		std::list<WaveForm*> waveFormList;
+
+		void AllocateRingBuffer();
+		void WriteSample(double amplitude);
+		uint64_t GetOldestIndex() const;
+
+		double historySeconds;
+		double samplesPerSecond;
+		double requestedSamplesPerSecond;		///< This is what the rate goes back to when the stream is cleared.
+		std::vector<double> ringBuffer;			///< Its size is always a power of two, so that indices wrap with a mask.
+		uint64_t ringMask;
+		double startTimeSeconds;				///< This is the time of grid index zero.
+		uint64_t numSamplesAdded;
+		uint64_t numSamplesWritten;				///< This is also the grid index of the next sample to be written.
+		double lastTimeSeconds;					///< This is the time of the latest sample added, which need not be on the grid.
+		double lastAmplitude;
+		int64_t lastAudibleIndex;
 	};
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "CmdLineParser.h"
 #include "AudioDataLib/FileFormats/SoundFontFormat.h"
 #include "AudioDataLib/FileFormats/WaveFileFormat.h"
+#include "AudioDataLib/FileFormats/WaveFileWriter.h"
 #include "AudioDataLib/WaveForm.h"
 #include "Main.h"
 #include "MidiPortSource.h"
@@ -16,11 +17,42 @@
 #include "AudioDataLib/MIDI/SampleBasedSynth.h"
 #include "AudioDataLib/SynthModules/LoopedAudioModule.h"
 #include "AudioDataLib/SynthModules/ReverbModule.h"
+#include "AudioDataLib/PCMConverter.h"
+#include "AudioDataLib/Resampler.h"
+#include "AudioDataLib/RenderArena.h"
+#include "AudioDataLib/SynthModules/OscillatorModule.h"
+#include "AudioDataLib/SynthModules/MixerModule.h"
 #include <memory>
 #include <filesystem>
+#include <atomic>
+#include <cstdlib>
+#include <new>
 
 using namespace AudioDataLib;
 
+// The render benchmark wants to know how often the heap really gets hit, not just how often the
+// render arena had to grow, so we count every trip through the global allocator here.
+static std::atomic<uint64_t> numGlobalHeapAllocations(0);
+
+void* operator new(std::size_t size)
+{
+	numGlobalHeapAllocations++;
+	void* memory = ::malloc(size == 0 ? 1 : size);
+	if (!memory)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	::free(memory);
+}
+
+void operator delete(void* memory, std::size_t size) noexcept
+{
+	::free(memory);
+}
+
 int main(int argc, char** argv)
 {
 	CmdLineParser parser;
@@ -30,6 +62,8 @@ int main(int argc, char** argv)
 	parser.RegisterArg("keyboard", 1, "Receive MIDI input from the given MIDI input port.  A MIDI keyboard is not necessarily connected to the port, but could be any MIDI device.");
 	parser.RegisterArg("synth", 1, "Synthesize MIDI input to the sound-card.  Use the given synth type: \"simple\", or \"sample\".");
 	parser.RegisterArg("wavetable", 1, "If using the \"sample\" synth, use this option to specify the wave-table file (SF2 or DSL) to use.");
+	parser.RegisterArg("wavetable_budget", 1, "Keep no more than the given number of megabytes of wave-table samples in memory at once.  By default, there's no limit.");
+	parser.RegisterArg("wavetable_stream", 1, "Stream long wave-table samples from the file as they're played, keeping only the first given number of milliseconds of each in memory.");
 	parser.RegisterArg("record_midi", 1, "Record MIDI input to the given MIDI file.");
 	parser.RegisterArg("record_wave", 1, "Record synthesized MIDI input to the given WAVE file.");
 	parser.RegisterArg("log_midi", 0, "Print MIDI input to the screen as it is given.");
@@ -45,6 +79,9 @@ int main(int argc, char** argv)
 	parser.RegisterArg("unpack", 1, "Unpack the given sound-font or DLS file by generating from it a bunch of WAV files for all the samples it contains.");
 	parser.RegisterArg("device_substr", 1, "Specify a sub-string to look for when trying to select an audio device for input or output.");
 	parser.RegisterArg("add_reverb", 2, "Add a reverb effect to the given WAV file.");
+	parser.RegisterArg("resample", 3, "Resample the given WAV file to the given sample-rate (in Hz) and write the result to the third given output file.");
+	parser.RegisterArg("resample_quality", 1, "When resampling, use the given quality: \"linear\", \"cubic\", \"sinc16\", \"sinc32\" (the default), or \"sinc64\".");
+	parser.RegisterArg("benchmark", 1, "Run the given micro-benchmark and print the results.  Try \"convert\", \"resample\", \"render\" or \"mix\".");
 	
 	std::string error;
 	if (!parser.Parse(argc, argv, error))
@@ -108,6 +145,18 @@ int main(int argc, char** argv)
 		return 0;
 	}
 
+	if (parser.ArgGiven("benchmark"))
+	{
+		const std::string& benchmarkName = parser.GetArgValue("benchmark", 0);
+		if (!Benchmark(benchmarkName))
+		{
+			fprintf(stderr, "Error: %s\n", ErrorSystem::Get()->GetErrorMessage().c_str());
+			return -1;
+		}
+
+		return 0;
+	}
+
 	if (parser.ArgGiven("play"))
 	{
 		const std::string& filePath = parser.GetArgValue("play", 0);
@@ -118,7 +167,7 @@ int main(int argc, char** argv)
 			return -1;
 		}
 
-		FileInputStream inputStream(filePath.c_str());
+		MappedFileInputStream inputStream(filePath.c_str());
 		if (!inputStream.IsOpen())
 		{
 			fprintf(stderr, "Could not open file: %s\n", filePath.c_str());
@@ -174,6 +223,32 @@ int main(int argc, char** argv)
 		return 0;
 	}
 
+	if (parser.ArgGiven("resample"))
+	{
+		const std::string& inFilePath = parser.GetArgValue("resample", 0);
+		const std::string& outFilePath = parser.GetArgValue("resample", 1);
+		uint32_t framesPerSecond = (uint32_t)::atoi(parser.GetArgValue("resample", 2).c_str());
+
+		Resampler::Quality quality = Resampler::Quality::SINC_32;
+		if (parser.ArgGiven("resample_quality"))
+		{
+			const std::string& qualityName = parser.GetArgValue("resample_quality", 0);
+			if (!Resampler::GetQualityFromName(qualityName, quality))
+			{
+				fprintf(stderr, "Error: Unknown resample quality: %s\n", qualityName.c_str());
+				return -1;
+			}
+		}
+
+		if (!ResampleAudio(inFilePath, outFilePath, framesPerSecond, quality))
+		{
+			fprintf(stderr, "Error: %s\n", ErrorSystem::Get()->GetErrorMessage().c_str());
+			return -1;
+		}
+
+		return 0;
+	}
+
 	if (parser.ArgGiven("keyboard"))
 	{
 		if (!PlayWithKeyboard(parser))
@@ -199,7 +274,7 @@ bool AddReverb(const std::string& inFilePath, const std::string& outFilePath)
 		return false;
 	}
 
-	FileInputStream inputStream(inFilePath.c_str());
+	MappedFileInputStream inputStream(inFilePath.c_str());
 	if (!inputStream.IsOpen())
 	{
 		ErrorSystem::Get()->Add("Failed to open file: " + inFilePath);
@@ -307,6 +382,88 @@ bool AddReverb(const std::string& inFilePath, const std::string& outFilePath)
 	return true;
 }
 
+bool ResampleAudio(const std::string& inFilePath, const std::string& outFilePath, uint32_t framesPerSecond, Resampler::Quality quality)
+{
+	if (framesPerSecond == 0)
+	{
+		ErrorSystem::Get()->Add("Can't resample to a rate of zero.");
+		return false;
+	}
+
+	std::shared_ptr<FileFormat> fileFormat = FileFormat::CreateForFile(inFilePath);
+	if (!fileFormat)
+	{
+		ErrorSystem::Get()->Add("Could not recognize file: " + inFilePath);
+		return false;
+	}
+
+	MappedFileInputStream inputStream(inFilePath.c_str());
+	if (!inputStream.IsOpen())
+	{
+		ErrorSystem::Get()->Add("Failed to open file: " + inFilePath);
+		return false;
+	}
+
+	std::unique_ptr<FileData> fileData;
+	if (!fileFormat->ReadFromStream(inputStream, fileData))
+	{
+		ErrorSystem::Get()->Add("Failed to read file: " + inFilePath);
+		return false;
+	}
+
+	AudioData* audioData(dynamic_cast<AudioData*>(fileData.get()));
+	if (!audioData)
+	{
+		ErrorSystem::Get()->Add("Expected to get audio data from file (" + inFilePath + "), but didn't");
+		return false;
+	}
+
+	// The sink does the resampling for us, since the input and output rates differ.  We feed it a
+	// chunk at a time just like we would in real-time, and the resamplers carry over between chunks.
+	AudioSink audioSink;
+	audioSink.SetResamplerQuality(quality);
+	audioSink.AddAudioInput(std::shared_ptr<AudioStream>(new AudioStream(audioData)));
+
+	AudioData::Format format = audioData->GetFormat();
+	format.framesPerSecond = framesPerSecond;
+	std::shared_ptr<AudioStream> audioStreamOut(new AudioStream());
+	audioStreamOut->SetFormat(format);
+	audioSink.SetAudioOutput(audioStreamOut);
+
+	double totalSeconds = audioData->GetTimeSeconds();
+	double timeChunkSeconds = 0.5;
+	for (double seconds = timeChunkSeconds; audioSink.GetAudioInputCount() > 0; seconds += timeChunkSeconds)
+	{
+		audioSink.GenerateAudio(ADL_MIN(seconds, totalSeconds), 0.0);
+		if (ErrorSystem::Get()->Errors() || seconds >= totalSeconds)
+			break;
+	}
+
+	if (ErrorSystem::Get()->Errors())
+		return false;
+
+	AudioData resampledAudioData;
+	resampledAudioData.SetFormat(format);
+	resampledAudioData.SetAudioBufferSize(audioStreamOut->GetSize());
+	audioStreamOut->ReadBytesFromStream(resampledAudioData.GetAudioBuffer(), resampledAudioData.GetAudioBufferSize());
+
+	FileOutputStream outputStream(outFilePath.c_str());
+	if (!outputStream.IsOpen())
+	{
+		ErrorSystem::Get()->Add("Failed to open file: " + outFilePath);
+		return false;
+	}
+
+	if (!fileFormat->WriteToStream(outputStream, &resampledAudioData))
+	{
+		ErrorSystem::Get()->Add("Failed to write file: " + outFilePath);
+		return false;
+	}
+
+	printf("Resampled %s from %d Hz to %d Hz using %s interpolation.\n", inFilePath.c_str(), audioData->GetFormat().framesPerSecond, framesPerSecond, Resampler::GetQualityName(quality));
+	return true;
+}
+
 bool PlayWithKeyboard(CmdLineParser& parser)
 {
 	bool success = false;
@@ -317,7 +474,7 @@ bool PlayWithKeyboard(CmdLineParser& parser)
 	std::string recordedWaveFilePath;
 	Keyboard* keyboard = nullptr;
 	SDLAudio* player = nullptr;
-	std::shared_ptr<AudioStream> recordedAudioStream;
+	std::shared_ptr<WaveFileWriter> recordedWaveWriter;
 
 	do
 	{
@@ -391,7 +548,6 @@ bool PlayWithKeyboard(CmdLineParser& parser)
 				}
 
 				std::string waveTableFile = parser.GetArgValue("wavetable", 0);
-				FileInputStream inputStream(waveTableFile.c_str());
 				
 				std::shared_ptr<FileFormat> fileFormat(FileFormat::CreateForFile(waveTableFile));
 				if (!fileFormat.get())
@@ -400,20 +556,32 @@ bool PlayWithKeyboard(CmdLineParser& parser)
 					break;
 				}
 
+				// Samples are left in the file until they're played, so big banks open quickly and don't eat up memory.
 				std::unique_ptr<FileData> fileData;
-				if (!fileFormat->ReadFromStream(inputStream, fileData))
+				if (!fileFormat->OpenWaveTable(waveTableFile.c_str(), fileData))
 				{
 					ErrorSystem::Get()->Add("Failed to read file: " + waveTableFile);
 					break;
 				}
 
-				
 				if (!sampleBasedSynth->SetWaveTableData(fileData))
 				{
 					ErrorSystem::Get()->Add("Failed to set wave-table data from file: " + waveTableFile);
 					break;
 				}
 
+				if (parser.ArgGiven("wavetable_budget"))
+				{
+					uint64_t budgetMegabytes = (uint64_t)::atoll(parser.GetArgValue("wavetable_budget", 0).c_str());
+					sampleBasedSynth->GetWaveTableData()->SetResidencyBudget(budgetMegabytes * 1024 * 1024);
+				}
+
+				if (parser.ArgGiven("wavetable_stream"))
+				{
+					double preloadMilliseconds = ::atof(parser.GetArgValue("wavetable_stream", 0).c_str());
+					sampleBasedSynth->SetStreamingPreload(preloadMilliseconds / 1000.0);
+				}
+
 				// TODO: May want to expose this mapping to the command-line, but do this for now.
 				for(uint8_t i = 1; i <= 16; i++)
 					if (!sampleBasedSynth->SetChannelInstrument(i, i))
@@ -429,12 +597,11 @@ bool PlayWithKeyboard(CmdLineParser& parser)
 				break;
 			}
 
-			std::shared_ptr<Mutex> mutex(new StandardMutex());
-			std::shared_ptr<AudioStream> audioStream(new ThreadSafeAudioStream(mutex));
-			midiSynth->SetAudioStream(audioStream);
-
+			// The synth renders straight into the device buffer from the audio callback, so there's no stream to keep topped up.
 			player = new SDLAudio(SDLAudio::AudioDirection::SOUND_OUT);
-			player->SetAudioStream(midiSynth->GetAudioStream());
+			player->SetRenderFunction([midiSynth](uint8_t* buffer, uint64_t bufferSize, const AudioData::Format& format) {
+				midiSynth->Render(format, buffer, bufferSize);
+			});
 
 			if (parser.ArgGiven("record_wave"))
 			{
@@ -451,8 +618,15 @@ bool PlayWithKeyboard(CmdLineParser& parser)
 					break;
 				}
 
-				recordedAudioStream = std::shared_ptr<AudioStream>(new AudioStream());
-				player->SetRecordedAudioStream(recordedAudioStream);
+				// This goes straight to disk as it's played, so we can record for as long as we like.
+				recordedWaveWriter = std::make_shared<WaveFileWriter>(recordedWaveFilePath.c_str());
+				if (!recordedWaveWriter->IsOpen())
+				{
+					ErrorSystem::Get()->Add(std::format("Failed to open file {} for writing.", recordedWaveFilePath.c_str()));
+					break;
+				}
+
+				player->SetRecordedWaveWriter(recordedWaveWriter);
 			}
 
 			std::string deviceSubStr;
@@ -556,20 +730,32 @@ bool PlayWithKeyboard(CmdLineParser& parser)
 
 	if (source)
 	{
+		SampleBasedSynth* synth = source->FindDestination<SampleBasedSynth>();
+		if (synth && synth->GetStreamingPreload() > 0.0)
+		{
+			SampleStreamer::Stats stats = synth->GetStreamingStats();
+			if (stats.numUnderruns > 0)
+				printf("Warning: The disk couldn't keep up with the streamed samples %llu times, so %llu frames were missed.\n", (unsigned long long)stats.numUnderruns, (unsigned long long)stats.numFramesMissed);
+		}
+
 		source->Shutdown();
 		delete source;
 		source = nullptr;
 	}
 
-	if (recordedAudioStream.get())
+	if (recordedWaveWriter.get())
 	{
-		AudioData audioData;
-		audioData.SetAudioBufferSize(recordedAudioStream->GetSize());
-		audioData.SetFormat(recordedAudioStream->GetFormat());
-		recordedAudioStream->ReadBytesFromStream(audioData.GetAudioBuffer(), audioData.GetAudioBufferSize());
-		FileOutputStream recordedWaveOutputStream(recordedWaveFilePath.c_str());
-		WaveFileFormat fileFormat;
-		fileFormat.WriteToStream(recordedWaveOutputStream, &audioData);
+		// The player is gone by now, so nobody is writing to this anymore.
+		if (recordedWaveWriter->Finalize())
+		{
+			AsyncFileOutputStream::Stats stats = recordedWaveWriter->GetStats();
+			if (stats.numBytesDropped > 0)
+				printf("Warning: The disk couldn't keep up, so %llu bytes of audio were dropped from the recording.\n", (unsigned long long)stats.numBytesDropped);
+
+			printf("Saved file: %s!\n", recordedWaveFilePath.c_str());
+		}
+		else
+			success = false;
 	}
 
 	if (recordedMidiData)
@@ -682,11 +868,10 @@ bool PlayAudioData(AudioDataLib::AudioData* audioData, CmdLineParser& parser)
 		if (!keyboard->Setup())
 			break;
 
-		std::shared_ptr<Mutex> mutex(new StandardMutex());
-		std::shared_ptr<AudioStream> audioStreamOut(new ThreadSafeAudioStream(mutex));
-		audioSink.SetAudioOutput(audioStreamOut);
-
-		player.SetAudioStream(audioSink.GetAudioOutput());
+		// The sink mixes straight into the device buffer from the audio callback.
+		player.SetRenderFunction([&audioSink](uint8_t* buffer, uint64_t bufferSize, const AudioData::Format& format) {
+			audioSink.RenderAudio(format, buffer, bufferSize);
+		});
 
 		std::string deviceSubStr;
 		if (parser.ArgGiven("device_substr"))
@@ -705,8 +890,6 @@ bool PlayAudioData(AudioDataLib::AudioData* audioData, CmdLineParser& parser)
 
 		while (audioSink.GetAudioInputCount() > 0)
 		{
-			audioSink.GenerateAudio(0.2, 0.1);
-
 			if (!keyboard->Process())
 				break;
 
@@ -736,7 +919,7 @@ bool PlayAudioData(AudioDataLib::AudioData* audioData, CmdLineParser& parser)
 bool MixAudio(const std::vector<std::string>& sourceFileArray, const std::string& destinationFile)
 {
 	std::vector<std::shared_ptr<FileFormat>> fileFormatArray;
-	std::vector<std::shared_ptr<AudioData>> audioDataArray;
+	std::vector<std::shared_ptr<AudioData>> audioDataArray;		// This holds onto any sources that couldn't be streamed.
 
 	for (const std::string& sourceFile : sourceFileArray)
 	{
@@ -756,59 +939,66 @@ bool MixAudio(const std::vector<std::string>& sourceFileArray, const std::string
 		return false;
 	}
 
+	AudioSink audioSink;
+
+	AudioData::Format format;
+	format.bitsPerSample = 0;
+
+	double maxTimeSeconds = 0.0;
 	for (int i = 0; i < (signed)sourceFileArray.size(); i++)
 	{
 		FileFormat* fileFormat = fileFormatArray[i].get();
 		const std::string& sourceFile = sourceFileArray[i];
 
-		FileInputStream inputStream(sourceFile.c_str());
-		if (!inputStream.IsOpen())
-		{
-			ErrorSystem::Get()->Add(std::format("Failed to open file {} for reading.", sourceFile.c_str()));
-			return false;
-		}
+		std::shared_ptr<AudioStream> audioStreamIn;
+		double timeSeconds = 0.0;
 
-		std::unique_ptr<FileData> fileData;
-		if (!fileFormat->ReadFromStream(inputStream, fileData))
+		// Stream the file from disk if we can, so that we don't have to hold all the sources in memory at once.
+		std::shared_ptr<FileAudioStream> fileAudioStream;
+		if (fileFormat->OpenAudioStream(sourceFile.c_str(), fileAudioStream))
 		{
-			ErrorSystem::Get()->Add("Failed to read file: " + sourceFile);
-			return false;
+			audioStreamIn = fileAudioStream;
+			timeSeconds = double(fileAudioStream->GetNumFrames()) / fileAudioStream->GetFormat().framesPerSecond;
 		}
-
-		std::shared_ptr<AudioData> audioData(dynamic_cast<AudioData*>(fileData.get()));
-		if (!audioData.get())
+		else
 		{
-			ErrorSystem::Get()->Add(std::format("File data for file {} is not audio data.", sourceFile.c_str()));
-			return false;
-		}
+			ErrorSystem::Get()->Clear();
 
-		fileData.release();
-		audioDataArray.push_back(audioData);
-	}
+			MappedFileInputStream inputStream(sourceFile.c_str());
+			if (!inputStream.IsOpen())
+			{
+				ErrorSystem::Get()->Add(std::format("Failed to open file {} for reading.", sourceFile.c_str()));
+				return false;
+			}
 
-	if (audioDataArray.size() != sourceFileArray.size())
-	{
-		ErrorSystem::Get()->Add("Could not load all source files.");
-		return false;
-	}
+			std::unique_ptr<FileData> fileData;
+			if (!fileFormat->ReadFromStream(inputStream, fileData))
+			{
+				ErrorSystem::Get()->Add("Failed to read file: " + sourceFile);
+				return false;
+			}
 
-	AudioSink audioSink;
+			std::shared_ptr<AudioData> audioData(dynamic_cast<AudioData*>(fileData.get()));
+			if (!audioData.get())
+			{
+				ErrorSystem::Get()->Add(std::format("File data for file {} is not audio data.", sourceFile.c_str()));
+				return false;
+			}
 
-	AudioData::Format format;
-	format.bitsPerSample = 0;
+			fileData.release();
+			audioDataArray.push_back(audioData);
+
+			audioStreamIn.reset(new AudioStream(audioData.get()));
+			timeSeconds = audioData->GetTimeSeconds();
+		}
 
-	double maxTimeSeconds = 0.0;
-	for (std::shared_ptr<AudioData>& audioData : audioDataArray)
-	{
-		double timeSeconds = audioData->GetTimeSeconds();
 		if (maxTimeSeconds < timeSeconds)
 			maxTimeSeconds = timeSeconds;
 
-		std::shared_ptr<AudioStream> audioStreamIn(new AudioStream(audioData.get()));
 		audioSink.AddAudioInput(audioStreamIn);
 
 		if (format.bitsPerSample == 0)
-			format = audioData->GetFormat();
+			format = audioStreamIn->GetFormat();
 	}
 
 	std::shared_ptr<AudioStream> audioStreamOut(new AudioStream());
@@ -848,7 +1038,7 @@ bool DumpInfo(const std::string& filePath, bool csv)
 {
 	bool success = false;
 	
-	FileInputStream inputStream(filePath.c_str());
+	MappedFileInputStream inputStream(filePath.c_str());
 	if (!inputStream.IsOpen())
 	{
 		ErrorSystem::Get()->Add("Failed to open file: " + filePath);
@@ -888,7 +1078,7 @@ bool Unpack(const std::string& filePath)
 		return false;
 	}
 
-	FileInputStream inputStream(filePath.c_str());
+	MappedFileInputStream inputStream(filePath.c_str());
 	if (!inputStream.IsOpen())
 	{
 		ErrorSystem::Get()->Add("Failed to open file: " + filePath);
@@ -953,5 +1143,403 @@ bool Unpack(const std::string& filePath)
 
 	printf("Wrote %d files.\n", waveTableData->GetNumAudioSamples());
 
+	return true;
+}
+
+bool Benchmark(const std::string& benchmarkName)
+{
+	if (benchmarkName == "convert")
+		return BenchmarkConversion();
+
+	if (benchmarkName == "resample")
+		return BenchmarkResampling();
+
+	if (benchmarkName == "render")
+		return BenchmarkRendering();
+
+	if (benchmarkName == "mix")
+		return BenchmarkMixing();
+
+	ErrorSystem::Get()->Add("Unknown benchmark: " + benchmarkName);
+	return false;
+}
+
+// This is how we used to convert audio to wave-forms: one sample at a time, switching on the format for every one of them.
+double DecodeSampleOneAtATime(const AudioData::Format& format, const uint8_t* sampleBuffer)
+{
+	switch (format.sampleType)
+	{
+		case AudioData::Format::SIGNED_INTEGER:
+		{
+			switch (format.bitsPerSample)
+			{
+				case 8:		return double(*(const int8_t*)sampleBuffer) / double(std::numeric_limits<int8_t>::max());
+				case 16:	return double(*(const int16_t*)sampleBuffer) / double(std::numeric_limits<int16_t>::max());
+				case 32:	return double(*(const int32_t*)sampleBuffer) / double(std::numeric_limits<int32_t>::max());
+			}
+			break;
+		}
+		case AudioData::Format::UNSIGNED_INTEGER:
+		{
+			switch (format.bitsPerSample)
+			{
+				case 8:		return (double(*(const uint8_t*)sampleBuffer) / double(std::numeric_limits<uint8_t>::max())) * 2.0 - 1.0;
+				case 16:	return (double(*(const uint16_t*)sampleBuffer) / double(std::numeric_limits<uint16_t>::max())) * 2.0 - 1.0;
+				case 32:	return (double(*(const uint32_t*)sampleBuffer) / double(std::numeric_limits<uint32_t>::max())) * 2.0 - 1.0;
+			}
+			break;
+		}
+		case AudioData::Format::FLOAT:
+		{
+			switch (format.bitsPerSample)
+			{
+				case 32:	return double(*(const float*)sampleBuffer);
+				case 64:	return *(const double*)sampleBuffer;
+			}
+			break;
+		}
+	}
+
+	return 0.0;
+}
+
+bool BenchmarkConversion()
+{
+	constexpr double durationSeconds = 30.0;
+	constexpr uint32_t numPasses = 5;
+
+	struct FormatCase
+	{
+		const char* name;
+		AudioData::Format::SampleType sampleType;
+		uint16_t bitsPerSample;
+		uint16_t numChannels;
+	};
+
+	FormatCase formatCaseArray[] =
+	{
+		{ "int16 stereo", AudioData::Format::SIGNED_INTEGER, 16, 2 },
+		{ "int16 mono", AudioData::Format::SIGNED_INTEGER, 16, 1 },
+		{ "int32 mono", AudioData::Format::SIGNED_INTEGER, 32, 1 },
+		{ "uint8 mono", AudioData::Format::UNSIGNED_INTEGER, 8, 1 },
+		{ "float32 stereo", AudioData::Format::FLOAT, 32, 2 },
+		{ "float32 mono", AudioData::Format::FLOAT, 32, 1 }
+	};
+
+	PCMConverter::InstructionSet bestInstructionSet = PCMConverter::DetectInstructionSet();
+	printf("Best supported instruction set: %s\n", PCMConverter::GetInstructionSetName(bestInstructionSet));
+	printf("Converting %.0f seconds of 48 kHz audio, %d passes per measurement.\n\n", durationSeconds, numPasses);
+
+	for (const FormatCase& formatCase : formatCaseArray)
+	{
+		AudioData audioData;
+		AudioData::Format& format = audioData.GetFormat();
+		format.sampleType = formatCase.sampleType;
+		format.bitsPerSample = formatCase.bitsPerSample;
+		format.numChannels = formatCase.numChannels;
+		format.framesPerSecond = 48000;
+		audioData.SetAudioBufferSize(format.BytesFromSeconds(durationSeconds));
+
+		WaveForm waveForm;
+		uint64_t numFrames = audioData.GetNumFrames();
+		waveForm.MakeUniform(0.0, double(format.framesPerSecond), numFrames);
+		for (uint64_t i = 0; i < numFrames; i++)
+			waveForm.SetAmplitude(i, 0.5 * ::sin(2.0 * ADL_PI * 440.0 * waveForm.GetSampleTime(i)));
+
+		printf("%s:\n", formatCase.name);
+
+		HighResTimer timer;
+		timer.Start();
+		std::vector<double> amplitudeArray(numFrames);
+		for (uint32_t pass = 0; pass < numPasses; pass++)
+			for (uint64_t i = 0; i < numFrames; i++)
+				amplitudeArray[i] = DecodeSampleOneAtATime(format, &audioData.GetAudioBuffer()[i * format.BytesPerFrame()]);
+		double oneAtATimeSeconds = timer.GetElapsedTimeSeconds() / double(numPasses);
+		printf("\tone-at-a-time decode: %8.3f ms\n", oneAtATimeSeconds * 1000.0);
+
+		for (int32_t i = 0; i <= int32_t(bestInstructionSet); i++)
+		{
+			PCMConverter::SetInstructionSet(PCMConverter::InstructionSet(i));
+
+			timer.Reset();
+			for (uint32_t pass = 0; pass < numPasses; pass++)
+				if (!waveForm.ConvertToAudioBuffer(format, audioData.GetAudioBuffer(), audioData.GetAudioBufferSize(), 0))
+					return false;
+			double encodeSeconds = timer.GetElapsedTimeSeconds() / double(numPasses);
+
+			WaveForm decodedWaveForm;
+			timer.Reset();
+			for (uint32_t pass = 0; pass < numPasses; pass++)
+				if (!decodedWaveForm.ConvertFromAudioBuffer(format, audioData.GetAudioBuffer(), audioData.GetAudioBufferSize(), 0))
+					return false;
+			double decodeSeconds = timer.GetElapsedTimeSeconds() / double(numPasses);
+
+			printf("\t%6s decode: %8.3f ms (%5.2fx), encode: %8.3f ms\n",
+				PCMConverter::GetInstructionSetName(PCMConverter::InstructionSet(i)),
+				decodeSeconds * 1000.0,
+				oneAtATimeSeconds / decodeSeconds,
+				encodeSeconds * 1000.0);
+		}
+
+		printf("\n");
+	}
+
+	PCMConverter::SetInstructionSet(bestInstructionSet);
+	return true;
+}
+
+bool BenchmarkResampling()
+{
+	constexpr double durationSeconds = 30.0;
+	constexpr double inputRate = 44100.0;
+	constexpr double outputRate = 48000.0;
+	constexpr uint64_t blockSize = 512;
+
+	uint64_t numInputSamples = uint64_t(durationSeconds * inputRate);
+	std::vector<double> inputArray(numInputSamples);
+	for (uint64_t i = 0; i < numInputSamples; i++)
+		inputArray[i] = 0.5 * ::sin(2.0 * ADL_PI * 440.0 * double(i) / inputRate);
+
+	double outputBlock[blockSize];
+
+	PCMConverter::InstructionSet bestInstructionSet = PCMConverter::DetectInstructionSet();
+	printf("Best supported instruction set: %s\n", PCMConverter::GetInstructionSetName(bestInstructionSet));
+	printf("Resampling %.0f seconds of mono audio from %.0f Hz to %.0f Hz, %d output samples at a time.\n\n", durationSeconds, inputRate, outputRate, int(blockSize));
+
+	for (int32_t i = int32_t(Resampler::Quality::LINEAR); i <= int32_t(Resampler::Quality::SINC_64); i++)
+	{
+		Resampler::Quality quality = Resampler::Quality(i);
+		printf("%s:\n", Resampler::GetQualityName(quality));
+
+		for (int32_t j = 0; j <= int32_t(bestInstructionSet); j++)
+		{
+			PCMConverter::SetInstructionSet(PCMConverter::InstructionSet(j));
+
+			Resampler resampler;
+			if (!resampler.Configure(inputRate, outputRate, quality))
+				return false;
+
+			// This is how we'd stream through the resampler in an audio callback: ask how much input
+			// we need for a block of output, hand exactly that over, and repeat.
+			HighResTimer timer;
+			timer.Start();
+			uint64_t inputPosition = 0;
+			uint64_t numOutputSamples = 0;
+			while (true)
+			{
+				uint64_t numInputSamplesNeeded = resampler.GetInputNeeded(blockSize);
+				if (inputPosition + numInputSamplesNeeded > numInputSamples)
+					break;
+
+				uint64_t numInputSamplesConsumed = 0;
+				numOutputSamples += resampler.Process(&inputArray[inputPosition], numInputSamplesNeeded, outputBlock, blockSize, numInputSamplesConsumed);
+				inputPosition += numInputSamplesConsumed;
+			}
+			double elapsedSeconds = timer.GetElapsedTimeSeconds();
+
+			printf("\t%6s: %8.3f ms (%6.1fx real-time), %d samples out\n",
+				PCMConverter::GetInstructionSetName(PCMConverter::InstructionSet(j)),
+				elapsedSeconds * 1000.0,
+				durationSeconds / elapsedSeconds,
+				int(numOutputSamples));
+
+			// The linear and cubic tiers don't use any vector instructions, so there's nothing more to compare.
+			if (quality == Resampler::Quality::LINEAR || quality == Resampler::Quality::CUBIC)
+				break;
+		}
+
+		printf("\n");
+	}
+
+	PCMConverter::SetInstructionSet(bestInstructionSet);
+	return true;
+}
+
+bool BenchmarkRendering()
+{
+	constexpr uint32_t numGroups = 4;
+	constexpr uint32_t numVoicesPerGroup = 16;
+	constexpr double samplesPerSecond = 48000.0;
+	constexpr double passDurationSeconds = 256.0 / samplesPerSecond;
+	constexpr uint32_t numPasses = 2000;
+
+	// Build a little graph of sub-mixes, much like a synth would have for its voices.
+	MixerModule rootModule;
+	for (uint32_t i = 0; i < numGroups; i++)
+	{
+		auto groupModule = new MixerModule();
+		for (uint32_t j = 0; j < numVoicesPerGroup; j++)
+		{
+			OscillatorModule::WaveParams waveParams;
+			waveParams.waveType = OscillatorModule::WaveType(j % 3);
+			waveParams.frequency = MidiSynth::MidiPitchToFrequency(uint8_t(36 + i * numVoicesPerGroup + j));
+			waveParams.amplitude = 0.5 / double(numGroups * numVoicesPerGroup);
+
+			auto oscillatorModule = new OscillatorModule();
+			oscillatorModule->SetWaveParams(waveParams);
+			groupModule->AddDependentModule(std::shared_ptr<SynthModule>(oscillatorModule));
+		}
+
+		rootModule.AddDependentModule(std::shared_ptr<SynthModule>(groupModule));
+	}
+
+	printf("Rendering %d voices in %d sub-mixes, %d passes of %.0f samples each.\n\n", numGroups * numVoicesPerGroup, numGroups, numPasses, passDurationSeconds * samplesPerSecond);
+
+	for (uint32_t useArena = 0; useArena <= 1; useArena++)
+	{
+		RenderArena renderArena;
+		uint64_t maxSteadyStateArenaAllocations = 0;
+		uint64_t maxSteadyStateHeapAllocations = 0;
+		uint64_t numSteadyStateHeapAllocations = 0;
+
+		HighResTimer timer;
+		timer.Start();
+		for (uint32_t pass = 0; pass < numPasses; pass++)
+		{
+			renderArena.Reset();
+			if (pass > 1)
+				maxSteadyStateArenaAllocations = ADL_MAX(maxSteadyStateArenaAllocations, renderArena.GetStats().numHeapAllocationsLastPass);
+
+			uint64_t numHeapAllocationsBefore = numGlobalHeapAllocations;
+			{
+				RenderArena::Scope renderArenaScope(useArena ? &renderArena : nullptr);
+				RenderArena::ScratchWaveForm waveForm;
+				if (!rootModule.GenerateSound(passDurationSeconds, samplesPerSecond, *waveForm, nullptr))
+					return false;
+			}
+			uint64_t numHeapAllocationsThisPass = numGlobalHeapAllocations - numHeapAllocationsBefore;
+
+			// The first couple of passes are warm-up, where the arena and the module graph are still finding their sizes.
+			if (pass > 1)
+			{
+				numSteadyStateHeapAllocations += numHeapAllocationsThisPass;
+				maxSteadyStateHeapAllocations = ADL_MAX(maxSteadyStateHeapAllocations, numHeapAllocationsThisPass);
+			}
+		}
+		double elapsedSeconds = timer.GetElapsedTimeSeconds();
+
+		printf("%s:\n", useArena ? "with render arena" : "without render arena");
+		printf("\t%8.3f ms total, %6.2f us per pass\n", elapsedSeconds * 1000.0, elapsedSeconds * 1e6 / double(numPasses));
+		printf("\t%d calls to operator new after warm-up, %d in the worst pass\n", int(numSteadyStateHeapAllocations), int(maxSteadyStateHeapAllocations));
+
+		if (useArena)
+		{
+			const RenderArena::Stats& stats = renderArena.GetStats();
+			printf("\t%d times the arena grew in all, %d in the worst pass after warm-up\n", int(stats.numHeapAllocations), int(maxSteadyStateArenaAllocations));
+			printf("\t%d pooled wave-forms, %d bytes of arena memory\n", int(stats.numPooledWaveForms), int(stats.capacityBytes));
+		}
+	}
+
+	return true;
+}
+
+bool BenchmarkMixing()
+{
+	constexpr uint32_t numFramesPerMix = 512;
+	constexpr uint32_t numSourceClips = 16;
+	const uint32_t numWorkerThreads = ADL_MAX(std::thread::hardware_concurrency(), 2) - 1;
+
+	AudioData::Format format;
+	format.sampleType = AudioData::Format::SIGNED_INTEGER;
+	format.bitsPerSample = 16;
+	format.numChannels = 2;
+	format.framesPerSecond = 48000.0;
+
+	// Every input plays one of a handful of quiet noise clips, so that even a thousand of them don't saturate the mix.
+	std::vector<std::shared_ptr<AudioData>> sourceClipArray;
+	for (uint32_t i = 0; i < numSourceClips; i++)
+	{
+		auto audioData = std::make_shared<AudioData>();
+		audioData->SetFormat(format);
+		audioData->SetAudioBufferSize(format.BytesFromSeconds(0.5 + 0.03 * double(i)));
+
+		auto sampleArray = (int16_t*)audioData->GetAudioBuffer();
+		uint64_t numSamples = audioData->GetAudioBufferSize() / sizeof(int16_t);
+		for (uint64_t j = 0; j < numSamples; j++)
+			sampleArray[j] = int16_t((rand() % 1001) - 500) / 16;
+
+		sourceClipArray.push_back(audioData);
+	}
+
+	printf("Mixing 16-bit stereo inputs, %d frames at a time, with %d worker threads when in parallel.\n\n", numFramesPerMix, numWorkerThreads);
+
+	for (uint32_t numInputs : { 64, 256, 1024 })
+	{
+		std::vector<uint8_t> mixedAudio[2];
+		double elapsedSeconds[2];
+
+		for (uint32_t parallel = 0; parallel <= 1; parallel++)
+		{
+			AudioSink audioSink;
+			audioSink.SetParallelMixing(parallel ? numWorkerThreads : 0);
+
+			for (uint32_t i = 0; i < numInputs; i++)
+				audioSink.AddAudioInput(std::make_shared<AudioStream>(sourceClipArray[i % numSourceClips].get()));
+
+			std::vector<uint8_t> mixBuffer(numFramesPerMix * format.BytesPerFrame());
+
+			HighResTimer timer;
+			timer.Start();
+			while (audioSink.GetAudioInputCount() > 0)
+			{
+				audioSink.RenderAudio(format, mixBuffer.data(), mixBuffer.size());
+				mixedAudio[parallel].insert(mixedAudio[parallel].end(), mixBuffer.begin(), mixBuffer.end());
+			}
+			elapsedSeconds[parallel] = timer.GetElapsedTimeSeconds();
+		}
+
+		printf("%4d inputs:\n", numInputs);
+		printf("\tserial:   %8.3f ms\n", elapsedSeconds[0] * 1000.0);
+		printf("\tparallel: %8.3f ms (%.2fx)\n", elapsedSeconds[1] * 1000.0, elapsedSeconds[0] / elapsedSeconds[1]);
+		printf("\toutput is %s\n", (mixedAudio[0] == mixedAudio[1]) ? "bit-identical" : "DIFFERENT");
+
+		if (mixedAudio[0] != mixedAudio[1])
+		{
+			ErrorSystem::Get()->Add("Parallel mix didn't match the serial mix.");
+			return false;
+		}
+	}
+
+	// The block mixer doesn't know 24-bit samples, so same-format inputs of that depth have to take the general path.
+	// Either way, every byte of the output has to be written, and the inputs have to run dry in the time they last.
+	AudioData::Format format24 = format;
+	format24.bitsPerSample = 24;
+
+	auto audioData24 = std::make_shared<AudioData>();
+	audioData24->SetFormat(format24);
+	audioData24->SetAudioBufferSize(format24.BytesFromSeconds(0.25));
+	::memset(audioData24->GetAudioBuffer(), 0x11, (size_t)audioData24->GetAudioBufferSize());
+
+	AudioSink audioSink24;
+	for (uint32_t i = 0; i < 4; i++)
+		audioSink24.AddAudioInput(std::make_shared<AudioStream>(audioData24.get()));
+
+	std::vector<uint8_t> mixBuffer24(numFramesPerMix * format24.BytesPerFrame());
+	uint64_t maxNumMixes = audioData24->GetNumFrames() / numFramesPerMix + 1;
+	uint64_t numMixes = 0;
+	while (audioSink24.GetAudioInputCount() > 0 && numMixes <= maxNumMixes)
+	{
+		::memset(mixBuffer24.data(), 0xCD, mixBuffer24.size());
+		audioSink24.RenderAudio(format24, mixBuffer24.data(), mixBuffer24.size());
+		numMixes++;
+
+		for (uint8_t byte : mixBuffer24)
+		{
+			if (byte == 0xCD)
+			{
+				ErrorSystem::Get()->Add("A 24-bit mix left part of its output unwritten.");
+				return false;
+			}
+		}
+	}
+
+	printf("24-bit same-format inputs: %s\n", (audioSink24.GetAudioInputCount() == 0) ? "drained" : "STUCK");
+
+	if (audioSink24.GetAudioInputCount() > 0)
+	{
+		ErrorSystem::Get()->Add("24-bit same-format inputs never ran dry.");
+		return false;
+	}
+
 	return true;
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "SDLAudio.h"
 #include "AudioDataLib/ErrorSystem.h"
 #include "AudioDataLib/Timer.h"
+#include "AudioDataLib/Resampler.h"
 #include "CmdLineParser.h"
 #include "AudioDataLib/MIDI/MidiMsgLogDestination.h"
 
@@ -15,6 +16,13 @@ bool DumpInfo(const std::string& filePath, bool csv);
 bool Unpack(const std::string& filePath);
 bool PlayWithKeyboard(CmdLineParser& parser);
 bool AddReverb(const std::string& inFilePath, const std::string& outFilePath);
+bool ResampleAudio(const std::string& inFilePath, const std::string& outFilePath, uint32_t framesPerSecond, AudioDataLib::Resampler::Quality quality);
+bool Benchmark(const std::string& benchmarkName);
+bool BenchmarkConversion();
+bool BenchmarkResampling();
+bool BenchmarkRendering();
+bool BenchmarkMixing();
+double DecodeSampleOneAtATime(const AudioDataLib::AudioData::Format& format, const uint8_t* sampleBuffer);
 
 class StdoutLogDestination : public AudioDataLib::MidiMsgLogDestination
 {
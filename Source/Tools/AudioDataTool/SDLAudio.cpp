@@ -18,9 +18,9 @@ SDLAudio::SDLAudio(AudioDirection audioDirection)
 
 bool SDLAudio::Setup(const std::string& deviceSubStr)
 {
-	if (!this->audioStream)
+	if (!this->audioStream && !(this->audioDirection == AudioDirection::SOUND_OUT && this->renderFunction))
 	{
-		ErrorSystem::Get()->Add("No audio stream set.");
+		ErrorSystem::Get()->Add("No audio stream or render function set.");
 		return false;
 	}
 
@@ -71,23 +71,23 @@ bool SDLAudio::Setup(const std::string& deviceSubStr)
 		return false;
 	}
 
-	AudioData::Format format;
-	format.numChannels = this->audioSpec.channels;
-	format.bitsPerSample = SDL_AUDIO_BITSIZE(this->audioSpec.format);
-	format.framesPerSecond = this->audioSpec.freq;
+	this->format.numChannels = this->audioSpec.channels;
+	this->format.bitsPerSample = SDL_AUDIO_BITSIZE(this->audioSpec.format);
+	this->format.framesPerSecond = this->audioSpec.freq;
 
 	// TODO: What about big/little endian?
 	if (SDL_AUDIO_ISFLOAT(this->audioSpec.format))
-		format.sampleType = AudioData::Format::FLOAT;
+		this->format.sampleType = AudioData::Format::FLOAT;
 	else if (SDL_AUDIO_ISSIGNED(this->audioSpec.format))
-		format.sampleType = AudioData::Format::SIGNED_INTEGER;
+		this->format.sampleType = AudioData::Format::SIGNED_INTEGER;
 	else
-		format.sampleType = AudioData::Format::UNSIGNED_INTEGER;
+		this->format.sampleType = AudioData::Format::UNSIGNED_INTEGER;
 
-	this->audioStream->SetFormat(format);
+	if (this->audioStream)
+		this->audioStream->SetFormat(this->format);
 
-	if (this->recordedAudioStream.get())
-		this->recordedAudioStream->SetFormat(format);
+	if (this->recordedWaveWriter.get() && !this->recordedWaveWriter->SetFormat(this->format))
+		return false;
 
 	// This will cause our callback to start getting called.
 	SDL_PauseAudioDevice(this->audioDeviceID, 0);
@@ -121,12 +121,20 @@ bool SDLAudio::Shutdown()
 	{
 		case AudioDirection::SOUND_OUT:
 		{
-			uint64_t numBytesRead = this->audioStream->ReadBytesFromStream(buffer, uint64_t(length));
-			for (uint64_t i = numBytesRead; i < uint64_t(length); i++)
-				buffer[i] = this->audioSpec.silence;
-
-			if (this->recordedAudioStream.get())
-				this->recordedAudioStream->WriteBytesToStream(buffer, length);
+			if (this->renderFunction)
+				this->renderFunction(buffer, uint64_t(length), this->format);
+			else
+			{
+				uint64_t numBytesRead = this->audioStream->ReadBytesFromStream(buffer, uint64_t(length));
+				for (uint64_t i = numBytesRead; i < uint64_t(length); i++)
+					buffer[i] = this->audioSpec.silence;
+
+				if (numBytesRead < uint64_t(length) && this->latencyController)
+					this->latencyController->ReportUnderrun();
+			}
+
+			if (this->recordedWaveWriter.get())
+				this->recordedWaveWriter->WriteBytesToStream(buffer, length);
 
 			break;
 		}
@@ -5,6 +5,8 @@
 #include "SDL.h"
 #undef main
 #include "AudioDataLib/ByteStream.h"
+#include "AudioDataLib/LatencyController.h"
+#include "AudioDataLib/FileFormats/WaveFileWriter.h"
 
 class SDLAudio
 {
@@ -15,6 +17,12 @@ public:
 		SOUND_OUT
 	};
 
+	/**
+	 * In pull-mode, this is called from the audio callback to fill the device buffer directly,
+	 * in the format of the device, instead of copying out of our audio stream.
+	 */
+	typedef std::function<void(uint8_t* buffer, uint64_t bufferSize, const AudioDataLib::AudioData::Format& format)> RenderFunction;
+
 	SDLAudio(AudioDirection audioDirection);
 	virtual ~SDLAudio();
 
@@ -24,8 +32,21 @@ public:
 	void SetAudioStream(std::shared_ptr<AudioDataLib::AudioStream> audioStream) { this->audioStream = audioStream; }
 	std::shared_ptr<AudioDataLib::AudioStream> GetAudioStream() { return this->audioStream; }
 
-	void SetRecordedAudioStream(std::shared_ptr<AudioDataLib::AudioStream> recordedAudioStream) { this->recordedAudioStream = recordedAudioStream; }
-	std::shared_ptr<AudioDataLib::AudioStream> GetRecordedAudioStream() { return this->recordedAudioStream; }
+	void SetRenderFunction(RenderFunction renderFunction) { this->renderFunction = renderFunction; }
+
+	/**
+	 * If given, we tell this controller whenever our audio stream comes up short in the callback.
+	 */
+	void SetLatencyController(std::shared_ptr<AudioDataLib::LatencyController> latencyController) { this->latencyController = latencyController; }
+
+	const AudioDataLib::AudioData::Format& GetFormat() const { return this->format; }
+
+	/**
+	 * If given, everything we play is also written to this, straight from the audio callback.
+	 * We give it the format of the device once the device is open.
+	 */
+	void SetRecordedWaveWriter(std::shared_ptr<AudioDataLib::WaveFileWriter> recordedWaveWriter) { this->recordedWaveWriter = recordedWaveWriter; }
+	std::shared_ptr<AudioDataLib::WaveFileWriter> GetRecordedWaveWriter() { return this->recordedWaveWriter; }
 
 protected:
 
@@ -33,7 +54,10 @@ protected:
 	virtual void AudioCallback(Uint8* buffer, int length);
 
 	std::shared_ptr<AudioDataLib::AudioStream> audioStream;
-	std::shared_ptr<AudioDataLib::AudioStream> recordedAudioStream;
+	std::shared_ptr<AudioDataLib::WaveFileWriter> recordedWaveWriter;
+	RenderFunction renderFunction;
+	std::shared_ptr<AudioDataLib::LatencyController> latencyController;
+	AudioDataLib::AudioData::Format format;
 
 	SDL_AudioSpec audioSpec;
 	SDL_AudioDeviceID audioDeviceID;
@@ -229,6 +229,8 @@ void Frame::OnMakeSound(wxCommandEvent& event)
 	double amplitudeA = 0.1;
 	double amplitudeB = 0.2;
 
+	waveForm->MakeUniform(0.0, double(numSamples - 1) / durationSeconds);
+
 	for (uint32_t i = 0; i < numSamples; i++)
 	{
 		WaveForm::Sample sample;